@@ -25,6 +25,11 @@
 //system
 #include <unordered_set>
 
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
+
 class ccImage;
 class ccMesh;
 class ccPointCloud;
@@ -362,6 +367,26 @@ public: //orthorectification tools
 									double* maxCorner = nullptr,
 									double* realCorners = nullptr) const;
 
+	//! Projective ortho-rectification of an image (as image) with already computed parameters
+	/** \param image input image
+		\param a a0, a1 & a2 parameters (see computeOrthoRectificationParams)
+		\param b b0, b1 & b2 parameters
+		\param c c0(=1), c1 & c2 parameters
+		\param pixelSize pixel size (auto if -1)
+		\param minCorner (optional) outputs 3D min corner (2 values)
+		\param maxCorner (optional) outputs 3D max corner (2 values)
+		\param realCorners (optional) image real 3D corners (4*2 values)
+		\return ortho-rectified image
+	**/
+	ccImage* orthoRectifyAsImage(	const ccImage* image,
+									const double a[3],
+									const double b[3],
+									const double c[3],
+									double& pixelSize,
+									double* minCorner = nullptr,
+									double* maxCorner = nullptr,
+									double* realCorners = nullptr) const;
+
 	//! Direct ortho-rectification of an image (as image)
 	/** No keypoint is required. The user must specify however the
 		orthorectification 'altitude'.
@@ -400,6 +425,77 @@ public: //orthorectification tools
 									std::vector<ccImage*>* orthoRectifiedImages = nullptr,
 									std::vector<std::pair<double,double> >* relativePos = nullptr);
 
+	//! Ortho-rectified mosaic writer (see OrthoRectifyAsMosaic)
+	class QCC_DB_LIB_API MosaicWriter
+	{
+	public:
+		//! Destructor
+		virtual ~MosaicWriter() = default;
+
+		//! Opens the output mosaic
+		/** The mosaic covers [minCorner.x ; minCorner.x + width * pixelSize] x [minCorner.y ; minCorner.y + height * pixelSize].
+			The first row of pixels is at the top (i.e. max Y).
+			\param width mosaic width (in pixels)
+			\param height mosaic height (in pixels)
+			\param minCorner 3D min corner (2 values)
+			\param pixelSize pixel size
+			\param tileSize tile size (in pixels)
+			\return success
+		**/
+		virtual bool open(unsigned width, unsigned height, const double minCorner[2], double pixelSize, unsigned tileSize) = 0;
+
+		//! Writes a tile (32 bits image, transparent where no image is projected)
+		/** The tiles are written sequentially, row of tiles by row of tiles. The border tiles may be smaller.
+			\param x tile top-left corner position (in pixels, from the left of the mosaic)
+			\param y tile top-left corner position (in pixels, from the top of the mosaic)
+			\param tile tile image
+			\return success
+		**/
+		virtual bool writeTile(unsigned x, unsigned y, const QImage& tile) = 0;
+
+		//! Closes the output mosaic
+		virtual bool close() = 0;
+	};
+
+	//! Input image of an ortho-rectified mosaic (see OrthoRectifyAsMosaic)
+	struct MosaicImage
+	{
+		//! Image (if already in memory)
+		const ccImage* image = nullptr;
+		//! Image filename (if not in memory: the image is then only loaded when needed)
+		QString filename;
+		//! Image width (in pixels)
+		unsigned width = 0;
+		//! Image height (in pixels)
+		unsigned height = 0;
+		//! a0, a1 & a2 ortho-rectification parameters (see computeOrthoRectificationParams)
+		double a[3]{ 0.0, 0.0, 0.0 };
+		//! b0, b1 & b2 ortho-rectification parameters
+		double b[3]{ 0.0, 0.0, 0.0 };
+		//! c0(=1), c1 & c2 ortho-rectification parameters
+		double c[3]{ 1.0, 0.0, 0.0 };
+	};
+
+	//! Projective ortho-rectification of multiple images (as a single tiled mosaic)
+	/** The mosaic is computed tile by tile (the tiles of a same row are computed
+		in parallel). Only the images overlapping a tile are read to fill it, and
+		only one row of tiles is held in memory at a time. The images that are not
+		in memory are loaded when the first row of tiles they overlap is computed,
+		and released after the last one. Where several images overlap, the first
+		one (in the input order) prevails.
+		\param images input images (with their ortho-rectification parameters)
+		\param pixelSize mosaic pixel size (auto if <= 0: same resolution as the largest input image)
+		\param writer mosaic writer
+		\param tileSize tile size (in pixels)
+		\param progressCb progress callback (optional)
+		\return true if successful
+	**/
+	static bool OrthoRectifyAsMosaic(	const std::vector<MosaicImage>& images,
+										double pixelSize,
+										MosaicWriter& writer,
+										unsigned tileSize = 512,
+										CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
 	//! Computes ortho-rectification parameters for a given image
 	/** Requires at least 4 key points!
 		Collinearity equation:
@@ -0,0 +1,58 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_CLOUD_BATCHES_HEADER
+#define CC_CLOUD_BATCHES_HEADER
+
+//Local
+#include "qCC_db.h"
+
+//CCCoreLib
+#include <CCGeom.h>
+
+//system
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloud;
+}
+
+//! Tools to process the points of a cloud by spatially coherent batches
+class QCC_DB_LIB_API ccCloudBatches
+{
+public:
+
+	//! Max number of cells per dimension of the batching grid
+	static const int MAX_GRID_SIZE = (1 << 21) - 1;
+
+	//! Sorts the points of a cloud by batch (i.e. by cell of a regular grid)
+	/** The points of a same batch are close to each other, so that they share most of
+		their neighbors (e.g. the same octree cells can be extracted once per batch).
+		\param cloud input cloud
+		\param cellSize grid cell size (increased if the grid would have more than MAX_GRID_SIZE cells per dimension)
+		\param[out] sortedIndexes point indexes (sorted by batch)
+		\param[out] batchStarts start position of each batch in sortedIndexes (plus one last 'end' position)
+		\return false if not enough memory
+	**/
+	static bool BuildGridBatches(	CCCoreLib::GenericIndexedCloud* cloud,
+									PointCoordinateType cellSize,
+									std::vector<unsigned>& sortedIndexes,
+									std::vector<size_t>& batchStarts);
+};
+
+#endif //CC_CLOUD_BATCHES_HEADER
@@ -0,0 +1,140 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_FWF_DATA_CONTAINER_HEADER
+#define CC_FWF_DATA_CONTAINER_HEADER
+
+//Local
+#include "qCC_db.h"
+
+//Qt
+#include <QString>
+
+//system
+#include <cstdint>
+#include <vector>
+
+class QFile;
+
+//! Full WaveForm (FWF) raw data container
+/** The data is either stored in memory or memory-mapped from a file (e.g. the '.wdp' file
+	or the waveform EVLR of a LAS 1.3/1.4 file). In the latter case, the data is only read
+	(by the OS) when it is accessed, and only the accessed pages are kept in memory.
+
+	The mapped containers are registered by (canonical) file path, so that all the
+	containers mapped from a file can be detached from it before it is overwritten
+	(see DetachAllFromFile).
+
+	\warning A memory-mapped file must not be modified while it is mapped (see loadInMemory).
+	\warning Loading the data in memory (loadInMemory, DetachAllFromFile, resize or the
+	non-const version of data) changes the data address: the raw pointers previously
+	returned by data() (e.g. the storage of a ccWaveformProxy) are then invalid.
+**/
+class QCC_DB_LIB_API ccFWFDataContainer
+{
+public:
+
+	//! Default constructor (empty container, in memory)
+	ccFWFDataContainer() = default;
+
+	//! Constructor (in memory)
+	/** \warning May throw a std::bad_alloc exception
+	**/
+	explicit ccFWFDataContainer(size_t size);
+
+	//! Destructor
+	~ccFWFDataContainer();
+
+	//! Loads (a part of) a file
+	/** \param filename file name
+		\param offset offset of the data in the file (in bytes)
+		\param size size of the data (in bytes)
+		\param mapFile whether to memory-map the file (if possible) or to load the data in memory
+		\return success
+	**/
+	bool fromFile(const QString& filename, uint64_t offset, uint64_t size, bool mapFile = true);
+
+	//! Returns whether the data is memory-mapped from a file
+	inline bool isMapped() const { return m_map != nullptr; }
+
+	//! Returns whether the data is memory-mapped from a given file
+	bool isMappedFrom(const QString& filename) const;
+
+	//! Loads the memory-mapped data in memory (and releases the file)
+	/** Does nothing if the data is already in memory.
+		\warning Invalidates the pointers previously returned by data() (see the class description)
+		\return false if not enough memory
+	**/
+	bool loadInMemory();
+
+	//! Loads in memory the data of all the containers memory-mapped from a given file
+	/** Must be called before overwriting this file.
+		\warning Invalidates the pointers previously returned by data() for these containers
+		\return false if not enough memory
+	**/
+	static bool DetachAllFromFile(const QString& filename);
+
+	//! Gives access to the data
+	inline const uint8_t* data() const { return m_map ? m_map : m_memory.data(); }
+	//! Gives access to the data (for writing)
+	/** The memory-mapped data (if any) is first loaded in memory (see loadInMemory).
+		\return nullptr if the data couldn't be loaded in memory
+	**/
+	uint8_t* data();
+
+	//! Returns the data size (in bytes)
+	inline size_t size() const { return m_map ? m_mapSize : m_memory.size(); }
+
+	//! Returns whether the container is empty
+	inline bool empty() const { return size() == 0; }
+
+	//! Resizes the (in-memory) container
+	/** The memory-mapped data (if any) is first loaded in memory.
+		\warning May throw a std::bad_alloc exception
+	**/
+	void resize(size_t size);
+
+protected:
+
+	//! Releases the memory-mapped file (if any)
+	void unmap();
+
+	//! Releases the memory-mapped file (if any) without unregistering it
+	void releaseFile();
+
+	//! Copies the memory-mapped data in memory
+	bool copyMappedData();
+
+	//! In-memory data
+	std::vector<uint8_t> m_memory;
+	//! Memory-mapped file (if any)
+	QFile* m_file = nullptr;
+	//! Memory-mapped data (if any)
+	uint8_t* m_map = nullptr;
+	//! Memory-mapped data size
+	size_t m_mapSize = 0;
+	//! Canonical path of the memory-mapped file (registry key)
+	QString m_mappedPath;
+
+private:
+
+	//! The container is not copyable (the mapped data is owned)
+	ccFWFDataContainer(const ccFWFDataContainer&) = delete;
+	ccFWFDataContainer& operator=(const ccFWFDataContainer&) = delete;
+};
+
+#endif //CC_FWF_DATA_CONTAINER_HEADER
@@ -24,6 +24,15 @@
 
 //CCCoreLib
 #include <GenericCloud.h>
+#include <GenericIndexedCloud.h>
+
+//system
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
 
 class ccPointCloud;
 
@@ -79,11 +88,33 @@ public:
 	**/
 	unsigned char checkVisibility(const CCVector3& P) const override;
 
+	//! Determines the "visibility" of all the points of a cloud relatively to several sensors at once
+	/** The points are read only once and projected in parallel (see ccGBLSensor::checkVisibility).
+		A point is visible if at least one sensor sees it. Otherwise, its visibility is the
+		lowest visibility code returned by the sensors (as in ccPointCloud::testVisibility).
+		\param cloud a point cloud
+		\param sensors the sensors (with their depth buffer)
+		\param visibility output visibility values (one per point)
+		\param progressCb optional progress callback (the process can be cancelled)
+		\return false if not enough memory or if the process was cancelled
+	**/
+	static bool ComputeVisibility(	CCCoreLib::GenericIndexedCloud* cloud,
+									const std::vector<ccGBLSensor*>& sensors,
+									std::vector<unsigned char>& visibility,
+									CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
 	//! Computes angular parameters automatically (all but the angular steps!)
 	/** \warning this method uses the cloud global iterator.
 	**/
 	bool computeAutoParameters(CCCoreLib::GenericCloud* theCloud);
 
+	//! Error codes
+	enum Errors {	ERROR_BAD_INPUT      = -1,
+					ERROR_MEMORY         = -2,
+					ERROR_PROC_CANCELLED = -3,
+					ERROR_DB_TOO_SMALL   = -4,
+	};
+
 	//! Returns the error string corresponding to an error code
 	/** Errors codes are returned by ccGBLSensor::computeDepthBuffer or ccDepthBuffer::fillHoles for instance.
 	**/
@@ -212,6 +243,20 @@ public: //depth buffer management
 	**/
 	bool computeDepthBuffer(CCCoreLib::GenericCloud* cloud, int& errorCode, ccPointCloud* projectedCloud = nullptr);
 
+	//! Projects a point cloud along the points of view of several sensors at once
+	/** The points are read only once (by batches) and projected in parallel for each sensor.
+		\warning this method uses the cloud global iterator
+		\param cloud a point cloud
+		\param sensors the sensors
+		\param errorCode error code in case the method fails
+		\param projectedCloud optional cloud to store the projected points (only if there's a single sensor)
+		\return whether the depth buffers were successfully created or not
+	**/
+	static bool ComputeDepthBuffers(	CCCoreLib::GenericCloud* cloud,
+									const std::vector<ccGBLSensor*>& sensors,
+									int& errorCode,
+									ccPointCloud* projectedCloud = nullptr);
+
 	//! Returns the associated depth buffer
 	/** Call ccGBLSensor::computeDepthBuffer first otherwise the returned buffer will be 0.
 	**/
@@ -231,6 +276,33 @@ protected:
 	//! Converts 2D angular coordinates (yaw,pitch) in integer depth buffer coordinates
 	bool convertToDepthMapCoords(PointCoordinateType yaw, PointCoordinateType pitch, unsigned& i, unsigned& j) const;
 
+	//! Returns the world to sensor transformation
+	/** \param posIndex sensor position index (see ccIndexedTransformationBuffer)
+	**/
+	ccGLMatrix getWorldToSensorTransformation(double posIndex) const;
+
+	//! Projects a point (already expressed in the sensor frame) in the sensor world
+	void projectInSensorFrame(const CCVector3& P, CCVector2& destPoint, PointCoordinateType& depth) const;
+
+	//! Projects a set of points in the sensor world (in parallel)
+	/** \param points points to project
+		\param count number of points
+		\param worldToSensor world to sensor transformation (see getWorldToSensorTransformation)
+		\param destPoints projected points (output, same size as the input points)
+		\param depths depth of each point (output, same size as the input points)
+	**/
+	void projectPoints(	const CCVector3* points,
+						unsigned count,
+						const ccGLMatrix& worldToSensor,
+						CCVector2* destPoints,
+						PointCoordinateType* depths) const;
+
+	//! Initializes the depth buffer (with the current angular parameters)
+	bool initDepthBuffer(int& errorCode);
+
+	//! Determines the "visibility" of a point already projected in the sensor world
+	unsigned char checkProjectedVisibility(const CCVector2& Q, PointCoordinateType depth) const;
+
 	//! Minimal pitch limit (in radians)
 	/** Phi = 0 corresponds to the scanner vertical direction (upward) **/
 	PointCoordinateType m_phiMin;
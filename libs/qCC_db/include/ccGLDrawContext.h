@@ -112,7 +112,7 @@ struct ccGLDrawContext
 	bool decimateCloudOnMove;
 	//! Minimum number of points for activating LOD display
 	unsigned minLODPointCount;
-	//! Current level for LOD display
+	//! Current level for LOD display (i.e. index of the current refinement pass)
 	unsigned char currentLODLevel;
 	//! Whether more points are available or not at the current level
 	bool moreLODPointsAvailable;
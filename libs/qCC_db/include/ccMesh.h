@@ -26,6 +26,8 @@
 
 class ccProgressDialog;
 class ccPolyline;
+class ccScalarField;
+class QOpenGLBuffer;
 
 //! Triangular mesh
 class QCC_DB_LIB_API ccMesh : public ccGenericMesh
@@ -408,6 +410,21 @@ public:
 	//! Merges duplicated vertices
 	bool mergeDuplicatedVertices(unsigned char octreeLevel = DefaultMergeDuplicateVerticesLevel, QWidget* parentWidget = nullptr);
 
+	//! Notify a modification of the triangles (vertex indexes)
+	/** Automatically called by notifyGeometryUpdate.
+	**/
+	inline void trianglesHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_TRIANGLES; }
+
+	//! Release VBOs
+	void releaseVBOs();
+
+	//! Returns the VBOs size (if any)
+	size_t vboSize() const;
+
+	//inherited from ccDrawableObject
+	void setDisplay(ccGenericGLDisplay* win) override;
+	void removeFromDisplay(const ccGenericGLDisplay* win) override; //for proper VBO release
+
 protected: //methods
 
 	//inherited from ccHObject
@@ -418,6 +435,7 @@ protected: //methods
 	void applyGLTransformation(const ccGLMatrix& trans) override;
 	void onUpdateOf(ccHObject* obj) override;
 	void onDeletionOf(const ccHObject* obj) override;
+	void notifyGeometryUpdate() override;
 
 	//! Same as other 'computeInterpolationWeights' method with a set of 3 vertices indexes
 	void computeInterpolationWeights(const CCCoreLib::VerticesIndexes& vertIndexes, const CCVector3& P, CCVector3d& weights) const;
@@ -496,6 +514,76 @@ protected: //members
 	//! Mesh normals indexes (per-triangle)
 	triangleNormalsIndexesSet* m_triNormalIndexes;
 
+protected: // VBO
+
+	//! Init/updates VBOs
+	/** The vertices features (points, colors and normals) are stored once in a vertex
+		buffer, and the triangles in an index buffer. Only the modified (or newly
+		displayed) features are sent again to the GPU.
+		\return whether the VBOs can be used for the display
+	**/
+	bool updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams& glParams);
+
+	//! VBO set
+	struct vboSet
+	{
+		//! States of the VBO(s)
+		enum STATES { NEW, INITIALIZED, FAILED };
+
+		//! Update flags
+		enum UPDATE_FLAGS {
+			UPDATE_POINTS = 1,
+			UPDATE_COLORS = 2,
+			UPDATE_NORMALS = 4,
+			UPDATE_TRIANGLES = 8,
+			UPDATE_ALL = UPDATE_POINTS | UPDATE_COLORS | UPDATE_NORMALS | UPDATE_TRIANGLES
+		};
+
+		vboSet()
+			: vertices(nullptr)
+			, indexes(nullptr)
+			, vertexCount(0)
+			, triangleCount(0)
+			, rgbShift(0)
+			, normalShift(0)
+			, hasColors(false)
+			, colorIsSF(false)
+			, sourceSF(nullptr)
+			, hasNormals(false)
+			, pointsVersion(0)
+			, colorsVersion(0)
+			, normalsVersion(0)
+			, totalMemSizeBytes(0)
+			, updateFlags(0)
+			, state(NEW)
+		{}
+
+		//! Vertex buffer (points, then colors and normals if any)
+		QOpenGLBuffer* vertices;
+		//! Index buffer (3 vertex indexes per triangle)
+		QOpenGLBuffer* indexes;
+		unsigned vertexCount;
+		size_t triangleCount;
+		int rgbShift;
+		int normalShift;
+		bool hasColors;
+		bool colorIsSF;
+		ccScalarField* sourceSF;
+		bool hasNormals;
+		//! Versions of the vertices features when they were sent to the GPU (see ccPointCloud::getFeatureVersions)
+		unsigned pointsVersion;
+		unsigned colorsVersion;
+		unsigned normalsVersion;
+		size_t totalMemSizeBytes;
+		int updateFlags;
+
+		//! Current state
+		STATES state;
+	};
+
+	//! Set of VBOs attached to this mesh
+	vboSet m_vboManager;
+
 private:
 	//! Copy of a ccMesh instance is not supported (because of all the pointers to the members)
 	ccMesh(const ccMesh&) {}
@@ -0,0 +1,135 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_MULTI_CAMERA_COLORIZER_HEADER
+#define CC_MULTI_CAMERA_COLORIZER_HEADER
+
+//Local
+#include "qCC_db.h"
+
+//Qt
+#include <QString>
+
+//system
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
+
+class ccCameraSensor;
+class ccImage;
+class ccPointCloud;
+
+//! Colorizes a point cloud from a set of oriented images (camera sensors)
+/** The cameras are indexed with a coarse grid over the cloud (each occupied cell
+	stores the cameras whose field of view may contain it). For each camera, a depth
+	map is built from the points of its cells (to handle occlusions). Each point then
+	takes the color of the best image (the closest and most frontal one) or a blend
+	of all the images seeing it.
+
+	The cameras are processed by chunks, in parallel. Only the images of the current
+	chunk are decoded (and only when they are needed), so that the memory stays bounded
+	whatever the number of cameras.
+**/
+class QCC_DB_LIB_API ccMultiCameraColorizer
+{
+public:
+
+	//! Colorization mode
+	enum Mode
+	{
+		BEST_IMAGE, //!< each point takes the color of the best image
+		BLEND		//!< each point takes the weighted average color of all the images seeing it
+	};
+
+	//! Colorization parameters
+	struct Parameters
+	{
+		//! Colorization mode
+		Mode mode = BEST_IMAGE;
+		//! Whether to test occlusions (with a depth map per camera)
+		bool testOcclusions = true;
+		//! Relative depth tolerance for the occlusion test
+		float depthTolerance = 0.02f;
+		//! Max depth map dimension (width or height)
+		/** The depth map has the same aspect ratio as the image.
+		**/
+		unsigned depthMapMaxSize = 1024;
+		//! Whether to use the normals (if any) to favor the most frontal images
+		bool useNormals = true;
+		//! Max number of decoded images in memory (0 = as many as the number of threads)
+		unsigned maxDecodedImages = 0;
+		//! Max number of threads (0 = all cores)
+		int maxThreadCount = 0;
+	};
+
+	//! Default constructor
+	ccMultiCameraColorizer() = default;
+
+	//! Adds a camera with an image already in memory
+	/** \param sensor camera sensor
+		\param image image (with the same dimensions as the sensor array)
+		\return false if the sensor or the image is invalid
+	**/
+	bool addCamera(ccCameraSensor* sensor, const ccImage* image);
+
+	//! Adds a camera with an image file (decoded on demand)
+	/** \param sensor camera sensor
+		\param imageFilename image filename
+		\return false if the sensor is invalid
+	**/
+	bool addCamera(ccCameraSensor* sensor, const QString& imageFilename);
+
+	//! Returns the number of cameras
+	inline size_t cameraCount() const { return m_cameras.size(); }
+
+	//! Colorizes a point cloud
+	/** The points not seen by any camera (or whose best image can't be read)
+		keep their previous color (or are set to black if the cloud had no color).
+		\param cloud point cloud
+		\param params colorization parameters
+		\param errorMessage error message (if any)
+		\param colorizedCount number of colorized points (output, optional)
+		\param progressCb progress callback (optional)
+		\return success
+	**/
+	bool colorize(	ccPointCloud* cloud,
+					const Parameters& params,
+					QString& errorMessage,
+					unsigned* colorizedCount = nullptr,
+					CCCoreLib::GenericProgressCallback* progressCb = nullptr) const;
+
+protected:
+
+	//! Camera
+	struct Camera
+	{
+		//! Camera sensor
+		ccCameraSensor* sensor = nullptr;
+		//! Image (if already in memory)
+		const ccImage* image = nullptr;
+		//! Image filename (otherwise)
+		QString imageFilename;
+	};
+
+	//! Cameras
+	std::vector<Camera> m_cameras;
+};
+
+#endif //CC_MULTI_CAMERA_COLORIZER_HEADER
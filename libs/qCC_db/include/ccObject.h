@@ -25,6 +25,9 @@
 #include <QSharedPointer>
 #include <QVariant>
 
+//System
+#include <atomic>
+
 
 //! Object state flag
 enum CC_OBJECT_FLAG {	//CC_UNUSED			= 1, //DGM: not used anymore (former CC_FATHER_DEPENDENT)
@@ -163,14 +166,22 @@ public:
 	//! Resets the unique ID
 	void reset() { m_lastUniqueID = MinUniqueID; }
 	//! Returns a (new) unique ID
+	/** \remark Thread-safe (entities can be created by parallel processes)
+	**/
 	unsigned fetchOne() { return ++m_lastUniqueID; }
 	//! Returns the value of the last generated unique ID
 	unsigned getLast() const { return m_lastUniqueID; }
 	//! Updates the value of the last generated unique ID with the current one
-	void update(unsigned ID) { if (ID > m_lastUniqueID) m_lastUniqueID = ID; }
+	void update(unsigned ID)
+	{
+		unsigned lastID = m_lastUniqueID;
+		while (ID > lastID && !m_lastUniqueID.compare_exchange_weak(lastID, ID))
+		{
+		}
+	}
 
 protected:
-	unsigned m_lastUniqueID;
+	std::atomic<unsigned> m_lastUniqueID;
 };
 
 //! Generic "CloudCompare Object" template
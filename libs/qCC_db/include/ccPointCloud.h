@@ -27,6 +27,7 @@
 
 //Local
 #include "ccColorScale.h"
+#include "ccFWFDataContainer.h"
 #include "ccNormalVectors.h"
 #include "ccWaveform.h"
 
@@ -161,11 +162,25 @@ public: //features deletion/clearing
 	void unallocateNorms();
 
 	//! Notify a modification of color / scalar field display parameters or contents
-	inline void colorsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_COLORS; }
+	inline void colorsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_COLORS; ++m_featureVersions.colors; }
 	//! Notify a modification of normals display parameters or contents
-	inline void normalsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_NORMALS; decompressNormals();}
+	inline void normalsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_NORMALS; ++m_featureVersions.normals; decompressNormals();}
 	//! Notify a modification of points display parameters or contents
-	inline void pointsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_POINTS; }
+	inline void pointsHaveChanged() { m_vboManager.updateFlags |= vboSet::UPDATE_POINTS; ++m_featureVersions.points; }
+
+	//! Versions of the displayed features
+	/** Each version is incremented when the corresponding feature is modified.
+		Used by the entities that display the cloud data with their own VBOs (e.g. meshes).
+	**/
+	struct FeatureVersions
+	{
+		unsigned points = 0;
+		unsigned colors = 0;
+		unsigned normals = 0;
+	};
+
+	//! Returns the versions of the displayed features
+	inline const FeatureVersions& getFeatureVersions() const { return m_featureVersions; }
 
 public: //features allocation/resize
 
@@ -406,8 +421,8 @@ public: //waveform (e.g. from airborne scanners)
 	//! Waveform descriptors set
 	using FWFDescriptorSet = QMap<uint8_t, WaveformDescriptor>;
 
-	//! Waveform data container
-	using FWFDataContainer = std::vector<uint8_t>;
+	//! Waveform data container (in memory or memory-mapped from a file)
+	using FWFDataContainer = ccFWFDataContainer;
 	using SharedFWFDataContainer = QSharedPointer<const FWFDataContainer>;
 
 	//! Gives access to the FWF descriptors
@@ -431,12 +446,13 @@ public: //waveform (e.g. from airborne scanners)
 	const SharedFWFDataContainer& fwfData() const { return m_fwfData; }
 
 	//! Compresses the associated FWF data container
-	/** As the container is shared, the compressed version will be potentially added to the memory
+	/** Only the byte ranges used by the waveforms are kept (they are copied in parallel).
+		As the container is shared, the compressed version will be potentially added to the memory
 		resulting in a decrease of the available memory...
 	**/
 	bool compressFWFData();
 
-	//! Computes the maximum amplitude of all associated waveforms
+	//! Computes the maximum amplitude of all associated waveforms (in parallel)
 	bool computeFWFAmplitude(double& minVal, double& maxVal, ccProgressDialog* pDlg = nullptr) const;
 
 	//! Clears all associated FWF data
@@ -628,6 +644,35 @@ public: //other methods
 		double blendGrayscalePercent = 0.5;
 	};
 
+	//! Spatial filter parameters (see applySpatialFilter)
+	struct SpatialFilterParameters
+	{
+		//! Spatial sigma (the neighbourhood radius is 3 * sigma)
+		PointCoordinateType sigma = 0;
+		//! Scalar sigma (if strictly positive, a bilateral filter is applied)
+		PointCoordinateType sigmaSF = 0;
+		//! Guide scalar field (bilateral filter only)
+		const CCCoreLib::ScalarField* guideSF = nullptr;
+		//! Filter options (filter type, burnt-out color threshold, grayscale blending)
+		RgbFilterOptions options;
+		//! Whether to filter the RGB colors
+		bool filterRGB = false;
+		//! Scalar fields to filter (input, output)
+		/** The output scalar field can be the input one (the original values are then read from a copy).
+			The output values are set to NaN where no valid neighbour is found.
+		**/
+		std::vector< std::pair<const CCCoreLib::ScalarField*, CCCoreLib::ScalarField*> > scalarFields;
+	};
+
+	//! Applies a spatial filter (Gaussian, bilateral, mean or median) on RGB colors and/or several scalar fields at once
+	/** The octree is traversed only once, whatever the number of filtered fields. The candidate neighbours
+		are extracted once per octree cell and shared by all the points of the cell.
+		\param params filter parameters
+		\param progressCb the client application can get some notification of the process progress through this callback mechanism (see GenericProgressCallback)
+		\return success
+	**/
+	bool applySpatialFilter(const SpatialFilterParameters& params, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
 	//! Applies a spatial Gaussian filter on RGB colors
 	/** The "amplitutde" of the Gaussian filter must be specified (sigma).
 		As 99% of the Gaussian distribution is between -3*sigma and +3*sigma around the mean value,
@@ -933,6 +978,12 @@ protected: // VBO
 	//! Set of VBOs attached to this cloud
 	vboSet m_vboManager;
 
+	//! Versions of the displayed features (see getFeatureVersions)
+	FeatureVersions m_featureVersions;
+
+	//! Increments the versions of all the displayed features
+	inline void featuresHaveChanged() { ++m_featureVersions.points; ++m_featureVersions.colors; ++m_featureVersions.normals; }
+
 	//per-block data transfer to the GPU (VBO or standard mode)
 	void glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkColorPointer (const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
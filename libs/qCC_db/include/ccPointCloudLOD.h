@@ -31,6 +31,7 @@
 
 class ccPointCloud;
 class ccPointCloudLODThread;
+struct ccGLCameraParameters;
 
 //! Level descriptor
 struct LODLevelDesc
@@ -175,6 +176,27 @@ public:
 	//! Returns whether all points have been displayed or not
 	inline bool allDisplayed() const { return m_currentState.displayedPoints >= m_currentState.visiblePoints; }
 
+	//! Starts a new traversal of the visible cells, driven by their screen-space error
+	/** Automatically calls flagVisibility. The cells are then refined (see getNextIndexMap) by
+		order of decreasing screen-space error, i.e. the estimated spacing (in pixels) between the
+		displayed points of the cell. The cells for which this spacing is below the target spacing
+		are not refined anymore (so that far regions don't get as many points as near ones).
+		\param camera camera parameters (with the current OpenGL matrices and viewport)
+		\param targetSpacing_pix target spacing between the displayed points (in pixels)
+		\param clipPlanes optional clipping planes
+		\return the number of visible points
+	**/
+	uint32_t initTraversal(const ccGLCameraParameters& camera, float targetSpacing_pix, ccClipPlaneSet* clipPlanes = nullptr);
+
+	//! Builds an index map with the next points to display (see initTraversal)
+	/** \param maxCount max number of points for this pass (input) / actual number of points in the map (output)
+		\return the index map
+	**/
+	LODIndexSet& getNextIndexMap(unsigned& maxCount);
+
+	//! Returns whether the current traversal is finished (i.e. the target spacing is reached everywhere)
+	inline bool traversalFinished() const { return m_traversal.queue.empty(); }
+
 	//! Returns the memory used by the structure (in bytes)
 	size_t memory() const;
 
@@ -207,6 +229,12 @@ protected: //methods
 	//! Adds a given number of points to the active index map (should be dispatched among the children cells)
 	uint32_t addNPointsToIndexMap(Node& node, uint32_t count);
 
+	//! Returns the projected size (diameter) of a cell (in pixels) for the current traversal
+	float projectedSize(const Node& node) const;
+
+	//! Queues a cell for the current traversal (if it still needs to be refined)
+	void queueNode(const Node& node, int32_t index, bool force = false);
+
 protected: //members
 
 	//! Level data
@@ -241,6 +269,45 @@ protected: //members
 	//! Current rendering state
 	RenderParams m_currentState;
 
+	//! Queued cell (screen-space error driven traversal)
+	struct QueuedNode
+	{
+		//! Screen-space error (estimated spacing between the displayed points, in pixels)
+		float error;
+		//! Cell index
+		int32_t index;
+		//! Cell level
+		uint8_t level;
+
+		//! Comparison operator (for the max-heap)
+		inline bool operator < (const QueuedNode& other) const { return error < other.error; }
+	};
+
+	//! Screen-space error driven traversal
+	struct Traversal
+	{
+		Traversal()
+			: wRow{0.0, 0.0, 0.0, 1.0}
+			, pixelScale(1.0)
+			, targetSpacing_pix(1.0f)
+			, perspective(false)
+		{}
+
+		//! Cells to refine (max-heap, sorted by decreasing screen-space error)
+		std::vector<QueuedNode> queue;
+		//! 4th row of the (projection x model view) matrix (to compute the 'w' clip coordinate)
+		double wRow[4];
+		//! Scale to convert a size in clip space to pixels
+		double pixelScale;
+		//! Target spacing between the displayed points (in pixels)
+		float targetSpacing_pix;
+		//! Whether the camera is in perspective mode
+		bool perspective;
+	};
+
+	//! Current traversal
+	Traversal m_traversal;
+
 	//! Index map
 	LODIndexSet m_indexMap;
 
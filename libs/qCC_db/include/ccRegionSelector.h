@@ -0,0 +1,139 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_REGION_SELECTOR_HEADER
+#define CC_REGION_SELECTOR_HEADER
+
+//Always first
+#include "ccGenericGLDisplay.h"
+
+//Local
+#include "ccBBox.h"
+
+//system
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloud;
+}
+
+class ccGenericPointCloud;
+
+//! Selects the points of a cloud falling inside (or outside) a region
+/** If the cloud has an octree (e.g. the one built for the LOD display), the octree cells
+	are classified from the root cell down as being fully inside, fully outside or straddling
+	the region. Only the points of the (smallest) straddling cells are tested individually.
+	Otherwise, all the points are tested.
+**/
+class QCC_DB_LIB_API ccRegionSelector
+{
+public:
+
+	//! Position of an octree cell relatively to a region
+	enum CellPosition { CELL_OUTSIDE, CELL_INSIDE, CELL_STRADDLING };
+
+	//! Region
+	class QCC_DB_LIB_API Region
+	{
+	public:
+		//! Destructor
+		virtual ~Region() = default;
+
+		//! Classifies an (axis-aligned) octree cell
+		/** The classification must be conservative: if unsure, the cell should be
+			considered as straddling the region.
+		**/
+		virtual CellPosition classifyCell(const CCVector3& cellMin, const CCVector3& cellMax) const = 0;
+
+		//! Returns whether a point is inside the region
+		/** \warning Must be thread-safe
+		**/
+		virtual bool isInside(const CCVector3& P) const = 0;
+	};
+
+	//! Axis-aligned box region
+	class QCC_DB_LIB_API BoxRegion : public Region
+	{
+	public:
+		//! Default constructor
+		explicit BoxRegion(const ccBBox& box);
+
+		//inherited from Region
+		CellPosition classifyCell(const CCVector3& cellMin, const CCVector3& cellMax) const override;
+		bool isInside(const CCVector3& P) const override;
+
+	protected:
+		//! Box
+		ccBBox m_box;
+	};
+
+	//! Screen polygon region (i.e. the prism defined by a 2D polygon and the camera viewing rays)
+	class QCC_DB_LIB_API ScreenPolygonRegion : public Region
+	{
+	public:
+		//! Default constructor
+		/** \param camera camera parameters
+			\param polygon polygon vertices (in pixels, relatively to the viewport center)
+			\param skipPointsOutsideFrustum whether the points outside of the camera frustum should be considered as outside
+		**/
+		ScreenPolygonRegion(const ccGLCameraParameters& camera,
+							const CCCoreLib::GenericIndexedCloud* polygon,
+							bool skipPointsOutsideFrustum);
+
+		//inherited from Region
+		CellPosition classifyCell(const CCVector3& cellMin, const CCVector3& cellMax) const override;
+		bool isInside(const CCVector3& P) const override;
+
+	protected:
+		//! Returns whether a polygon edge intersects a 2D (axis-aligned) rectangle or not
+		bool edgeIntersectsRect(unsigned edgeIndex, const CCVector2d& rectMin, const CCVector2d& rectMax) const;
+
+		//! Camera parameters
+		ccGLCameraParameters m_camera;
+		//! Polygon
+		const CCCoreLib::GenericIndexedCloud* m_polygon;
+		//! Polygon vertices
+		std::vector<CCVector2d> m_vertices;
+		//! Polygon bounding-box (min corner)
+		CCVector2d m_polyMin;
+		//! Polygon bounding-box (max corner)
+		CCVector2d m_polyMax;
+		//! Whether the points outside of the camera frustum should be considered as outside
+		bool m_skipPointsOutsideFrustum;
+		//! Half viewport width
+		double m_halfW;
+		//! Half viewport height
+		double m_halfH;
+		//! 4th row of the (projection x model view) matrix (to compute the 'w' clip coordinate)
+		double m_wRow[4];
+	};
+
+	//! Selects the points of a cloud falling inside (or outside) a region
+	/** \param cloud input cloud
+		\param region region
+		\param indexes output point indexes (in no particular order)
+		\param inside whether to select the points inside or outside the region
+		\return false if not enough memory
+	**/
+	static bool Select(	ccGenericPointCloud* cloud,
+						const Region& region,
+						std::vector<unsigned>& indexes,
+						bool inside = true);
+};
+
+#endif //CC_REGION_SELECTOR_HEADER
@@ -158,6 +158,8 @@ protected: //members
 
 //! Waveform proxy
 /** For easier access to the waveform data
+	\warning The proxy keeps a raw pointer on the FWF data storage: it must not be kept
+	after the storage has been loaded in memory (see ccFWFDataContainer::loadInMemory)
 **/
 class QCC_DB_LIB_API ccWaveformProxy
 {
@@ -27,11 +27,21 @@
 
 //CCCoreLib
 #include <ConjugateGradient.h>
+#include <GenericProgressCallback.h>
 
 //Qt
 #include <QDir>
 #include <QTextStream>
 
+//system
+#include <atomic>
+#include <limits>
+
+#if defined(_OPENMP)
+//OpenMP
+#include <omp.h>
+#endif
+
 ccCameraSensor::IntrinsicParameters::IntrinsicParameters()
 	: vertFocal_pix(1.0f)
 	, skew(0)
@@ -1789,6 +1799,100 @@ bool ccCameraSensor::computeOrthoRectificationParams(	const ccImage* image,
 	return true;
 }
 
+//! Computes the corners of an ortho-rectified image (projective ortho-rectification)
+/** \param a a0, a1 & a2 parameters
+	\param b b0, b1 & b2 parameters
+	\param c c0(=1), c1 & c2 parameters
+	\param width image width
+	\param height image height
+	\param[out] corners top-left, top-right, bottom-right and bottom-left 3D corners (4*2 values)
+	\param[out] minC 3D min corner (2 values)
+	\param[out] maxC 3D max corner (2 values)
+**/
+static void ComputeOrthoRectifiedCorners(	const double a[3], const double b[3], const double c[3],
+											unsigned width, unsigned height,
+											double corners[8], double minC[2], double maxC[2])
+{
+	const double halfWidth = width / 2.0;
+	const double halfHeight = height / 2.0;
+	const double imageCorners[8] = {	-halfWidth, -halfHeight,
+										 halfWidth, -halfHeight,
+										 halfWidth,  halfHeight,
+										-halfWidth,  halfHeight };
+
+	for (unsigned k = 0; k < 4; ++k)
+	{
+		double xi = imageCorners[2 * k];
+		double yi = imageCorners[2 * k + 1];
+		double qi = 1.0 + c[1] * xi + c[2] * yi;
+		corners[2 * k] = (a[0] + a[1] * xi + a[2] * yi) / qi;
+		corners[2 * k + 1] = (b[0] + b[1] * xi + b[2] * yi) / qi;
+	}
+
+	//we look for min and max bounding box
+	minC[0] = maxC[0] = corners[0];
+	minC[1] = maxC[1] = corners[1];
+	for (unsigned k = 1; k < 4; ++k)
+	{
+		const double* C = corners + 2 * k;
+		minC[0] = std::min(minC[0], C[0]);
+		maxC[0] = std::max(maxC[0], C[0]);
+		minC[1] = std::min(minC[1], C[1]);
+		maxC[1] = std::max(maxC[1], C[1]);
+	}
+}
+
+//! Inverse projective ortho-rectification (ortho-rectified 3D coordinates to image coordinates, relatively to the image center)
+static inline void OrthoRectifiedToImageCoords(	const double a[3], const double b[3], const double c[3],
+												double xip, double yip,
+												double& xi, double& yi)
+{
+	double q = (c[2] * xip - a[2]) * (c[1] * yip - b[1]) - (c[2] * yip - b[2]) * (c[1] * xip - a[1]);
+	double p = (a[0] - xip) * (c[1] * yip - b[1]) - (b[0] - yip) * (c[1] * xip - a[1]);
+	yi = p / q;
+
+	q = (c[1] * xip - a[1]) * (c[2] * yip - b[2]) - (c[1] * yip - b[1]) * (c[2] * xip - a[2]);
+	p = (a[0] - xip) * (c[2] * yip - b[2]) - (b[0] - yip) * (c[2] * xip - a[2]);
+	xi = p / q;
+}
+
+//! Returns the color of an image pixel (pure black pixels are treated as transparent ones!)
+static inline QRgb GetOrthoPixel(const QImage& image, int x, int y)
+{
+	QRgb rgb = image.pixel(x, y);
+	return ((rgb & RGB_MASK) != 0 ? rgb : qRgba(0, 0, 0, 0));
+}
+
+//! Fills an ortho-rectified image (the rows are processed in parallel)
+/** \param orthoImage output image (32 bits)
+	\param minC 3D min corner of the output image (2 values)
+	\param pixelSize pixel size
+	\param sampler functor returning the color of the ortho-rectified image at a given (3D) position
+**/
+template <class Sampler> static void FillOrthoImage(QImage& orthoImage, const double minC[2], double pixelSize, const Sampler& sampler)
+{
+	const int w = orthoImage.width();
+	const int h = orthoImage.height();
+
+	//QImage::scanLine may detach the image: we only access the raw data in the parallel loop
+	uchar* bits = orthoImage.bits();
+	const size_t bytesPerLine = static_cast<size_t>(orthoImage.bytesPerLine());
+
+#if defined(_OPENMP)
+	#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int j = 0; j < h; ++j)
+	{
+		double yip = minC[1] + static_cast<double>(j) * pixelSize;
+		//the image rows are stored from top to bottom
+		QRgb* line = reinterpret_cast<QRgb*>(bits + static_cast<size_t>(h - 1 - j) * bytesPerLine);
+		for (int i = 0; i < w; ++i)
+		{
+			line[i] = sampler(minC[0] + static_cast<double>(i) * pixelSize, yip);
+		}
+	}
+}
+
 ccImage* ccCameraSensor::orthoRectifyAsImageDirect(	const ccImage* image,
 													PointCoordinateType Z0,
 													double& pixelSize,
@@ -1916,34 +2020,35 @@ ccImage* ccCameraSensor::orthoRectifyAsImageDirect(	const ccImage* image,
 	if (orthoImage.isNull()) //not enough memory!
 		return nullptr;
 
-	const QRgb blackValue = qRgb(0, 0, 0);
+	//the sensor position is only retrieved once (instead of once per pixel)
+	//as before, if it's not available (can't happen here, as the corners already required it) the pixels are left transparent
+	ccIndexedTransformation trans;
+	const bool hasPose = getActiveAbsoluteTransformation(trans);
+	assert(hasPose);
+	const ccGLMatrix globalToLocal = trans.inverse();
+
+	const QImage& sourceImage = image->data();
 	const QRgb blackAlphaZero = qRgba(0, 0, 0, 0);
 
-	for (unsigned i = 0; i < w; ++i)
+	FillOrthoImage(orthoImage, minC, _pixelSize, [&](double xip, double yip)
 	{
-		PointCoordinateType xip = static_cast<PointCoordinateType>(minC[0] + i*_pixelSize);
-		for (unsigned j = 0; j < h; ++j)
-		{
-			PointCoordinateType yip = static_cast<PointCoordinateType>(minC[1] + j*_pixelSize);
+		CCVector3 P3D(static_cast<PointCoordinateType>(xip), static_cast<PointCoordinateType>(yip), Z0);
+		globalToLocal.apply(P3D);
 
-			QRgb rgb = blackValue; //output pixel is (transparent) black by default
-
-			CCVector3 P3D(xip,yip,Z0);
-			CCVector2 imageCoord;
-			if (fromGlobalCoordToImageCoord(P3D,imageCoord,undistortImages))
+		CCVector2 imageCoord;
+		if (hasPose && fromLocalCoordToImageCoord(P3D, imageCoord, undistortImages))
+		{
+			int x = static_cast<int>(imageCoord.x);
+			int y = static_cast<int>(imageCoord.y);
+			if (x >= 0 && x < width && y >= 0 && y < height)
 			{
-				int x = static_cast<int>(imageCoord.x);
-				int y = static_cast<int>(imageCoord.y);
-				if (x >= 0 && x < width && y >= 0 && y < height)
-				{
-					rgb = image->data().pixel(x,y);
-				}
+				return GetOrthoPixel(sourceImage, x, y);
 			}
-
-			//pure black pixels are treated as transparent ones!
-			orthoImage.setPixel(i, h - 1 - j, rgb != blackValue ? rgb : blackAlphaZero);
 		}
-	}
+
+		//output pixel is (transparent) black by default
+		return blackAlphaZero;
+	});
 
 	//output pixel size (auto)
 	pixelSize = _pixelSize;
@@ -1968,78 +2073,34 @@ ccImage* ccCameraSensor::orthoRectifyAsImage(	const ccImage* image,
 		return nullptr;
 	}
 
-	const double& a0 = a[0];
-	const double& a1 = a[1];
-	const double& a2 = a[2];
-	const double& b0 = b[0];
-	const double& b1 = b[1];
-	const double& b2 = b[2];
-	//const double& c0 = c[0];
-	const double& c1 = c[1];
-	const double& c2 = c[2];
-
-	//first, we compute the ortho-rectified image corners
-	double corners[8];
-	double xi;
-	double yi;
-	double qi;
+	return orthoRectifyAsImage(image, a, b, c, pixelSize, minCorner, maxCorner, realCorners);
+}
 
+ccImage* ccCameraSensor::orthoRectifyAsImage(	const ccImage* image,
+												const double a[3],
+												const double b[3],
+												const double c[3],
+												double& pixelSize,
+												double* minCorner/*=nullptr*/,
+												double* maxCorner/*=nullptr*/,
+												double* realCorners/*=nullptr*/) const
+{
 	int width = static_cast<int>(image->getW());
 	int height = static_cast<int>(image->getH());
 	double halfWidth = width / 2.0;
 	double halfHeight = height / 2.0;
 
-	//top-left
-	xi = -halfWidth;
-	yi = -halfHeight;
-	qi = 1.0 + c1 * xi + c2 * yi;
-	corners[0] = (a0 + a1 * xi + a2 * yi) / qi;
-	corners[1] = (b0 + b1 * xi + b2 * yi) / qi;
-
-	//top-right
-	xi = halfWidth;
-	yi = -halfHeight;
-	qi = 1.0 + c1 * xi + c2 * yi;
-	corners[2] = (a0 + a1 * xi + a2 * yi) / qi;
-	corners[3] = (b0 + b1 * xi + b2 * yi) / qi;
-
-	//bottom-right
-	xi = halfWidth;
-	yi = halfHeight;
-	qi = 1.0 + c1 * xi + c2 * yi;
-	corners[4] = (a0 + a1 * xi + a2 * yi) / qi;
-	corners[5] = (b0 + b1 * xi + b2 * yi) / qi;
-
-	//bottom-left
-	xi = -halfWidth;
-	yi = halfHeight;
-	qi = 1.0 + c1 * xi + c2 * yi;
-	corners[6] = (a0 + a1 * xi + a2 * yi) / qi;
-	corners[7] = (b0 + b1 * xi + b2 * yi) / qi;
+	//first, we compute the ortho-rectified image corners
+	double corners[8];
+	double minC[2];
+	double maxC[2];
+	ComputeOrthoRectifiedCorners(a, b, c, image->getW(), image->getH(), corners, minC, maxC);
 
 	if (realCorners)
 	{
 		memcpy(realCorners, corners, 8 * sizeof(double));
 	}
 
-	//we look for min and max bounding box
-	double minC[2] = { corners[0], corners[1] };
-	double maxC[2] = { corners[0], corners[1] };
-
-	for (unsigned k = 1; k < 4; ++k)
-	{
-		const double* C = corners + 2 * k;
-		if (minC[0] > C[0])
-			minC[0] = C[0];
-		else if (maxC[0] < C[0])
-			maxC[0] = C[0];
-
-		if (minC[1] > C[1])
-			minC[1] = C[1];
-		else if (maxC[1] < C[1])
-			maxC[1] = C[1];
-	}
-
 	//output 3D boundaries (optional)
 	if (minCorner)
 	{
@@ -2068,41 +2129,25 @@ ccImage* ccCameraSensor::orthoRectifyAsImage(	const ccImage* image,
 	if (orthoImage.isNull()) //not enough memory!
 		return nullptr;
 
-	const QRgb blackValue = qRgb(0, 0, 0);
+	const QImage& sourceImage = image->data();
 	const QRgb blackAlphaZero = qRgba(0, 0, 0, 0);
 
-	for (unsigned i = 0; i < w; ++i)
+	FillOrthoImage(orthoImage, minC, _pixelSize, [&](double xip, double yip)
 	{
-		double xip = minC[0] + static_cast<double>(i)*_pixelSize;
-		for (unsigned j = 0; j < h; ++j)
-		{
-			QRgb rgb = blackValue; //output pixel is (transparent) black by default
-
-			double yip = minC[1] + static_cast<double>(j)*_pixelSize;
-			double q = (c2*xip - a2)*(c1*yip - b1) - (c2*yip - b2)*(c1*xip - a1);
-			double p = (a0 - xip)*(c1*yip - b1) - (b0 - yip)*(c1*xip - a1);
-			double yi = p / q;
-			yi += halfHeight;
-			int y = static_cast<int>(yi);
-
-			if (y >= 0 && y < height)
-			{
-				q = (c1*xip - a1)*(c2*yip - b2) - (c1*yip - b1)*(c2*xip - a2);
-				p = (a0 - xip)*(c2*yip - b2) - (b0 - yip)*(c2*xip - a2);
-				double  xi = p / q;
-				xi += halfWidth;
-				int x = static_cast<int>(xi);
+		double xi = 0;
+		double yi = 0;
+		OrthoRectifiedToImageCoords(a, b, c, xip, yip, xi, yi);
 
-				if (x >= 0 && x < width)
-				{
-					rgb = image->data().pixel(x, y);
-				}
-			}
-
-			//pure black pixels are treated as transparent ones!
-			orthoImage.setPixel(i, h - 1 - j, rgb != blackValue ? rgb : blackAlphaZero);
+		int x = static_cast<int>(xi + halfWidth);
+		int y = static_cast<int>(yi + halfHeight);
+		if (x >= 0 && x < width && y >= 0 && y < height)
+		{
+			return GetOrthoPixel(sourceImage, x, y);
 		}
-	}
+
+		//output pixel is (transparent) black by default
+		return blackAlphaZero;
+	});
 
 	//output pixel size (auto)
 	pixelSize = _pixelSize;
@@ -2146,82 +2191,25 @@ bool ccCameraSensor::OrthoRectifyAsImages(	std::vector<ccImage*> images,
 	//compute output corners and max dimension for all images
 	for (size_t k = 0; k < count; ++k)
 	{
-		const double& a0 = a[k * 3];
-		const double& a1 = a[k * 3 + 1];
-		const double& a2 = a[k * 3 + 2];
-		const double& b0 = b[k * 3];
-		const double& b1 = b[k * 3 + 1];
-		const double& b2 = b[k * 3 + 2];
-		//const double& c0 = c[k*3];
-		const double& c1 = c[k * 3 + 1];
-		const double& c2 = c[k * 3 + 2];
-
 		//first, we compute the ortho-rectified image corners
 		double corners[8];
-		double xi;
-		double yi;
-		double qi;
-
-		unsigned width = images[k]->getW();
-		unsigned height = images[k]->getH();
-
-		//top-left
-		xi = -0.5*width;
-		yi = -0.5*height;
-		qi = 1.0 + c1 * xi + c2 * yi;
-		corners[0] = (a0 + a1 * xi + a2 * yi) / qi;
-		corners[1] = (b0 + b1 * xi + b2 * yi) / qi;
-
-		//top-right
-		xi = 0.5*width;
-		//yi = -0.5*height;
-		qi = 1.0 + c1 * xi + c2 * yi;
-		corners[2] = (a0 + a1 * xi + a2 * yi) / qi;
-		corners[3] = (b0 + b1 * xi + b2 * yi) / qi;
-
-		//bottom-right
-		//xi =  0.5*width;
-		yi = 0.5*height;
-		qi = 1.0 + c1 * xi + c2 * yi;
-		corners[4] = (a0 + a1 * xi + a2 * yi) / qi;
-		corners[5] = (b0 + b1 * xi + b2 * yi) / qi;
-
-		//bottom-left
-		xi = -0.5*width;
-		//yi = 0.5*height;
-		qi = 1.0 + c1 * xi + c2 * yi;
-		corners[6] = (a0 + a1 * xi + a2 * yi) / qi;
-		corners[7] = (b0 + b1 * xi + b2 * yi) / qi;
-
-		//we look for min and max bounding box
 		double* minC = &minCorners[2 * k];
 		double* maxC = &maxCorners[2 * k];
-		maxC[0] = minC[0] = corners[0];
-		maxC[1] = minC[1] = corners[1];
-		for (unsigned k = 1; k < 4; ++k)
+		ComputeOrthoRectifiedCorners(a + 3 * k, b + 3 * k, c + 3 * k, images[k]->getW(), images[k]->getH(), corners, minC, maxC);
+
+		if (k == 0)
+		{
+			globalCorners[0] = minC[0];
+			globalCorners[1] = minC[1];
+			globalCorners[2] = maxC[0];
+			globalCorners[3] = maxC[1];
+		}
+		else
 		{
-			const double* C = corners + 2 * k;
-			//dimension: X
-			if (minC[0] > C[0])
-				minC[0] = C[0];
-			else if (maxC[0] < C[0])
-				maxC[0] = C[0];
-
-			if (globalCorners[0] > minC[0])
-				globalCorners[0] = minC[0];
-			if (globalCorners[2] < maxC[0])
-				globalCorners[2] = maxC[0];
-
-			//dimension: Y
-			if (minC[1] > C[1])
-				minC[1] = C[1];
-			else if (maxC[1] < C[1])
-				maxC[1] = C[1];
-
-			if (globalCorners[1] > minC[1])
-				globalCorners[1] = minC[1];
-			if (globalCorners[3] < maxC[1])
-				globalCorners[3] = maxC[1];
+			globalCorners[0] = std::min(globalCorners[0], minC[0]);
+			globalCorners[1] = std::min(globalCorners[1], minC[1]);
+			globalCorners[2] = std::max(globalCorners[2], maxC[0]);
+			globalCorners[3] = std::max(globalCorners[3], maxC[1]);
 		}
 
 		double dx = maxC[0] - minC[0];
@@ -2282,48 +2270,28 @@ bool ccCameraSensor::OrthoRectifyAsImages(	std::vector<ccImage*> images,
 		}
 
 		//ortho rectification parameters
-		const double& a0 = a[k * 3];
-		const double& a1 = a[k * 3 + 1];
-		const double& a2 = a[k * 3 + 2];
-		const double& b0 = b[k * 3];
-		const double& b1 = b[k * 3 + 1];
-		const double& b2 = b[k * 3 + 2];
-		//const double& c0 = c[k*3];
-		const double& c1 = c[k * 3 + 1];
-		const double& c2 = c[k * 3 + 2];
-
-		for (unsigned i = 0; i < w; ++i)
-		{
-			double xip = minC[0] + static_cast<double>(i)*pixelSize;
-			for (unsigned j = 0; j < h; ++j)
-			{
-				double yip = minC[1] + static_cast<double>(j)*pixelSize;
-				double q = (c2*xip - a2)*(c1*yip - b1) - (c2*yip - b2)*(c1*xip - a1);
-				double p = (a0 - xip)*(c1*yip - b1) - (b0 - yip)*(c1*xip - a1);
-				double yi = p / q;
+		const double* ak = a + 3 * k;
+		const double* bk = b + 3 * k;
+		const double* ck = c + 3 * k;
 
-				q = (c1*xip - a1)*(c2*yip - b2) - (c1*yip - b1)*(c2*xip - a2);
-				p = (a0 - xip)*(c2*yip - b2) - (b0 - yip)*(c2*xip - a2);
-				double  xi = p / q;
+		const QImage& sourceImage = image->data();
+		const QRgb outsideValue = qRgba(255, 0, 255, 0);
 
-				xi += 0.5 * width;
-				yi += 0.5 * height;
+		FillOrthoImage(orthoImage, minC, pixelSize, [&](double xip, double yip)
+		{
+			double xi = 0;
+			double yi = 0;
+			OrthoRectifiedToImageCoords(ak, bk, ck, xip, yip, xi, yi);
 
-				int x = static_cast<int>(xi);
-				int y = static_cast<int>(yi);
-				if (x >= 0 && x < static_cast<int>(width) && y >= 0 && y < static_cast<int>(height))
-				{
-					QRgb rgb = image->data().pixel(x, y);
-					//pure black pixels are treated as transparent ones!
-					if (qRed(rgb) + qGreen(rgb) + qBlue(rgb) > 0)
-						orthoImage.setPixel(i, h - 1 - j, rgb);
-					else
-						orthoImage.setPixel(i, h - 1 - j, qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), 0));
-				}
-				else
-					orthoImage.setPixel(i, h - 1 - j, qRgba(255, 0, 255, 0));
+			int x = static_cast<int>(xi + 0.5 * width);
+			int y = static_cast<int>(yi + 0.5 * height);
+			if (x >= 0 && x < static_cast<int>(width) && y >= 0 && y < static_cast<int>(height))
+			{
+				return GetOrthoPixel(sourceImage, x, y);
 			}
-		}
+
+			return outsideValue;
+		});
 
 		//eventually compute relative pos
 		if (relativePos)
@@ -2362,6 +2330,312 @@ bool ccCameraSensor::OrthoRectifyAsImages(	std::vector<ccImage*> images,
 	return true;
 }
 
+bool ccCameraSensor::OrthoRectifyAsMosaic(	const std::vector<MosaicImage>& images,
+											double pixelSize,
+											MosaicWriter& writer,
+											unsigned tileSize/*=512*/,
+											CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	size_t count = images.size();
+	if (count == 0)
+	{
+		ccLog::Warning("[OrthoRectifyAsMosaic] No image to process?!");
+		return false;
+	}
+	if (tileSize == 0)
+	{
+		assert(false);
+		return false;
+	}
+
+	//min & max corners for each image
+	std::vector<double> minCorners;
+	std::vector<double> maxCorners;
+	//images loaded on demand (for the images that are not in memory)
+	std::vector<QImage> loadedImages;
+	std::vector<unsigned char> loadingFailed;
+	try
+	{
+		minCorners.resize(2 * count);
+		maxCorners.resize(2 * count);
+		loadedImages.resize(count);
+		loadingFailed.resize(count, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		ccLog::Warning("[OrthoRectifyAsMosaic] Not enough memory!");
+		return false;
+	}
+
+	//mosaic extents
+	double globalMinC[2] = { 0, 0 };
+	double globalMaxC[2] = { 0, 0 };
+	//max dimension of all (ortho-rectified) images and of all (original) images
+	double maxDimAllImages = 0;
+	unsigned maxImageSize = 0;
+
+	for (size_t k = 0; k < count; ++k)
+	{
+		double corners[8];
+		double* minC = &minCorners[2 * k];
+		double* maxC = &maxCorners[2 * k];
+		ComputeOrthoRectifiedCorners(images[k].a, images[k].b, images[k].c, images[k].width, images[k].height, corners, minC, maxC);
+
+		for (unsigned char d = 0; d < 2; ++d)
+		{
+			globalMinC[d] = (k == 0 ? minC[d] : std::min(globalMinC[d], minC[d]));
+			globalMaxC[d] = (k == 0 ? maxC[d] : std::max(globalMaxC[d], maxC[d]));
+		}
+
+		maxDimAllImages = std::max(maxDimAllImages, std::max(maxC[0] - minC[0], maxC[1] - minC[1]));
+		maxImageSize = std::max(maxImageSize, std::max(images[k].width, images[k].height));
+	}
+
+	if (pixelSize <= 0)
+	{
+		//auto: same resolution as the (largest) input images
+		if (maxImageSize == 0)
+		{
+			ccLog::Warning("[OrthoRectifyAsMosaic] Invalid input images");
+			return false;
+		}
+		pixelSize = maxDimAllImages / maxImageSize;
+	}
+
+	double widthd = std::ceil((globalMaxC[0] - globalMinC[0]) / pixelSize);
+	double heightd = std::ceil((globalMaxC[1] - globalMinC[1]) / pixelSize);
+	if (	!std::isfinite(widthd) || !std::isfinite(heightd)
+		||	widthd < 1.0 || heightd < 1.0
+		||	widthd > std::numeric_limits<int>::max() || heightd > std::numeric_limits<int>::max())
+	{
+		ccLog::Warning("[OrthoRectifyAsMosaic] Invalid mosaic dimensions (check the pixel size)");
+		return false;
+	}
+	const unsigned width = static_cast<unsigned>(widthd);
+	const unsigned height = static_cast<unsigned>(heightd);
+
+	if (!writer.open(width, height, globalMinC, pixelSize, tileSize))
+	{
+		ccLog::Warning("[OrthoRectifyAsMosaic] Failed to open the output mosaic");
+		return false;
+	}
+
+	const unsigned tileCountX = (width + tileSize - 1) / tileSize;
+	const unsigned tileCountY = (height + tileSize - 1) / tileSize;
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle(QObject::tr("Ortho-rectification"));
+			progressCb->setInfo(QObject::tr("Mosaic: %1 x %2 pixels\n%3 image(s)").arg(width).arg(height).arg(count));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	//the tiles of a same row are computed in parallel, then written sequentially
+	//(so that only one row of tiles is held in memory at a time)
+	std::vector<QImage> tiles(tileCountX);
+	bool success = true;
+
+	for (unsigned ty = 0; ty < tileCountY && success; ++ty)
+	{
+		const unsigned y0 = ty * tileSize;
+		const unsigned th = std::min(tileSize, height - y0);
+		std::atomic<bool> notEnoughMemory(false);
+
+		//3D extents of the row of tiles (pixel positions)
+		const double rowMaxY = globalMinC[1] + static_cast<double>(height - 1 - y0) * pixelSize;
+		const double rowMinY = globalMinC[1] + static_cast<double>(height - y0 - th) * pixelSize;
+
+		//load the images (not in memory) overlapping this row of tiles
+		{
+			std::vector<int> toLoad;
+			for (size_t k = 0; k < count; ++k)
+			{
+				if (	!images[k].image
+					&&	loadedImages[k].isNull()
+					&&	!loadingFailed[k]
+					&&	maxCorners[2 * k + 1] >= rowMinY
+					&&	minCorners[2 * k + 1] <= rowMaxY)
+				{
+					toLoad.push_back(static_cast<int>(k));
+				}
+			}
+
+#if defined(_OPENMP)
+			#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+			for (int l = 0; l < static_cast<int>(toLoad.size()); ++l)
+			{
+				int k = toLoad[l];
+				if (!loadedImages[k].load(images[k].filename))
+				{
+					loadingFailed[k] = 1;
+				}
+			}
+
+			for (int k : toLoad)
+			{
+				if (loadingFailed[k])
+				{
+					ccLog::Warning(QString("[OrthoRectifyAsMosaic] Failed to load image '%1' (ignored)").arg(images[k].filename));
+				}
+			}
+		}
+
+#if defined(_OPENMP)
+		#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+		for (int tx = 0; tx < static_cast<int>(tileCountX); ++tx)
+		{
+			const unsigned x0 = static_cast<unsigned>(tx) * tileSize;
+			const unsigned tw = std::min(tileSize, width - x0);
+
+			QImage tile(tw, th, QImage::Format_ARGB32);
+			if (tile.isNull())
+			{
+				//not enough memory
+				notEnoughMemory = true;
+				continue;
+			}
+			tile.fill(qRgba(0, 0, 0, 0));
+
+			//3D extents of the tile (pixel positions)
+			const double tileMinX = globalMinC[0] + static_cast<double>(x0) * pixelSize;
+			const double tileMaxX = globalMinC[0] + static_cast<double>(x0 + tw - 1) * pixelSize;
+			const double tileMaxY = rowMaxY;
+			const double tileMinY = rowMinY;
+
+			uchar* bits = tile.bits();
+			const size_t bytesPerLine = static_cast<size_t>(tile.bytesPerLine());
+			size_t emptyPixelCount = static_cast<size_t>(tw) * th;
+
+			//the first image (in the input order) covering a pixel sets its color
+			for (size_t k = 0; k < count && emptyPixelCount != 0; ++k)
+			{
+				//only the images overlapping the tile are read
+				const double* minC = &minCorners[2 * k];
+				const double* maxC = &maxCorners[2 * k];
+				if (maxC[0] < tileMinX || minC[0] > tileMaxX || maxC[1] < tileMinY || minC[1] > tileMaxY)
+				{
+					continue;
+				}
+
+				const QImage& sourceImage = (images[k].image ? images[k].image->data() : loadedImages[k]);
+				if (sourceImage.isNull())
+				{
+					continue;
+				}
+				const int sourceWidth = sourceImage.width();
+				const int sourceHeight = sourceImage.height();
+				const double* ak = images[k].a;
+				const double* bk = images[k].b;
+				const double* ck = images[k].c;
+
+				for (unsigned j = 0; j < th; ++j)
+				{
+					double yip = tileMaxY - static_cast<double>(j) * pixelSize;
+					if (yip < minC[1] || yip > maxC[1])
+					{
+						continue;
+					}
+
+					QRgb* line = reinterpret_cast<QRgb*>(bits + j * bytesPerLine);
+					for (unsigned i = 0; i < tw; ++i)
+					{
+						if (qAlpha(line[i]) != 0)
+						{
+							//already set
+							continue;
+						}
+
+						double xip = tileMinX + static_cast<double>(i) * pixelSize;
+						if (xip < minC[0] || xip > maxC[0])
+						{
+							continue;
+						}
+
+						double xi = 0;
+						double yi = 0;
+						OrthoRectifiedToImageCoords(ak, bk, ck, xip, yip, xi, yi);
+
+						int x = static_cast<int>(xi + 0.5 * sourceWidth);
+						int y = static_cast<int>(yi + 0.5 * sourceHeight);
+						if (x >= 0 && x < sourceWidth && y >= 0 && y < sourceHeight)
+						{
+							QRgb rgb = GetOrthoPixel(sourceImage, x, y);
+							if (qAlpha(rgb) != 0)
+							{
+								line[i] = rgb;
+								--emptyPixelCount;
+							}
+						}
+					}
+				}
+			}
+
+			tiles[tx] = tile;
+		}
+
+		if (notEnoughMemory)
+		{
+			ccLog::Warning("[OrthoRectifyAsMosaic] Not enough memory!");
+			success = false;
+			break;
+		}
+
+		for (unsigned tx = 0; tx < tileCountX; ++tx)
+		{
+			if (!writer.writeTile(tx * tileSize, y0, tiles[tx]))
+			{
+				ccLog::Warning("[OrthoRectifyAsMosaic] Failed to write the mosaic tiles");
+				success = false;
+				break;
+			}
+			tiles[tx] = QImage();
+		}
+
+		//release the loaded images that don't overlap the next rows of tiles
+		if (ty + 1 < tileCountY)
+		{
+			const double nextRowMaxY = globalMinC[1] + static_cast<double>(height - 1 - (y0 + tileSize)) * pixelSize;
+			for (size_t k = 0; k < count; ++k)
+			{
+				if (!loadedImages[k].isNull() && minCorners[2 * k + 1] > nextRowMaxY)
+				{
+					loadedImages[k] = QImage();
+				}
+			}
+		}
+
+		if (progressCb)
+		{
+			progressCb->update((100.0f * (ty + 1)) / tileCountY);
+			if (progressCb->isCancelRequested())
+			{
+				ccLog::Warning("[OrthoRectifyAsMosaic] Process cancelled by the user");
+				success = false;
+			}
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (!writer.close())
+	{
+		ccLog::Warning("[OrthoRectifyAsMosaic] Failed to close the output mosaic");
+		success = false;
+	}
+
+	return success;
+}
+
 ccPointCloud* ccCameraSensor::orthoRectifyAsCloud(	const ccImage* image,
 													CCCoreLib::GenericIndexedCloud* keypoints3D,
 													std::vector<KeyPoint>& keypointsImage) const
@@ -0,0 +1,91 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccCloudBatches.h"
+
+//CCCoreLib
+#include <GenericIndexedCloud.h>
+
+//system
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+bool ccCloudBatches::BuildGridBatches(	CCCoreLib::GenericIndexedCloud* cloud,
+										PointCoordinateType cellSize,
+										std::vector<unsigned>& sortedIndexes,
+										std::vector<size_t>& batchStarts)
+{
+	sortedIndexes.clear();
+	batchStarts.clear();
+
+	assert(cloud);
+	unsigned pointCount = (cloud ? cloud->size() : 0);
+	if (pointCount == 0)
+	{
+		return true;
+	}
+
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud->getBoundingBox(bbMin, bbMax);
+	CCVector3 diag = bbMax - bbMin;
+
+	PointCoordinateType maxDim = std::max(diag.x, std::max(diag.y, diag.z));
+	cellSize = std::max(cellSize, maxDim / MAX_GRID_SIZE);
+	if (cellSize <= 0)
+	{
+		//all the points are at the same position
+		cellSize = 1;
+	}
+
+	try
+	{
+		//(cell code, point index) pairs
+		std::vector<std::pair<uint64_t, unsigned>> codes;
+		codes.resize(pointCount);
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			CCVector3 relativePos = (*cloud->getPoint(i) - bbMin) / cellSize;
+			uint64_t x = static_cast<uint64_t>(std::min(static_cast<int>(relativePos.x), MAX_GRID_SIZE));
+			uint64_t y = static_cast<uint64_t>(std::min(static_cast<int>(relativePos.y), MAX_GRID_SIZE));
+			uint64_t z = static_cast<uint64_t>(std::min(static_cast<int>(relativePos.z), MAX_GRID_SIZE));
+			codes[i] = { (z << 42) | (y << 21) | x, i };
+		}
+		std::sort(codes.begin(), codes.end());
+
+		sortedIndexes.resize(pointCount);
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			if (i == 0 || codes[i].first != codes[i - 1].first)
+			{
+				batchStarts.push_back(i);
+			}
+			sortedIndexes[i] = codes[i].second;
+		}
+		batchStarts.push_back(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		sortedIndexes.clear();
+		batchStarts.clear();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,248 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccFWFDataContainer.h"
+
+//Local
+#include "ccLog.h"
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QMultiHash>
+#include <QMutex>
+
+//system
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+//! Registry of the memory-mapped containers (by canonical file path)
+static QMultiHash<QString, ccFWFDataContainer*> s_mappedContainers;
+//! Registry mutex
+static QMutex s_mappedContainersMutex;
+
+//! Returns the key of a file in the registry
+static QString RegistryKey(const QString& filename)
+{
+	QFileInfo fi(filename);
+	QString canonicalPath = fi.canonicalFilePath();
+	//the file may not exist (yet)
+	return canonicalPath.isEmpty() ? fi.absoluteFilePath() : canonicalPath;
+}
+
+ccFWFDataContainer::ccFWFDataContainer(size_t size)
+	: m_memory(size)
+{
+}
+
+ccFWFDataContainer::~ccFWFDataContainer()
+{
+	unmap();
+}
+
+void ccFWFDataContainer::unmap()
+{
+	if (!m_mappedPath.isEmpty())
+	{
+		QMutexLocker locker(&s_mappedContainersMutex);
+		s_mappedContainers.remove(m_mappedPath, this);
+	}
+
+	releaseFile();
+}
+
+void ccFWFDataContainer::releaseFile()
+{
+	if (m_file)
+	{
+		if (m_map)
+		{
+			m_file->unmap(m_map);
+		}
+		m_file->close();
+		delete m_file;
+		m_file = nullptr;
+	}
+	m_map = nullptr;
+	m_mapSize = 0;
+	m_mappedPath.clear();
+}
+
+bool ccFWFDataContainer::fromFile(const QString& filename, uint64_t offset, uint64_t size, bool mapFile/*=true*/)
+{
+	unmap();
+	m_memory.clear();
+	m_memory.shrink_to_fit();
+
+	QFile* file = new QFile(filename);
+	if (!file->open(QFile::ReadOnly))
+	{
+		ccLog::Warning(QString("[FWF] Failed to open file '%1': %2").arg(filename, file->errorString()));
+		delete file;
+		return false;
+	}
+
+	uint64_t fileSize = static_cast<uint64_t>(file->size());
+	if (offset > fileSize)
+	{
+		ccLog::Warning(QString("[FWF] Invalid waveform data offset in file '%1'").arg(filename));
+		delete file;
+		return false;
+	}
+	if (offset + size > fileSize)
+	{
+		ccLog::Warning(QString("[FWF] File '%1' is smaller than expected (truncated?)").arg(filename));
+		size = fileSize - offset;
+	}
+
+	if (size > std::numeric_limits<size_t>::max())
+	{
+		ccLog::Warning(QString("[FWF] Waveform data is too big to be loaded (%1 bytes)").arg(size));
+		delete file;
+		return false;
+	}
+
+	if (mapFile && size != 0)
+	{
+		uchar* map = file->map(static_cast<qint64>(offset), static_cast<qint64>(size));
+		if (map)
+		{
+			m_file = file;
+			m_map = map;
+			m_mapSize = static_cast<size_t>(size);
+			m_mappedPath = RegistryKey(filename);
+
+			QMutexLocker locker(&s_mappedContainersMutex);
+			s_mappedContainers.insert(m_mappedPath, this);
+			return true;
+		}
+
+		//typically if the address space is too small (32 bits systems)
+		ccLog::Warning(QString("[FWF] Failed to map file '%1' (%2). The waveform data will be loaded in memory").arg(filename, file->errorString()));
+	}
+
+	//in-memory version
+	try
+	{
+		m_memory.resize(static_cast<size_t>(size));
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[FWF] Not enough memory to load the waveform data");
+		delete file;
+		return false;
+	}
+
+	if (!file->seek(static_cast<qint64>(offset)) || file->read(reinterpret_cast<char*>(m_memory.data()), static_cast<qint64>(size)) != static_cast<qint64>(size))
+	{
+		ccLog::Warning(QString("[FWF] Failed to read the waveform data from file '%1'").arg(filename));
+		m_memory.clear();
+		m_memory.shrink_to_fit();
+		delete file;
+		return false;
+	}
+
+	delete file;
+	return true;
+}
+
+bool ccFWFDataContainer::isMappedFrom(const QString& filename) const
+{
+	return m_map && m_mappedPath == RegistryKey(filename);
+}
+
+bool ccFWFDataContainer::copyMappedData()
+{
+	assert(m_map);
+
+	try
+	{
+		m_memory.resize(m_mapSize);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[FWF] Not enough memory to load the waveform data");
+		return false;
+	}
+	memcpy(m_memory.data(), m_map, m_mapSize);
+
+	return true;
+}
+
+bool ccFWFDataContainer::loadInMemory()
+{
+	if (!m_map)
+	{
+		//nothing to do
+		return true;
+	}
+
+	if (!copyMappedData())
+	{
+		return false;
+	}
+
+	unmap();
+
+	return true;
+}
+
+bool ccFWFDataContainer::DetachAllFromFile(const QString& filename)
+{
+	QString key = RegistryKey(filename);
+
+	QMutexLocker locker(&s_mappedContainersMutex);
+
+	//the containers stay locked in the registry while their data is copied (so that they can't be released concurrently)
+	QList<ccFWFDataContainer*> containers = s_mappedContainers.values(key);
+	for (ccFWFDataContainer* container : containers)
+	{
+		if (!container->copyMappedData())
+		{
+			ccLog::Warning(QString("[FWF] Not enough memory to load the waveform data mapped from '%1'").arg(filename));
+			return false;
+		}
+		s_mappedContainers.remove(key, container);
+		container->releaseFile();
+	}
+
+	return true;
+}
+
+uint8_t* ccFWFDataContainer::data()
+{
+	if (m_map && !loadInMemory())
+	{
+		return nullptr;
+	}
+
+	return m_memory.data();
+}
+
+void ccFWFDataContainer::resize(size_t size)
+{
+	if (m_map)
+	{
+		if (!loadInMemory())
+		{
+			throw std::bad_alloc();
+		}
+	}
+
+	m_memory.resize(size);
+}
@@ -28,14 +28,18 @@
 //Qt
 #include <QCoreApplication>
 
+//system
+#include <algorithm>
+
+#if defined(_OPENMP)
+//OpenMP
+#include <omp.h>
+#endif
+
 //maximum depth buffer dimension (width or height)
 static const int s_MaxDepthBufferSize = (1 << 14); //16384
-
-enum Errors {	ERROR_BAD_INPUT      = -1,
-				ERROR_MEMORY         = -2,
-				ERROR_PROC_CANCELLED = -3,
-				ERROR_DB_TOO_SMALL   = -4,
-};
+//number of points read and projected at once
+static const unsigned s_projectionBatchSize = (1 << 16);
 
 QString ccGBLSensor::GetErrorString(int errorCode)
 {
@@ -141,23 +145,20 @@ void ccGBLSensor::setYawStep(PointCoordinateType dTheta)
 	}
 }
 
-void ccGBLSensor::projectPoint(	const CCVector3& sourcePoint,
-								CCVector2& destPoint,
-								PointCoordinateType &depth,
-								double posIndex/*=0*/) const
+ccGLMatrix ccGBLSensor::getWorldToSensorTransformation(double posIndex) const
 {
-	//project point in sensor world
-	CCVector3 P = sourcePoint;
-
 	//sensor to world global transformation = sensor position * rigid transformation
 	ccIndexedTransformation sensorPos; //identity by default
 	if (m_posBuffer)
 		m_posBuffer->getInterpolatedTransformation(posIndex, sensorPos);
 	sensorPos *= m_rigidTransformation;
 
-	//apply (inverse) global transformation (i.e world to sensor)
-	sensorPos.inverse().apply(P);
+	//world to sensor = inverse of the global transformation
+	return sensorPos.inverse();
+}
 
+void ccGBLSensor::projectInSensorFrame(const CCVector3& P, CCVector2& destPoint, PointCoordinateType& depth) const
+{
 	//convert to 2D sensor field of view + compute its distance
 	switch (m_rotationOrder)
 	{
@@ -192,6 +193,38 @@ void ccGBLSensor::projectPoint(	const CCVector3& sourcePoint,
 	depth = P.norm();
 }
 
+void ccGBLSensor::projectPoint(	const CCVector3& sourcePoint,
+								CCVector2& destPoint,
+								PointCoordinateType &depth,
+								double posIndex/*=0*/) const
+{
+	//project point in sensor world
+	CCVector3 P = sourcePoint;
+
+	//apply (inverse) global transformation (i.e world to sensor)
+	getWorldToSensorTransformation(posIndex).apply(P);
+
+	projectInSensorFrame(P, destPoint, depth);
+}
+
+void ccGBLSensor::projectPoints(const CCVector3* points,
+								unsigned count,
+								const ccGLMatrix& worldToSensor,
+								CCVector2* destPoints,
+								PointCoordinateType* depths) const
+{
+	int pointCount = static_cast<int>(count);
+#if defined(_OPENMP)
+	#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int i = 0; i < pointCount; ++i)
+	{
+		CCVector3 P = points[i];
+		worldToSensor.apply(P);
+		projectInSensorFrame(P, destPoints[i], depths[i]);
+	}
+}
+
 bool ccGBLSensor::convertToDepthMapCoords(PointCoordinateType yaw, PointCoordinateType pitch, unsigned& i, unsigned& j) const
 {
 	if (m_depthBuffer.zBuff.empty())
@@ -536,60 +569,92 @@ bool ccGBLSensor::computeAutoParameters(CCCoreLib::GenericCloud* theCloud)
 
 	unsigned pointCount = theCloud->size();
 
+	std::vector<CCVector3> points;
+	std::vector<CCVector2> projectedPoints;
+	std::vector<PointCoordinateType> depths;
+	try
+	{
+		unsigned batchSize = std::min(s_projectionBatchSize, pointCount);
+		points.resize(batchSize);
+		projectedPoints.resize(batchSize);
+		depths.resize(batchSize);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	//the (yaw,pitch) ranges are computed in a single pass, for both the regular and the shifted angles
+	//(we'll only know at the end whether the angles should be shifted or not)
+	const PointCoordinateType twoPi = static_cast<PointCoordinateType>(2.0*M_PI);
 	PointCoordinateType minPitch = 0;
 	PointCoordinateType maxPitch = 0;
 	PointCoordinateType minYaw = 0;
 	PointCoordinateType maxYaw = 0;
+	PointCoordinateType minShiftedPitch = 0;
+	PointCoordinateType maxShiftedPitch = 0;
+	PointCoordinateType minShiftedYaw = 0;
+	PointCoordinateType maxShiftedYaw = 0;
 	PointCoordinateType maxDepth = 0;
 	{
-		//first project all points to compute the (yaw,pitch) ranges
+		ccGLMatrix worldToSensor = getWorldToSensorTransformation(m_activeIndex);
+
+		//project all points (by batches) to compute the (yaw,pitch) ranges
 		theCloud->placeIteratorAtBeginning();
-		for (unsigned i = 0; i < pointCount; ++i)
+		for (unsigned start = 0; start < pointCount; start += s_projectionBatchSize)
 		{
-			const CCVector3* P = theCloud->getNextPoint();
-			CCVector2 Q;
-			PointCoordinateType depth;
-			//Q.x and Q.y are inside [-pi;pi] by default (result of atan2)
-			projectPoint(*P, Q, depth, m_activeIndex);
-
-			//yaw
-			int angleYaw = static_cast<int>(CCCoreLib::RadiansToDegrees(Q.x));
-			assert(angleYaw >= -180 && angleYaw <= 180);
-			if (angleYaw == 180) //360 degrees warp
-				angleYaw = -180;
-			nonEmptyAnglesYaw[180 + angleYaw] = true;
-			if (i != 0)
+			unsigned count = std::min(s_projectionBatchSize, pointCount - start);
+			for (unsigned i = 0; i < count; ++i)
 			{
-				if (minYaw > Q.x)
-					minYaw = Q.x;
-				else if (maxYaw < Q.x)
-					maxYaw = Q.x;
-			}
-			else
-			{
-				minYaw = maxYaw = Q.x;
+				points[i] = *theCloud->getNextPoint();
 			}
 
-			//pitch
-			int anglePitch = static_cast<int>(CCCoreLib::RadiansToDegrees(Q.y));
-			assert(anglePitch >= -180 && anglePitch <= 180);
-			if (anglePitch == 180)
-				anglePitch = -180;
-			nonEmptyAnglesPitch[180 + anglePitch] = true;
-			if (i != 0)
-			{
-				if (minPitch > Q.y)
-					minPitch = Q.y;
-				else if (maxPitch < Q.y)
-					maxPitch = Q.y;
-			}
-			else
+			//Q.x and Q.y are inside [-pi;pi] by default (result of atan2)
+			projectPoints(points.data(), count, worldToSensor, projectedPoints.data(), depths.data());
+
+			for (unsigned i = 0; i < count; ++i)
 			{
-				minPitch = maxPitch = Q.y;
-			}
+				const CCVector2& Q = projectedPoints[i];
+				PointCoordinateType shiftedYaw = (Q.x < 0 ? Q.x + twoPi : Q.x);
+				PointCoordinateType shiftedPitch = (Q.y < 0 ? Q.y + twoPi : Q.y);
+
+				//yaw
+				int angleYaw = static_cast<int>(CCCoreLib::RadiansToDegrees(Q.x));
+				assert(angleYaw >= -180 && angleYaw <= 180);
+				if (angleYaw == 180) //360 degrees warp
+					angleYaw = -180;
+				nonEmptyAnglesYaw[180 + angleYaw] = true;
+
+				//pitch
+				int anglePitch = static_cast<int>(CCCoreLib::RadiansToDegrees(Q.y));
+				assert(anglePitch >= -180 && anglePitch <= 180);
+				if (anglePitch == 180)
+					anglePitch = -180;
+				nonEmptyAnglesPitch[180 + anglePitch] = true;
+
+				if (start + i != 0)
+				{
+					minYaw = std::min(minYaw, Q.x);
+					maxYaw = std::max(maxYaw, Q.x);
+					minPitch = std::min(minPitch, Q.y);
+					maxPitch = std::max(maxPitch, Q.y);
+					minShiftedYaw = std::min(minShiftedYaw, shiftedYaw);
+					maxShiftedYaw = std::max(maxShiftedYaw, shiftedYaw);
+					minShiftedPitch = std::min(minShiftedPitch, shiftedPitch);
+					maxShiftedPitch = std::max(maxShiftedPitch, shiftedPitch);
+				}
+				else
+				{
+					minYaw = maxYaw = Q.x;
+					minPitch = maxPitch = Q.y;
+					minShiftedYaw = maxShiftedYaw = shiftedYaw;
+					minShiftedPitch = maxShiftedPitch = shiftedPitch;
+				}
 
-			if (depth > maxDepth)
-				maxDepth = depth;
+				if (depths[i] > maxDepth)
+					maxDepth = depths[i];
+			}
 		}
 	}
 
@@ -599,35 +664,16 @@ bool ccGBLSensor::computeAutoParameters(CCCoreLib::GenericCloud* theCloud)
 	m_yawAnglesAreShifted = (bestEmptyPartYaw.start != 0 && bestEmptyPartYaw.span > 1 && bestEmptyPartYaw.start + bestEmptyPartYaw.span < 360);
 	m_pitchAnglesAreShifted = (bestEmptyPartPitch.start != 0 && bestEmptyPartPitch.span > 1 && bestEmptyPartPitch.start + bestEmptyPartPitch.span < 360);
 
-	if (m_yawAnglesAreShifted || m_pitchAnglesAreShifted)
+	//no need to re-project the points if the angles are shifted
+	if (m_yawAnglesAreShifted)
 	{
-		//we re-project all the points in order to update the boundaries!
-		theCloud->placeIteratorAtBeginning();
-		for (unsigned i = 0; i < pointCount; ++i)
-		{
-			const CCVector3 *P = theCloud->getNextPoint();
-			CCVector2 Q;
-			PointCoordinateType depth;
-			projectPoint(*P, Q, depth, m_activeIndex);
-
-			if (i != 0)
-			{
-				if (minYaw > Q.x)
-					minYaw = Q.x;
-				else if (maxYaw < Q.x)
-					maxYaw = Q.x;
-
-				if (minPitch > Q.y)
-					minPitch = Q.y;
-				else if (maxPitch < Q.y)
-					maxPitch = Q.y;
-			}
-			else
-			{
-				minYaw = maxYaw = Q.x;
-				minPitch = maxPitch = Q.y;
-			}
-		}
+		minYaw = minShiftedYaw;
+		maxYaw = maxShiftedYaw;
+	}
+	if (m_pitchAnglesAreShifted)
+	{
+		minPitch = minShiftedPitch;
+		maxPitch = maxShiftedPitch;
 	}
 
 	setYawRange(minYaw, maxYaw);
@@ -637,142 +683,214 @@ bool ccGBLSensor::computeAutoParameters(CCCoreLib::GenericCloud* theCloud)
 	return true;
 }
 
+bool ccGBLSensor::initDepthBuffer(int& errorCode)
+{
+	//clear previous Z-buffer (if any)
+	clearDepthBuffer();
+
+	PointCoordinateType deltaTheta = m_deltaTheta;
+	PointCoordinateType deltaPhi = m_deltaPhi;
+
+	//yaw as X
+	int width = static_cast<int>(ceil((m_thetaMax - m_thetaMin) / m_deltaTheta));
+	if (width > s_MaxDepthBufferSize)
+	{
+		deltaTheta = (m_thetaMax - m_thetaMin) / static_cast<PointCoordinateType>(s_MaxDepthBufferSize);
+		width = s_MaxDepthBufferSize;
+	}
+	//pitch as Y
+	int height = static_cast<int>(ceil((m_phiMax - m_phiMin) / m_deltaPhi));
+	if (height > s_MaxDepthBufferSize)
+	{
+		deltaPhi = (m_phiMax - m_phiMin) / static_cast<PointCoordinateType>(s_MaxDepthBufferSize);
+		height = s_MaxDepthBufferSize;
+	}
+
+	if (width <= 0 || height <= 0)
+	{
+		//depth buffer dimensions are too small?!
+		errorCode = ERROR_DB_TOO_SMALL;
+		return false;
+	}
+
+	unsigned zBuffSize = width * height;
+	try
+	{
+		assert(m_depthBuffer.zBuff.empty());
+		m_depthBuffer.zBuff.resize(zBuffSize, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		errorCode = ERROR_MEMORY;
+		return false;
+	}
+
+	m_depthBuffer.width = static_cast<unsigned>(width);
+	m_depthBuffer.height = static_cast<unsigned>(height);
+	m_depthBuffer.deltaTheta = deltaTheta;
+	m_depthBuffer.deltaPhi = deltaPhi;
+
+	return true;
+}
+
 bool ccGBLSensor::computeDepthBuffer(CCCoreLib::GenericCloud* theCloud, int& errorCode, ccPointCloud* projectedCloud/*=nullptr*/)
+{
+	std::vector<ccGBLSensor*> sensors{ this };
+	return ComputeDepthBuffers(theCloud, sensors, errorCode, projectedCloud);
+}
+
+bool ccGBLSensor::ComputeDepthBuffers(	CCCoreLib::GenericCloud* theCloud,
+										const std::vector<ccGBLSensor*>& sensors,
+										int& errorCode,
+										ccPointCloud* projectedCloud/*=nullptr*/)
 {
 	assert(theCloud);
-	if (!theCloud)
+	if (!theCloud || sensors.empty() || (projectedCloud && sensors.size() != 1))
 	{
 		//invalid input parameter
 		errorCode = ERROR_BAD_INPUT;
 		return false;
 	}
 
-	//clear previous Z-buffer (if any)
-	clearDepthBuffer();
-
-	//init new Z-buffer
+	auto clearDepthBuffers = [&sensors]()
 	{
-		PointCoordinateType deltaTheta = m_deltaTheta;
-		PointCoordinateType deltaPhi = m_deltaPhi;
-
-		//yaw as X
-		int width = static_cast<int>(ceil((m_thetaMax - m_thetaMin) / m_deltaTheta));
-		if (width > s_MaxDepthBufferSize)
-		{
-			deltaTheta = (m_thetaMax - m_thetaMin) / static_cast<PointCoordinateType>(s_MaxDepthBufferSize);
-			width = s_MaxDepthBufferSize;
-		}
-		//pitch as Y
-		int height = static_cast<int>(ceil((m_phiMax - m_phiMin) / m_deltaPhi));
-		if (height > s_MaxDepthBufferSize)
+		for (ccGBLSensor* sensor : sensors)
 		{
-			deltaPhi = (m_phiMax - m_phiMin) / static_cast<PointCoordinateType>(s_MaxDepthBufferSize);
-			height = s_MaxDepthBufferSize;
+			sensor->clearDepthBuffer();
 		}
+	};
 
-		if (width <= 0 || height <= 0)
+	//init new Z-buffers
+	for (ccGBLSensor* sensor : sensors)
+	{
+		assert(sensor);
+		if (!sensor->initDepthBuffer(errorCode))
 		{
-			//depth buffer dimensions are too small?!
-			errorCode = ERROR_DB_TOO_SMALL;
+			clearDepthBuffers();
 			return false;
 		}
+	}
 
-		unsigned zBuffSize = width * height;
-		try
-		{
-			assert(m_depthBuffer.zBuff.empty());
-			m_depthBuffer.zBuff.resize(zBuffSize, 0);
-		}
-		catch (const std::bad_alloc&)
+	unsigned pointCount = theCloud->size();
+
+	if (projectedCloud)
+	{
+		projectedCloud->clear();
+		if (!projectedCloud->reserve(pointCount) || !projectedCloud->enableScalarField())
 		{
 			//not enough memory
 			errorCode = ERROR_MEMORY;
+			clearDepthBuffers();
 			return false;
 		}
+	}
 
-		m_depthBuffer.width = static_cast<unsigned>(width);
-		m_depthBuffer.height = static_cast<unsigned>(height);
-		m_depthBuffer.deltaTheta = deltaTheta;
-		m_depthBuffer.deltaPhi = deltaPhi;
+	//temporary buffers (for one batch of points)
+	std::vector<CCVector3> points;
+	std::vector<CCVector2> projectedPoints;
+	std::vector<PointCoordinateType> depths;
+	try
+	{
+		unsigned batchSize = std::min(pointCount, s_projectionBatchSize);
+		points.resize(batchSize);
+		projectedPoints.resize(batchSize);
+		depths.resize(batchSize);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		errorCode = ERROR_MEMORY;
+		clearDepthBuffers();
+		return false;
 	}
 
-	unsigned pointCount = theCloud->size();
+	//the sensors are static during the whole process
+	std::vector<ccGLMatrix> worldToSensor;
+	worldToSensor.reserve(sensors.size());
+	for (ccGBLSensor* sensor : sensors)
+	{
+		worldToSensor.push_back(sensor->getWorldToSensorTransformation(sensor->m_activeIndex));
+	}
 
-	//project points and accumulate them in Z-buffer
+	//project points and accumulate them in Z-buffers
 	{
-		if (projectedCloud)
-		{
-			projectedCloud->clear();
-			if (!projectedCloud->reserve(pointCount) || !projectedCloud->enableScalarField())
-			{
-				//not enough memory
-				errorCode = ERROR_MEMORY;
-				clearDepthBuffer();
-				return false;
-			}
-		}
+		//progress bar
+		ccProgressDialog pdlg(true);
+		CCCoreLib::NormalizedProgress nprogress(&pdlg, pointCount);
+		pdlg.setMethodTitle(QObject::tr("Depth buffer"));
+		if (sensors.size() == 1)
+			pdlg.setInfo(QObject::tr("Points: %L1").arg(pointCount));
+		else
+			pdlg.setInfo(QObject::tr("Points: %L1\nSensors: %2").arg(pointCount).arg(sensors.size()));
+		pdlg.start();
+		QCoreApplication::processEvents();
 
 		theCloud->placeIteratorAtBeginning();
+		for (unsigned start = 0; start < pointCount; start += s_projectionBatchSize)
 		{
-			//progress bar
-			ccProgressDialog pdlg(true);
-			CCCoreLib::NormalizedProgress nprogress(&pdlg, pointCount);
-			pdlg.setMethodTitle(QObject::tr("Depth buffer"));
-			pdlg.setInfo(QObject::tr("Points: %L1").arg(pointCount));
-			pdlg.start();
-			QCoreApplication::processEvents();
+			unsigned count = std::min(pointCount - start, s_projectionBatchSize);
 
-			for (unsigned i = 0; i < pointCount; ++i)
+			//the points are read only once (whatever the number of sensors)
+			for (unsigned i = 0; i < count; ++i)
 			{
-				const CCVector3* P = theCloud->getNextPoint();
-				CCVector2 Q;
-				PointCoordinateType depth;
-				projectPoint(*P, Q, depth, m_activeIndex);
+				points[i] = *theCloud->getNextPoint();
+			}
 
-				unsigned x = 0;
-				unsigned y = 0;
-				if (convertToDepthMapCoords(Q.x, Q.y, x, y))
+			for (size_t s = 0; s < sensors.size(); ++s)
+			{
+				ccGBLSensor* sensor = sensors[s];
+
+				//projection (in parallel)
+				sensor->projectPoints(points.data(), count, worldToSensor[s], projectedPoints.data(), depths.data());
+
+				//accumulation (we keep the farthest point in each cell)
+				ccDepthBuffer& depthBuffer = sensor->m_depthBuffer;
+				for (unsigned i = 0; i < count; ++i)
 				{
-					PointCoordinateType& zBuf = m_depthBuffer.zBuff[y*m_depthBuffer.width + x];
-					zBuf = std::max(zBuf, depth);
-					m_sensorRange = std::max(m_sensorRange, depth);
+					const CCVector2& Q = projectedPoints[i];
+					unsigned x = 0;
+					unsigned y = 0;
+					if (sensor->convertToDepthMapCoords(Q.x, Q.y, x, y))
+					{
+						PointCoordinateType& zBuf = depthBuffer.zBuff[y*depthBuffer.width + x];
+						zBuf = std::max(zBuf, depths[i]);
+						sensor->m_sensorRange = std::max(sensor->m_sensorRange, depths[i]);
+					}
 				}
 
 				if (projectedCloud)
 				{
-					projectedCloud->addPoint(CCVector3(Q.x, Q.y, 0));
-					projectedCloud->setPointScalarValue(i, depth);
+					for (unsigned i = 0; i < count; ++i)
+					{
+						const CCVector2& Q = projectedPoints[i];
+						projectedCloud->addPoint(CCVector3(Q.x, Q.y, 0));
+						projectedCloud->setPointScalarValue(start + i, depths[i]);
+					}
 				}
+			}
 
-				if (!nprogress.oneStep())
-				{
-					//cancelled by user
-					errorCode = ERROR_PROC_CANCELLED;
-					clearDepthBuffer();
-					return false;
-				}
+			if (!nprogress.steps(count))
+			{
+				//cancelled by user
+				errorCode = ERROR_PROC_CANCELLED;
+				clearDepthBuffers();
+				return false;
 			}
 		}
 	}
 
-	m_depthBuffer.fillHoles();
+	for (ccGBLSensor* sensor : sensors)
+	{
+		sensor->m_depthBuffer.fillHoles();
+	}
 
 	errorCode = 0;
 	return true;
 }
 
-unsigned char ccGBLSensor::checkVisibility(const CCVector3& P) const
+unsigned char ccGBLSensor::checkProjectedVisibility(const CCVector2& Q, PointCoordinateType depth) const
 {
-	if (m_depthBuffer.zBuff.empty()) //no z-buffer?
-	{
-		return CCCoreLib::POINT_VISIBLE;
-	}
-
-	//project point
-	CCVector2 Q;
-	PointCoordinateType depth;
-	projectPoint(P, Q, depth, m_activeIndex);
-
 	//out of sight
 	if (depth > m_sensorRange)
 	{
@@ -796,6 +914,119 @@ unsigned char ccGBLSensor::checkVisibility(const CCVector3& P) const
 	return CCCoreLib::POINT_VISIBLE;
 }
 
+unsigned char ccGBLSensor::checkVisibility(const CCVector3& P) const
+{
+	if (m_depthBuffer.zBuff.empty()) //no z-buffer?
+	{
+		return CCCoreLib::POINT_VISIBLE;
+	}
+
+	//project point
+	CCVector2 Q;
+	PointCoordinateType depth;
+	projectPoint(P, Q, depth, m_activeIndex);
+
+	return checkProjectedVisibility(Q, depth);
+}
+
+bool ccGBLSensor::ComputeVisibility(CCCoreLib::GenericIndexedCloud* cloud,
+									const std::vector<ccGBLSensor*>& sensors,
+									std::vector<unsigned char>& visibility,
+									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	assert(cloud);
+	if (!cloud)
+	{
+		return false;
+	}
+
+	unsigned pointCount = cloud->size();
+	try
+	{
+		visibility.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	std::vector<ccGLMatrix> worldToSensor;
+	worldToSensor.reserve(sensors.size());
+	for (const ccGBLSensor* sensor : sensors)
+	{
+		assert(sensor);
+		if (sensor->m_depthBuffer.zBuff.empty())
+		{
+			//a sensor without depth buffer sees all the points (see checkVisibility)
+			std::fill(visibility.begin(), visibility.end(), CCCoreLib::POINT_VISIBLE);
+			return true;
+		}
+		worldToSensor.push_back(sensor->getWorldToSensorTransformation(sensor->m_activeIndex));
+	}
+
+	if (sensors.empty())
+	{
+		std::fill(visibility.begin(), visibility.end(), CCCoreLib::POINT_VISIBLE);
+		return true;
+	}
+
+	CCCoreLib::NormalizedProgress nprogress(progressCb, pointCount);
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Compute visibility");
+			progressCb->setInfo(qPrintable(QString("Points: %L1").arg(pointCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	//the points are processed by batches (so that the process can be cancelled)
+	for (unsigned start = 0; start < pointCount; start += s_projectionBatchSize)
+	{
+		int count = static_cast<int>(std::min(pointCount - start, s_projectionBatchSize));
+#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int i = 0; i < count; ++i)
+		{
+			unsigned pointIndex = start + static_cast<unsigned>(i);
+			const CCVector3* P = cloud->getPoint(pointIndex);
+
+			unsigned char bestVisibility = 255; //impossible value
+			for (size_t s = 0; s < sensors.size(); ++s)
+			{
+				CCVector3 Ps = *P;
+				worldToSensor[s].apply(Ps);
+
+				CCVector2 Q;
+				PointCoordinateType depth;
+				sensors[s]->projectInSensorFrame(Ps, Q, depth);
+
+				unsigned char pointVisibility = sensors[s]->checkProjectedVisibility(Q, depth);
+				if (pointVisibility == CCCoreLib::POINT_VISIBLE)
+				{
+					bestVisibility = pointVisibility;
+					break;
+				}
+				bestVisibility = std::min(bestVisibility, pointVisibility);
+			}
+
+			visibility[pointIndex] = bestVisibility;
+		}
+
+		if (progressCb && !nprogress.steps(static_cast<unsigned>(count)))
+		{
+			//cancelled by user
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void ccGBLSensor::drawMeOnly(CC_DRAW_CONTEXT& context)
 {
 	if (!MACRO_Draw3D(context))
@@ -42,10 +42,14 @@
 #include <Neighbourhood.h>
 #include <Delaunay2dMesh.h>
 
+//Qt
+#include <QOpenGLBuffer>
+
 //System
 #include <string.h>
 #include <assert.h>
 #include <cmath> //for std::modf
+#include <limits>
 
 static CCVector3 s_blankNorm(0, 0, 0);
 
@@ -124,10 +128,19 @@ ccMesh::~ccMesh()
 		m_triMtlIndexes->release();
 	if (m_triNormalIndexes)
 		m_triNormalIndexes->release();
+
+	releaseVBOs();
 }
 
 void ccMesh::setAssociatedCloud(ccGenericPointCloud* cloud)
 {
+	if (cloud != m_associatedCloud)
+	{
+		//the VBOs content can't be validated with the feature versions of another cloud
+		//(we don't release them here, as there may be no active GL context)
+		m_vboManager.updateFlags = vboSet::UPDATE_ALL;
+	}
+
 	m_associatedCloud = cloud;
 
 	if (m_associatedCloud)
@@ -147,6 +160,13 @@ void ccMesh::onUpdateOf(ccHObject* obj)
 	ccGenericMesh::onUpdateOf(obj);
 }
 
+void ccMesh::notifyGeometryUpdate()
+{
+	ccGenericMesh::notifyGeometryUpdate();
+
+	trianglesHaveChanged();
+}
+
 void ccMesh::onDeletionOf(const ccHObject* obj)
 {
 	if (obj == m_associatedCloud)
@@ -1581,6 +1601,7 @@ const ccGLMatrix& ccMesh::getGLTransformationHistory() const
 void ccMesh::addTriangle(unsigned i1, unsigned i2, unsigned i3)
 {
 	m_triVertIndexes->emplace_back(CCCoreLib::VerticesIndexes(i1, i2, i3));
+	trianglesHaveChanged();
 }
 
 bool ccMesh::reserve(size_t n)
@@ -1634,6 +1655,7 @@ void ccMesh::swapTriangles(unsigned index1, unsigned index2)
 	assert(std::max(index1, index2) < size());
 
 	m_triVertIndexes->swap(index1, index2);
+	trianglesHaveChanged();
 	if (m_triMtlIndexes)
 		m_triMtlIndexes->swap(index1, index2);
 	if (m_texCoordIndexes)
@@ -1837,7 +1859,74 @@ void ccMesh::drawMeOnly(CC_DRAW_CONTEXT& context)
 			EnableGLStippleMask(context.qGLContext, true);
 		}
 
-		if (!visFiltering && !(applyMaterials || showTextures) && (!glParams.showSF || !sfMayHaveHiddenValues))
+		//fast display modes (no per-vertex/per-triangle filtering)
+		bool fastDisplay = (!visFiltering && !(applyMaterials || showTextures) && (!glParams.showSF || !sfMayHaveHiddenValues));
+
+		//persistent VBOs with indexed display (not compatible with per-triangle normals)
+		//note: the whole mesh is displayed in this mode (the L.O.D. was only meant to reduce the amount of data sent at each frame)
+		bool useVBOs = (fastDisplay && context.useVBOs && !showTriNormals && updateVBOs(context, glParams));
+
+		if (useVBOs)
+		{
+			//the GL type depends on the PointCoordinateType 'size' (float or double)
+			GLenum GL_COORD_TYPE = sizeof(PointCoordinateType) == 4 ? GL_FLOAT : GL_DOUBLE;
+
+			const GLbyte* start = nullptr; //fake pointer used to prevent warnings on Linux
+
+			if (m_vboManager.vertices->bind())
+			{
+				glFunc->glEnableClientState(GL_VERTEX_ARRAY);
+				glFunc->glVertexPointer(3, GL_COORD_TYPE, 0, nullptr);
+
+				if (glParams.showNorms)
+				{
+					glFunc->glEnableClientState(GL_NORMAL_ARRAY);
+					glFunc->glNormalPointer(GL_COORD_TYPE, 0, static_cast<const GLvoid*>(start + m_vboManager.normalShift));
+				}
+				if (glParams.showSF || glParams.showColors)
+				{
+					glFunc->glEnableClientState(GL_COLOR_ARRAY);
+					glFunc->glColorPointer(4, GL_UNSIGNED_BYTE, 0, static_cast<const GLvoid*>(start + m_vboManager.rgbShift));
+				}
+
+				m_vboManager.vertices->release();
+
+				if (showWired)
+				{
+					glFunc->glPushAttrib(GL_POLYGON_BIT);
+					glFunc->glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+				}
+
+				if (m_vboManager.indexes->bind())
+				{
+					glFunc->glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_vboManager.triangleCount * 3), GL_UNSIGNED_INT, nullptr);
+					m_vboManager.indexes->release();
+				}
+				else
+				{
+					ccLog::Warning("[VBO] Failed to bind VBO?! We'll deactivate them then...");
+					m_vboManager.state = vboSet::FAILED;
+				}
+
+				if (showWired)
+				{
+					glFunc->glPopAttrib(); //GL_POLYGON_BIT
+				}
+
+				//disable arrays
+				glFunc->glDisableClientState(GL_VERTEX_ARRAY);
+				if (glParams.showNorms)
+					glFunc->glDisableClientState(GL_NORMAL_ARRAY);
+				if (glParams.showSF || glParams.showColors)
+					glFunc->glDisableClientState(GL_COLOR_ARRAY);
+			}
+			else
+			{
+				ccLog::Warning("[VBO] Failed to bind VBO?! We'll deactivate them then...");
+				m_vboManager.state = vboSet::FAILED;
+			}
+		}
+		else if (fastDisplay)
 		{
 			assert(!entityPickingMode || !glParams.showSF);
 			//the GL type depends on the PointCoordinateType 'size' (float or double)
@@ -2180,6 +2269,400 @@ void ccMesh::drawMeOnly(CC_DRAW_CONTEXT& context)
 	}
 }
 
+//! Allocates a VBO (if necessary)
+/** \return false if the VBO couldn't be created or allocated
+**/
+static bool InitVBO(QOpenGLBuffer*& vbo, QOpenGLBuffer::Type type, qint64 sizeBytes, bool& reallocated)
+{
+	reallocated = false;
+
+	if (sizeBytes > std::numeric_limits<int>::max())
+	{
+		//QOpenGLBuffer can't handle buffers of this size
+		return false;
+	}
+
+	if (!vbo)
+	{
+		vbo = new QOpenGLBuffer(type);
+	}
+
+	if (!vbo->isCreated())
+	{
+		if (!vbo->create())
+		{
+			//no message as it will probably happen on a lot on (old) graphic cards
+			return false;
+		}
+		vbo->setUsagePattern(QOpenGLBuffer::StaticDraw); //"StaticDraw: The data will be set once and used many times for drawing operations."
+	}
+
+	if (!vbo->bind())
+	{
+		ccLog::Warning("[ccMesh::updateVBOs] Failed to bind VBO to active context!");
+		vbo->destroy();
+		return false;
+	}
+
+	if (vbo->size() != static_cast<int>(sizeBytes))
+	{
+		vbo->allocate(static_cast<int>(sizeBytes));
+		reallocated = true;
+
+		if (vbo->size() != static_cast<int>(sizeBytes))
+		{
+			ccLog::Warning("[ccMesh::updateVBOs] Not enough (GPU) memory!");
+			vbo->release();
+			vbo->destroy();
+			return false;
+		}
+	}
+
+	vbo->release();
+
+	return true;
+}
+
+bool ccMesh::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams& glParams)
+{
+	if (m_vboManager.state == vboSet::FAILED)
+	{
+		return false;
+	}
+
+	if (!m_currentDisplay)
+	{
+		ccLog::Warning(QString("[ccMesh::updateVBOs] Need an associated GL context! (mesh '%1')").arg(getName()));
+		assert(false);
+		return false;
+	}
+
+	//the vertices features are read directly from the cloud structures
+	if (!m_associatedCloud || !m_associatedCloud->isA(CC_TYPES::POINT_CLOUD))
+	{
+		return false;
+	}
+	ccPointCloud* cloud = static_cast<ccPointCloud*>(m_associatedCloud);
+	const ccPointCloud::FeatureVersions& versions = cloud->getFeatureVersions();
+	ccScalarField* currentSF = glParams.showSF ? cloud->getCurrentDisplayedScalarField() : nullptr;
+
+	unsigned vertexCount = cloud->size();
+	size_t triCount = m_triVertIndexes->size();
+
+	bool withColors = (glParams.showSF || glParams.showColors);
+	bool withNormals = glParams.showNorms;
+
+	if (m_vboManager.state == vboSet::INITIALIZED)
+	{
+		if (	m_vboManager.vertexCount != vertexCount
+			||	(withColors && !m_vboManager.hasColors)
+			||	(withNormals && !m_vboManager.hasNormals))
+		{
+			//the vertex buffer layout has changed
+			m_vboManager.updateFlags = vboSet::UPDATE_ALL;
+		}
+		else
+		{
+			//let's check if something has changed
+			if (m_vboManager.pointsVersion != versions.points)
+			{
+				m_vboManager.updateFlags |= vboSet::UPDATE_POINTS;
+			}
+
+			if (glParams.showColors && (m_vboManager.colorIsSF || m_vboManager.colorsVersion != versions.colors))
+			{
+				m_vboManager.updateFlags |= vboSet::UPDATE_COLORS;
+			}
+
+			if (	glParams.showSF
+				&& (	!m_vboManager.colorIsSF
+					||	m_vboManager.sourceSF != currentSF
+					||	m_vboManager.colorsVersion != versions.colors
+					||	(currentSF && currentSF->getModificationFlag())))
+			{
+				m_vboManager.updateFlags |= vboSet::UPDATE_COLORS;
+			}
+
+			if (withNormals && m_vboManager.normalsVersion != versions.normals)
+			{
+				m_vboManager.updateFlags |= vboSet::UPDATE_NORMALS;
+			}
+
+			if (m_vboManager.triangleCount != triCount)
+			{
+				m_vboManager.updateFlags |= vboSet::UPDATE_TRIANGLES;
+			}
+		}
+
+		//nothing to do?
+		if (m_vboManager.updateFlags == 0)
+		{
+			return true;
+		}
+	}
+	else
+	{
+		m_vboManager.updateFlags = vboSet::UPDATE_ALL;
+	}
+
+	if (m_vboManager.updateFlags == vboSet::UPDATE_ALL)
+	{
+		//the vertex buffer layout only depends on the currently displayed features
+		m_vboManager.hasColors = withColors;
+		m_vboManager.hasNormals = withNormals;
+	}
+
+	//vertex buffer layout
+	qint64 vertexBufferSizeBytes = static_cast<qint64>(sizeof(PointCoordinateType)) * vertexCount * 3;
+	if (m_vboManager.hasColors)
+	{
+		m_vboManager.rgbShift = static_cast<int>(std::min<qint64>(vertexBufferSizeBytes, std::numeric_limits<int>::max()));
+		vertexBufferSizeBytes += static_cast<qint64>(sizeof(ColorCompType)) * vertexCount * 4;
+	}
+	if (m_vboManager.hasNormals)
+	{
+		m_vboManager.normalShift = static_cast<int>(std::min<qint64>(vertexBufferSizeBytes, std::numeric_limits<int>::max()));
+		vertexBufferSizeBytes += static_cast<qint64>(sizeof(PointCoordinateType)) * vertexCount * 3;
+	}
+	qint64 indexBufferSizeBytes = static_cast<qint64>(sizeof(CCCoreLib::VerticesIndexes)) * triCount;
+
+	QOpenGLFunctions_2_1* glFunc = context.glFunctions<QOpenGLFunctions_2_1>();
+	assert(glFunc != nullptr);
+	if (!glFunc)
+	{
+		return false;
+	}
+
+	//init VBOs
+	bool verticesReallocated = false;
+	bool indexesReallocated = false;
+	if (	!InitVBO(m_vboManager.vertices, QOpenGLBuffer::VertexBuffer, vertexBufferSizeBytes, verticesReallocated)
+		||	!InitVBO(m_vboManager.indexes, QOpenGLBuffer::IndexBuffer, indexBufferSizeBytes, indexesReallocated))
+	{
+		ccLog::Warning(QString("[ccMesh::updateVBOs] Failed to initialize VBOs (not enough memory?) (mesh '%1')").arg(getName()));
+		releaseVBOs();
+		m_vboManager.state = vboSet::FAILED;
+		return false;
+	}
+
+	if (verticesReallocated)
+	{
+		//if the vbo is reallocated, then all its content has been cleared!
+		m_vboManager.updateFlags |= (vboSet::UPDATE_POINTS | vboSet::UPDATE_COLORS | vboSet::UPDATE_NORMALS);
+	}
+	if (indexesReallocated)
+	{
+		m_vboManager.updateFlags |= vboSet::UPDATE_TRIANGLES;
+	}
+
+	//vertices features
+	if (m_vboManager.updateFlags & (vboSet::UPDATE_POINTS | vboSet::UPDATE_COLORS | vboSet::UPDATE_NORMALS))
+	{
+		m_vboManager.vertices->bind();
+
+		size_t chunkCount = ccChunk::Count(vertexCount);
+
+		//load points
+		if (m_vboManager.updateFlags & vboSet::UPDATE_POINTS)
+		{
+			for (size_t k = 0; k < chunkCount; ++k)
+			{
+				size_t chunkStart = ccChunk::StartPos(k);
+				int chunkSize = static_cast<int>(ccChunk::Size(k, vertexCount));
+				m_vboManager.vertices->write(	static_cast<int>(sizeof(PointCoordinateType) * chunkStart * 3),
+												cloud->getPoint(static_cast<unsigned>(chunkStart)),
+												static_cast<int>(sizeof(PointCoordinateType)) * chunkSize * 3);
+			}
+			m_vboManager.pointsVersion = versions.points;
+		}
+
+		//load colors
+		if ((m_vboManager.updateFlags & vboSet::UPDATE_COLORS) && withColors)
+		{
+			if (glParams.showSF)
+			{
+				if (currentSF)
+				{
+					//convert the SF values to colors
+					ccColor::Rgba* _sfColors = reinterpret_cast<ccColor::Rgba*>(GetColorsBuffer());
+					for (size_t k = 0; k < chunkCount; ++k)
+					{
+						size_t chunkStart = ccChunk::StartPos(k);
+						int chunkSize = static_cast<int>(ccChunk::Size(k, vertexCount));
+						for (int j = 0; j < chunkSize; ++j)
+						{
+							const ccColor::Rgb* col = currentSF->getValueColor(static_cast<unsigned>(chunkStart + j));
+							_sfColors[j] = ccColor::FromRgbToRgba(col ? *col : ccColor::lightGreyRGB);
+						}
+						m_vboManager.vertices->write(	m_vboManager.rgbShift + static_cast<int>(sizeof(ColorCompType) * chunkStart * 4),
+														_sfColors,
+														static_cast<int>(sizeof(ColorCompType)) * chunkSize * 4);
+					}
+
+					if (currentSF->getModificationFlag())
+					{
+						currentSF->setModificationFlag(false);
+						//the cloud VBOs (if any) won't see the flag anymore
+						cloud->colorsHaveChanged();
+					}
+				}
+				else
+				{
+					assert(false);
+				}
+			}
+			else if (glParams.showColors)
+			{
+				const RGBAColorsTableType* rgbaColors = cloud->rgbaColors();
+				assert(rgbaColors && rgbaColors->size() >= vertexCount);
+				for (size_t k = 0; k < chunkCount; ++k)
+				{
+					size_t chunkStart = ccChunk::StartPos(k);
+					int chunkSize = static_cast<int>(ccChunk::Size(k, vertexCount));
+					m_vboManager.vertices->write(	m_vboManager.rgbShift + static_cast<int>(sizeof(ColorCompType) * chunkStart * 4),
+													ccChunk::Start(*rgbaColors, k),
+													static_cast<int>(sizeof(ColorCompType)) * chunkSize * 4);
+				}
+			}
+
+			m_vboManager.colorIsSF = glParams.showSF;
+			m_vboManager.sourceSF = currentSF;
+			m_vboManager.colorsVersion = versions.colors;
+		}
+
+		//load normals
+		if ((m_vboManager.updateFlags & vboSet::UPDATE_NORMALS) && withNormals)
+		{
+			//we must decode the normals first!
+			const NormsIndexesTableType* normals = cloud->normals();
+			assert(normals && normals->size() >= vertexCount);
+			CCVector3* _normals = GetNormalsBuffer();
+			for (size_t k = 0; k < chunkCount; ++k)
+			{
+				size_t chunkStart = ccChunk::StartPos(k);
+				int chunkSize = static_cast<int>(ccChunk::Size(k, vertexCount));
+				const CompressedNormType* _normIndexes = ccChunk::Start(*normals, k);
+				for (int j = 0; j < chunkSize; ++j)
+				{
+					_normals[j] = ccNormalVectors::GetNormal(_normIndexes[j]);
+				}
+				m_vboManager.vertices->write(	m_vboManager.normalShift + static_cast<int>(sizeof(PointCoordinateType) * chunkStart * 3),
+												_normals,
+												static_cast<int>(sizeof(PointCoordinateType)) * chunkSize * 3);
+			}
+			m_vboManager.normalsVersion = versions.normals;
+		}
+
+		m_vboManager.vertices->release();
+	}
+
+	//triangles
+	if (m_vboManager.updateFlags & vboSet::UPDATE_TRIANGLES)
+	{
+		m_vboManager.indexes->bind();
+		size_t chunkCount = ccChunk::Count(triCount);
+		for (size_t k = 0; k < chunkCount; ++k)
+		{
+			size_t chunkStart = ccChunk::StartPos(k);
+			int chunkSize = static_cast<int>(ccChunk::Size(k, triCount));
+			m_vboManager.indexes->write(static_cast<int>(sizeof(CCCoreLib::VerticesIndexes) * chunkStart),
+										ccChunk::Start(*m_triVertIndexes, k),
+										static_cast<int>(sizeof(CCCoreLib::VerticesIndexes)) * chunkSize);
+		}
+		m_vboManager.indexes->release();
+	}
+
+	//if an error is detected
+	GLenum glError = glFunc->glGetError();
+	if (glError != GL_NO_ERROR)
+	{
+		ccLog::Warning(QString("[ccMesh::updateVBOs] OpenGL error 0x%1 (mesh '%2')").arg(glError, 0, 16).arg(getName()));
+		releaseVBOs();
+		m_vboManager.state = vboSet::FAILED;
+		return false;
+	}
+
+#ifdef _DEBUG
+	size_t totalSizeBytesBefore = m_vboManager.totalMemSizeBytes;
+#endif
+	m_vboManager.totalMemSizeBytes = static_cast<size_t>(vertexBufferSizeBytes + indexBufferSizeBytes);
+	m_vboManager.vertexCount = vertexCount;
+	m_vboManager.triangleCount = triCount;
+
+#ifdef _DEBUG
+	if (m_vboManager.totalMemSizeBytes != totalSizeBytesBefore)
+		ccLog::Print(QString("[VBO] VBO(s) (re)initialized for mesh '%1' (%2 Mb)")
+			.arg(getName())
+			.arg(static_cast<double>(m_vboManager.totalMemSizeBytes) / (1 << 20), 0, 'f', 2));
+#endif
+
+	m_vboManager.state = vboSet::INITIALIZED;
+	m_vboManager.updateFlags = 0;
+
+	return true;
+}
+
+size_t ccMesh::vboSize() const
+{
+	return m_vboManager.totalMemSizeBytes;
+}
+
+void ccMesh::releaseVBOs()
+{
+	if (m_vboManager.state == vboSet::NEW && !m_vboManager.vertices && !m_vboManager.indexes)
+		return;
+
+	if (m_currentDisplay)
+	{
+		//'destroy' the VBOs
+		for (QOpenGLBuffer** vbo : { &m_vboManager.vertices, &m_vboManager.indexes })
+		{
+			if (*vbo)
+			{
+				(*vbo)->destroy();
+				delete *vbo;
+				*vbo = nullptr;
+			}
+		}
+	}
+	else
+	{
+		assert(!m_vboManager.vertices && !m_vboManager.indexes);
+	}
+
+	m_vboManager.vertexCount = 0;
+	m_vboManager.triangleCount = 0;
+	m_vboManager.hasColors = false;
+	m_vboManager.hasNormals = false;
+	m_vboManager.colorIsSF = false;
+	m_vboManager.sourceSF = nullptr;
+	m_vboManager.totalMemSizeBytes = 0;
+	m_vboManager.updateFlags = 0;
+	m_vboManager.state = vboSet::NEW;
+}
+
+void ccMesh::setDisplay(ccGenericGLDisplay* win)
+{
+	if (m_currentDisplay && win != m_currentDisplay)
+	{
+		//be sure to release the VBOs before switching to another (or no) display!
+		releaseVBOs();
+	}
+
+	ccGenericMesh::setDisplay(win);
+}
+
+void ccMesh::removeFromDisplay(const ccGenericGLDisplay* win)
+{
+	if (win == m_currentDisplay)
+	{
+		releaseVBOs();
+	}
+
+	//call parent's method
+	ccGenericMesh::removeFromDisplay(win);
+}
+
 ccMesh* ccMesh::createNewMeshFromSelection(	bool removeSelectedTriangles,
 											std::vector<int>* newIndexesOfRemainingTriangles/*=nullptr*/,
 											bool withChildEntities/*=false*/)
@@ -2667,6 +3150,7 @@ void ccMesh::shiftTriangleIndexes(unsigned shift)
 		ti.i2 += shift;
 		ti.i3 += shift;
 	}
+	trianglesHaveChanged();
 }
 
 void ccMesh::flipTriangles()
@@ -2675,6 +3159,7 @@ void ccMesh::flipTriangles()
 	{
 		std::swap(ti.i2, ti.i3);
 	}
+	trianglesHaveChanged();
 }
 
 /*********************************************************/
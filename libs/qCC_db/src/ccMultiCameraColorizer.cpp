@@ -0,0 +1,782 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccMultiCameraColorizer.h"
+
+//Local
+#include "ccCameraSensor.h"
+#include "ccImage.h"
+#include "ccLog.h"
+#include "ccPointCloud.h"
+
+//CCCoreLib
+#include <GenericProgressCallback.h>
+
+//Qt
+#include <QImageReader>
+
+//system
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#if defined(_OPENMP)
+//OpenMP
+#include <omp.h>
+#endif
+
+//! Average number of points per grid cell
+static const unsigned c_targetPointsPerCell = 256;
+//! Max grid resolution (along each dimension)
+static const unsigned c_maxGridResolution = 64;
+//! Relative margin added to the field of view when indexing the cameras (to account for the lens distortion)
+static const float c_fovMargin = 0.1f;
+//! Min frontality (so that the points seen from a grazing angle are not completely discarded)
+static const float c_minFrontality = 0.05f;
+
+namespace
+{
+	//! Coarse grid over the cloud (only the occupied cells are stored)
+	struct CellGrid
+	{
+		//! Grid origin
+		CCVector3 origin;
+		//! Cell size
+		PointCoordinateType cellSize = 0;
+		//! Grid resolution (along each dimension)
+		unsigned resolution = 0;
+		//! Occupied cells positions (i + j * res + k * res^2)
+		std::vector<unsigned> cellPos;
+		//! Index of the first point of each occupied cell in 'pointIndexes' (+ the total number of points)
+		std::vector<unsigned> cellStart;
+		//! Point indexes (sorted by cell)
+		std::vector<unsigned> pointIndexes;
+
+		//! Returns the min corner of an occupied cell
+		CCVector3 cellMin(size_t cellIndex) const
+		{
+			unsigned pos = cellPos[cellIndex];
+			unsigned i = pos % resolution;
+			unsigned j = (pos / resolution) % resolution;
+			unsigned k = pos / (resolution * resolution);
+			return origin + CCVector3(i * cellSize, j * cellSize, k * cellSize);
+		}
+	};
+
+	//! Camera (pre-computed) geometry
+	struct CameraGeometry
+	{
+		//! Global to local (sensor) transformation
+		ccGLMatrix globalToLocal;
+		//! Camera center (global coordinates system)
+		CCVector3 center;
+		//! Array width (in pixels)
+		int width = 0;
+		//! Array height (in pixels)
+		int height = 0;
+		//! Indexes of the cells that may be seen by the camera
+		std::vector<unsigned> cells;
+		//! Whether the camera is valid
+		bool isValid = false;
+	};
+
+	//! Projected point sample
+	struct Sample
+	{
+		//! Point index
+		unsigned index;
+		//! Weight
+		float weight;
+		//! Color
+		ccColor::Rgb color;
+	};
+
+	//! Returns whether a (global) axis-aligned box is completely outside the field of view of a camera
+	bool IsBoxOutside(const CCVector3& bbMin, PointCoordinateType size, const ccGLMatrix& globalToLocal, const float xRange[2], const float yRange[2])
+	{
+		//the camera looks along -Z: depth = -z. The field of view is the intersection of
+		//the half-spaces xRange[0] * depth <= x <= xRange[1] * depth (same for y)
+		unsigned char outside[5] = { 0, 0, 0, 0, 0 };
+		for (unsigned char c = 0; c < 8; ++c)
+		{
+			CCVector3 P(	bbMin.x + ((c & 1) ? size : 0),
+							bbMin.y + ((c & 2) ? size : 0),
+							bbMin.z + ((c & 4) ? size : 0) );
+			globalToLocal.apply(P);
+			PointCoordinateType depth = -P.z;
+
+			if (P.x > xRange[1] * depth) ++outside[0];
+			if (P.x < xRange[0] * depth) ++outside[1];
+			if (P.y > yRange[1] * depth) ++outside[2];
+			if (P.y < yRange[0] * depth) ++outside[3];
+			if (depth <= 0) ++outside[4];
+		}
+
+		//the box is outside if all its corners are outside of the same half-space
+		for (unsigned char i = 0; i < 5; ++i)
+		{
+			if (outside[i] == 8)
+				return true;
+		}
+		return false;
+	}
+}
+
+bool ccMultiCameraColorizer::addCamera(ccCameraSensor* sensor, const ccImage* image)
+{
+	if (!sensor || !image || image->data().isNull())
+	{
+		return false;
+	}
+
+	const ccCameraSensor::IntrinsicParameters& params = sensor->getIntrinsicParameters();
+	if (params.arrayWidth <= 0 || params.arrayHeight <= 0)
+	{
+		return false;
+	}
+
+	try
+	{
+		Camera camera;
+		camera.sensor = sensor;
+		camera.image = image;
+		m_cameras.push_back(camera);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool ccMultiCameraColorizer::addCamera(ccCameraSensor* sensor, const QString& imageFilename)
+{
+	if (!sensor || imageFilename.isEmpty())
+	{
+		return false;
+	}
+
+	const ccCameraSensor::IntrinsicParameters& params = sensor->getIntrinsicParameters();
+	if (params.arrayWidth <= 0 || params.arrayHeight <= 0)
+	{
+		return false;
+	}
+
+	try
+	{
+		Camera camera;
+		camera.sensor = sensor;
+		camera.imageFilename = imageFilename;
+		m_cameras.push_back(camera);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+//! Builds the grid over the cloud
+static bool BuildGrid(ccPointCloud& cloud, CellGrid& grid)
+{
+	unsigned pointCount = cloud.size();
+
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud.getBoundingBox(bbMin, bbMax);
+	CCVector3 diag = bbMax - bbMin;
+	PointCoordinateType maxDim = std::max(diag.x, std::max(diag.y, diag.z));
+
+	grid.resolution = static_cast<unsigned>(std::round(std::cbrt(static_cast<double>(pointCount) / c_targetPointsPerCell)));
+	grid.resolution = std::max(1u, std::min(grid.resolution, c_maxGridResolution));
+	grid.origin = bbMin;
+	grid.cellSize = (maxDim > 0 ? maxDim / grid.resolution : CCCoreLib::PC_ONE);
+	//we slightly enlarge the cells so that the points on the upper boundary fall inside the grid
+	grid.cellSize *= static_cast<PointCoordinateType>(1.0 + 1.0e-6);
+
+	const unsigned res = grid.resolution;
+	std::vector<unsigned> pointPos;
+	std::vector<unsigned> cellCount;
+	try
+	{
+		pointPos.resize(pointCount);
+		cellCount.resize(static_cast<size_t>(res) * res * res, 0);
+		grid.pointIndexes.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	int count = static_cast<int>(pointCount);
+#if defined(_OPENMP)
+	#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int i = 0; i < count; ++i)
+	{
+		CCVector3 P = (*cloud.getPoint(static_cast<unsigned>(i)) - grid.origin) / grid.cellSize;
+		unsigned x = std::min(static_cast<unsigned>(std::max<PointCoordinateType>(P.x, 0)), res - 1);
+		unsigned y = std::min(static_cast<unsigned>(std::max<PointCoordinateType>(P.y, 0)), res - 1);
+		unsigned z = std::min(static_cast<unsigned>(std::max<PointCoordinateType>(P.z, 0)), res - 1);
+		pointPos[i] = x + (y + z * res) * res;
+	}
+
+	//counting sort
+	for (unsigned pos : pointPos)
+	{
+		++cellCount[pos];
+	}
+
+	size_t occupiedCount = cellCount.size() - std::count(cellCount.begin(), cellCount.end(), 0u);
+	try
+	{
+		grid.cellPos.reserve(occupiedCount);
+		grid.cellStart.reserve(occupiedCount + 1);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	//cellCount now stores the insertion position of each cell
+	unsigned start = 0;
+	for (size_t pos = 0; pos < cellCount.size(); ++pos)
+	{
+		unsigned n = cellCount[pos];
+		if (n != 0)
+		{
+			grid.cellPos.push_back(static_cast<unsigned>(pos));
+			grid.cellStart.push_back(start);
+		}
+		cellCount[pos] = start;
+		start += n;
+	}
+	grid.cellStart.push_back(start);
+
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		grid.pointIndexes[cellCount[pointPos[i]]++] = i;
+	}
+
+	return true;
+}
+
+//! Projects the points of the cells seen by a camera, and computes their weight (and color)
+/** \param cloud point cloud
+	\param grid grid
+	\param sensor camera sensor
+	\param geom camera geometry
+	\param params colorization parameters
+	\param cameraIndex camera index
+	\param bestCameras best camera for each point (optional: only the points for which this camera is the best one are kept)
+	\param image image (optional: to fetch the point colors)
+	\param samples output samples
+**/
+static void ProcessCamera(	const ccPointCloud& cloud,
+							const CellGrid& grid,
+							const ccCameraSensor& sensor,
+							const CameraGeometry& geom,
+							const ccMultiCameraColorizer::Parameters& params,
+							int cameraIndex,
+							const std::vector<int>* bestCameras,
+							const QImage* image,
+							std::vector<Sample>& samples)
+{
+	struct Projection
+	{
+		unsigned index;
+		CCVector2 pix;
+		PointCoordinateType depth;
+	};
+
+	//project the points
+	std::vector<Projection> projections;
+	for (unsigned cellIndex : geom.cells)
+	{
+		for (unsigned j = grid.cellStart[cellIndex]; j < grid.cellStart[cellIndex + 1]; ++j)
+		{
+			unsigned index = grid.pointIndexes[j];
+			if (bestCameras && bestCameras->at(index) != cameraIndex)
+			{
+				continue;
+			}
+
+			CCVector3 P = *cloud.getPoint(index);
+			geom.globalToLocal.apply(P);
+
+			Projection proj;
+			if (!sensor.fromLocalCoordToImageCoord(P, proj.pix, true))
+			{
+				//behind the camera
+				continue;
+			}
+			if (proj.pix.x < 0 || proj.pix.x >= geom.width || proj.pix.y < 0 || proj.pix.y >= geom.height)
+			{
+				//outside of the image
+				continue;
+			}
+
+			proj.index = index;
+			proj.depth = -P.z;
+			projections.push_back(proj);
+		}
+	}
+
+	if (projections.empty())
+	{
+		return;
+	}
+
+	//depth map (to test the occlusions)
+	std::vector<PointCoordinateType> depthMap;
+	float depthMapScale = 1.0f;
+	unsigned depthMapWidth = 0;
+	if (params.testOcclusions && !bestCameras) //no need to test the occlusions again for the best camera
+	{
+		depthMapScale = std::min(1.0f, static_cast<float>(params.depthMapMaxSize) / std::max(geom.width, geom.height));
+		depthMapWidth = std::max(1u, static_cast<unsigned>(std::ceil(geom.width * depthMapScale)));
+		unsigned depthMapHeight = std::max(1u, static_cast<unsigned>(std::ceil(geom.height * depthMapScale)));
+		depthMap.resize(static_cast<size_t>(depthMapWidth) * depthMapHeight, std::numeric_limits<PointCoordinateType>::max());
+
+		//we keep the closest point in each cell
+		for (const Projection& proj : projections)
+		{
+			unsigned x = std::min(static_cast<unsigned>(proj.pix.x * depthMapScale), depthMapWidth - 1);
+			unsigned y = std::min(static_cast<unsigned>(proj.pix.y * depthMapScale), depthMapHeight - 1);
+			PointCoordinateType& depth = depthMap[y * depthMapWidth + x];
+			depth = std::min(depth, proj.depth);
+		}
+	}
+
+	bool useNormals = (params.useNormals && cloud.hasNormals());
+	float imageScaleX = (image ? static_cast<float>(image->width()) / geom.width : 0.0f);
+	float imageScaleY = (image ? static_cast<float>(image->height()) / geom.height : 0.0f);
+
+	samples.reserve(projections.size());
+	for (const Projection& proj : projections)
+	{
+		if (!depthMap.empty())
+		{
+			unsigned x = std::min(static_cast<unsigned>(proj.pix.x * depthMapScale), depthMapWidth - 1);
+			unsigned y = std::min(static_cast<unsigned>(proj.pix.y * depthMapScale), static_cast<unsigned>(depthMap.size() / depthMapWidth) - 1);
+			if (proj.depth > depthMap[y * depthMapWidth + x] * (1.0f + params.depthTolerance))
+			{
+				//occluded
+				continue;
+			}
+		}
+
+		//the weight is the inverse of the pixel footprint on the surface (i.e. closest and most frontal images first)
+		float frontality = 1.0f;
+		if (useNormals)
+		{
+			const CCVector3* P = cloud.getPoint(proj.index);
+			CCVector3 viewDir = geom.center - *P;
+			viewDir.normalize();
+			//the normals are not necessarily oriented
+			frontality = std::max(c_minFrontality, static_cast<float>(std::abs(cloud.getPointNormal(proj.index).dot(viewDir))));
+		}
+		PointCoordinateType depth = std::max(proj.depth, std::numeric_limits<PointCoordinateType>::epsilon());
+
+		Sample sample;
+		sample.index = proj.index;
+		sample.weight = frontality / static_cast<float>(depth * depth);
+		sample.color = ccColor::blackRGB;
+
+		if (image)
+		{
+			int x = std::min(static_cast<int>(proj.pix.x * imageScaleX), image->width() - 1);
+			int y = std::min(static_cast<int>(proj.pix.y * imageScaleY), image->height() - 1);
+			QRgb rgb = image->pixel(x, y);
+			sample.color = ccColor::Rgb(	static_cast<ColorCompType>(qRed(rgb)),
+											static_cast<ColorCompType>(qGreen(rgb)),
+											static_cast<ColorCompType>(qBlue(rgb)) );
+		}
+
+		samples.push_back(sample);
+	}
+}
+
+bool ccMultiCameraColorizer::colorize(	ccPointCloud* cloud,
+										const Parameters& params,
+										QString& errorMessage,
+										unsigned* colorizedCount/*=nullptr*/,
+										CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/) const
+{
+	if (colorizedCount)
+	{
+		*colorizedCount = 0;
+	}
+
+	if (!cloud || cloud->size() == 0)
+	{
+		errorMessage = "Invalid input cloud";
+		return false;
+	}
+	if (m_cameras.empty())
+	{
+		errorMessage = "No camera";
+		return false;
+	}
+
+	int threadCount = 1;
+#if defined(_OPENMP)
+	threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads());
+#endif
+	//the number of cameras processed at once bounds the number of decoded images in memory
+	size_t chunkSize = (params.maxDecodedImages != 0 ? params.maxDecodedImages : static_cast<unsigned>(threadCount));
+
+	unsigned pointCount = cloud->size();
+	int cameraCount = static_cast<int>(m_cameras.size());
+
+	//grid over the cloud
+	CellGrid grid;
+	if (!BuildGrid(*cloud, grid))
+	{
+		errorMessage = "Not enough memory";
+		return false;
+	}
+
+	//camera index: cells that may be seen by each camera
+	std::vector<CameraGeometry> geometries;
+	try
+	{
+		geometries.resize(m_cameras.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		errorMessage = "Not enough memory";
+		return false;
+	}
+
+	for (int c = 0; c < cameraCount; ++c)
+	{
+		//the sensor transformation is not thread-safe (it may rely on the parent entities)
+		ccIndexedTransformation trans;
+		if (!m_cameras[c].sensor->getActiveAbsoluteTransformation(trans))
+		{
+			ccLog::Warning(QString("[ccMultiCameraColorizer] Camera '%1' has no valid position (ignored)").arg(m_cameras[c].sensor->getName()));
+			continue;
+		}
+		CameraGeometry& geom = geometries[c];
+		geom.globalToLocal = trans.inverse();
+		geom.center = trans.getTranslationAsVec3D();
+		geom.width = m_cameras[c].sensor->getIntrinsicParameters().arrayWidth;
+		geom.height = m_cameras[c].sensor->getIntrinsicParameters().arrayHeight;
+		geom.isValid = true;
+	}
+
+	std::atomic<bool> memoryError(false);
+#if defined(_OPENMP)
+	#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+	for (int c = 0; c < cameraCount; ++c)
+	{
+		CameraGeometry& geom = geometries[c];
+		if (!geom.isValid)
+		{
+			continue;
+		}
+
+		//field of view (tangent of the angles)
+		const ccCameraSensor::IntrinsicParameters& intrinsics = m_cameras[c].sensor->getIntrinsicParameters();
+		float f = intrinsics.vertFocal_pix;
+		float xRange[2] = { -intrinsics.principal_point[0] / f, (geom.width - intrinsics.principal_point[0]) / f };
+		float yRange[2] = { (intrinsics.principal_point[1] - geom.height) / f, intrinsics.principal_point[1] / f };
+		float xMargin = c_fovMargin * (xRange[1] - xRange[0]);
+		float yMargin = c_fovMargin * (yRange[1] - yRange[0]);
+		xRange[0] -= xMargin;
+		xRange[1] += xMargin;
+		yRange[0] -= yMargin;
+		yRange[1] += yMargin;
+
+		try
+		{
+			for (size_t i = 0; i < grid.cellPos.size(); ++i)
+			{
+				if (!IsBoxOutside(grid.cellMin(i), grid.cellSize, geom.globalToLocal, xRange, yRange))
+				{
+					geom.cells.push_back(static_cast<unsigned>(i));
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			memoryError = true;
+		}
+	}
+	if (memoryError)
+	{
+		errorMessage = "Not enough memory";
+		return false;
+	}
+
+	//per-point accumulators
+	std::vector<int> bestCameras;
+	std::vector<float> bestWeights;
+	std::vector<float> blendedColors; //R, G, B, sum of the weights
+	try
+	{
+		if (params.mode == BEST_IMAGE)
+		{
+			bestCameras.resize(pointCount, -1);
+			bestWeights.resize(pointCount, 0.0f);
+		}
+		else
+		{
+			blendedColors.resize(4 * static_cast<size_t>(pointCount), 0.0f);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		errorMessage = "Not enough memory";
+		return false;
+	}
+
+	std::vector<ccColor::Rgb> colors;
+	std::vector<bool> hasColor; //whether a color sample has actually been fetched for each point (BEST_IMAGE mode)
+	std::vector<unsigned> bestPointCount; //number of points for which each camera is the best one
+
+	//processes all the cameras (by chunks)
+	auto processCameras = [&](bool withImages, const std::function<void(int, const std::vector<Sample>&)>& merge) -> bool
+	{
+		for (int chunkStart = 0; chunkStart < cameraCount; chunkStart += static_cast<int>(chunkSize))
+		{
+			int chunkEnd = std::min(cameraCount, chunkStart + static_cast<int>(chunkSize));
+
+			std::vector< std::vector<Sample> > chunkSamples(chunkEnd - chunkStart);
+			std::vector<QString> chunkErrors(chunkEnd - chunkStart);
+
+#if defined(_OPENMP)
+			#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+			for (int c = chunkStart; c < chunkEnd; ++c)
+			{
+				const CameraGeometry& geom = geometries[c];
+				if (!geom.isValid || geom.cells.empty())
+				{
+					continue;
+				}
+				if (withImages && !bestPointCount.empty() && bestPointCount[c] == 0)
+				{
+					//no need to decode this image
+					continue;
+				}
+
+				const Camera& camera = m_cameras[c];
+				QImage decodedImage;
+				const QImage* image = nullptr;
+				if (withImages)
+				{
+					if (camera.image)
+					{
+						image = &camera.image->data();
+					}
+					else
+					{
+						//the image is only decoded now (and released as soon as its points are processed)
+						QImageReader reader(camera.imageFilename);
+						decodedImage = reader.read();
+						if (decodedImage.isNull())
+						{
+							chunkErrors[c - chunkStart] = QString("Failed to read image '%1': %2").arg(camera.imageFilename, reader.errorString());
+							continue;
+						}
+						image = &decodedImage;
+					}
+				}
+
+				try
+				{
+					ProcessCamera(	*cloud,
+									grid,
+									*camera.sensor,
+									geom,
+									params,
+									c,
+									(withImages && !bestCameras.empty()) ? &bestCameras : nullptr,
+									image,
+									chunkSamples[c - chunkStart]);
+				}
+				catch (const std::bad_alloc&)
+				{
+					chunkErrors[c - chunkStart] = "Not enough memory";
+					chunkSamples[c - chunkStart].clear();
+				}
+			}
+
+			//merge the results (sequentially)
+			for (int c = chunkStart; c < chunkEnd; ++c)
+			{
+				if (!chunkErrors[c - chunkStart].isEmpty())
+				{
+					ccLog::Warning(QString("[ccMultiCameraColorizer] Camera '%1': %2").arg(m_cameras[c].sensor->getName(), chunkErrors[c - chunkStart]));
+				}
+				merge(c, chunkSamples[c - chunkStart]);
+				chunkSamples[c - chunkStart].clear();
+				chunkSamples[c - chunkStart].shrink_to_fit();
+			}
+
+			if (progressCb)
+			{
+				if (progressCb->isCancelRequested())
+				{
+					return false;
+				}
+				progressCb->update(100.0f * chunkEnd / cameraCount);
+			}
+		}
+
+		return true;
+	};
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle(QObject::tr("Colorization"));
+			progressCb->setInfo(QObject::tr("Points: %L1\nCameras: %L2").arg(pointCount).arg(cameraCount));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	bool success = true;
+	try
+	{
+		colors.resize(pointCount);
+
+		if (params.mode == BEST_IMAGE)
+		{
+			hasColor.resize(pointCount, false);
+
+			//1st pass: geometry only (we look for the best camera for each point)
+			success = processCameras(false, [&](int c, const std::vector<Sample>& samples)
+			{
+				for (const Sample& sample : samples)
+				{
+					if (sample.weight > bestWeights[sample.index])
+					{
+						bestWeights[sample.index] = sample.weight;
+						bestCameras[sample.index] = c;
+					}
+				}
+			});
+
+			if (success)
+			{
+				//we only decode the images that are the best ones for at least one point
+				bestPointCount.resize(m_cameras.size(), 0);
+				for (int c : bestCameras)
+				{
+					if (c >= 0)
+						++bestPointCount[c];
+				}
+
+				//2nd pass: colors (if the image of the best camera can't be read, the points keep their previous color)
+				success = processCameras(true, [&](int c, const std::vector<Sample>& samples)
+				{
+					for (const Sample& sample : samples)
+					{
+						colors[sample.index] = sample.color;
+						hasColor[sample.index] = true;
+					}
+				});
+			}
+		}
+		else //BLEND
+		{
+			success = processCameras(true, [&](int c, const std::vector<Sample>& samples)
+			{
+				for (const Sample& sample : samples)
+				{
+					float* color = &blendedColors[4 * static_cast<size_t>(sample.index)];
+					color[0] += sample.weight * sample.color.r;
+					color[1] += sample.weight * sample.color.g;
+					color[2] += sample.weight * sample.color.b;
+					color[3] += sample.weight;
+				}
+			});
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		errorMessage = "Not enough memory";
+		success = false;
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (!success)
+	{
+		if (errorMessage.isEmpty())
+		{
+			errorMessage = "Process cancelled by user";
+		}
+		return false;
+	}
+
+	//apply the colors
+	if (!cloud->hasColors() && !cloud->resizeTheRGBTable(false))
+	{
+		errorMessage = "Not enough memory";
+		return false;
+	}
+
+	unsigned count = 0;
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		if (params.mode == BEST_IMAGE)
+		{
+			if (!hasColor[i])
+			{
+				//not seen by any camera, or the image of the best camera couldn't be read
+				continue;
+			}
+		}
+		else //BLEND
+		{
+			const float* color = &blendedColors[4 * static_cast<size_t>(i)];
+			if (color[3] <= 0)
+			{
+				continue;
+			}
+			colors[i] = ccColor::Rgb(	static_cast<ColorCompType>(std::min(255.0f, color[0] / color[3])),
+										static_cast<ColorCompType>(std::min(255.0f, color[1] / color[3])),
+										static_cast<ColorCompType>(std::min(255.0f, color[2] / color[3])) );
+		}
+
+		cloud->setPointColor(i, colors[i]);
+		++count;
+	}
+	cloud->showColors(true);
+
+	if (colorizedCount)
+	{
+		*colorizedCount = count;
+	}
+
+	return true;
+}
@@ -42,6 +42,7 @@
 #include "ccPointCloudLOD.h"
 #include "ccPolyline.h"
 #include "ccProgressDialog.h"
+#include "ccRegionSelector.h"
 #include "ccScalarField.h"
 #include "ccHObjectCaster.h"
 
@@ -51,9 +52,16 @@
 #include <QSettings>
 
 //system
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <queue>
 
+#if defined(_OPENMP)
+//OpenMP
+#include <omp.h>
+#endif
+
 static const char s_deviationSFName[] = "Deviation";
 
 // 'Draw normals' shader program
@@ -541,6 +549,8 @@ void ccPointCloud::unallocatePoints()
 
 void ccPointCloud::notifyGeometryUpdate()
 {
+	featuresHaveChanged();
+
 	ccHObject::notifyGeometryUpdate();
 
 	releaseVBOs();
@@ -775,20 +785,17 @@ const ccPointCloud& ccPointCloud::append(ccPointCloud* addedCloud, unsigned poin
 			{
 				//we need to merge the two FWF data containers!
 				assert(!fwfData()->empty() && !addedCloud->fwfData()->empty());
-				FWFDataContainer* mergedContainer = new FWFDataContainer;
 				try
 				{
 					fwfDataOffset = fwfData()->size();
-					mergedContainer->reserve(fwfData()->size() + addedCloud->fwfData()->size());
-					mergedContainer->insert(mergedContainer->end(), fwfData()->begin(), fwfData()->end());
-					mergedContainer->insert(mergedContainer->end(), addedCloud->fwfData()->begin(), addedCloud->fwfData()->end());
+					FWFDataContainer* mergedContainer = new FWFDataContainer(fwfData()->size() + addedCloud->fwfData()->size());
+					memcpy(mergedContainer->data(), fwfData()->data(), fwfData()->size());
+					memcpy(mergedContainer->data() + fwfDataOffset, addedCloud->fwfData()->data(), addedCloud->fwfData()->size());
 					fwfData() = SharedFWFDataContainer(mergedContainer);
 				}
 				catch (const std::bad_alloc&)
 				{
 					success = false;
-					delete mergedContainer;
-					mergedContainer = nullptr;
 					ccLog::Warning("[ccPointCloud::fusion] Not enough memory: failed to merge waveform containers!");
 				}
 			}
@@ -1284,6 +1291,17 @@ bool ccPointCloud::resizeTheNormsTable()
 	return m_normals && m_normals->size() == m_points.size();
 }
 
+//! Number of waveforms (or FWF data ranges) processed per batch
+static const unsigned s_fwfBatchSize = (1 << 20);
+
+//! Contiguous range of used bytes in the FWF data container
+struct FWFDataRange
+{
+	uint64_t start;		//!< first byte (in the original container)
+	uint64_t end;		//!< last byte + 1 (in the original container)
+	uint64_t newStart;	//!< first byte (in the compressed container)
+};
+
 bool ccPointCloud::compressFWFData()
 {
 	if (!m_fwfData || m_fwfData->empty())
@@ -1293,64 +1311,105 @@ bool ccPointCloud::compressFWFData()
 
 	try
 	{
-		size_t initialCount = m_fwfData->size();
-		std::vector<size_t> usedIndexes;
-		usedIndexes.resize(initialCount, 0);
+		const uint64_t initialCount = m_fwfData->size();
 
+		//list the byte ranges used by the waveforms
+		//(instead of flagging each byte, so that the memory overhead only depends on the number of waveforms)
+		std::vector<FWFDataRange> ranges;
+		ranges.reserve(m_fwfWaveforms.size());
 		for (const ccWaveform& w : m_fwfWaveforms)
 		{
-			if (w.byteCount() == 0)
+			if (w.byteCount() == 0 || w.dataOffset() >= initialCount)
 			{
-				assert(false);
+				assert(w.byteCount() == 0);
 				continue;
 			}
 
-			size_t start = w.dataOffset();
-			size_t end = w.dataOffset() + w.byteCount();
-			for (size_t i = start; i < end; ++i)
-			{
-				usedIndexes[i] = 1;
-			}
+			FWFDataRange range;
+			range.start = w.dataOffset();
+			range.end = std::min<uint64_t>(w.dataOffset() + w.byteCount(), initialCount);
+			range.newStart = 0;
+			ranges.push_back(range);
 		}
 
-		size_t newIndex = 0;
-		for (size_t& index : usedIndexes)
+		//merge the overlapping (or contiguous) ranges
+		std::sort(ranges.begin(), ranges.end(), [](const FWFDataRange& a, const FWFDataRange& b) { return a.start < b.start; });
+		size_t rangeCount = 0;
+		for (const FWFDataRange& range : ranges)
 		{
-			if (index != 0)
+			if (rangeCount != 0 && range.start <= ranges[rangeCount - 1].end)
 			{
-				index = ++newIndex; //we need to start at 1 (as 0 means 'not used')
+				ranges[rangeCount - 1].end = std::max(ranges[rangeCount - 1].end, range.end);
 			}
+			else
+			{
+				ranges[rangeCount++] = range;
+			}
+		}
+		ranges.resize(rangeCount);
+		ranges.shrink_to_fit();
+
+		//prefix sum of the range lengths = the ranges offsets in the compressed container
+		uint64_t newCount = 0;
+		for (FWFDataRange& range : ranges)
+		{
+			range.newStart = newCount;
+			newCount += range.end - range.start;
 		}
 
-		if (newIndex >= initialCount)
+		if (newCount >= initialCount)
 		{
 			//nothing to do
 			ccLog::Print(QString("[ccPointCloud::compressFWFData] Cloud '%1': no need to compress FWF data").arg(getName()));
 			return true;
 		}
 
-		//now create the new container
-		FWFDataContainer* newContainer = new FWFDataContainer;
-		newContainer->reserve(newIndex);
+		//now create the new container (the data is never held more than twice in memory)
+		FWFDataContainer* newContainer = new FWFDataContainer(static_cast<size_t>(newCount));
 
-		for (size_t i = 0; i < initialCount; ++i)
+		//copy the used ranges (in parallel)
+		const uint8_t* src = m_fwfData->data();
+		uint8_t* dest = newContainer->data();
+		for (size_t batchStart = 0; batchStart < ranges.size(); batchStart += s_fwfBatchSize)
 		{
-			if (usedIndexes[i])
+			int count = static_cast<int>(std::min<size_t>(ranges.size() - batchStart, s_fwfBatchSize));
+#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				newContainer->push_back(m_fwfData->at(i));
+				const FWFDataRange& range = ranges[batchStart + i];
+				memcpy(dest + range.newStart, src + range.start, static_cast<size_t>(range.end - range.start));
 			}
 		}
 
-		//and don't forget to update the waveform descriptors!
-		for (ccWaveform& w : m_fwfWaveforms)
+		//and don't forget to update the waveform descriptors! (in parallel as well)
+		for (size_t batchStart = 0; batchStart < m_fwfWaveforms.size(); batchStart += s_fwfBatchSize)
 		{
-			uint64_t offset = w.dataOffset();
-			assert(usedIndexes[offset] != 0);
-			w.setDataOffset(usedIndexes[offset] - 1);
+			int count = static_cast<int>(std::min<size_t>(m_fwfWaveforms.size() - batchStart, s_fwfBatchSize));
+#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+			for (int i = 0; i < count; ++i)
+			{
+				ccWaveform& w = m_fwfWaveforms[batchStart + i];
+				uint64_t offset = w.dataOffset();
+
+				//look for the (last) range starting before the waveform data
+				auto it = std::upper_bound(ranges.begin(), ranges.end(), offset, [](uint64_t value, const FWFDataRange& range) { return value < range.start; });
+				if (it == ranges.begin() || offset >= (it - 1)->end)
+				{
+					//no data
+					w.setDataOffset(0);
+					continue;
+				}
+				--it;
+				w.setDataOffset(it->newStart + (offset - it->start));
+			}
 		}
 		m_fwfData = SharedFWFDataContainer(newContainer);
 
-		ccLog::Print(QString("[ccPointCloud::compressFWFData] Cloud '%1': FWF data compressed --> %2 / %3 (%4%)").arg(getName()).arg(newIndex).arg(initialCount).arg(100.0 - (newIndex * 100.0) / initialCount, 0, 'f', 1));
+		ccLog::Print(QString("[ccPointCloud::compressFWFData] Cloud '%1': FWF data compressed --> %2 / %3 (%4%)").arg(getName()).arg(newCount).arg(initialCount).arg(100.0 - (newCount * 100.0) / initialCount, 0, 'f', 1));
 	}
 	catch (const std::bad_alloc&)
 	{
@@ -1809,223 +1868,287 @@ bool ccPointCloud::colorize(float r, float g, float b, float a/*=1.0f*/)
 	return true;
 }
 
-//! "Cellular" function to apply a gaussian filter on the RGB values of points inside an octree cell
-/** This function is meant to be applied to all cells of the octree
-	The method also permits to use a bilateral behaviour for the filter. This is automatically switched on
-	if its sigmaSF parameter in additionalParameters is positive.
+//! Spatial filter context (see ComputeCellSpatialFilter)
+struct SpatialFilterContext
+{
+	//! Filtered cloud
+	const ccPointCloud* cloud = nullptr;
+	//! Filter parameters
+	const ccPointCloud::SpatialFilterParameters* params = nullptr;
+	//! Neighbourhood radius
+	double radius = 0.0;
+	//! 2 * sigma^2
+	double sigma2 = 0.0;
+	//! 2 * sigmaSF^2
+	double sigmaSF2 = 0.0;
+	//! Whether the filter is bilateral
+	bool bilateral = false;
+	//! Whether the filter is a mean filter
+	bool mean = false;
+	//! Whether the filter is a median filter
+	bool median = false;
+	//! Output colors (if the colors are filtered)
+	std::vector<ccColor::Rgba>* outputColors = nullptr;
+	//! Copies of the input scalar fields that are also filtered in place (nullptr otherwise)
+	std::vector<const std::vector<ScalarType>*> sfSnapshots;
+	//! Copy of the guide scalar field if it is also filtered in place (nullptr otherwise)
+	const std::vector<ScalarType>* guideSnapshot = nullptr;
+
+	//! Returns the (original) guide value of a point
+	inline ScalarType guideValue(unsigned index) const { return guideSnapshot ? (*guideSnapshot)[index] : params->guideSF->getValue(index); }
+	//! Returns the (original) value of a point for a given input scalar field
+	inline ScalarType sfValue(size_t s, unsigned index) const { return sfSnapshots[s] ? (*sfSnapshots[s])[index] : params->scalarFields[s].first->getValue(index); }
+};
+
+//! Returns the median of a 256 bins histogram (same as std::nth_element at count/2)
+static inline ColorCompType HistogramMedian(const unsigned* histogram, unsigned count)
+{
+	unsigned cumulated = 0;
+	for (unsigned v = 0; v < 256; ++v)
+	{
+		cumulated += histogram[v];
+		if (cumulated > count / 2)
+		{
+			return static_cast<ColorCompType>(v);
+		}
+	}
+
+	assert(false);
+	return ccColor::MAX;
+}
+
+//! "Cellular" function to apply a spatial (Gaussian, bilateral, mean or median) filter on the points inside an octree cell
+/** The candidate neighbours are extracted once for the whole cell (all the points within 'radius' of any point of
+	the cell) and shared by all the points of the cell. Their data (position, color, scalar values) is copied in
+	contiguous arrays so that each point only has to test the squared distances of the candidates.
 
-	See ccPointCloud::applyScalarFieldGaussianFilter.
 	Method parameters (defined in "additionalParameters") are :
-	- (PointCoordinateType*) sigma
-	- (PointCoordinateType*) sigmaSF
+	- (SpatialFilterContext*) context
 
 	\param cell structure describing the cell on which processing is applied
 	\param additionalParameters see method description
 	\param nProgress optional (normalized) progress notification (per-point)
 **/
-static bool ComputeCellGaussianFilter(	const CCCoreLib::DgmOctree::octreeCell& cell,
+static bool ComputeCellSpatialFilter(	const CCCoreLib::DgmOctree::octreeCell& cell,
 										void** additionalParameters,
 										CCCoreLib::NormalizedProgress* nProgress = nullptr )
 {
-	//additional parameters
-	PointCoordinateType sigma = *(static_cast<PointCoordinateType*>(additionalParameters[0]));
-	PointCoordinateType sigmaSF = *(static_cast<PointCoordinateType*>(additionalParameters[1]));
-	ccPointCloud::RgbFilterOptions filterParams= *(static_cast<ccPointCloud::RgbFilterOptions*>(additionalParameters[2]));
-	bool applyToSF = filterParams.applyToSFduringRGB;
-	unsigned char burntOutColorThresholdMin = filterParams.burntOutColorThreshold;
-	unsigned char burntOutColorThresholdMax = 255 - burntOutColorThresholdMin;
-	bool mean = filterParams.filterType == ccPointCloud::RGB_FILTER_TYPES::MEAN;
-	bool median = filterParams.filterType == ccPointCloud::RGB_FILTER_TYPES::MEDIAN;
+	const SpatialFilterContext& context = *static_cast<const SpatialFilterContext*>(additionalParameters[0]);
+	const ccPointCloud::SpatialFilterParameters& params = *context.params;
+	const ccPointCloud::RgbFilterOptions& options = params.options;
+	const ccPointCloud* cloud = context.cloud;
 
-	//we only use the squared value of sigma
-	double sigma2 = (2.0 * sigma) * sigma;
-	double radius = 3.0 * sigma; //3 * sigma > 99.7%
-
-	//we only use the squared value of sigmaSF
-	PointCoordinateType sigmaSF2 = 2 * sigmaSF*sigmaSF;
+	const unsigned char burntOutColorThresholdMin = options.burntOutColorThreshold;
+	const unsigned char burntOutColorThresholdMax = 255 - burntOutColorThresholdMin;
+	const bool filterRGB = (context.outputColors != nullptr);
+	const size_t sfCount = params.scalarFields.size();
 
 	//number of points inside the current cell
 	unsigned n = cell.points->size();
 
-	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
-	nNSS.level = cell.level;
-	cell.parentOctree->getCellPos(cell.truncatedCode, cell.level, nNSS.cellPos, true);
-	cell.parentOctree->computeCellCenter(nNSS.cellPos, cell.level, nNSS.cellCenter);
+	//candidate neighbours, shared by all the points of the cell
+	CCCoreLib::DgmOctree::NeighboursSet candidates;
+	{
+		Tuple3i cellPos;
+		cell.parentOctree->getCellPos(cell.truncatedCode, cell.level, cellPos, true);
+		CCVector3 cellCenter;
+		cell.parentOctree->computeCellCenter(cellPos, cell.level, cellCenter);
+		PointCoordinateType cellHalfDiagonal = cell.parentOctree->getCellSize(cell.level) * static_cast<PointCoordinateType>(sqrt(3.0) / 2);
+
+		try
+		{
+			cell.parentOctree->getPointsInSphericalNeighbourhood(cellCenter, static_cast<PointCoordinateType>(context.radius) + cellHalfDiagonal, candidates, cell.level);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+	}
+	const size_t candidateCount = candidates.size();
 
-	//we already know the points lying in the first cell (this is the one we are treating :)
+	//candidates data (in contiguous arrays)
+	std::vector<CCVector3> positions;
+	std::vector<ccColor::Rgb> colors;
+	std::vector<unsigned char> colorFlags; //bit 0: burnt-out color, bit 1: grayscale color
+	std::vector<ScalarType> guideValues;
+	std::vector<ScalarType> sfValues; //candidateCount values per scalar field
+	//neighbours of the current point (indexes in the candidates arrays) and their weights
+	std::vector<unsigned> neighbours;
+	std::vector<double> weights;
+	std::vector<ScalarType> medianValues;
 	try
 	{
-		nNSS.pointsInNeighbourhood.resize(n);
+		positions.resize(candidateCount);
+		if (filterRGB)
+		{
+			colors.resize(candidateCount);
+			colorFlags.resize(candidateCount, 0);
+		}
+		if (context.bilateral)
+		{
+			guideValues.resize(candidateCount);
+		}
+		sfValues.resize(candidateCount * sfCount);
+		neighbours.reserve(candidateCount);
+		weights.reserve(candidateCount);
 	}
-	catch (.../*const std::bad_alloc&*/) //out of memory
+	catch (const std::bad_alloc&)
 	{
 		return false;
 	}
 
-	CCCoreLib::DgmOctree::NeighboursSet::iterator it = nNSS.pointsInNeighbourhood.begin();
+	for (size_t j = 0; j < candidateCount; ++j)
 	{
-		for (unsigned i = 0; i < n; ++i, ++it)
+		const CCCoreLib::DgmOctree::PointDescriptor& desc = candidates[j];
+		positions[j] = *desc.point;
+
+		if (filterRGB)
 		{
-			it->point = cell.points->getPointPersistentPtr(i);
-			it->pointIndex = cell.points->getPointGlobalIndex(i);
+			const ccColor::Rgba& col = cloud->getPointColor(desc.pointIndex);
+			colors[j] = ccColor::Rgb(col.r, col.g, col.b);
+
+			if ((	col.r >= burntOutColorThresholdMax &&
+					col.g >= burntOutColorThresholdMax &&
+					col.b >= burntOutColorThresholdMax )
+				||
+				(	col.r <= burntOutColorThresholdMin &&
+					col.g <= burntOutColorThresholdMin &&
+					col.b <= burntOutColorThresholdMin )
+				)
+			{
+				colorFlags[j] |= 1;
+			}
+
+			if (options.blendGrayscale)
+			{
+				double grayscaleMin = (col.r / 3.0) + (col.g / 3.0) + (col.b / 3.0) - options.blendGrayscaleThreshold;
+				double grayscaleMax = grayscaleMin + 2.0 * options.blendGrayscaleThreshold;
+				if (static_cast<double>(col.r) >= grayscaleMin && static_cast<double>(col.g) >= grayscaleMin && static_cast<double>(col.b) >= grayscaleMin &&
+					static_cast<double>(col.r) <= grayscaleMax && static_cast<double>(col.g) <= grayscaleMax && static_cast<double>(col.b) <= grayscaleMax)
+				{
+					colorFlags[j] |= 2;
+				}
+			}
 		}
-	}
-	nNSS.alreadyVisitedNeighbourhoodSize = 1;
 
-	ccPointCloud* cloud = static_cast<ccPointCloud*>(cell.points->getAssociatedCloud());
-	assert(cloud);
+		if (context.bilateral)
+		{
+			guideValues[j] = context.guideValue(desc.pointIndex);
+		}
 
-	bool bilateralFilter = (sigmaSF > 0.0) && !mean && !median;
+		for (size_t s = 0; s < sfCount; ++s)
+		{
+			sfValues[s * candidateCount + j] = context.sfValue(s, desc.pointIndex);
+		}
+	}
 
-	// For the median filter
-	std::vector<unsigned char> rValues;
-	std::vector<unsigned char> gValues;
-	std::vector<unsigned char> bValues;
-	std::vector<ScalarType> sfValues;
+	const double squareRadius = context.radius * context.radius;
 
 	for (unsigned i = 0; i < n; ++i) //for each point in cell
 	{
-		ScalarType queryValue = 0; //scalar of the query point
 		unsigned queryPointIndex = cell.points->getPointGlobalIndex(i);
 
-		if (bilateralFilter)
+		ScalarType queryValue = 0; //guide value of the query point
+		if (context.bilateral)
 		{
-			queryValue = cell.points->getPointScalarValue(i);
+			queryValue = context.guideValue(queryPointIndex);
 
 			// check that the query SF value is valid, otherwise no need to compute anything
 			if (!CCCoreLib::ScalarField::ValidValue(queryValue))
 			{
-				//leave original color
+				//leave original color, but invalidate the filtered scalar values
+				for (size_t s = 0; s < sfCount; ++s)
+				{
+					params.scalarFields[s].second->setValue(queryPointIndex, CCCoreLib::NAN_VALUE);
+				}
 				continue;
 			}
 		}
 
-		//we retrieve the points inside a spherical neighbourhood (radius: '3*sigma')
-		cell.points->getPoint(i, nNSS.queryPoint);
-		//warning: there may be more points at the end of nNSS.pointsInNeighbourhood than the actual nearest neighbors (k)!
-		unsigned k = cell.parentOctree->findNeighborsInASphereStartingFromCell(nNSS, radius, false);
-
-		//each point adds a contribution weighted by its distance to the sphere center
-		it = nNSS.pointsInNeighbourhood.begin();
-		if (median)
+		//we retrieve the candidates inside the spherical neighbourhood (radius: '3*sigma')
+		const CCVector3 P = *cell.points->getPoint(i);
+		neighbours.clear();
+		weights.clear();
+		for (size_t j = 0; j < candidateCount; ++j)
 		{
-			rValues.clear();
-			gValues.clear();
-			bValues.clear();
-			sfValues.clear();
-			for (unsigned j = 0; j < k; ++j, ++it)
+			double squareDist = (positions[j] - P).norm2d();
+			if (squareDist > squareRadius)
 			{
-				const ccColor::Rgba& col = cloud->getPointColor(it->pointIndex);
+				continue;
+			}
 
-				if ((	col.r >= burntOutColorThresholdMax &&
-						col.g >= burntOutColorThresholdMax &&
-						col.b >= burntOutColorThresholdMax )
-					||
-					(	col.r <= burntOutColorThresholdMin &&
-						col.g <= burntOutColorThresholdMin &&
-						col.b <= burntOutColorThresholdMin )
-					)
+			double weight = (context.mean || context.median) ? 1.0 : exp(-squareDist / context.sigma2); //PDF: -exp(-(x-mu)^2/(2*sigma^2))
+			if (context.bilateral)
+			{
+				ScalarType val = guideValues[j];
+				if (!CCCoreLib::ScalarField::ValidValue(val))
 				{
 					continue;
 				}
+				double dSF = queryValue - val;
+				weight *= exp(-(dSF*dSF) / context.sigmaSF2);
+			}
 
-				rValues.push_back(col.r);
-				gValues.push_back(col.g);
-				bValues.push_back(col.b);
+			neighbours.push_back(static_cast<unsigned>(j));
+			weights.push_back(weight);
+		}
 
-				if (applyToSF)
+		//RGB
+		if (filterRGB)
+		{
+			if (context.median)
+			{
+				//histogram based median (no sorting)
+				unsigned histograms[3][256];
+				memset(histograms, 0, sizeof(histograms));
+				unsigned count = 0;
+				for (unsigned j : neighbours)
 				{
-					ScalarType val = cloud->getPointScalarValue(it->pointIndex);
-					if (CCCoreLib::ScalarField::ValidValue(val))
+					if (colorFlags[j] & 1)
 					{
-						sfValues.push_back(val);
+						continue;
 					}
+					const ccColor::Rgb& col = colors[j];
+					++histograms[0][col.r];
+					++histograms[1][col.g];
+					++histograms[2][col.b];
+					++count;
 				}
-			}
 
-			if (rValues.size() != 0)
-			{
-				std::vector<unsigned char>::iterator medR = rValues.begin() + rValues.size() / 2;
-				std::nth_element(rValues.begin(), medR, rValues.end());
-				std::vector<unsigned char>::iterator medG = gValues.begin() + gValues.size() / 2;
-				std::nth_element(gValues.begin(), medG, gValues.end());
-				std::vector<unsigned char>::iterator medB = bValues.begin() + bValues.size() / 2;
-				std::nth_element(bValues.begin(), medB, bValues.end());
-
-				ccColor::Rgb medCol(static_cast<ColorCompType>(*medR),
-									static_cast<ColorCompType>(*medG),
-									static_cast<ColorCompType>(*medB));
-
-				cloud->setPointColor(queryPointIndex, medCol);
-			}
-
-			if (sfValues.size() != 0)
-			{
-				std::vector<ScalarType>::iterator medSF = sfValues.begin() + sfValues.size() / 2;
-				std::nth_element(sfValues.begin(), medSF, sfValues.end());
-				cloud->setPointScalarValue(queryPointIndex, static_cast<ScalarType>(*medSF));
+				if (count != 0)
+				{
+					(*context.outputColors)[queryPointIndex] = ccColor::Rgba(	HistogramMedian(histograms[0], count),
+																				HistogramMedian(histograms[1], count),
+																				HistogramMedian(histograms[2], count),
+																				ccColor::MAX);
+				}
 			}
-		}
-		else
-		{
-			ccColor::RgbTpl<double> rgbSum(0.0, 0.0, 0.0);
-			double wSum = 0.0;
-			double sfSum = 0.0;
-			double sfWSum = 0.0;
-			ccColor::RgbTpl<double> rgbGrayscaleSum(0.0, 0.0, 0.0);
-			double wGrayscaleSum = 0.0;
-			size_t nrOfGrayscale = 0;
-			size_t nrOfUsedNeighbours = 0;
-
-			for (unsigned j = 0; j < k; ++j, ++it)
+			else
 			{
-				double weight = mean ? 1.0 : exp(-(it->squareDistd) / sigma2); //PDF: -exp(-(x-mu)^2/(2*sigma^2))
+				ccColor::RgbTpl<double> rgbSum(0.0, 0.0, 0.0);
+				double wSum = 0.0;
+				ccColor::RgbTpl<double> rgbGrayscaleSum(0.0, 0.0, 0.0);
+				double wGrayscaleSum = 0.0;
+				size_t nrOfGrayscale = 0;
+				size_t nrOfUsedNeighbours = 0;
 
-				const ccColor::Rgba& col = cloud->getPointColor(it->pointIndex);
-
-				if (bilateralFilter || applyToSF)
+				for (size_t k = 0; k < neighbours.size(); ++k)
 				{
-					ScalarType val = cloud->getPointScalarValue(it->pointIndex);
-					if (CCCoreLib::ScalarField::ValidValue(val))
-					{
-						if (bilateralFilter)
-						{
-							double dSF = queryValue - val;
-							weight *= exp(-(dSF*dSF) / sigmaSF2);
-						}
-						sfSum += weight * val;
-						sfWSum += weight;
-					}
-					else
+					unsigned j = neighbours[k];
+					if (colorFlags[j] & 1)
 					{
 						continue;
 					}
-				}
-
-				if ((	col.r >= burntOutColorThresholdMax &&
-						col.g >= burntOutColorThresholdMax &&
-						col.b >= burntOutColorThresholdMax )
-					||
-					(	col.r <= burntOutColorThresholdMin &&
-						col.g <= burntOutColorThresholdMin &&
-						col.b <= burntOutColorThresholdMin )
-					)
-				{
-					continue;
-				}
 
-				rgbSum.r += weight * col.r;
-				rgbSum.g += weight * col.g;
-				rgbSum.b += weight * col.b;
-				wSum += weight;
-				++nrOfUsedNeighbours;
+					double weight = weights[k];
+					const ccColor::Rgb& col = colors[j];
+					rgbSum.r += weight * col.r;
+					rgbSum.g += weight * col.g;
+					rgbSum.b += weight * col.b;
+					wSum += weight;
+					++nrOfUsedNeighbours;
 
-				if (filterParams.blendGrayscale)
-				{
-					double grayscaleMin = (col.r / 3.0) + (col.g / 3.0) + (col.b / 3.0) - filterParams.blendGrayscaleThreshold;
-					double grayscaleMax = grayscaleMin + 2.0 * filterParams.blendGrayscaleThreshold;
-					if (static_cast<double>(col.r) >= grayscaleMin && static_cast<double>(col.g) >= grayscaleMin && static_cast<double>(col.b) >= grayscaleMin &&
-						static_cast<double>(col.r) <= grayscaleMax && static_cast<double>(col.g) <= grayscaleMax && static_cast<double>(col.b) <= grayscaleMax)
+					if (colorFlags[j] & 2)
 					{
 						//grayscale color based on threshold value
 						rgbGrayscaleSum.r += weight * col.r;
@@ -2035,88 +2158,238 @@ static bool ComputeCellGaussianFilter(	const CCCoreLib::DgmOctree::octreeCell& c
 						++nrOfGrayscale;
 					}
 				}
-			}
 
-			if (wSum != 0.0)
-			{
-				ccColor::Rgb avgCol(static_cast<ColorCompType>(std::max(std::min(255.0, rgbSum.r / wSum), 0.0)),
-									static_cast<ColorCompType>(std::max(std::min(255.0, rgbSum.g / wSum), 0.0)),
-									static_cast<ColorCompType>(std::max(std::min(255.0, rgbSum.b / wSum), 0.0)));
-
-				//blend grayscale modifications
-				if (filterParams.blendGrayscale)
+				if (wSum != 0.0)
 				{
-					//if the neighbor set contains more grayscale point than given percent, so use only use grayscale points
-					if ((static_cast<double>(nrOfGrayscale) > filterParams.blendGrayscalePercent * nrOfUsedNeighbours) && wGrayscaleSum != 0)
-					{
-						avgCol.r = static_cast<ColorCompType>(std::max(std::min(255.0, rgbGrayscaleSum.r / wGrayscaleSum), 0.0));
-						avgCol.g = static_cast<ColorCompType>(std::max(std::min(255.0, rgbGrayscaleSum.g / wGrayscaleSum), 0.0));
-						avgCol.b = static_cast<ColorCompType>(std::max(std::min(255.0, rgbGrayscaleSum.b / wGrayscaleSum), 0.0));
-					}
-					else //else, we have more RGB colors than grayscale ones. We use only the RGB values.
+					ccColor::Rgb avgCol(static_cast<ColorCompType>(std::max(std::min(255.0, rgbSum.r / wSum), 0.0)),
+										static_cast<ColorCompType>(std::max(std::min(255.0, rgbSum.g / wSum), 0.0)),
+										static_cast<ColorCompType>(std::max(std::min(255.0, rgbSum.b / wSum), 0.0)));
+
+					//blend grayscale modifications
+					if (options.blendGrayscale)
 					{
-						double wRGBSum = wSum - wGrayscaleSum;
-						if (wRGBSum != 0.0)
+						//if the neighbor set contains more grayscale point than given percent, so use only use grayscale points
+						if ((static_cast<double>(nrOfGrayscale) > options.blendGrayscalePercent * nrOfUsedNeighbours) && wGrayscaleSum != 0)
 						{
-							avgCol.r = static_cast<ColorCompType>(std::max(std::min(255.0, (rgbSum.r - rgbGrayscaleSum.r) / wRGBSum), 0.0));
-							avgCol.g = static_cast<ColorCompType>(std::max(std::min(255.0, (rgbSum.g - rgbGrayscaleSum.g) / wRGBSum), 0.0));
-							avgCol.b = static_cast<ColorCompType>(std::max(std::min(255.0, (rgbSum.b - rgbGrayscaleSum.b) / wRGBSum), 0.0));
+							avgCol.r = static_cast<ColorCompType>(std::max(std::min(255.0, rgbGrayscaleSum.r / wGrayscaleSum), 0.0));
+							avgCol.g = static_cast<ColorCompType>(std::max(std::min(255.0, rgbGrayscaleSum.g / wGrayscaleSum), 0.0));
+							avgCol.b = static_cast<ColorCompType>(std::max(std::min(255.0, rgbGrayscaleSum.b / wGrayscaleSum), 0.0));
+						}
+						else //else, we have more RGB colors than grayscale ones. We use only the RGB values.
+						{
+							double wRGBSum = wSum - wGrayscaleSum;
+							if (wRGBSum != 0.0)
+							{
+								avgCol.r = static_cast<ColorCompType>(std::max(std::min(255.0, (rgbSum.r - rgbGrayscaleSum.r) / wRGBSum), 0.0));
+								avgCol.g = static_cast<ColorCompType>(std::max(std::min(255.0, (rgbSum.g - rgbGrayscaleSum.g) / wRGBSum), 0.0));
+								avgCol.b = static_cast<ColorCompType>(std::max(std::min(255.0, (rgbSum.b - rgbGrayscaleSum.b) / wRGBSum), 0.0));
+							}
 						}
 					}
-				}
 
-				cloud->setPointColor(queryPointIndex, avgCol);
+					(*context.outputColors)[queryPointIndex] = ccColor::Rgba(avgCol, ccColor::MAX);
+				}
 			}
+		}
+
+		//scalar fields
+		for (size_t s = 0; s < sfCount; ++s)
+		{
+			const ScalarType* values = sfValues.data() + s * candidateCount;
+			CCCoreLib::ScalarField* outputSF = params.scalarFields[s].second;
+
+			if (context.median)
+			{
+				//selection based median
+				medianValues.clear();
+				for (unsigned j : neighbours)
+				{
+					if (CCCoreLib::ScalarField::ValidValue(values[j]))
+					{
+						medianValues.push_back(values[j]);
+					}
+				}
 
-			if (applyToSF)
+				if (!medianValues.empty())
+				{
+					std::vector<ScalarType>::iterator medSF = medianValues.begin() + medianValues.size() / 2;
+					std::nth_element(medianValues.begin(), medSF, medianValues.end());
+					outputSF->setValue(queryPointIndex, *medSF);
+				}
+				else
+				{
+					//no valid neighbour
+					outputSF->setValue(queryPointIndex, CCCoreLib::NAN_VALUE);
+				}
+			}
+			else
 			{
+				double sfSum = 0.0;
+				double sfWSum = 0.0;
+				for (size_t k = 0; k < neighbours.size(); ++k)
+				{
+					ScalarType val = values[neighbours[k]];
+					if (CCCoreLib::ScalarField::ValidValue(val))
+					{
+						sfSum += weights[k] * val;
+						sfWSum += weights[k];
+					}
+				}
+
 				if (sfWSum != 0.0)
 				{
-					cloud->setPointScalarValue(queryPointIndex, static_cast<ScalarType>(sfSum / sfWSum));
+					outputSF->setValue(queryPointIndex, static_cast<ScalarType>(sfSum / sfWSum));
+				}
+				else
+				{
+					//no valid neighbour
+					outputSF->setValue(queryPointIndex, CCCoreLib::NAN_VALUE);
 				}
 			}
 		}
+	}
 
-		if (nProgress && !nProgress->oneStep())
-		{
-			return false;
-		}
+	if (nProgress && !nProgress->steps(n))
+	{
+		return false;
 	}
 
 	return true;
 }
 
-bool ccPointCloud::applyFilterToRGB(PointCoordinateType sigma,
-									PointCoordinateType sigmaSF,
-									RgbFilterOptions filterParams,
-									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+bool ccPointCloud::applySpatialFilter(	const SpatialFilterParameters& params,
+										CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
 {
 	unsigned n = size();
 	if (n == 0)
 	{
-		ccLog::Warning("[ccPointCloud::applyFilterToRGB] Cloud is empty");
+		ccLog::Warning("[ccPointCloud::applySpatialFilter] Cloud is empty");
 		return false;
 	}
 
-	if (!hasColors())
+	if (params.sigma <= 0)
 	{
-		ccLog::Warning("[ccPointCloud::applyFilterToRGB] Cloud has no RGB color");
+		ccLog::Warning("[ccPointCloud::applySpatialFilter] Invalid sigma");
 		return false;
 	}
 
-	if ((sigmaSF > 0) && (nullptr == getCurrentOutScalarField()))
+	if (params.filterRGB && !hasColors())
 	{
-		ccLog::Warning("[ccPointCloud::applyFilterToRGB] A non-zero scalar field variance was set without an active 'input' scalar-field");
+		ccLog::Warning("[ccPointCloud::applySpatialFilter] Cloud has no RGB color");
 		return false;
 	}
 
+	if (!params.filterRGB && params.scalarFields.empty())
+	{
+		ccLog::Warning("[ccPointCloud::applySpatialFilter] Nothing to filter");
+		return false;
+	}
+
+	for (const auto& sfPair : params.scalarFields)
+	{
+		if (!sfPair.first || !sfPair.second || sfPair.first->size() != n || sfPair.second->size() != n)
+		{
+			ccLog::Warning("[ccPointCloud::applySpatialFilter] Invalid scalar field");
+			return false;
+		}
+	}
+
+	SpatialFilterContext context;
+	context.cloud = this;
+	context.params = &params;
+	context.radius = 3.0 * params.sigma; //3 * sigma > 99.7%
+	context.sigma2 = (2.0 * params.sigma) * params.sigma;
+	context.mean = (params.options.filterType == RGB_FILTER_TYPES::MEAN);
+	context.median = (params.options.filterType == RGB_FILTER_TYPES::MEDIAN);
+	context.bilateral = (params.sigmaSF > 0 && !context.mean && !context.median);
+	context.sigmaSF2 = (2.0 * params.sigmaSF) * params.sigmaSF;
+	if (context.bilateral && (!params.guideSF || params.guideSF->size() != n))
+	{
+		ccLog::Warning("[ccPointCloud::applySpatialFilter] A non-zero scalar field variance was set without a valid guide scalar field");
+		return false;
+	}
+
+	//the scalar fields that are also written (i.e. filtered in place) must be read from a copy
+	std::vector< std::vector<ScalarType> > snapshots;
+	try
+	{
+		auto isOutput = [&params](const CCCoreLib::ScalarField* sf) {
+			for (const auto& sfPair : params.scalarFields)
+			{
+				if (sfPair.second == sf)
+					return true;
+			}
+			return false;
+		};
+		auto takeSnapshot = [&](const CCCoreLib::ScalarField* sf) -> const std::vector<ScalarType>* {
+			if (!sf || !isOutput(sf))
+			{
+				return nullptr;
+			}
+			snapshots.emplace_back(n);
+			std::vector<ScalarType>& snapshot = snapshots.back();
+			for (unsigned i = 0; i < n; ++i)
+			{
+				snapshot[i] = sf->getValue(i);
+			}
+			return &snapshot;
+		};
+
+		//reserve first so that the snapshot addresses remain valid
+		snapshots.reserve(params.scalarFields.size() + 1);
+		for (const auto& sfPair : params.scalarFields)
+		{
+			context.sfSnapshots.push_back(takeSnapshot(sfPair.first));
+		}
+		if (context.bilateral)
+		{
+			//the guide is generally one of the input scalar fields
+			for (size_t s = 0; s < params.scalarFields.size(); ++s)
+			{
+				if (params.scalarFields[s].first == params.guideSF)
+				{
+					context.guideSnapshot = context.sfSnapshots[s];
+					break;
+				}
+			}
+			if (!context.guideSnapshot)
+			{
+				context.guideSnapshot = takeSnapshot(params.guideSF);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccPointCloud::applySpatialFilter] Not enough memory");
+		return false;
+	}
+
+	//the colors are written in a separate buffer (the neighbours must be read with their original colors)
+	std::vector<ccColor::Rgba> outputColors;
+	if (params.filterRGB)
+	{
+		try
+		{
+			outputColors.resize(n);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccPointCloud::applySpatialFilter] Not enough memory");
+			return false;
+		}
+		for (unsigned i = 0; i < n; ++i)
+		{
+			outputColors[i] = getPointColor(i);
+		}
+		context.outputColors = &outputColors;
+	}
+
 	ccOctree* theOctree = getOctree().data();
 	if (!theOctree)
 	{
 		if (!computeOctree(progressCb))
 		{
-			ccLog::Warning("[ccPointCloud::applyFilterToRGB] Failed to compute the octree");
-			delete theOctree;
+			ccLog::Warning("[ccPointCloud::applySpatialFilter] Failed to compute the octree");
 			return false;
 		}
 		else
@@ -2125,14 +2398,19 @@ bool ccPointCloud::applyFilterToRGB(PointCoordinateType sigma,
 		}
 	}
 
-	//best octree level
-	unsigned char level = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(3 * sigma);
+	//the candidates are shared by all the points of a cell: we use cells about half as big as the neighbourhood radius
+	//(so that the candidates sphere is not much bigger than the neighbourhood sphere)
+	unsigned char level = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(static_cast<PointCoordinateType>(context.radius));
+	if (level < CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL)
+	{
+		++level;
+	}
 
 	if (progressCb)
 	{
 		if (progressCb->textCanBeEdited())
 		{
-			progressCb->setMethodTitle("RGB filter");
+			progressCb->setMethodTitle(params.filterRGB ? "RGB filter" : "SF filter");
 			char infos[32];
 			snprintf(infos, 32, "Level: %i", level);
 			progressCb->setInfo(infos);
@@ -2140,25 +2418,69 @@ bool ccPointCloud::applyFilterToRGB(PointCoordinateType sigma,
 		progressCb->update(0);
 	}
 
-	void* additionalParameters[] {	reinterpret_cast<void*>(&sigma),
-									reinterpret_cast<void*>(&sigmaSF),
-									reinterpret_cast<void*>(&filterParams)
-	};
-
-	bool success = true;
+	void* additionalParameters[] { reinterpret_cast<void*>(&context) };
 
 	if (theOctree->executeFunctionForAllCellsAtLevel(	level,
-														ComputeCellGaussianFilter,
+														ComputeCellSpatialFilter,
 														additionalParameters,
 														true,
 														progressCb,
 														"Filter computation") == 0)
 	{
 		//something went wrong
-		success = false;
+		return false;
+	}
+
+	if (params.filterRGB)
+	{
+		for (unsigned i = 0; i < n; ++i)
+		{
+			m_rgbaColors->setValue(i, outputColors[i]);
+		}
+
+		//We must update the VBOs
+		colorsHaveChanged();
 	}
 
-	return success;
+	return true;
+}
+
+bool ccPointCloud::applyFilterToRGB(PointCoordinateType sigma,
+									PointCoordinateType sigmaSF,
+									RgbFilterOptions filterParams,
+									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (size() == 0)
+	{
+		ccLog::Warning("[ccPointCloud::applyFilterToRGB] Cloud is empty");
+		return false;
+	}
+
+	if (!hasColors())
+	{
+		ccLog::Warning("[ccPointCloud::applyFilterToRGB] Cloud has no RGB color");
+		return false;
+	}
+
+	if ((sigmaSF > 0) && (nullptr == getCurrentOutScalarField()))
+	{
+		ccLog::Warning("[ccPointCloud::applyFilterToRGB] A non-zero scalar field variance was set without an active 'input' scalar-field");
+		return false;
+	}
+
+	SpatialFilterParameters params;
+	params.sigma = sigma;
+	params.sigmaSF = sigmaSF;
+	params.guideSF = getCurrentOutScalarField();
+	params.options = filterParams;
+	params.filterRGB = true;
+	if (filterParams.applyToSFduringRGB && getCurrentOutScalarField() && getCurrentInScalarField())
+	{
+		//the 'out' scalar field is filtered into the 'in' one
+		params.scalarFields.emplace_back(getCurrentOutScalarField(), getCurrentInScalarField());
+	}
+
+	return applySpatialFilter(params, progressCb);
 }
 
 //Contribution from Michael J Smith
@@ -2594,6 +2916,7 @@ void ccPointCloud::swapPoints(unsigned firstIndex, unsigned secondIndex)
 	}
 
 	//We must update the VBOs
+	featuresHaveChanged();
 	releaseVBOs();
 }
 
@@ -3075,20 +3398,21 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 								glFunc->glGetIntegerv(GL_VIEWPORT, camera.viewport);
 								glFunc->glGetDoublev(GL_PROJECTION_MATRIX, camera.projectionMat.data());
 								glFunc->glGetDoublev(GL_MODELVIEW_MATRIX, camera.modelViewMat.data());
-								//camera frustum
-								Frustum frustum(camera.modelViewMat, camera.projectionMat);
 
-								//first time: we flag the cells visibility and count the number of visible points
-								m_lod->flagVisibility(frustum, m_clipPlanes.empty() ? nullptr : &m_clipPlanes);
+								//the cells are refined until the spacing between the displayed points is below the point size
+								float pointSize = (m_pointSize != 0 ? static_cast<float>(m_pointSize) : context.display->getViewportParameters().defaultPointSize);
+
+								//first pass: we flag the cells visibility and start a new traversal
+								//(the cells with the highest screen-space error will be refined first)
+								m_lod->initTraversal(camera, pointSize, m_clipPlanes.empty() ? nullptr : &m_clipPlanes);
 							}
 
-							unsigned remainingPointsAtThisLevel = 0;
 							toDisplay.startIndex = 0;
 							toDisplay.count = MAX_POINT_COUNT_PER_LOD_RENDER_PASS;
-							toDisplay.indexMap = &m_lod->getIndexMap(context.currentLODLevel, toDisplay.count, remainingPointsAtThisLevel);
+							toDisplay.indexMap = &m_lod->getNextIndexMap(toDisplay.count);
 							if (toDisplay.count == 0)
 							{
-								//nothing to draw at this level
+								//nothing (more) to draw
 								toDisplay.indexMap = nullptr;
 							}
 							else
@@ -3097,9 +3421,12 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 								toDisplay.endIndex = toDisplay.startIndex + toDisplay.count;
 							}
 
-							//could we draw more points at the next level?
-							context.moreLODPointsAvailable = (remainingPointsAtThisLevel != 0);
-							context.higherLODLevelsAvailable = (!m_lod->allDisplayed() && context.currentLODLevel + 1 <= maxLevel);
+							//should we refine the display during the next pass?
+							//(the pass index is stored in 'currentLODLevel', hence the limit)
+							if (!m_lod->traversalFinished() && context.currentLODLevel < 255)
+							{
+								context.higherLODLevelsAvailable = true;
+							}
 						}
 					}
 				}
@@ -5350,32 +5677,27 @@ CCCoreLib::ReferenceCloud* ccPointCloud::crop(const ccBBox& box, bool inside/*=t
 		return nullptr;
 	}
 
-	CCCoreLib::ReferenceCloud* ref = new CCCoreLib::ReferenceCloud(this);
-	if (!ref->reserve(count))
+	//the octree cells (if any) are classified first
+	std::vector<unsigned> indexes;
+	if (!ccRegionSelector::Select(this, ccRegionSelector::BoxRegion(box), indexes, inside))
 	{
 		ccLog::Warning("[ccPointCloud::crop] Not enough memory!");
-		delete ref;
 		return nullptr;
 	}
+	//keep the original order of the points
+	std::sort(indexes.begin(), indexes.end());
 
-	for (unsigned i = 0; i < count; ++i)
+	CCCoreLib::ReferenceCloud* ref = new CCCoreLib::ReferenceCloud(this);
+	if (!indexes.empty() && !ref->reserve(static_cast<unsigned>(indexes.size())))
 	{
-		const CCVector3* P = point(i);
-		bool pointIsInside = box.contains(*P);
-		if (inside == pointIsInside)
-		{
-			ref->addPointIndex(i);
-		}
+		ccLog::Warning("[ccPointCloud::crop] Not enough memory!");
+		delete ref;
+		return nullptr;
 	}
 
-	if (ref->size() == 0)
-	{
-		//no points inside selection!
-		ref->clear(true);
-	}
-	else
+	for (unsigned index : indexes)
 	{
-		ref->resize(ref->size());
+		ref->addPointIndex(index);
 	}
 
 	return ref;
@@ -5663,7 +5985,12 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 						//then send them in VRAM
 						currentVBO->write(currentVBO->rgbShift, s_rgbBuffer4ub, sizeof(ColorCompType) * chunkSize * 4);
 						//upadte 'modification' flag for current displayed SF
-						m_vboManager.sourceSF->setModificationFlag(false);
+						if (m_vboManager.sourceSF->getModificationFlag())
+						{
+							//the external VBOs (if any) won't see the flag anymore
+							++m_featureVersions.colors;
+							m_vboManager.sourceSF->setModificationFlag(false);
+						}
 					}
 					else if (glParams.showColors)
 					{
@@ -5817,6 +6144,9 @@ void ccPointCloud::releaseVBOs()
 	if (m_vboManager.state == vboSet::NEW)
 		return;
 
+	//the external VBOs (if any) should be updated as well
+	featuresHaveChanged();
+
 	if (m_currentDisplay)
 	{
 		//'destroy' all vbos
@@ -6502,6 +6832,10 @@ bool ccPointCloud::computeFWFAmplitude(double& minVal, double& maxVal, ccProgres
 	{
 		return false;
 	}
+	if (!m_fwfData)
+	{
+		return false;
+	}
 
 	//progress dialog
 	CCCoreLib::NormalizedProgress nProgress(pDlg, static_cast<unsigned>(m_fwfWaveforms.size()));
@@ -6513,42 +6847,98 @@ bool ccPointCloud::computeFWFAmplitude(double& minVal, double& maxVal, ccProgres
 		QCoreApplication::processEvents();
 	}
 
-	//for all waveforms
-	bool firstTest = true;
-	for (unsigned i = 0; i < size(); ++i)
+	//descriptors look-up table (we don't want to access the map from several threads)
+	std::vector<const WaveformDescriptor*> descriptors(256, nullptr);
+	for (FWFDescriptorSet::const_iterator it = m_fwfDescriptors.constBegin(); it != m_fwfDescriptors.constEnd(); ++it)
 	{
-		if (pDlg && !nProgress.oneStep())
+		if (it.value().numberOfSamples != 0)
 		{
-			return false;
+			descriptors[it.key()] = &it.value();
 		}
+	}
 
-		ccWaveformProxy proxy = waveformProxy(i);
-		if (!proxy.isValid())
-		{
-			continue;
-		}
+	const uint8_t* storage = m_fwfData->data();
+	const uint64_t storageSize = m_fwfData->size();
 
-		double wMinVal = 0.0;
-		double wMaxVal = 0.0;
-		proxy.getRange(wMinVal, wMaxVal);
+	//for all waveforms (by batches, processed in parallel)
+	bool firstTest = true;
+	for (unsigned batchStart = 0; batchStart < size(); batchStart += s_fwfBatchSize)
+	{
+		int count = static_cast<int>(std::min(size() - batchStart, s_fwfBatchSize));
 
-		if (firstTest)
-		{
-			minVal = wMinVal;
-			maxVal = wMaxVal;
-			firstTest = false;
-		}
-		else
+#if defined(_OPENMP)
+		#pragma omp parallel num_threads(omp_get_max_threads())
+#endif
 		{
-			if (wMaxVal > maxVal)
+			bool threadFirstTest = true;
+			double threadMinVal = 0.0;
+			double threadMaxVal = 0.0;
+
+#if defined(_OPENMP)
+			#pragma omp for
+#endif
+			for (int i = 0; i < count; ++i)
 			{
-				maxVal = wMaxVal;
+				const ccWaveform& w = m_fwfWaveforms[batchStart + i];
+				const WaveformDescriptor* d = descriptors[w.descriptorID()];
+				if (w.descriptorID() == 0 || !d || w.dataOffset() + w.byteCount() > storageSize)
+				{
+					//invalid waveform
+					continue;
+				}
+
+				//the (real) sample values are a linear function of the raw ones
+				uint32_t rawMin = w.getRawSample(0, *d, storage);
+				uint32_t rawMax = rawMin;
+				for (uint32_t j = 1; j < d->numberOfSamples; ++j)
+				{
+					uint32_t raw = w.getRawSample(j, *d, storage);
+					rawMin = std::min(rawMin, raw);
+					rawMax = std::max(rawMax, raw);
+				}
+				double v1 = d->digitizerGain * rawMin + d->digitizerOffset;
+				double v2 = d->digitizerGain * rawMax + d->digitizerOffset;
+				double wMinVal = std::min(v1, v2);
+				double wMaxVal = std::max(v1, v2);
+
+				if (threadFirstTest)
+				{
+					threadMinVal = wMinVal;
+					threadMaxVal = wMaxVal;
+					threadFirstTest = false;
+				}
+				else
+				{
+					threadMinVal = std::min(threadMinVal, wMinVal);
+					threadMaxVal = std::max(threadMaxVal, wMaxVal);
+				}
 			}
-			if (wMinVal < minVal)
+
+			if (!threadFirstTest)
 			{
-				minVal = wMinVal;
+#if defined(_OPENMP)
+				#pragma omp critical
+#endif
+				{
+					if (firstTest)
+					{
+						minVal = threadMinVal;
+						maxVal = threadMaxVal;
+						firstTest = false;
+					}
+					else
+					{
+						minVal = std::min(minVal, threadMinVal);
+						maxVal = std::max(maxVal, threadMaxVal);
+					}
+				}
 			}
 		}
+
+		if (pDlg && !nProgress.steps(static_cast<unsigned>(count)))
+		{
+			return false;
+		}
 	}
 
 	return !firstTest;
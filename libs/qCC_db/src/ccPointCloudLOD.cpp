@@ -18,6 +18,7 @@
 #include "ccPointCloudLOD.h"
 
 //Local
+#include "ccGenericGLDisplay.h"
 #include "ccPointCloud.h"
 
 //Qt
@@ -25,6 +26,14 @@
 #include <QElapsedTimer>
 #include <QThread>
 
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//! Number of points displayed for an inner cell before its children are refined
+static const uint32_t c_innerCellSampleCount = 64;
+
 //! Thread for background computation
 class ccPointCloudLODThread : public QThread
 {
@@ -392,7 +401,9 @@ size_t ccPointCloudLOD::memory() const
 	size_t nodeSize = sizeof(Node);
 	size_t nodesSize = totalNodeCount * nodeSize;
 
-	return nodesSize + thisSize;
+	size_t queueSize = m_traversal.queue.capacity() * sizeof(QueuedNode);
+
+	return nodesSize + queueSize + thisSize;
 }
 
 bool ccPointCloudLOD::init(ccPointCloud* cloud)
@@ -430,6 +441,8 @@ void ccPointCloudLOD::clearData()
 	m_levels.front().data.resize(1);
 	m_levels.front().data.front() = Node();
 
+	m_traversal.queue.clear();
+
 	m_octree.clear();
 }
 
@@ -510,6 +523,7 @@ void ccPointCloudLOD::clear()
 	}
 
 	m_levels.clear();
+	m_traversal = Traversal();
 	m_octree.clear();
 	m_state = NOT_INITIALIZED;
 
@@ -947,4 +961,167 @@ LODIndexSet& ccPointCloudLOD::getIndexMap(unsigned char level, unsigned& maxCoun
 	return m_indexMap;
 }
 
+uint32_t ccPointCloudLOD::initTraversal(const ccGLCameraParameters& camera, float targetSpacing_pix, ccClipPlaneSet* clipPlanes/*=nullptr*/)
+{
+	m_traversal.queue.clear();
+
+	Frustum frustum(camera.modelViewMat, camera.projectionMat);
+	uint32_t visibleCount = flagVisibility(frustum, clipPlanes);
+	if (visibleCount == 0)
+	{
+		return 0;
+	}
+
+	//to project the cells: 'w' = 4th row of (P x MV) . [center, 1]
+	//(= depth in perspective mode, = 1 in orthographic mode)
+	ccGLMatrixd projModelView = camera.projectionMat * camera.modelViewMat;
+	const double* PMV = projModelView.data();
+	m_traversal.wRow[0] = PMV[3];
+	m_traversal.wRow[1] = PMV[7];
+	m_traversal.wRow[2] = PMV[11];
+	m_traversal.wRow[3] = PMV[15];
+	//clip space [-1, 1] --> viewport pixels (vertical scale)
+	m_traversal.pixelScale = camera.projectionMat.data()[5] * camera.viewport[3] / 2.0;
+	m_traversal.perspective = camera.perspective;
+	m_traversal.targetSpacing_pix = std::max(targetSpacing_pix, 1.0f);
+
+	//the root cell is always displayed (even if it is very small on screen)
+	queueNode(root(), 0, true);
+
+	return visibleCount;
+}
+
+float ccPointCloudLOD::projectedSize(const Node& node) const
+{
+	const double* wRow = m_traversal.wRow;
+	double w = wRow[0] * node.center.x + wRow[1] * node.center.y + wRow[2] * node.center.z + wRow[3];
+	double diameter = 2.0 * node.radius * std::abs(m_traversal.pixelScale);
+
+	if ((m_traversal.perspective && w <= node.radius) || w < std::numeric_limits<float>::epsilon())
+	{
+		//the camera is inside (or too close to) the cell
+		return std::numeric_limits<float>::max();
+	}
+
+	return static_cast<float>(std::min(diameter / w, static_cast<double>(std::numeric_limits<float>::max())));
+}
+
+void ccPointCloudLOD::queueNode(const Node& node, int32_t index, bool force/*=false*/)
+{
+	if (node.intersection == Frustum::OUTSIDE || node.displayedPointCount >= node.pointCount)
+	{
+		//nothing (more) to display
+		return;
+	}
+
+	//estimated spacing between the displayed points (assuming they sample a surface)
+	float error = projectedSize(node) / std::sqrt(static_cast<float>(node.displayedPointCount + 1));
+	if (!force && error <= m_traversal.targetSpacing_pix)
+	{
+		//the cell is already dense enough
+		return;
+	}
+
+	QueuedNode queuedNode;
+	queuedNode.error = error;
+	queuedNode.index = index;
+	queuedNode.level = node.level;
+
+	m_traversal.queue.push_back(queuedNode); //may throw std::bad_alloc
+	std::push_heap(m_traversal.queue.begin(), m_traversal.queue.end());
+}
+
+LODIndexSet& ccPointCloudLOD::getNextIndexMap(unsigned& maxCount)
+{
+	m_lastIndexMap.clear();
+
+	if (m_octree.isNull() || m_state != INITIALIZED || m_traversal.queue.empty() || maxCount == 0)
+	{
+		maxCount = 0;
+		return m_lastIndexMap; //empty
+	}
+
+	m_indexMap.clear();
+	try
+	{
+		m_indexMap.reserve(maxCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		maxCount = 0;
+		return m_lastIndexMap; //empty
+	}
+
+	std::vector<QueuedNode>& queue = m_traversal.queue;
+	try
+	{
+		while (!queue.empty() && m_indexMap.size() < maxCount)
+		{
+			//the cell with the highest screen-space error comes first
+			std::pop_heap(queue.begin(), queue.end());
+			QueuedNode queuedNode = queue.back();
+			queue.pop_back();
+
+			Node& n = node(queuedNode.index, queuedNode.level);
+			uint32_t budget = maxCount - static_cast<uint32_t>(m_indexMap.size());
+			uint32_t remainingCount = n.pointCount - n.displayedPointCount;
+
+			if (n.childCount)
+			{
+				//inner cell: we display a coarse sample of its points first (dispatched among its children)
+				if (n.displayedPointCount < c_innerCellSampleCount)
+				{
+					uint32_t count = std::min(c_innerCellSampleCount - n.displayedPointCount, remainingCount);
+					uint32_t displayedCount = addNPointsToIndexMap(n, std::min(count, budget));
+					if (count > budget && displayedCount != 0)
+					{
+						//we'll finish this cell during the next pass
+						queueNode(n, queuedNode.index, true);
+						break;
+					}
+				}
+
+				//then its children will be refined (depending on their own screen-space error)
+				for (int i = 0; i < 8; ++i)
+				{
+					if (n.childIndexes[i] >= 0)
+					{
+						const Node& childNode = node(n.childIndexes[i], n.level + 1);
+						queueNode(childNode, n.childIndexes[i]);
+					}
+				}
+			}
+			else
+			{
+				//leaf cell: we display the number of points required to reach the target spacing
+				double ratio = projectedSize(n) / m_traversal.targetSpacing_pix;
+				double requiredCount = std::ceil(ratio * ratio) - 1.0 - n.displayedPointCount;
+				uint32_t count = (requiredCount < remainingCount ? static_cast<uint32_t>(std::max(requiredCount, 1.0)) : remainingCount);
+				count = std::min(count, budget);
+
+				addNPointsToIndexMap(n, count);
+				queueNode(n, queuedNode.index);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory: we stop the traversal here
+		queue.clear();
+	}
+
+	maxCount = static_cast<unsigned>(m_indexMap.size());
+	m_currentState.displayedPoints += static_cast<uint32_t>(m_indexMap.size());
+
+	if (queue.empty())
+	{
+		//no need to keep this memory
+		queue.shrink_to_fit();
+	}
+
+	m_lastIndexMap = m_indexMap;
+	return m_indexMap;
+}
+
 #include "ccPointCloudLOD.moc"
@@ -0,0 +1,469 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "ccRegionSelector.h"
+
+//Local
+#include "ccGenericPointCloud.h"
+#include "ccOctree.h"
+
+//CCCoreLib
+#include <ManualSegmentationTools.h>
+
+//system
+#include <algorithm>
+#include <cassert>
+
+#if defined(_OPENMP)
+//OpenMP
+#include <omp.h>
+#endif
+
+//! Straddling cells with less points than this are not split anymore
+static const unsigned c_minCellPointCount = 64;
+//! Number of points per block (when all the points have to be tested)
+static const unsigned c_blockPointCount = (1 << 16);
+//! Max number of points tested at once (to limit the memory consumption)
+static const unsigned c_maxBatchPointCount = (1 << 22);
+
+ccRegionSelector::BoxRegion::BoxRegion(const ccBBox& box)
+	: m_box(box)
+{
+}
+
+ccRegionSelector::CellPosition ccRegionSelector::BoxRegion::classifyCell(const CCVector3& cellMin, const CCVector3& cellMax) const
+{
+	const CCVector3& boxMin = m_box.minCorner();
+	const CCVector3& boxMax = m_box.maxCorner();
+
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		if (cellMax.u[d] < boxMin.u[d] || cellMin.u[d] > boxMax.u[d])
+		{
+			return CELL_OUTSIDE;
+		}
+	}
+
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		if (cellMin.u[d] < boxMin.u[d] || cellMax.u[d] > boxMax.u[d])
+		{
+			return CELL_STRADDLING;
+		}
+	}
+
+	return CELL_INSIDE;
+}
+
+bool ccRegionSelector::BoxRegion::isInside(const CCVector3& P) const
+{
+	return m_box.contains(P);
+}
+
+ccRegionSelector::ScreenPolygonRegion::ScreenPolygonRegion(	const ccGLCameraParameters& camera,
+															const CCCoreLib::GenericIndexedCloud* polygon,
+															bool skipPointsOutsideFrustum)
+	: m_camera(camera)
+	, m_polygon(polygon)
+	, m_polyMin(0, 0)
+	, m_polyMax(0, 0)
+	, m_skipPointsOutsideFrustum(skipPointsOutsideFrustum)
+	, m_halfW(camera.viewport[2] / 2.0)
+	, m_halfH(camera.viewport[3] / 2.0)
+	, m_wRow{0.0, 0.0, 0.0, 1.0}
+{
+	//to check whether the cells are in front of the camera: 'w' = 4th row of (P x MV) . [X, 1]
+	ccGLMatrixd projModelView = camera.projectionMat * camera.modelViewMat;
+	const double* PMV = projModelView.data();
+	m_wRow[0] = PMV[3];
+	m_wRow[1] = PMV[7];
+	m_wRow[2] = PMV[11];
+	m_wRow[3] = PMV[15];
+
+	unsigned vertexCount = (polygon ? polygon->size() : 0);
+	m_vertices.resize(vertexCount);
+	for (unsigned i = 0; i < vertexCount; ++i)
+	{
+		const CCVector3* P = polygon->getPoint(i);
+		m_vertices[i] = CCVector2d(P->x, P->y);
+
+		if (i == 0)
+		{
+			m_polyMin = m_polyMax = m_vertices[i];
+		}
+		else
+		{
+			m_polyMin.x = std::min(m_polyMin.x, m_vertices[i].x);
+			m_polyMin.y = std::min(m_polyMin.y, m_vertices[i].y);
+			m_polyMax.x = std::max(m_polyMax.x, m_vertices[i].x);
+			m_polyMax.y = std::max(m_polyMax.y, m_vertices[i].y);
+		}
+	}
+}
+
+bool ccRegionSelector::ScreenPolygonRegion::edgeIntersectsRect(unsigned edgeIndex, const CCVector2d& rectMin, const CCVector2d& rectMax) const
+{
+	const CCVector2d& A = m_vertices[edgeIndex];
+	const CCVector2d& B = m_vertices[(edgeIndex + 1) % m_vertices.size()];
+
+	//the edge is on one side of the rectangle
+	if (	std::max(A.x, B.x) < rectMin.x || std::min(A.x, B.x) > rectMax.x
+		||	std::max(A.y, B.y) < rectMin.y || std::min(A.y, B.y) > rectMax.y)
+	{
+		return false;
+	}
+
+	//one of the edge vertices is inside the rectangle
+	if (	(A.x >= rectMin.x && A.x <= rectMax.x && A.y >= rectMin.y && A.y <= rectMax.y)
+		||	(B.x >= rectMin.x && B.x <= rectMax.x && B.y >= rectMin.y && B.y <= rectMax.y))
+	{
+		return true;
+	}
+
+	//otherwise the edge line must separate the rectangle corners
+	CCVector2d AB = B - A;
+	bool positive = false;
+	bool negative = false;
+	for (unsigned i = 0; i < 4; ++i)
+	{
+		CCVector2d corner((i & 1) ? rectMax.x : rectMin.x, (i & 2) ? rectMax.y : rectMin.y);
+		double s = AB.x * (corner.y - A.y) - AB.y * (corner.x - A.x);
+		if (s >= 0)
+			positive = true;
+		if (s <= 0)
+			negative = true;
+	}
+
+	return (positive && negative);
+}
+
+ccRegionSelector::CellPosition ccRegionSelector::ScreenPolygonRegion::classifyCell(const CCVector3& cellMin, const CCVector3& cellMax) const
+{
+	if (m_vertices.size() < 3)
+	{
+		//the points will be tested individually
+		return CELL_STRADDLING;
+	}
+
+	//bounding rectangle of the projected cell corners
+	CCVector2d rectMin(0, 0);
+	CCVector2d rectMax(0, 0);
+	bool allCornersInFrustum = true;
+	for (unsigned i = 0; i < 8; ++i)
+	{
+		CCVector3 C(	(i & 1) ? cellMax.x : cellMin.x,
+						(i & 2) ? cellMax.y : cellMin.y,
+						(i & 4) ? cellMax.z : cellMin.z);
+
+		double w = m_wRow[0] * C.x + m_wRow[1] * C.y + m_wRow[2] * C.z + m_wRow[3];
+		if (w <= 0)
+		{
+			//the cell is (partly) behind the camera: its projection can't be bounded
+			return CELL_STRADDLING;
+		}
+
+		CCVector3d Q2D;
+		bool cornerInFrustum = false;
+		m_camera.project(C, Q2D, &cornerInFrustum);
+		allCornersInFrustum &= cornerInFrustum;
+
+		CCVector2d Q(Q2D.x - m_halfW, Q2D.y - m_halfH);
+		if (i == 0)
+		{
+			rectMin = rectMax = Q;
+		}
+		else
+		{
+			rectMin.x = std::min(rectMin.x, Q.x);
+			rectMin.y = std::min(rectMin.y, Q.y);
+			rectMax.x = std::max(rectMax.x, Q.x);
+			rectMax.y = std::max(rectMax.y, Q.y);
+		}
+	}
+
+	//as the cell is in front of the camera, its projection is the convex hull of its projected corners
+	if (	rectMax.x < m_polyMin.x || rectMin.x > m_polyMax.x
+		||	rectMax.y < m_polyMin.y || rectMin.y > m_polyMax.y)
+	{
+		return CELL_OUTSIDE;
+	}
+
+	for (unsigned i = 0; i < static_cast<unsigned>(m_vertices.size()); ++i)
+	{
+		if (edgeIntersectsRect(i, rectMin, rectMax))
+		{
+			return CELL_STRADDLING;
+		}
+	}
+
+	//no edge crosses the rectangle: it is either fully inside or fully outside the polygon
+	CCVector2 rectCenter(	static_cast<PointCoordinateType>((rectMin.x + rectMax.x) / 2),
+							static_cast<PointCoordinateType>((rectMin.y + rectMax.y) / 2));
+	if (!CCCoreLib::ManualSegmentationTools::isPointInsidePoly(rectCenter, m_polygon))
+	{
+		return CELL_OUTSIDE;
+	}
+
+	if (m_skipPointsOutsideFrustum && !allCornersInFrustum)
+	{
+		//some points may be outside of the frustum (i.e. before the near plane or beyond the far plane)
+		return CELL_STRADDLING;
+	}
+
+	return CELL_INSIDE;
+}
+
+bool ccRegionSelector::ScreenPolygonRegion::isInside(const CCVector3& P) const
+{
+	CCVector3d Q2D;
+	bool pointInFrustum = false;
+	m_camera.project(P, Q2D, &pointInFrustum);
+
+	//we can only skip the test if the point is outside the viewport/frustum AND the polyline is fully inside the viewport
+	if (!pointInFrustum && m_skipPointsOutsideFrustum)
+	{
+		return false;
+	}
+
+	CCVector2 P2D(	static_cast<PointCoordinateType>(Q2D.x - m_halfW),
+					static_cast<PointCoordinateType>(Q2D.y - m_halfH));
+
+	return CCCoreLib::ManualSegmentationTools::isPointInsidePoly(P2D, m_polygon);
+}
+
+//! Range of points to test individually
+struct PointRange
+{
+	//! First point (index in the octree codes, or point index if there's no octree)
+	unsigned first;
+	//! Number of points
+	unsigned count;
+};
+
+//! Classifies the octree cells (from the root cell down)
+class OctreeCellsClassifier
+{
+public:
+
+	OctreeCellsClassifier(	const ccOctree& octree,
+							const ccRegionSelector::Region& region,
+							bool inside,
+							std::vector<unsigned>& indexes,
+							std::vector<PointRange>& straddlingRanges)
+		: m_octree(octree)
+		, m_cellCodes(octree.pointsAndTheirCellCodes())
+		, m_region(region)
+		, m_inside(inside)
+		, m_indexes(indexes)
+		, m_straddlingRanges(straddlingRanges)
+	{}
+
+	//! Classifies a cell (may throw std::bad_alloc)
+	/** \param level cell level
+		\param truncatedCode cell (truncated) code
+		\param first index of the first point of the cell (in the octree codes)
+		\param last index of the last point of the cell (excluded)
+	**/
+	void visit(unsigned char level, CCCoreLib::DgmOctree::CellCode truncatedCode, unsigned first, unsigned last)
+	{
+		CCVector3 cellMin;
+		CCVector3 cellMax;
+		m_octree.computeCellLimits(truncatedCode, level, cellMin, cellMax, true);
+
+		ccRegionSelector::CellPosition position = m_region.classifyCell(cellMin, cellMax);
+		if (position == ccRegionSelector::CELL_STRADDLING)
+		{
+			if (level == CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL || last - first <= c_minCellPointCount)
+			{
+				//the points of this cell will be tested individually
+				m_straddlingRanges.push_back(PointRange{ first, last - first });
+				return;
+			}
+
+			//otherwise we classify the children cells
+			unsigned char childLevel = level + 1;
+			const unsigned char bitDec = CCCoreLib::DgmOctree::GET_BIT_SHIFT(childLevel);
+			auto codeLessThan = [bitDec](CCCoreLib::DgmOctree::CellCode truncatedCode, const CCCoreLib::DgmOctree::IndexAndCode& a)
+			{
+				return truncatedCode < (a.theCode >> bitDec);
+			};
+
+			unsigned childFirst = first;
+			while (childFirst < last)
+			{
+				CCCoreLib::DgmOctree::CellCode childCode = (m_cellCodes[childFirst].theCode >> bitDec);
+
+				//the codes are sorted: binary search of the first point of the next cell
+				CCCoreLib::DgmOctree::cellsContainer::const_iterator it = std::upper_bound(m_cellCodes.begin() + childFirst, m_cellCodes.begin() + last, childCode, codeLessThan);
+				unsigned childLast = static_cast<unsigned>(it - m_cellCodes.begin());
+
+				visit(childLevel, childCode, childFirst, childLast);
+				childFirst = childLast;
+			}
+		}
+		else if ((position == ccRegionSelector::CELL_INSIDE) == m_inside)
+		{
+			//all the points of the cell are selected
+			for (unsigned i = first; i < last; ++i)
+			{
+				m_indexes.push_back(m_cellCodes[i].theIndex);
+			}
+		}
+	}
+
+protected:
+
+	const ccOctree& m_octree;
+	const CCCoreLib::DgmOctree::cellsContainer& m_cellCodes;
+	const ccRegionSelector::Region& m_region;
+	bool m_inside;
+	std::vector<unsigned>& m_indexes;
+	std::vector<PointRange>& m_straddlingRanges;
+};
+
+bool ccRegionSelector::Select(	ccGenericPointCloud* cloud,
+								const Region& region,
+								std::vector<unsigned>& indexes,
+								bool inside/*=true*/)
+{
+	indexes.clear();
+
+	if (!cloud)
+	{
+		assert(false);
+		return false;
+	}
+
+	unsigned pointCount = cloud->size();
+	if (pointCount == 0)
+	{
+		return true;
+	}
+
+	//ranges of points to test individually
+	std::vector<PointRange> ranges;
+	const CCCoreLib::DgmOctree::cellsContainer* cellCodes = nullptr;
+
+	try
+	{
+		ccOctree::Shared octree = cloud->getOctree();
+		if (octree && octree->pointsAndTheirCellCodes().size() == pointCount)
+		{
+			cellCodes = &octree->pointsAndTheirCellCodes();
+
+			OctreeCellsClassifier classifier(*octree, region, inside, indexes, ranges);
+			classifier.visit(0, 0, 0, pointCount);
+		}
+		else
+		{
+			//no (valid) octree: all the points have to be tested
+			for (unsigned first = 0; first < pointCount; first += c_blockPointCount)
+			{
+				ranges.push_back(PointRange{ first, std::min(c_blockPointCount, pointCount - first) });
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		indexes.clear();
+		return false;
+	}
+
+	//now we test the points of the straddling cells (by batches)
+	std::vector<unsigned char> pointFlags;
+	try
+	{
+		pointFlags.resize(std::min(c_maxBatchPointCount, pointCount));
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		indexes.clear();
+		return false;
+	}
+
+	size_t batchStart = 0;
+	while (batchStart < ranges.size())
+	{
+		//gather as many ranges as possible in this batch
+		std::vector<unsigned> flagOffsets;
+		size_t batchStop = batchStart;
+		unsigned batchPointCount = 0;
+		try
+		{
+			while (batchStop < ranges.size() && (batchStop == batchStart || batchPointCount + ranges[batchStop].count <= c_maxBatchPointCount))
+			{
+				flagOffsets.push_back(batchPointCount);
+				batchPointCount += ranges[batchStop].count;
+				++batchStop;
+			}
+			if (batchPointCount > pointFlags.size())
+			{
+				pointFlags.resize(batchPointCount);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			indexes.clear();
+			return false;
+		}
+
+		int rangeCount = static_cast<int>(batchStop - batchStart);
+#if defined(_OPENMP)
+		#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+		for (int r = 0; r < rangeCount; ++r)
+		{
+			const PointRange& range = ranges[batchStart + r];
+			unsigned char* flags = pointFlags.data() + flagOffsets[r];
+			for (unsigned i = 0; i < range.count; ++i)
+			{
+				unsigned pointIndex = (cellCodes ? (*cellCodes)[range.first + i].theIndex : range.first + i);
+				flags[i] = (region.isInside(*cloud->getPoint(pointIndex)) == inside ? 1 : 0);
+			}
+		}
+
+		//merge the results
+		try
+		{
+			for (int r = 0; r < rangeCount; ++r)
+			{
+				const PointRange& range = ranges[batchStart + r];
+				const unsigned char* flags = pointFlags.data() + flagOffsets[r];
+				for (unsigned i = 0; i < range.count; ++i)
+				{
+					if (flags[i])
+					{
+						indexes.push_back(cellCodes ? (*cellCodes)[range.first + i].theIndex : range.first + i);
+					}
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			indexes.clear();
+			return false;
+		}
+
+		batchStart = batchStop;
+	}
+
+	return true;
+}
@@ -0,0 +1,84 @@
+#include "TestCloudBatches.h"
+
+#include "ccCloudBatches.h"
+#include "ccPointCloud.h"
+
+void TestCloudBatches::testGridCells() const
+{
+	ccPointCloud cloud;
+	QVERIFY(cloud.reserve(54));
+	for (int k = 0; k < 3; ++k)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				cloud.addPoint(CCVector3(i, j, k));
+				cloud.addPoint(CCVector3(i + 0.5, j + 0.5, k + 0.5));
+			}
+		}
+	}
+
+	std::vector<unsigned> sortedIndexes;
+	std::vector<size_t> batchStarts;
+	QVERIFY(ccCloudBatches::BuildGridBatches(&cloud, 1, sortedIndexes, batchStarts));
+
+	QCOMPARE(sortedIndexes.size(), static_cast<size_t>(54));
+	QCOMPARE(batchStarts.size(), static_cast<size_t>(28));
+	QCOMPARE(batchStarts.front(), static_cast<size_t>(0));
+	QCOMPARE(batchStarts.back(), static_cast<size_t>(54));
+
+	//each point appears exactly once
+	std::vector<bool> seen(54, false);
+	for (unsigned index : sortedIndexes)
+	{
+		QVERIFY(index < 54);
+		QVERIFY(!seen[index]);
+		seen[index] = true;
+	}
+
+	//each batch holds the two points of a single cell
+	for (size_t b = 0; b + 1 < batchStarts.size(); ++b)
+	{
+		QCOMPARE(batchStarts[b + 1] - batchStarts[b], static_cast<size_t>(2));
+
+		const CCVector3* P = cloud.getPoint(sortedIndexes[batchStarts[b]]);
+		const CCVector3* Q = cloud.getPoint(sortedIndexes[batchStarts[b] + 1]);
+		QCOMPARE(static_cast<int>(P->x), static_cast<int>(Q->x));
+		QCOMPARE(static_cast<int>(P->y), static_cast<int>(Q->y));
+		QCOMPARE(static_cast<int>(P->z), static_cast<int>(Q->z));
+	}
+}
+
+void TestCloudBatches::testEmptyCloud() const
+{
+	ccPointCloud cloud;
+
+	std::vector<unsigned> sortedIndexes{ 1, 2, 3 };
+	std::vector<size_t> batchStarts{ 0, 3 };
+	QVERIFY(ccCloudBatches::BuildGridBatches(&cloud, 1, sortedIndexes, batchStarts));
+
+	QVERIFY(sortedIndexes.empty());
+	QVERIFY(batchStarts.empty());
+}
+
+void TestCloudBatches::testDegenerateCloud() const
+{
+	ccPointCloud cloud;
+	QVERIFY(cloud.reserve(10));
+	for (int i = 0; i < 10; ++i)
+	{
+		cloud.addPoint(CCVector3(1, 2, 3));
+	}
+
+	std::vector<unsigned> sortedIndexes;
+	std::vector<size_t> batchStarts;
+	QVERIFY(ccCloudBatches::BuildGridBatches(&cloud, 0, sortedIndexes, batchStarts));
+
+	QCOMPARE(sortedIndexes.size(), static_cast<size_t>(10));
+	QCOMPARE(batchStarts.size(), static_cast<size_t>(2));
+	QCOMPARE(batchStarts[0], static_cast<size_t>(0));
+	QCOMPARE(batchStarts[1], static_cast<size_t>(10));
+}
+
+QTEST_MAIN(TestCloudBatches)
@@ -0,0 +1,22 @@
+#ifndef CC_TEST_CLOUD_BATCHES_HEADER
+#define CC_TEST_CLOUD_BATCHES_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestCloudBatches : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+	//! Two points per cell of a 3x3x3 grid: one batch per cell
+	void testGridCells() const;
+
+	//! Empty cloud: no batch
+	void testEmptyCloud() const;
+
+	//! Points at the same position (and zero cell size): a single batch
+	void testDegenerateCloud() const;
+};
+
+
+#endif //CC_TEST_CLOUD_BATCHES_HEADER
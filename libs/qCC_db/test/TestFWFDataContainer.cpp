@@ -0,0 +1,177 @@
+#include "TestFWFDataContainer.h"
+
+#include "ccFWFDataContainer.h"
+
+#include <QFile>
+
+QString TestFWFDataContainer::writeTestFile(const QString& name, int size, int seed) const
+{
+	QString filename = m_dir.filePath(name);
+
+	QByteArray bytes(size, 0);
+	for (int i = 0; i < size; ++i)
+	{
+		bytes[i] = static_cast<char>(i + seed);
+	}
+
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly) || file.write(bytes) != size)
+	{
+		return QString();
+	}
+
+	return filename;
+}
+
+//! Checks that the container holds the bytes [offset, offset + size) of a test file
+static bool CheckContents(const ccFWFDataContainer& container, int offset, int seed, size_t size)
+{
+	if (container.size() != size || !container.data())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (container.data()[i] != static_cast<uint8_t>(offset + i + seed))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void TestFWFDataContainer::initTestCase() const
+{
+	QVERIFY(m_dir.isValid());
+}
+
+void TestFWFDataContainer::testInMemory() const
+{
+	ccFWFDataContainer empty;
+	QVERIFY(empty.empty());
+	QVERIFY(!empty.isMapped());
+
+	ccFWFDataContainer container(16);
+	QVERIFY(!container.isMapped());
+	QCOMPARE(container.size(), static_cast<size_t>(16));
+
+	uint8_t* data = container.data();
+	QVERIFY(data);
+	data[15] = 42;
+	QVERIFY(container.loadInMemory()); //nothing to do
+	QCOMPARE(container.data()[15], static_cast<uint8_t>(42));
+
+	container.resize(32);
+	QCOMPARE(container.size(), static_cast<size_t>(32));
+	QCOMPARE(container.data()[15], static_cast<uint8_t>(42));
+}
+
+void TestFWFDataContainer::testFromFileInMemory() const
+{
+	QString filename = writeTestFile("in_memory.bin", 64, 0);
+	QVERIFY(!filename.isEmpty());
+
+	ccFWFDataContainer container;
+	QVERIFY(container.fromFile(filename, 4, 8, false));
+	QVERIFY(!container.isMapped());
+	QVERIFY(!container.isMappedFrom(filename));
+	QVERIFY(CheckContents(container, 4, 0, 8));
+
+	//missing file
+	QVERIFY(!container.fromFile(m_dir.filePath("missing.bin"), 0, 8, false));
+}
+
+void TestFWFDataContainer::testMapped() const
+{
+	QString filename = writeTestFile("mapped.bin", 64, 0);
+	QVERIFY(!filename.isEmpty());
+
+	ccFWFDataContainer container;
+	QVERIFY(container.fromFile(filename, 16, 32));
+	QVERIFY(container.isMapped());
+	QVERIFY(container.isMappedFrom(filename));
+	//the registry is based on the canonical path
+	QVERIFY(container.isMappedFrom(m_dir.path() + "/./mapped.bin"));
+	QVERIFY(CheckContents(container, 16, 0, 32));
+
+	QVERIFY(container.loadInMemory());
+	QVERIFY(!container.isMapped());
+	QVERIFY(!container.isMappedFrom(filename));
+	QVERIFY(CheckContents(container, 16, 0, 32));
+
+	//the file is released
+	QVERIFY(QFile::remove(filename));
+	QVERIFY(CheckContents(container, 16, 0, 32));
+}
+
+void TestFWFDataContainer::testTruncatedFile() const
+{
+	QString filename = writeTestFile("truncated.bin", 64, 0);
+	QVERIFY(!filename.isEmpty());
+
+	ccFWFDataContainer container;
+	QVERIFY(container.fromFile(filename, 48, 100));
+	QVERIFY(CheckContents(container, 48, 0, 16));
+
+	QVERIFY(container.fromFile(filename, 48, 100, false));
+	QVERIFY(CheckContents(container, 48, 0, 16));
+
+	//invalid offset
+	QVERIFY(!container.fromFile(filename, 100, 8));
+}
+
+void TestFWFDataContainer::testWritableAccess() const
+{
+	QString filename = writeTestFile("writable.bin", 64, 0);
+	QVERIFY(!filename.isEmpty());
+
+	ccFWFDataContainer container;
+	QVERIFY(container.fromFile(filename, 0, 64));
+	QVERIFY(container.isMapped());
+
+	uint8_t* data = container.data();
+	QVERIFY(data);
+	QVERIFY(!container.isMapped());
+	data[0] = 255;
+
+	//the file is unchanged
+	ccFWFDataContainer other;
+	QVERIFY(other.fromFile(filename, 0, 64, false));
+	QVERIFY(CheckContents(other, 0, 0, 64));
+}
+
+void TestFWFDataContainer::testDetachAllFromFile() const
+{
+	QString filename = writeTestFile("detach.bin", 64, 0);
+	QVERIFY(!filename.isEmpty());
+	QString otherFilename = writeTestFile("detach_other.bin", 64, 7);
+	QVERIFY(!otherFilename.isEmpty());
+
+	ccFWFDataContainer first;
+	QVERIFY(first.fromFile(filename, 0, 32));
+	ccFWFDataContainer second;
+	QVERIFY(second.fromFile(filename, 32, 32));
+	ccFWFDataContainer other;
+	QVERIFY(other.fromFile(otherFilename, 0, 64));
+	QVERIFY(first.isMapped() && second.isMapped() && other.isMapped());
+
+	QVERIFY(ccFWFDataContainer::DetachAllFromFile(filename));
+	QVERIFY(!first.isMapped());
+	QVERIFY(!second.isMapped());
+	QVERIFY(other.isMappedFrom(otherFilename));
+	QVERIFY(CheckContents(first, 0, 0, 32));
+	QVERIFY(CheckContents(second, 32, 0, 32));
+
+	//the file can now be overwritten
+	QCOMPARE(writeTestFile("detach.bin", 64, 100), filename);
+	QVERIFY(CheckContents(first, 0, 0, 32));
+	QVERIFY(CheckContents(second, 32, 0, 32));
+
+	//nothing left to detach
+	QVERIFY(ccFWFDataContainer::DetachAllFromFile(filename));
+	QVERIFY(CheckContents(other, 0, 7, 64));
+}
+
+QTEST_MAIN(TestFWFDataContainer)
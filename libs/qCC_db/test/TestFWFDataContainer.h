@@ -0,0 +1,41 @@
+#ifndef CC_TEST_FWF_DATA_CONTAINER_HEADER
+#define CC_TEST_FWF_DATA_CONTAINER_HEADER
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+class TestFWFDataContainer : public QObject
+{
+Q_OBJECT
+private:
+	//! Writes a test file (where byte[i] = i + seed) and returns its path
+	QString writeTestFile(const QString& name, int size, int seed) const;
+
+	//! Temporary directory for the test files
+	QTemporaryDir m_dir;
+
+private Q_SLOTS:
+	void initTestCase() const;
+
+	//! In-memory container
+	void testInMemory() const;
+
+	//! File part loaded in memory
+	void testFromFileInMemory() const;
+
+	//! File part memory-mapped, then loaded in memory
+	void testMapped() const;
+
+	//! The size is clamped to the file size
+	void testTruncatedFile() const;
+
+	//! The non-const data accessor loads the mapped data in memory
+	void testWritableAccess() const;
+
+	//! All the containers mapped from a file are detached from it (and only them)
+	void testDetachAllFromFile() const;
+};
+
+
+#endif //CC_TEST_FWF_DATA_CONTAINER_HEADER
@@ -0,0 +1,141 @@
+#include "TestPointCloudFWF.h"
+
+#include "ccPointCloud.h"
+
+//! Creates a cloud with 4 waveforms pointing in a 100 bytes container (where data[i] = i)
+/** - waveform #0: bytes [10, 15)
+	- waveform #1: bytes [12, 18) (overlaps #0)
+	- waveform #2: bytes [50, 54)
+	- waveform #3: no data
+**/
+static bool CreateFWFCloud(ccPointCloud& cloud)
+{
+	if (!cloud.reserve(4))
+	{
+		return false;
+	}
+	for (int i = 0; i < 4; ++i)
+	{
+		cloud.addPoint(CCVector3(i, 0, 0));
+	}
+
+	ccPointCloud::FWFDataContainer* container = new ccPointCloud::FWFDataContainer(100);
+	uint8_t* data = container->data();
+	for (int i = 0; i < 100; ++i)
+	{
+		data[i] = static_cast<uint8_t>(i);
+	}
+	cloud.fwfData() = ccPointCloud::SharedFWFDataContainer(container);
+
+	WaveformDescriptor d;
+	d.numberOfSamples = 4;
+	d.samplingRate_ps = 1000;
+	d.digitizerGain = 2.0;
+	d.digitizerOffset = 1.0;
+	d.bitsPerSample = 8;
+	cloud.fwfDescriptors().insert(1, d);
+
+	std::vector<ccWaveform>& waveforms = cloud.waveforms();
+	waveforms.resize(cloud.size());
+	waveforms[0] = ccWaveform(1);
+	waveforms[0].setDataDescription(10, 5);
+	waveforms[1] = ccWaveform(1);
+	waveforms[1].setDataDescription(12, 6);
+	waveforms[2] = ccWaveform(1);
+	waveforms[2].setDataDescription(50, 4);
+	waveforms[3] = ccWaveform(0);
+	waveforms[3].setDataDescription(0, 0);
+
+	return true;
+}
+
+void TestPointCloudFWF::testCompressRemapping() const
+{
+	ccPointCloud cloud;
+	QVERIFY(CreateFWFCloud(cloud));
+
+	//first byte of each waveform (before compression)
+	std::vector<uint8_t> firstBytes;
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		firstBytes.push_back(cloud.fwfData()->data()[cloud.waveforms()[i].dataOffset()]);
+	}
+
+	QVERIFY(cloud.compressFWFData());
+
+	//[10, 18) and [50, 54) are kept
+	QCOMPARE(cloud.fwfData()->size(), static_cast<size_t>(12));
+
+	const std::vector<ccWaveform>& waveforms = cloud.waveforms();
+	QCOMPARE(waveforms[0].dataOffset(), static_cast<uint64_t>(0));
+	QCOMPARE(waveforms[1].dataOffset(), static_cast<uint64_t>(2));
+	QCOMPARE(waveforms[2].dataOffset(), static_cast<uint64_t>(8));
+	QCOMPARE(waveforms[3].dataOffset(), static_cast<uint64_t>(0));
+
+	//the byte counts are unchanged
+	QCOMPARE(waveforms[0].byteCount(), static_cast<uint32_t>(5));
+	QCOMPARE(waveforms[1].byteCount(), static_cast<uint32_t>(6));
+	QCOMPARE(waveforms[2].byteCount(), static_cast<uint32_t>(4));
+	QCOMPARE(waveforms[3].byteCount(), static_cast<uint32_t>(0));
+
+	//the data is preserved
+	const uint8_t* data = cloud.fwfData()->data();
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		QCOMPARE(data[waveforms[i].dataOffset()], firstBytes[i]);
+		for (uint32_t j = 0; j < waveforms[i].byteCount(); ++j)
+		{
+			QCOMPARE(data[waveforms[i].dataOffset() + j], static_cast<uint8_t>(firstBytes[i] + j));
+		}
+	}
+}
+
+void TestPointCloudFWF::testCompressNoGain() const
+{
+	ccPointCloud cloud;
+	QVERIFY(CreateFWFCloud(cloud));
+
+	//all the bytes are used
+	cloud.waveforms()[3] = ccWaveform(1);
+	cloud.waveforms()[3].setDataDescription(0, 100);
+
+	const ccPointCloud::FWFDataContainer* container = cloud.fwfData().data();
+	QVERIFY(cloud.compressFWFData());
+	QCOMPARE(cloud.fwfData().data(), container);
+	QCOMPARE(cloud.fwfData()->size(), static_cast<size_t>(100));
+	QCOMPARE(cloud.waveforms()[2].dataOffset(), static_cast<uint64_t>(50));
+}
+
+void TestPointCloudFWF::testCompressEmpty() const
+{
+	ccPointCloud cloud;
+	QVERIFY(!cloud.compressFWFData());
+
+	cloud.fwfData() = ccPointCloud::SharedFWFDataContainer(new ccPointCloud::FWFDataContainer);
+	QVERIFY(!cloud.compressFWFData());
+}
+
+void TestPointCloudFWF::testAmplitude() const
+{
+	ccPointCloud cloud;
+	QVERIFY(CreateFWFCloud(cloud));
+
+	//4 samples per waveform: raw values in [10, 53] (waveform #3 has no descriptor)
+	double minVal = 0.0;
+	double maxVal = 0.0;
+	QVERIFY(cloud.computeFWFAmplitude(minVal, maxVal));
+	QCOMPARE(minVal, 2.0 * 10 + 1.0);
+	QCOMPARE(maxVal, 2.0 * 53 + 1.0);
+
+	//same values after compression
+	QVERIFY(cloud.compressFWFData());
+	QVERIFY(cloud.computeFWFAmplitude(minVal, maxVal));
+	QCOMPARE(minVal, 2.0 * 10 + 1.0);
+	QCOMPARE(maxVal, 2.0 * 53 + 1.0);
+
+	//the waveforms table must match the cloud size
+	cloud.waveforms().pop_back();
+	QVERIFY(!cloud.computeFWFAmplitude(minVal, maxVal));
+}
+
+QTEST_MAIN(TestPointCloudFWF)
@@ -0,0 +1,25 @@
+#ifndef CC_TEST_POINT_CLOUD_FWF_HEADER
+#define CC_TEST_POINT_CLOUD_FWF_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestPointCloudFWF : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+	//! Unused bytes are removed and the waveform offsets are remapped
+	void testCompressRemapping() const;
+
+	//! Nothing to compress: the container is kept as is
+	void testCompressNoGain() const;
+
+	//! No FWF data: compression fails
+	void testCompressEmpty() const;
+
+	//! Min and max amplitudes (before and after compression)
+	void testAmplitude() const;
+};
+
+
+#endif //CC_TEST_POINT_CLOUD_FWF_HEADER
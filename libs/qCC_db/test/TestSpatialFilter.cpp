@@ -0,0 +1,260 @@
+#include "TestSpatialFilter.h"
+
+#include "ccPointCloud.h"
+
+#include <algorithm>
+#include <vector>
+
+Q_DECLARE_METATYPE(ccPointCloud::RGB_FILTER_TYPES)
+
+//! Adds a scalar field to a cloud and returns it
+static CCCoreLib::ScalarField* AddScalarField(ccPointCloud& cloud, const std::string& name)
+{
+	int sfIdx = cloud.addScalarField(name);
+	return (sfIdx >= 0 ? cloud.getScalarField(sfIdx) : nullptr);
+}
+
+//! Test value of a point (not spatially smooth)
+static ScalarType TestValue(unsigned index)
+{
+	return static_cast<ScalarType>((index * 37) % 17);
+}
+
+void TestSpatialFilter::testInPlaceScalarField_data() const
+{
+	QTest::addColumn<ccPointCloud::RGB_FILTER_TYPES>("filterType");
+	QTest::addColumn<bool>("bilateral");
+
+	QTest::newRow("gaussian") << ccPointCloud::RGB_FILTER_TYPES::GAUSSIAN << false;
+	QTest::newRow("bilateral") << ccPointCloud::RGB_FILTER_TYPES::BILATERAL << true;
+	QTest::newRow("mean") << ccPointCloud::RGB_FILTER_TYPES::MEAN << false;
+	QTest::newRow("median") << ccPointCloud::RGB_FILTER_TYPES::MEDIAN << false;
+}
+
+void TestSpatialFilter::testInPlaceScalarField() const
+{
+	QFETCH(ccPointCloud::RGB_FILTER_TYPES, filterType);
+	QFETCH(bool, bilateral);
+
+	//6 x 6 x 2 grid
+	ccPointCloud cloud;
+	QVERIFY(cloud.reserve(72));
+	for (int k = 0; k < 2; ++k)
+	{
+		for (int j = 0; j < 6; ++j)
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				cloud.addPoint(CCVector3(i, j, k));
+			}
+		}
+	}
+
+	CCCoreLib::ScalarField* inputSF = AddScalarField(cloud, "input");
+	CCCoreLib::ScalarField* outputSF = AddScalarField(cloud, "output");
+	QVERIFY(inputSF && outputSF);
+	for (unsigned i = 0; i < cloud.size(); ++i)
+	{
+		inputSF->setValue(i, TestValue(i));
+	}
+
+	ccPointCloud::SpatialFilterParameters params;
+	params.sigma = 0.5f;
+	params.options.filterType = filterType;
+	if (bilateral)
+	{
+		params.sigmaSF = 2.0f;
+		params.guideSF = inputSF;
+	}
+
+	//reference: separate output
+	params.scalarFields.emplace_back(inputSF, outputSF);
+	QVERIFY(cloud.applySpatialFilter(params));
+	for (unsigned i = 0; i < cloud.size(); ++i)
+	{
+		//the input is left untouched
+		QCOMPARE(inputSF->getValue(i), TestValue(i));
+	}
+
+	//in place (the guide is also the filtered field)
+	params.scalarFields.clear();
+	params.scalarFields.emplace_back(inputSF, inputSF);
+	QVERIFY(cloud.applySpatialFilter(params));
+
+	bool changed = false;
+	for (unsigned i = 0; i < cloud.size(); ++i)
+	{
+		QCOMPARE(inputSF->getValue(i), outputSF->getValue(i));
+		changed |= (outputSF->getValue(i) != TestValue(i));
+	}
+	QVERIFY(changed);
+}
+
+void TestSpatialFilter::testNaNFill() const
+{
+	//2 x 2 x 2 cube (each point has 6 neighbours within 1.5) + an isolated point
+	ccPointCloud cloud;
+	QVERIFY(cloud.reserve(9));
+	for (int k = 0; k < 2; ++k)
+	{
+		for (int j = 0; j < 2; ++j)
+		{
+			for (int i = 0; i < 2; ++i)
+			{
+				cloud.addPoint(CCVector3(i, j, k));
+			}
+		}
+	}
+	cloud.addPoint(CCVector3(100, 100, 100));
+	const unsigned isolatedIndex = 8;
+
+	CCCoreLib::ScalarField* inputSF = AddScalarField(cloud, "input");
+	CCCoreLib::ScalarField* guideSF = AddScalarField(cloud, "guide");
+	CCCoreLib::ScalarField* outputSF = AddScalarField(cloud, "output");
+	QVERIFY(inputSF && guideSF && outputSF);
+	for (unsigned i = 0; i < cloud.size(); ++i)
+	{
+		inputSF->setValue(i, TestValue(i));
+		guideSF->setValue(i, 1.0f);
+	}
+	//the isolated point has no valid value
+	inputSF->setValue(isolatedIndex, CCCoreLib::NAN_VALUE);
+	//a point of the cube has no valid value (but valid neighbours)
+	inputSF->setValue(1, CCCoreLib::NAN_VALUE);
+
+	ccPointCloud::SpatialFilterParameters params;
+	params.sigma = 0.5f;
+	params.scalarFields.emplace_back(inputSF, outputSF);
+
+	for (ccPointCloud::RGB_FILTER_TYPES filterType : { ccPointCloud::RGB_FILTER_TYPES::GAUSSIAN, ccPointCloud::RGB_FILTER_TYPES::MEAN, ccPointCloud::RGB_FILTER_TYPES::MEDIAN })
+	{
+		params.options.filterType = filterType;
+		outputSF->fill(0);
+		QVERIFY(cloud.applySpatialFilter(params));
+
+		QVERIFY(!CCCoreLib::ScalarField::ValidValue(outputSF->getValue(isolatedIndex)));
+		for (unsigned i = 0; i < isolatedIndex; ++i)
+		{
+			QVERIFY(CCCoreLib::ScalarField::ValidValue(outputSF->getValue(i)));
+		}
+	}
+
+	//bilateral filter: the points with an invalid guide value are set to NaN
+	guideSF->setValue(3, CCCoreLib::NAN_VALUE);
+	params.options.filterType = ccPointCloud::RGB_FILTER_TYPES::BILATERAL;
+	params.sigmaSF = 1.0f;
+	params.guideSF = guideSF;
+	outputSF->fill(0);
+	QVERIFY(cloud.applySpatialFilter(params));
+
+	QVERIFY(!CCCoreLib::ScalarField::ValidValue(outputSF->getValue(3)));
+	QVERIFY(!CCCoreLib::ScalarField::ValidValue(outputSF->getValue(isolatedIndex)));
+	for (unsigned i = 0; i < isolatedIndex; ++i)
+	{
+		if (i != 3)
+		{
+			QVERIFY(CCCoreLib::ScalarField::ValidValue(outputSF->getValue(i)));
+		}
+	}
+}
+
+void TestSpatialFilter::testMedian() const
+{
+	//8 points (even count) all within the neighbourhood of each other
+	const unsigned count = 8;
+	ccPointCloud cloud;
+	QVERIFY(cloud.reserve(count));
+	for (unsigned i = 0; i < count; ++i)
+	{
+		cloud.addPoint(CCVector3(i * 0.01f, 0, 0));
+	}
+	QVERIFY(cloud.resizeTheRGBTable());
+
+	CCCoreLib::ScalarField* sf = AddScalarField(cloud, "values");
+	QVERIFY(sf);
+
+	std::vector<ColorCompType> red;
+	std::vector<ColorCompType> green;
+	std::vector<ColorCompType> blue;
+	std::vector<ScalarType> values;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		//no burnt-out color (i.e. not all components at 0 or 255)
+		ccColor::Rgb col(	static_cast<ColorCompType>((i * 37) % 200 + 10),
+							static_cast<ColorCompType>((i * 91) % 200 + 20),
+							static_cast<ColorCompType>((i * 53) % 250 + 1) );
+		cloud.setPointColor(i, col);
+		red.push_back(col.r);
+		green.push_back(col.g);
+		blue.push_back(col.b);
+
+		values.push_back(TestValue(i));
+		sf->setValue(i, values.back());
+	}
+
+	auto nthElementMedian = [](auto values) {
+		auto med = values.begin() + values.size() / 2;
+		std::nth_element(values.begin(), med, values.end());
+		return *med;
+	};
+	const ColorCompType expectedR = nthElementMedian(red);
+	const ColorCompType expectedG = nthElementMedian(green);
+	const ColorCompType expectedB = nthElementMedian(blue);
+	const ScalarType expectedValue = nthElementMedian(values);
+
+	ccPointCloud::SpatialFilterParameters params;
+	params.sigma = 1.0f;
+	params.options.filterType = ccPointCloud::RGB_FILTER_TYPES::MEDIAN;
+	params.filterRGB = true;
+	params.scalarFields.emplace_back(sf, sf);
+	QVERIFY(cloud.applySpatialFilter(params));
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const ccColor::Rgba& col = cloud.getPointColor(i);
+		QCOMPARE(col.r, expectedR);
+		QCOMPARE(col.g, expectedG);
+		QCOMPARE(col.b, expectedB);
+		QCOMPARE(sf->getValue(i), expectedValue);
+	}
+}
+
+void TestSpatialFilter::testInvalidParameters() const
+{
+	ccPointCloud cloud;
+	ccPointCloud::SpatialFilterParameters params;
+	params.sigma = 1.0f;
+	params.filterRGB = true;
+
+	//empty cloud
+	QVERIFY(!cloud.applySpatialFilter(params));
+
+	QVERIFY(cloud.reserve(2));
+	cloud.addPoint(CCVector3(0, 0, 0));
+	cloud.addPoint(CCVector3(1, 0, 0));
+
+	//no color
+	QVERIFY(!cloud.applySpatialFilter(params));
+
+	//nothing to filter
+	params.filterRGB = false;
+	QVERIFY(!cloud.applySpatialFilter(params));
+
+	CCCoreLib::ScalarField* sf = AddScalarField(cloud, "values");
+	QVERIFY(sf);
+	params.scalarFields.emplace_back(sf, sf);
+
+	//invalid sigma
+	params.sigma = 0;
+	QVERIFY(!cloud.applySpatialFilter(params));
+	params.sigma = 1.0f;
+
+	//bilateral filter without guide
+	params.sigmaSF = 1.0f;
+	QVERIFY(!cloud.applySpatialFilter(params));
+	params.sigmaSF = 0;
+
+	QVERIFY(cloud.applySpatialFilter(params));
+}
+
+QTEST_MAIN(TestSpatialFilter)
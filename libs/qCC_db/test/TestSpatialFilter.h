@@ -0,0 +1,26 @@
+#ifndef CC_TEST_SPATIAL_FILTER_HEADER
+#define CC_TEST_SPATIAL_FILTER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestSpatialFilter : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+	//! Filtering a scalar field in place gives the same result as filtering it in another field
+	void testInPlaceScalarField_data() const;
+	void testInPlaceScalarField() const;
+
+	//! The points without valid neighbour (or with an invalid guide value) are set to NaN
+	void testNaNFill() const;
+
+	//! The (histogram based) RGB median and the (selection based) SF median match std::nth_element
+	void testMedian() const;
+
+	//! Invalid parameters are rejected
+	void testInvalidParameters() const;
+};
+
+
+#endif //CC_TEST_SPATIAL_FILTER_HEADER
@@ -0,0 +1,125 @@
+#pragma once
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#include "qCC_glWindow.h"
+
+//local
+#include "ccGLWindowInterface.h"
+
+//Qt
+#include <QObject>
+
+class QOffscreenSurface;
+
+//! Offscreen (headless) OpenGL 3D view
+/** This view has no window nor widget: it renders in a QOffscreenSurface
+	and can only be used to render images (see renderToImage and renderToFile),
+	typically from the command line.
+
+	No GPU nor display is required as long as the Qt platform plugin can create
+	OpenGL contexts with an offscreen surface (e.g. 'offscreen' with a virtual X
+	server, or 'eglfs'/'minimalegl' with a surfaceless EGL implementation). Combined
+	with a software OpenGL implementation (e.g. Mesa's llvmpipe), this allows to
+	render snapshots on headless servers.
+**/
+class CCGLWINDOW_LIB_API ccGLOffscreenWindow : public QObject, public ccGLWindowInterface
+{
+	Q_OBJECT
+
+public:
+
+	//! Default constructor
+	/** \warning initializeGL must be called before rendering anything.
+	**/
+	ccGLOffscreenWindow(QSurfaceFormat* format = nullptr, QObject* parent = nullptr, bool silentInitialization = false);
+
+	//! Destructor
+	~ccGLOffscreenWindow() override;
+
+	//! Creates the OpenGL context and initializes the view
+	/** \return false if no OpenGL context could be created
+	**/
+	bool initializeGL();
+
+	//! Sets the view size (in pixels)
+	void resize(int w, int h);
+
+	//inherited from ccGLWindowInterface
+	inline qreal getDevicePixelRatio() const override { return 1.0; }
+	inline QFont getFont() const override { return m_font; }
+	inline QOpenGLContext* getOpenGLContext() const override { return m_context; }
+	inline void setWindowCursor(const QCursor&) override {}
+	void doMakeCurrent() override;
+	inline QObject* asQObject() override { return this; }
+	inline const QObject* asQObject() const override { return this; }
+	inline QString getWindowTitle() const override { return objectName(); }
+	inline void doGrabMouse() override {}
+	inline void doReleaseMouse() override {}
+	inline QPoint doMapFromGlobal(const QPoint& P) const override { return P; }
+	inline void doShowMaximized() override {}
+	inline void doResize(int w, int h) override { resize(w, h); }
+	inline void doResize(const QSize& size) override { resize(size.width(), size.height()); }
+	inline QImage doGrabFramebuffer() override { return {}; } //FBOs are always used
+	inline bool isStereo() const override { return false; }
+
+	inline QSize getScreenSize() const override { return m_size; }
+
+	//inherited from ccGLWindowInterface
+	inline int qtWidth() const override { return m_size.width(); }
+	inline int qtHeight() const override { return m_size.height(); }
+	inline QSize qtSize() const override { return m_size; }
+
+	//inherited from ccGenericGLDisplay
+	inline void requestUpdate() override {} //nothing to display
+
+	//! Creates an instance (with the default surface format) and initializes it
+	/** \return the offscreen view or nullptr if it couldn't be initialized
+	**/
+	static ccGLOffscreenWindow* Create(int width, int height, bool silentInitialization = false);
+
+protected: //rendering
+
+	//inherited from ccGLWindowInterface
+	inline ccQOpenGLFunctions* functions() const override { return m_context ? m_context->versionFunctions<ccQOpenGLFunctions>() : nullptr; }
+	inline QSurfaceFormat getSurfaceFormat() const override { return m_format; }
+	inline void doSetMouseTracking(bool) override {}
+	inline void doShowFullScreen() override {}
+	inline void doShowNormal() override {}
+	bool preInitialize(bool& firstTime) override;
+	bool postInitialize(bool firstTime) override;
+
+	//inherited from ccGLWindowInterface
+	int width() const override { return m_size.width(); }
+	int height() const override { return m_size.height(); }
+	QSize size() const override { return m_size; }
+	GLuint defaultQtFBO() const override { return 0; }
+
+protected: //members
+
+	//! Offscreen surface
+	QOffscreenSurface* m_surface;
+
+	//! Associated OpenGL context
+	QOpenGLContext* m_context;
+
+	//! Format
+	QSurfaceFormat m_format;
+
+	//! View size (in pixels)
+	QSize m_size;
+};
@@ -450,6 +450,33 @@ public:
 						bool dontScaleFeatures = false,
 						bool renderOverlayItems = false );
 
+	//! Render timings (see renderToImage)
+	struct RenderTimings
+	{
+		//! FBO and GL filter preparation (ms)
+		double setup_ms = 0.0;
+		//! 3D rendering pass(es) (ms)
+		double render3D_ms = 0.0;
+		//! GL filter shading, e.g. EDL (ms)
+		double glFilter_ms = 0.0;
+		//! 2D and overlay items (ms)
+		double overlay_ms = 0.0;
+		//! Image read back (ms)
+		double readBack_ms = 0.0;
+		//! Total (ms)
+		double total_ms = 0.0;
+	};
+
+	//! Enables or disables the per-stage timings of renderToImage
+	/** When enabled, the GPU is synchronized at the end of each stage
+		so that the timings are meaningful (which is slightly slower).
+	**/
+	inline void setRenderTimingsEnabled(bool state) { m_renderTimingsEnabled = state; }
+	//! Returns whether the per-stage timings of renderToImage are enabled
+	inline bool renderTimingsEnabled() const { return m_renderTimingsEnabled; }
+	//! Returns the timings of the last call to renderToImage (if enabled)
+	inline const RenderTimings& getLastRenderTimings() const { return m_lastRenderTimings; }
+
 	static void SetShaderPath(const QString &path);
 	static QString GetShaderPath();
 
@@ -1358,6 +1385,11 @@ protected: //members
 
 	//! Display scale
 	CCVector2d m_displayScale;
+
+	//! Whether the per-stage timings of renderToImage are enabled
+	bool m_renderTimingsEnabled;
+	//! Timings of the last call to renderToImage
+	RenderTimings m_lastRenderTimings;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(ccGLWindowInterface::INTERACTION_FLAGS);
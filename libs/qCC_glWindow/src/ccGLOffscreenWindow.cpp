@@ -0,0 +1,167 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+//qCC
+#include "ccGLOffscreenWindow.h"
+
+//qCC_db
+#include <ccLog.h>
+
+//CCFbo
+#include <ccFrameBufferObject.h>
+
+//Qt
+#include <QOffscreenSurface>
+
+ccGLOffscreenWindow::ccGLOffscreenWindow(	QSurfaceFormat* format/*=nullptr*/,
+											QObject* parent/*=nullptr*/,
+											bool silentInitialization/*=false*/)
+	: QObject(parent)
+	, ccGLWindowInterface(this, silentInitialization)
+	, m_surface(nullptr)
+	, m_context(nullptr)
+	, m_size(640, 480)
+{
+	m_format = format ? *format : QSurfaceFormat::defaultFormat();
+
+	//no interaction
+	setPickingMode(NO_PICKING);
+	setInteractionMode(MODE_TRANSFORM_CAMERA);
+
+	QString windowTitle = QString("3D View Offscreen %1").arg(m_uniqueID);
+	setObjectName(windowTitle);
+}
+
+ccGLOffscreenWindow::~ccGLOffscreenWindow()
+{
+	if (m_context && m_surface)
+	{
+		//the OpenGL resources must be released with the context being current
+		m_context->makeCurrent(m_surface);
+		uninitializeGL();
+		m_context->doneCurrent();
+	}
+
+	delete m_context;
+	m_context = nullptr;
+
+	if (m_surface)
+	{
+		m_surface->destroy();
+		delete m_surface;
+		m_surface = nullptr;
+	}
+}
+
+bool ccGLOffscreenWindow::initializeGL()
+{
+	return initialize();
+}
+
+void ccGLOffscreenWindow::resize(int w, int h)
+{
+	if (w <= 0 || h <= 0)
+	{
+		assert(false);
+		return;
+	}
+
+	m_size = QSize(w, h);
+
+	if (m_initialized)
+	{
+		doMakeCurrent();
+		onResizeGL(w, h);
+	}
+}
+
+void ccGLOffscreenWindow::doMakeCurrent()
+{
+	if (m_context && m_surface)
+	{
+		m_context->makeCurrent(m_surface);
+	}
+
+	if (m_activeFbo)
+	{
+		m_activeFbo->start();
+	}
+}
+
+bool ccGLOffscreenWindow::preInitialize(bool& firstTime)
+{
+	firstTime = false;
+	if (!m_context)
+	{
+		m_surface = new QOffscreenSurface;
+		m_surface->setFormat(m_format);
+		m_surface->create();
+		if (!m_surface->isValid())
+		{
+			ccLog::Error("Failed to create the offscreen surface");
+			return false;
+		}
+
+		m_context = new QOpenGLContext;
+		m_context->setFormat(m_format);
+		m_context->setShareContext(QOpenGLContext::globalShareContext());
+		if (!m_context->create())
+		{
+			ccLog::Error("Failed to create the OpenGL context");
+			return false;
+		}
+		firstTime = true;
+	}
+	else if (!m_context->isValid())
+	{
+		return false;
+	}
+
+	if (!m_context->makeCurrent(m_surface))
+	{
+		ccLog::Error("Failed to activate the OpenGL context (offscreen)");
+		return false;
+	}
+
+	return true;
+}
+
+bool ccGLOffscreenWindow::postInitialize(bool firstTime)
+{
+	if (firstTime)
+	{
+		onResizeGL(m_size.width(), m_size.height());
+	}
+
+	return true;
+}
+
+ccGLOffscreenWindow* ccGLOffscreenWindow::Create(int width, int height, bool silentInitialization/*=false*/)
+{
+	QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+	format.setStereo(false);
+
+	ccGLOffscreenWindow* window = new ccGLOffscreenWindow(&format, nullptr, silentInitialization);
+	window->resize(width, height);
+	if (!window->initializeGL())
+	{
+		delete window;
+		return nullptr;
+	}
+
+	return window;
+}
@@ -16,6 +16,7 @@
 //##########################################################################
 
 //qCC
+#include "ccGLOffscreenWindow.h"
 #include "ccGLWindow.h"
 #include "ccGLWindowStereo.h"
 #include "ccRenderingTools.h"
@@ -325,6 +326,7 @@ ccGLWindowInterface::ccGLWindowInterface(QObject* parent/*=nullptr*/, bool silen
 	, m_defaultCursorShape(Qt::ArrowCursor)
 	, m_signalEmitter(new ccGLWindowSignalEmitter(this, parent))
 	, m_displayScale(1.0, 1.0)
+	, m_renderTimingsEnabled(false)
 {
 	//start internal timer
 	m_timer.start();
@@ -883,7 +885,8 @@ void ccGLWindowInterface::onResizeGL(int w, int h)
 
 void ccGLWindowInterface::refresh(bool only2D/*=false*/)
 {
-	if (m_shouldBeRefreshed && asWidget()->isVisible())
+	//offscreen views have no widget
+	if (m_shouldBeRefreshed && asWidget() && asWidget()->isVisible())
 	{
 		redraw(only2D);
 	}
@@ -905,7 +908,7 @@ void ccGLWindowInterface::redraw(bool only2D/*=false*/, bool resetLOD/*=true*/)
 		deprecate3DLayer();
 	}
 
-	if (asWidget()->isVisible() && !m_autoRefresh)
+	if (asWidget() && asWidget()->isVisible() && !m_autoRefresh)
 	{
 		requestUpdate();
 	}
@@ -4587,7 +4590,9 @@ void ccGLWindowInterface::stopFrameRateTest()
 	displayNewMessage(QString(), ccGLWindow::UPPER_CENTER_MESSAGE); //clear message in the upper center area
 	if (s_frameRateElapsedTime_ms > 0)
 	{
-		QString message = QString("Framerate: %1 fps").arg((s_frameRateCurrentFrame*1.0e3) / s_frameRateElapsedTime_ms, 0, 'f', 3);
+		QString message = QString("Framerate: %1 fps (%2 ms per frame)")
+							.arg((s_frameRateCurrentFrame*1.0e3) / s_frameRateElapsedTime_ms, 0, 'f', 3)
+							.arg(static_cast<double>(s_frameRateElapsedTime_ms) / std::max(s_frameRateCurrentFrame, 1u), 0, 'f', 2);
 		displayNewMessage(message, ccGLWindow::LOWER_LEFT_MESSAGE, true);
 		ccLog::Print(message);
 	}
@@ -5723,6 +5728,10 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 
 	doMakeCurrent();
 
+	m_lastRenderTimings = RenderTimings();
+	QElapsedTimer renderTimer;
+	renderTimer.start();
+
 	//current window size (in pixels)
 	int Wp = static_cast<int>(width() * zoomFactor);
 	int Hp = static_cast<int>(height() * zoomFactor);
@@ -5821,6 +5830,20 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 	ccQOpenGLFunctions* glFunc = functions();
 	assert(glFunc);
 
+	//measures the duration of a rendering stage (the GPU must be synchronized first)
+	qint64 lastStageEnd_ns = 0;
+	auto stageDone = [&](double& stage_ms)
+	{
+		if (m_renderTimingsEnabled)
+		{
+			glFunc->glFinish();
+			qint64 now_ns = renderTimer.nsecsElapsed();
+			stage_ms = (now_ns - lastStageEnd_ns) / 1.0e6;
+			lastStageEnd_ns = now_ns;
+		}
+	};
+	stageDone(m_lastRenderTimings.setup_ms);
+
 	CC_DRAW_CONTEXT CONTEXT;
 	getContext(CONTEXT);
 	CONTEXT.renderZoom = zoomFactor;
@@ -5862,6 +5885,8 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 
 	m_stereoModeEnabled = stereoModeWasEnabled;
 
+	stageDone(m_lastRenderTimings.render3D_ms);
+
 	CONTEXT.drawingFlags = CC_DRAW_2D | CC_DRAW_FOREGROUND;
 	if (m_interactionFlags == INTERACT_TRANSFORM_ENTITIES)
 	{
@@ -5895,6 +5920,8 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 		ccGLUtils::DisplayTexture2DPosition(glFilter->getTexture(), 0, 0, CONTEXT.glW, CONTEXT.glH);
 
 		bindFBO(nullptr);
+
+		stageDone(m_lastRenderTimings.glFilter_ms);
 	}
 
 	bindFBO(fbo);
@@ -5927,14 +5954,27 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 
 	glFunc->glFlush();
 
-	//read from fbo
+	stageDone(m_lastRenderTimings.overlay_ms);
+
+	//read from fbo (all at once, as a single synchronization is much faster than one per line)
 	glFunc->glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
-	//to avoid memory issues, we read line by line
-	for (int i = 0; i < glHeight(); ++i)
+	glFunc->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glFunc->glReadPixels(0, 0, glWidth(), glHeight(), GL_BGRA, GL_UNSIGNED_BYTE, data);
+	glFunc->glReadBuffer(GL_NONE);
+
+	//OpenGL rows are stored from bottom to top: we flip them in place (no need for a second image)
 	{
-		glFunc->glReadPixels(0, i, glWidth(), 1, GL_BGRA, GL_UNSIGNED_BYTE, data + (glHeight() - 1 - i) * glWidth() * 4);
+		const size_t lineSize = static_cast<size_t>(glWidth()) * 4;
+		std::vector<GLubyte> lineBuffer(lineSize);
+		for (int i = 0; i < glHeight() / 2; ++i)
+		{
+			GLubyte* topLine = data + i * lineSize;
+			GLubyte* bottomLine = data + (glHeight() - 1 - i) * lineSize;
+			memcpy(lineBuffer.data(), topLine, lineSize);
+			memcpy(topLine, bottomLine, lineSize);
+			memcpy(bottomLine, lineBuffer.data(), lineSize);
+		}
 	}
-	glFunc->glReadBuffer(GL_NONE);
 
 	//restore the default FBO
 	bindFBO(nullptr);
@@ -5943,6 +5983,8 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 
 	logGLError("ccGLWindow::renderToFile");
 
+	stageDone(m_lastRenderTimings.readBack_ms);
+
 	if (m_fbo != fbo)
 	{
 		delete fbo;
@@ -5970,6 +6012,8 @@ QImage ccGLWindowInterface::renderToImage(	float zoomFactor/*=1.0f*/,
 	invalidateVisualization();
 	redraw(true);
 
+	m_lastRenderTimings.total_ms = renderTimer.nsecsElapsed() / 1.0e6;
+
 	return outputImage;
 }
 
@@ -7143,6 +7187,11 @@ ccGLWindowInterface* ccGLWindowInterface::FromQObject(QObject* object)
 	{
 		return glStereoWindow;
 	}
+	ccGLOffscreenWindow* glOffscreenWindow = qobject_cast<ccGLOffscreenWindow*>(object);
+	if (glOffscreenWindow)
+	{
+		return glOffscreenWindow;
+	}
 
 	ccLog::Warning(QString("[ccGLWindowInterface::FromQObject] Object %1 is not a valid GL window").arg(object->objectName()));
 	return nullptr;
@@ -0,0 +1,63 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_GEOTIFF_MOSAIC_WRITER_HEADER
+#define CC_GEOTIFF_MOSAIC_WRITER_HEADER
+
+#ifdef CC_GDAL_SUPPORT
+
+//Local
+#include "qCC_io.h"
+
+//qCC_db
+#include <ccCameraSensor.h>
+
+//Qt
+#include <QString>
+
+class GDALDataset;
+
+//! Writes an ortho-rectified mosaic as a tiled GeoTIFF file (RGBA)
+/** The tiles are written directly in the file (with GDAL), so that the whole
+	mosaic is never held in memory.
+**/
+class QCC_IO_LIB_API GeoTiffMosaicWriter : public ccCameraSensor::MosaicWriter
+{
+public:
+	//! Default constructor
+	/** \param filename output filename
+	**/
+	explicit GeoTiffMosaicWriter(const QString& filename);
+
+	//! Destructor
+	~GeoTiffMosaicWriter() override;
+
+	//inherited from ccCameraSensor::MosaicWriter
+	bool open(unsigned width, unsigned height, const double minCorner[2], double pixelSize, unsigned tileSize) override;
+	bool writeTile(unsigned x, unsigned y, const QImage& tile) override;
+	bool close() override;
+
+protected:
+	//! Output filename
+	QString m_filename;
+	//! Output dataset
+	GDALDataset* m_dataset;
+};
+
+#endif //CC_GDAL_SUPPORT
+
+#endif //CC_GEOTIFF_MOSAIC_WRITER_HEADER
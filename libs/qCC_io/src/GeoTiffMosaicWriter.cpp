@@ -0,0 +1,163 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                    COPYRIGHT: CloudCompare project                     #
+//#                                                                        #
+//##########################################################################
+
+#ifdef CC_GDAL_SUPPORT
+
+#include "GeoTiffMosaicWriter.h"
+
+//qCC_db
+#include <ccLog.h>
+
+//GDAL
+#include <cpl_string.h>
+#include <gdal_priv.h>
+
+//Qt
+#include <QImage>
+
+//System
+#include <algorithm>
+#include <cassert>
+
+GeoTiffMosaicWriter::GeoTiffMosaicWriter(const QString& filename)
+	: m_filename(filename)
+	, m_dataset(nullptr)
+{
+}
+
+GeoTiffMosaicWriter::~GeoTiffMosaicWriter()
+{
+	close();
+}
+
+bool GeoTiffMosaicWriter::open(unsigned width, unsigned height, const double minCorner[2], double pixelSize, unsigned tileSize)
+{
+	if (m_dataset)
+	{
+		//already opened
+		assert(false);
+		return false;
+	}
+
+	GDALAllRegister();
+
+	const char pszFormat[] = "GTiff";
+	GDALDriver* poDriver = GetGDALDriverManager()->GetDriverByName(pszFormat);
+	if (!poDriver)
+	{
+		ccLog::Warning("[GDAL] Driver %s is not supported", pszFormat);
+		return false;
+	}
+
+	//the GeoTIFF tiles must be a multiple of 16
+	int blockSize = static_cast<int>(((std::max(tileSize, 16u) + 15) / 16) * 16);
+
+	char** papszOptions = nullptr;
+	papszOptions = CSLSetNameValue(papszOptions, "TILED", "YES");
+	papszOptions = CSLSetNameValue(papszOptions, "BLOCKXSIZE", qPrintable(QString::number(blockSize)));
+	papszOptions = CSLSetNameValue(papszOptions, "BLOCKYSIZE", qPrintable(QString::number(blockSize)));
+	papszOptions = CSLSetNameValue(papszOptions, "COMPRESS", "DEFLATE");
+	papszOptions = CSLSetNameValue(papszOptions, "PHOTOMETRIC", "RGB");
+	papszOptions = CSLSetNameValue(papszOptions, "ALPHA", "YES");
+	papszOptions = CSLSetNameValue(papszOptions, "BIGTIFF", "IF_SAFER");
+
+	m_dataset = poDriver->Create(	qUtf8Printable(m_filename),
+									static_cast<int>(width),
+									static_cast<int>(height),
+									4,
+									GDT_Byte,
+									papszOptions);
+	CSLDestroy(papszOptions);
+
+	if (!m_dataset)
+	{
+		ccLog::Warning(QString("[GDAL] Failed to create the output raster '%1'").arg(m_filename));
+		return false;
+	}
+
+	m_dataset->SetMetadataItem("AREA_OR_POINT", "AREA");
+
+	//the pixels are centered on the ortho-rectified positions
+	double adfGeoTransform[6] {	minCorner[0] - pixelSize / 2,							//top left x
+								pixelSize,												//w-e pixel resolution
+								0,														//0
+								minCorner[1] + (static_cast<double>(height) - 0.5) * pixelSize,	//top left y
+								0,														//0
+								-pixelSize												//n-s pixel resolution
+	};
+	m_dataset->SetGeoTransform(adfGeoTransform);
+
+	m_dataset->GetRasterBand(4)->SetColorInterpretation(GCI_AlphaBand);
+
+	return true;
+}
+
+bool GeoTiffMosaicWriter::writeTile(unsigned x, unsigned y, const QImage& tile)
+{
+	if (!m_dataset || tile.isNull())
+	{
+		assert(false);
+		return false;
+	}
+
+	//byte-ordered RGBA (whatever the endianness)
+	QImage rgbaTile = tile.convertToFormat(QImage::Format_RGBA8888);
+	if (rgbaTile.isNull())
+	{
+		ccLog::Warning("[GDAL] Not enough memory");
+		return false;
+	}
+
+	CPLErr err = m_dataset->RasterIO(	GF_Write,
+										static_cast<int>(x),
+										static_cast<int>(y),
+										rgbaTile.width(),
+										rgbaTile.height(),
+										rgbaTile.bits(),
+										rgbaTile.width(),
+										rgbaTile.height(),
+										GDT_Byte,
+										4,
+										nullptr,
+										4,							//pixel spacing
+										rgbaTile.bytesPerLine(),	//line spacing
+										1);							//band spacing
+
+	if (err != CE_None)
+	{
+		ccLog::Warning(QString("[GDAL] Failed to write a tile in '%1'").arg(m_filename));
+		return false;
+	}
+
+	return true;
+}
+
+bool GeoTiffMosaicWriter::close()
+{
+	if (!m_dataset)
+	{
+		return true;
+	}
+
+	//flushes the remaining tiles
+	GDALClose(m_dataset);
+	m_dataset = nullptr;
+
+	return true;
+}
+
+#endif //CC_GDAL_SUPPORT
@@ -20,6 +20,7 @@
 //Local
 #include "BinFilter.h"
 #include "BundlerImportDlg.h"
+#include "GeoTiffMosaicWriter.h"
 
 //qCC_db
 #include <ccCameraSensor.h>
@@ -706,6 +707,10 @@ CC_FILE_ERROR BundlerFilter::loadFileExtended(	const QString& filename,
 	std::vector<ORImageInfo> OR_infos;
 	double OR_pixelSize = -1.0; //auto for first image
 	double OR_globalCorners[4] = { 0, 0, 0, 0}; //corners for the global set
+#ifdef CC_GDAL_SUPPORT
+	//images and ortho-rectification parameters for the global mosaic
+	std::vector<ccCameraSensor::MosaicImage> OR_mosaicImages;
+#endif
 
 	//alternative keypoints? (for ortho-rectification only)
 	ccGenericPointCloud* altKeypoints = nullptr;
@@ -852,16 +857,24 @@ CC_FILE_ERROR BundlerFilter::loadFileExtended(	const QString& filename,
 					double corners[8];
 					ccImage* orthoImage = nullptr;
 					
+					//ortho-rectification parameters ("standard" method only)
+					ccCameraSensor::MosaicImage mosaicImage;
+
 					//"standard" ortho-rectification method
 					if (orthoRectMethod == BundlerImportDlg::OPTIMIZED)
 					{
-						orthoImage = sensor->orthoRectifyAsImage(	image,
-																	_keypointsCloud,
-																	keypointsImage,
-																	OR_pixelSize,
-																	info.minC,
-																	info.maxC,
-																	corners);
+						//the parameters are computed once (they are also used for the mosaic)
+						if (sensor->computeOrthoRectificationParams(image, _keypointsCloud, keypointsImage, mosaicImage.a, mosaicImage.b, mosaicImage.c))
+						{
+							orthoImage = sensor->orthoRectifyAsImage(	image,
+																		mosaicImage.a,
+																		mosaicImage.b,
+																		mosaicImage.c,
+																		OR_pixelSize,
+																		info.minC,
+																		info.maxC,
+																		corners);
+						}
 					}
 					//"direct" ortho-rectification method
 					else
@@ -1009,6 +1022,25 @@ CC_FILE_ERROR BundlerFilter::loadFileExtended(	const QString& filename,
 
 						OR_infos.push_back(info);
 
+#ifdef CC_GDAL_SUPPORT
+						if (orthoRectMethod == BundlerImportDlg::OPTIMIZED)
+						{
+							//the images kept in memory are used directly (unless they are undistorted afterwards),
+							//otherwise they are loaded again (only when needed) during the mosaic computation
+							if (keepImagesInMemory && !undistortImages)
+							{
+								mosaicImage.image = image;
+							}
+							else
+							{
+								mosaicImage.filename = imageDir.absoluteFilePath(imageFilenames[i]);
+							}
+							mosaicImage.width = image->getW();
+							mosaicImage.height = image->getH();
+							OR_mosaicImages.push_back(mosaicImage);
+						}
+#endif
+
 						//update global boundaries
 						if (OR_globalCorners[0] > info.minC[0])
 							OR_globalCorners[0] = info.minC[0];
@@ -1150,6 +1182,33 @@ CC_FILE_ERROR BundlerFilter::loadFileExtended(	const QString& filename,
 		}
 	}
 
+#ifdef CC_GDAL_SUPPORT
+	//global mosaic (tiled GeoTIFF)
+	if (!OR_mosaicImages.empty() && !cancelledByUser)
+	{
+		QScopedPointer<ccProgressDialog> mDlg(nullptr);
+		if (parameters.parentWidget)
+		{
+			mDlg.reset(new ccProgressDialog(true, parameters.parentWidget)); //cancel available
+		}
+
+		QString mosaicFilename = imageDir.absoluteFilePath("ortho_mosaic.tif");
+		GeoTiffMosaicWriter mosaicWriter(mosaicFilename);
+		if (ccCameraSensor::OrthoRectifyAsMosaic(	OR_mosaicImages,
+													OR_pixelSize,
+													mosaicWriter,
+													512,
+													mDlg.data()))
+		{
+			ccLog::Print(QString("[Bundler] Ortho-rectified mosaic saved to '%1'").arg(mosaicFilename));
+		}
+		else
+		{
+			ccLog::Warning("[Bundler] Failed to generate the ortho-rectified mosaic");
+		}
+	}
+#endif
+
 	if (generateColoredDTM)
 	{
 		assert(mntSamples && !mntColors.empty());
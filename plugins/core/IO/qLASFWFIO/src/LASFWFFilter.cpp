@@ -256,6 +256,13 @@ CC_FILE_ERROR LASFWFFilter::saveToFile(ccHObject* entity, const QString& filenam
 			//we save it in a separate file
 			QFileInfo fi(filename);
 			QString fwFilename = fi.absolutePath() + "/" + fi.completeBaseName() + ".wdp";
+
+			//the FWF data may be memory-mapped from the files we are about to overwrite
+			if (!ccFWFDataContainer::DetachAllFromFile(filename) || !ccFWFDataContainer::DetachAllFromFile(fwFilename))
+			{
+				return CC_FERR_NOT_ENOUGH_MEMORY;
+			}
+
 			QFile fwfFile(fwFilename);
 			if (fwfFile.open(QFile::WriteOnly))
 			{
@@ -1104,23 +1111,21 @@ CC_FILE_ERROR LASFWFFilter::loadFile(const QString& filename, ccHObject& contain
 			//load the FWF data
 			if (fwfDataSource.isOpen() && fwfDataCount != 0)
 			{
+				//the FWF data is memory-mapped (it will only be read when accessed)
+				QString fwfFilename = fwfDataSource.fileName();
+				qint64 fwfDataStart = fwfDataSource.pos();
+				fwfDataSource.close();
+
 				ccPointCloud::FWFDataContainer* container = new ccPointCloud::FWFDataContainer;
-				try
-				{
-					container->resize(fwfDataCount);
-				}
-				catch (const std::bad_alloc&)
+				if (!container->fromFile(fwfFilename, fwfDataStart, fwfDataCount))
 				{
-					ccLog::Warning(QString("Not enough memory to import the waveform data"));
+					ccLog::Warning(QString("Failed to load the waveform data"));
 					cloud->waveforms().clear();
 					delete container;
 					hasFWF = false;
 					break;
 				}
 
-				fwfDataSource.read((char*)container->data(), fwfDataCount);
-				fwfDataSource.close();
-
 				cloud->fwfData() = ccPointCloud::SharedFWFDataContainer(container);
 			}
 		}
@@ -630,6 +630,14 @@ CC_FILE_ERROR LasIOFilter::saveToFile(ccHObject* entity, const QString& filename
 	}
 	auto* pointCloud = static_cast<ccPointCloud*>(entity);
 
+	// the waveform data may be memory-mapped from the files we are about to overwrite
+	QFileInfo outputInfo(filename);
+	if (!ccFWFDataContainer::DetachAllFromFile(filename)
+	    || !ccFWFDataContainer::DetachAllFromFile(QString("%1/%2.wdp").arg(outputInfo.path(), outputInfo.baseName())))
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
 	LasSaveDialog saveDialog(pointCloud, parameters.parentWidget);
 
 	CCVector3d bbMax, bbMin;
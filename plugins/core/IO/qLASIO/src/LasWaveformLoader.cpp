@@ -155,22 +155,33 @@ LasWaveformLoader::LasWaveformLoader(const laszip_header_struct& laszipHeader,
 
 	if (fwfDataSource.isOpen() && fwfDataCount != 0)
 	{
+		// the waveform data is memory-mapped (it will only be read when accessed)
+		QString fwfFilename = fwfDataSource.fileName();
+		qint64  fwfDataStart = fwfDataSource.pos();
+		fwfDataSource.close();
+
 		ccPointCloud::FWFDataContainer* container{nullptr};
 		try
 		{
 			container = new ccPointCloud::FWFDataContainer;
-			container->resize(fwfDataCount);
 			pointCloud.waveforms().resize(pointCloud.capacity());
 		}
 		catch (const std::bad_alloc&)
 		{
 			ccLog::Warning(QString("[LAS] Not enough memory to import the waveform data"));
 			delete container;
+			fwfDataCount = 0;
 			return;
 		}
 
-		fwfDataSource.read((char*)container->data(), fwfDataCount);
-		fwfDataSource.close();
+		if (!container->fromFile(fwfFilename, fwfDataStart, fwfDataCount))
+		{
+			ccLog::Warning(QString("[LAS] Failed to load the waveform data"));
+			delete container;
+			pointCloud.waveforms().clear();
+			fwfDataCount = 0;
+			return;
+		}
 
 		pointCloud.fwfData() = ccPointCloud::SharedFWFDataContainer(container);
 	}
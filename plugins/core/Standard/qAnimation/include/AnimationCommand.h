@@ -0,0 +1,36 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#             COPYRIGHT: Ryan Wicks, 2G Robotics Inc., 2015              #
+//#                                                                        #
+//##########################################################################
+
+#include "ccCommandLineInterface.h"
+
+//! Animation rendering command (-ANIMATION)
+/** The viewports are loaded from a file (e.g. a BIN file saved with the
+	same entities as the ones currently loaded). The loaded clouds and meshes
+	are rendered in a hidden 3D view, and the frames are saved or encoded
+	asynchronously (see AnimationFrameWriter).
+**/
+class AnimationCommand : public ccCommandLineInterface::Command
+{
+public:
+	AnimationCommand();
+
+	~AnimationCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#             COPYRIGHT: Ryan Wicks, 2G Robotics Inc., 2015              #
+//#                                                                        #
+//##########################################################################
+
+//Qt
+#include <QDir>
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+//System
+#include <algorithm>
+
+class QVideoEncoder;
+
+//! Asynchronous animation frames writer
+/** The frames are pushed (in order) by the rendering thread in a bounded queue.
+	They are then downscaled (super resolution), saved or encoded by worker threads,
+	so that the rendering is not stalled by the image compression and the disk I/O.
+	When encoding a video, a single worker is used so as to keep the frames order.
+**/
+class AnimationFrameWriter
+{
+public:
+
+	//! Default constructor
+	/** \param queueSize max number of pending frames (the rendering thread waits when the queue is full)
+		\param maxThreadCount max number of worker threads (0 = all cores but one)
+	**/
+	AnimationFrameWriter(int queueSize = 8, int maxThreadCount = 0);
+
+	//! Destructor (waits for the pending frames)
+	~AnimationFrameWriter();
+
+	//! Sets the downscale factor (super resolution)
+	void setDownscaleFactor(int factor) { m_downscaleFactor = std::max(factor, 1); }
+
+	//! Starts writing the frames as separate image files (frame_XXXXXX.png)
+	bool startFrames(const QString& outputDir, const QString& format = "png");
+
+	//! Starts encoding the frames in a video stream (the encoder should be already opened)
+	bool startVideo(QVideoEncoder* encoder);
+
+	//! Pushes a new frame
+	/** Waits if the queue is full.
+		\return false if an error occurred while saving/encoding a previous frame
+	**/
+	bool push(const QImage& image, int frameIndex);
+
+	//! Waits for all the pending frames to be written
+	/** \return success
+	**/
+	bool finish();
+
+	//! Cancels the pending frames
+	void cancel();
+
+	//! Returns the last error message (if any)
+	QString errorMessage() const;
+
+	//! Returns the number of frames written so far
+	int writtenFrameCount() const;
+
+protected:
+
+	//! Frame
+	struct Frame
+	{
+		QImage image;
+		int index = 0;
+	};
+
+	//! Starts the workers
+	void startWorkers(int workerCount);
+
+	//! Worker loop
+	void work();
+
+	//! Writes a single frame
+	bool write(Frame& frame, QString& error);
+
+	//! Pending frames
+	QQueue<Frame> m_queue;
+	//! Max number of pending frames
+	int m_queueSize;
+	//! Max number of worker threads
+	int m_maxThreadCount;
+	//! Dedicated thread pool (so as to not interfere with the global one)
+	QThreadPool m_threadPool;
+
+	//! Mutex (protects the queue and the state)
+	mutable QMutex m_mutex;
+	//! Signaled when a frame is pushed (or when writing is finished)
+	QWaitCondition m_frameAvailable;
+	//! Signaled when a frame is popped
+	QWaitCondition m_slotAvailable;
+
+	//! Whether all the frames have been pushed
+	bool m_noMoreFrames;
+	//! Whether the workers are running
+	bool m_started;
+	//! Last error message (if any)
+	QString m_errorMessage;
+	//! Number of frames written so far
+	int m_writtenFrameCount;
+
+	//! Downscale factor (super resolution)
+	int m_downscaleFactor;
+	//! Output directory (separate frames)
+	QDir m_outputDir;
+	//! Output image format (separate frames)
+	QString m_format;
+	//! Video encoder (if any)
+	QVideoEncoder* m_encoder;
+};
@@ -85,7 +85,7 @@ protected: //methods
 
 	int countFrames(size_t startIndex = 0);
 
-	void applyViewport(const ExtendedViewportParameters& viewportParameters);
+	void applyViewport(const ExtendedViewportParameters& viewportParameters, bool redraw = true);
 
 	double computeTotalTime();
 
@@ -0,0 +1,425 @@
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#             COPYRIGHT: Ryan Wicks, 2G Robotics Inc., 2015              #
+//#                                                                        #
+//##########################################################################
+
+#include "AnimationCommand.h"
+
+//Local
+#include "AnimationFrameWriter.h"
+#include "ExtendedViewport.h"
+#include "ViewInterpolate.h"
+
+//qCC_db
+#include <cc2DViewportObject.h>
+
+//qCC_io
+#include <FileIOFilter.h>
+
+//qCC_gl
+#include <ccGLOffscreenWindow.h>
+
+//Qt
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QScopedPointer>
+
+#ifdef QFFMPEG_SUPPORT
+//QTFFmpeg
+#include <QVideoEncoder.h>
+#endif
+
+constexpr char COMMAND_ANIMATION[] = "ANIMATION";
+constexpr char COMMAND_ANIMATION_VIEWPORTS[] = "VIEWPORTS";
+constexpr char COMMAND_ANIMATION_FPS[] = "FPS";
+constexpr char COMMAND_ANIMATION_STEP_DURATION[] = "STEP_DURATION";
+constexpr char COMMAND_ANIMATION_SIZE[] = "SIZE";
+constexpr char COMMAND_ANIMATION_SUPER_RES[] = "SUPER_RES";
+constexpr char COMMAND_ANIMATION_LOOP[] = "LOOP";
+constexpr char COMMAND_ANIMATION_OUTPUT_DIR[] = "OUTPUT_DIR";
+constexpr char COMMAND_ANIMATION_VIDEO[] = "VIDEO";
+constexpr char COMMAND_ANIMATION_BITRATE[] = "BITRATE";
+constexpr char COMMAND_ANIMATION_QUEUE_SIZE[] = "QUEUE_SIZE";
+constexpr char COMMAND_ANIMATION_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
+
+//same keys as qAnimationDlg
+static const QString s_stepDurationKey("StepDurationSec");
+static const QString s_stepEnabledKey("StepEnabled");
+
+AnimationCommand::AnimationCommand()
+	: Command("Animation", COMMAND_ANIMATION)
+{
+}
+
+//! Reads a positive integer value after a sub-option
+static bool ReadPositiveInt(ccCommandLineInterface& cmd, const char* option, int& value)
+{
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: value after \"-%1\"").arg(option));
+	}
+	bool conversionOk = false;
+	value = cmd.arguments().takeFirst().toInt(&conversionOk);
+	if (!conversionOk || value <= 0)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(option));
+	}
+	return true;
+}
+
+bool AnimationCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[ANIMATION]");
+
+	if (cmd.clouds().empty() && cmd.meshes().empty())
+	{
+		return cmd.error(QObject::tr("No entity loaded"));
+	}
+
+	QString viewportsFilename;
+	int fps = 30;
+	double stepDuration_sec = 2.0;
+	int width = 1920;
+	int height = 1080;
+	int superRes = 1;
+	bool loop = false;
+	QString outputDir;
+	QString videoFilename;
+	int bitrate_kbps = 10000;
+	int queueSize = 8;
+	int maxThreadCount = 0;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_VIEWPORTS))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: filename after \"-%1\"").arg(COMMAND_ANIMATION_VIEWPORTS));
+			}
+			viewportsFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_FPS))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_FPS, fps))
+				return false;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_STEP_DURATION))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: step duration after \"-%1\"").arg(COMMAND_ANIMATION_STEP_DURATION));
+			}
+			bool conversionOk = false;
+			stepDuration_sec = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || stepDuration_sec <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_ANIMATION_STEP_DURATION));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_SIZE))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().size() < 2)
+			{
+				return cmd.error(QObject::tr("Missing parameter(s): width and height expected after \"-%1\"").arg(COMMAND_ANIMATION_SIZE));
+			}
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_SIZE, width) || !ReadPositiveInt(cmd, COMMAND_ANIMATION_SIZE, height))
+				return false;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_SUPER_RES))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_SUPER_RES, superRes))
+				return false;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_LOOP))
+		{
+			cmd.arguments().pop_front();
+			loop = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_OUTPUT_DIR))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: directory after \"-%1\"").arg(COMMAND_ANIMATION_OUTPUT_DIR));
+			}
+			outputDir = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_VIDEO))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: filename after \"-%1\"").arg(COMMAND_ANIMATION_VIDEO));
+			}
+			videoFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_BITRATE))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_BITRATE, bitrate_kbps))
+				return false;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_QUEUE_SIZE))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_QUEUE_SIZE, queueSize))
+				return false;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_ANIMATION_MAX_THREAD_COUNT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after \"-%1\"").arg(COMMAND_ANIMATION_MAX_THREAD_COUNT));
+			}
+			bool conversionOk = false;
+			maxThreadCount = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_ANIMATION_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (viewportsFilename.isEmpty())
+	{
+		return cmd.error(QObject::tr("Missing viewports file (\"-%1\")").arg(COMMAND_ANIMATION_VIEWPORTS));
+	}
+
+	//load the viewports
+	QScopedPointer<ccHObject> viewportsContainer;
+	std::vector<ExtendedViewportParameters> steps;
+	std::vector<double> stepDurations;
+	{
+		//same parameters as the loaded entities (i.e. same global shift)
+		FileIOFilter::LoadParameters parameters = cmd.fileLoadingParams();
+		CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+		viewportsContainer.reset(FileIOFilter::LoadFromFile(viewportsFilename, parameters, result));
+		if (!viewportsContainer)
+		{
+			return cmd.error(QObject::tr("Failed to load the viewports file '%1'").arg(viewportsFilename));
+		}
+
+		ccHObject::Container viewports;
+		viewportsContainer->filterChildren(viewports, true, CC_TYPES::VIEWPORT_2D_OBJECT, true);
+		for (ccHObject* object : viewports)
+		{
+			cc2DViewportObject* vp = static_cast<cc2DViewportObject*>(object);
+			if (vp->hasMetaData(s_stepEnabledKey) && !vp->getMetaData(s_stepEnabledKey).toBool())
+			{
+				//step disabled in the plugin dialog
+				continue;
+			}
+			double duration_sec = stepDuration_sec;
+			if (vp->hasMetaData(s_stepDurationKey))
+			{
+				duration_sec = vp->getMetaData(s_stepDurationKey).toDouble();
+				if (!(duration_sec > 0)) //also catches NaN
+				{
+					//zero-length steps are skipped (the view jumps to the next viewport)
+					cmd.warning(QObject::tr("Viewport '%1' has a non-positive step duration (%2): step skipped").arg(vp->getName()).arg(duration_sec));
+					duration_sec = 0.0;
+				}
+			}
+			steps.push_back(ExtendedViewport(vp).toExtendedViewportParameters());
+			stepDurations.push_back(duration_sec);
+		}
+	}
+	if (steps.size() < 2)
+	{
+		return cmd.error(QObject::tr("At least 2 viewports are required (%1 found)").arg(steps.size()));
+	}
+	cmd.print(QObject::tr("Viewports: %1").arg(steps.size()));
+
+	size_t segmentCount = (loop ? steps.size() : steps.size() - 1);
+	double totalTime = 0;
+	for (size_t i = 0; i < segmentCount; ++i)
+	{
+		totalTime += stepDurations[i];
+	}
+	int frameCount = static_cast<int>(fps * totalTime);
+	if (frameCount <= 0)
+	{
+		return cmd.error(QObject::tr("Total animation duration is null"));
+	}
+
+#ifdef QFFMPEG_SUPPORT
+	if (!videoFilename.isEmpty())
+	{
+		//the encoder requires that the video dimensions are multiples of 8
+		if (width % 8)
+			width = (width / 8 + 1) * 8;
+		if (height % 8)
+			height = (height / 8 + 1) * 8;
+	}
+#else
+	if (!videoFilename.isEmpty())
+	{
+		return cmd.error(QObject::tr("Video mode is not supported (no FFMPEG support)"));
+	}
+#endif
+
+	//create an offscreen 3D view (no window/widget required)
+	QScopedPointer<ccGLOffscreenWindow> glWindow(ccGLOffscreenWindow::Create(width, height, true));
+	if (!glWindow)
+	{
+		return cmd.error(QObject::tr("Failed to create the offscreen 3D view"));
+	}
+
+	//the scene (the entities still belong to the command line)
+	ccHObject scene("Animation scene");
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		scene.addChild(desc.pc, ccHObject::DP_NONE);
+	}
+	for (CLMeshDesc& desc : cmd.meshes())
+	{
+		scene.addChild(desc.mesh, ccHObject::DP_NONE);
+	}
+	glWindow->setSceneDB(&scene);
+	//entities are only drawn by their associated display
+	scene.setDisplay_recursive(glWindow.data());
+	glWindow->setLODEnabled(false);
+
+	//the frames are saved/encoded by other threads while the next ones are rendered
+	AnimationFrameWriter frameWriter(queueSize, maxThreadCount);
+	frameWriter.setDownscaleFactor(superRes);
+
+#ifdef QFFMPEG_SUPPORT
+	QScopedPointer<QVideoEncoder> encoder;
+#endif
+	bool success = false;
+	if (videoFilename.isEmpty())
+	{
+		if (outputDir.isEmpty())
+		{
+			outputDir = QFileInfo(viewportsFilename).absolutePath();
+		}
+		success = frameWriter.startFrames(outputDir);
+	}
+#ifdef QFFMPEG_SUPPORT
+	else
+	{
+		encoder.reset(new QVideoEncoder(videoFilename, width, height, bitrate_kbps * 1024, fps, static_cast<unsigned>(fps)));
+		QStringList errors;
+		if (encoder->open(QString(), errors))
+		{
+			success = frameWriter.startVideo(encoder.data());
+		}
+		else
+		{
+			for (const QString& e : errors)
+			{
+				cmd.warning(e);
+			}
+			cmd.warning(QObject::tr("Failed to open file for output: %1").arg(videoFilename));
+		}
+	}
+#endif
+
+	QElapsedTimer eTimer;
+	eTimer.start();
+
+	double timeStep = 1.0 / fps;
+	double currentStepStartTime = 0.0;
+	size_t vp1Index = 0;
+	for (int frameIndex = 0; success && frameIndex < frameCount; )
+	{
+		double currentTime = frameIndex * timeStep;
+		double deltaTime = currentTime - currentStepStartTime;
+		if (deltaTime > stepDurations[vp1Index] || stepDurations[vp1Index] <= 0.0)
+		{
+			//we'll try the next step
+			currentStepStartTime += stepDurations[vp1Index];
+			if (++vp1Index == segmentCount)
+			{
+				break;
+			}
+			continue;
+		}
+
+		size_t vp2Index = (vp1Index + 1 == steps.size() ? 0 : vp1Index + 1);
+		ViewInterpolate interpolator(steps[vp1Index], steps[vp2Index]);
+		ExtendedViewportParameters currentViewport;
+		interpolator.interpolate(currentViewport, deltaTime / stepDurations[vp1Index]);
+
+		glWindow->setViewportParameters(currentViewport.params);
+		if (glWindow->customLightEnabled() != currentViewport.customLightEnabled)
+		{
+			glWindow->setCustomLight(currentViewport.customLightEnabled);
+		}
+		glWindow->setCustomLightPosition(currentViewport.customLightPos);
+
+		QImage image = glWindow->renderToImage(superRes, false, false, true);
+		if (image.isNull())
+		{
+			cmd.warning(QObject::tr("Failed to render frame #%1").arg(frameIndex + 1));
+			success = false;
+			break;
+		}
+
+		if (!frameWriter.push(image, frameIndex))
+		{
+			success = false;
+			break;
+		}
+
+		++frameIndex;
+	}
+
+	if (success)
+	{
+		success = frameWriter.finish();
+	}
+	else
+	{
+		frameWriter.cancel();
+	}
+	QString writerError = frameWriter.errorMessage();
+
+#ifdef QFFMPEG_SUPPORT
+	if (encoder)
+	{
+		encoder->close();
+	}
+#endif
+
+	//release the scene (the window won't unlink the entities once its DB root is null)
+	scene.setDisplay_recursive(nullptr);
+	glWindow->setSceneDB(nullptr);
+	scene.detachAllChildren();
+
+	if (!success)
+	{
+		return cmd.error(writerError.isEmpty() ? QObject::tr("Failed to render the animation") : writerError);
+	}
+
+	double elapsed_sec = eTimer.elapsed() / 1000.0;
+	int frames = frameWriter.writtenFrameCount();
+	cmd.print(QObject::tr("%1 frames rendered in %2 s (%3 fps)").arg(frames).arg(elapsed_sec, 0, 'f', 1).arg(elapsed_sec > 0 ? frames / elapsed_sec : 0.0, 0, 'f', 1));
+
+	return true;
+}
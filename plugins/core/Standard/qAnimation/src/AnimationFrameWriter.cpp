@@ -0,0 +1,249 @@
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#             COPYRIGHT: Ryan Wicks, 2G Robotics Inc., 2015              #
+//#                                                                        #
+//##########################################################################
+
+#include "AnimationFrameWriter.h"
+
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
+//Qt
+#include <QtConcurrentRun>
+
+#ifdef QFFMPEG_SUPPORT
+//QTFFmpeg
+#include <QVideoEncoder.h>
+#endif
+
+AnimationFrameWriter::AnimationFrameWriter(int queueSize/*=8*/, int maxThreadCount/*=0*/)
+	: m_queueSize(std::max(queueSize, 1))
+	, m_maxThreadCount(maxThreadCount)
+	, m_noMoreFrames(false)
+	, m_started(false)
+	, m_writtenFrameCount(0)
+	, m_downscaleFactor(1)
+	, m_encoder(nullptr)
+{
+	if (m_maxThreadCount <= 0)
+	{
+		//the rendering thread is busy too
+		m_maxThreadCount = std::max(ccQtHelpers::GetMaxThreadCount() - 1, 1);
+	}
+}
+
+AnimationFrameWriter::~AnimationFrameWriter()
+{
+	finish();
+}
+
+bool AnimationFrameWriter::startFrames(const QString& outputDir, const QString& format/*="png"*/)
+{
+	if (m_started)
+	{
+		assert(false);
+		return false;
+	}
+
+	m_outputDir = QDir(outputDir);
+	if (!m_outputDir.exists())
+	{
+		m_errorMessage = QString("Output directory '%1' doesn't exist").arg(outputDir);
+		return false;
+	}
+	m_format = format;
+	m_encoder = nullptr;
+
+	//the frames can be saved in any order
+	startWorkers(m_maxThreadCount);
+
+	return true;
+}
+
+bool AnimationFrameWriter::startVideo(QVideoEncoder* encoder)
+{
+	if (m_started)
+	{
+		assert(false);
+		return false;
+	}
+
+#ifdef QFFMPEG_SUPPORT
+	if (!encoder || !encoder->isOpen())
+	{
+		m_errorMessage = "Video encoder is not ready";
+		return false;
+	}
+	m_encoder = encoder;
+
+	//the frames must be encoded in order
+	startWorkers(1);
+
+	return true;
+#else
+	Q_UNUSED(encoder);
+	m_errorMessage = "No FFMPEG support";
+	return false;
+#endif
+}
+
+void AnimationFrameWriter::startWorkers(int workerCount)
+{
+	m_noMoreFrames = false;
+	m_started = true;
+	m_threadPool.setMaxThreadCount(workerCount);
+	for (int i = 0; i < workerCount; ++i)
+	{
+		QtConcurrent::run(&m_threadPool, [this]() { work(); });
+	}
+}
+
+bool AnimationFrameWriter::push(const QImage& image, int frameIndex)
+{
+	QMutexLocker locker(&m_mutex);
+	if (!m_started || m_noMoreFrames)
+	{
+		assert(false);
+		return false;
+	}
+
+	while (m_queue.size() >= m_queueSize && m_errorMessage.isEmpty())
+	{
+		m_slotAvailable.wait(&m_mutex);
+	}
+	if (!m_errorMessage.isEmpty())
+	{
+		return false;
+	}
+
+	Frame frame;
+	frame.image = image;
+	frame.index = frameIndex;
+	m_queue.enqueue(frame);
+	m_frameAvailable.wakeOne();
+
+	return true;
+}
+
+bool AnimationFrameWriter::finish()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		if (!m_started)
+		{
+			return m_errorMessage.isEmpty();
+		}
+		m_noMoreFrames = true;
+		m_frameAvailable.wakeAll();
+	}
+
+	m_threadPool.waitForDone();
+
+	QMutexLocker locker(&m_mutex);
+	m_started = false;
+	return m_errorMessage.isEmpty();
+}
+
+void AnimationFrameWriter::cancel()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_queue.clear();
+		m_slotAvailable.wakeAll();
+	}
+
+	finish();
+}
+
+QString AnimationFrameWriter::errorMessage() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_errorMessage;
+}
+
+int AnimationFrameWriter::writtenFrameCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_writtenFrameCount;
+}
+
+void AnimationFrameWriter::work()
+{
+	while (true)
+	{
+		Frame frame;
+		{
+			QMutexLocker locker(&m_mutex);
+			while (m_queue.empty() && !m_noMoreFrames && m_errorMessage.isEmpty())
+			{
+				m_frameAvailable.wait(&m_mutex);
+			}
+			if (m_queue.empty() || !m_errorMessage.isEmpty())
+			{
+				break;
+			}
+			frame = m_queue.dequeue();
+			m_slotAvailable.wakeOne();
+		}
+
+		QString error;
+		bool success = write(frame, error);
+
+		QMutexLocker locker(&m_mutex);
+		if (success)
+		{
+			++m_writtenFrameCount;
+		}
+		else
+		{
+			m_errorMessage = error;
+			//unlock the rendering thread and the other workers
+			m_queue.clear();
+			m_slotAvailable.wakeAll();
+			m_frameAvailable.wakeAll();
+			break;
+		}
+	}
+}
+
+bool AnimationFrameWriter::write(Frame& frame, QString& error)
+{
+	if (m_downscaleFactor > 1)
+	{
+		frame.image = frame.image.scaled(frame.image.width() / m_downscaleFactor, frame.image.height() / m_downscaleFactor, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	}
+
+#ifdef QFFMPEG_SUPPORT
+	if (m_encoder)
+	{
+		QString errorString;
+		if (!m_encoder->encodeImage(frame.image, frame.index, &errorString))
+		{
+			error = QString("Failed to encode frame #%1: %2").arg(frame.index + 1).arg(errorString);
+			return false;
+		}
+		return true;
+	}
+#endif
+
+	QString filename = QString("frame_%1.%2").arg(frame.index, 6, 10, QChar('0')).arg(m_format);
+	if (!frame.image.save(m_outputDir.filePath(filename)))
+	{
+		error = QString("Failed to save frame #%1").arg(frame.index + 1);
+		return false;
+	}
+
+	return true;
+}
@@ -18,6 +18,7 @@
 #include "qAnimationDlg.h"
 
 //Local
+#include "AnimationFrameWriter.h"
 #include "ViewInterpolate.h"
 
 //qCC_db
@@ -770,14 +771,20 @@ int qAnimationDlg::getCurrentStepIndex()
 	return stepSelectionList->currentRow();
 }
 
-void qAnimationDlg::applyViewport( const ExtendedViewportParameters& viewportParameters )
+void qAnimationDlg::applyViewport( const ExtendedViewportParameters& viewportParameters, bool redraw/*=true*/ )
 {
 	if (m_view3d)
 	{
 		m_view3d->setViewportParameters(viewportParameters.params);
-		m_view3d->setCustomLight(viewportParameters.customLightEnabled);
+		if (m_view3d->customLightEnabled() != viewportParameters.customLightEnabled)
+		{
+			m_view3d->setCustomLight(viewportParameters.customLightEnabled);
+		}
 		m_view3d->setCustomLightPosition(viewportParameters.customLightPos);
-		m_view3d->redraw();
+		if (redraw)
+		{
+			m_view3d->redraw();
+		}
 	}
 }
 
@@ -1352,17 +1359,42 @@ void qAnimationDlg::render(bool asSeparateFrames)
 	}
 #endif
 
+	//the frames are saved/encoded by other threads while the next ones are rendered
+	AnimationFrameWriter frameWriter;
+	if (renderingMode == SUPER_RESOLUTION)
+	{
+		frameWriter.setDownscaleFactor(superRes);
+	}
+	bool writerStarted = false;
+#ifdef QFFMPEG_SUPPORT
+	if (encoder)
+	{
+		writerStarted = frameWriter.startVideo(encoder.data());
+	}
+	else
+#endif
+	{
+		writerStarted = frameWriter.startFrames(QFileInfo(outputFilename).absolutePath());
+	}
+	if (!writerStarted)
+	{
+		QMessageBox::critical(this, "Error", frameWriter.errorMessage());
+	}
+
 	bool lodWasEnabled = m_view3d->isLODEnabled();
 	m_view3d->setLODEnabled(false);
 
-	QDir outputDir(QFileInfo(outputFilename).absolutePath());
+	QElapsedTimer renderTimer;
+	renderTimer.start();
+	QElapsedTimer eventsTimer;
+	eventsTimer.start();
 
-	bool success = true;
+	bool success = writerStarted;
 	double currentTime = 0.0;
 	double currentStepStartTime = 0.0;
 	double timeStep = 1.0 / fps;
 	size_t vp1Index = 0;
-	for (int frameIndex = 0; frameIndex < frameCount; )
+	for (int frameIndex = 0; success && frameIndex < frameCount; )
 	{
 		size_t vp2Index = vp1Index + 1;
 		if (vp2Index == trajectory->size())
@@ -1381,7 +1413,8 @@ void qAnimationDlg::render(bool asSeparateFrames)
 			ExtendedViewportParameters currentViewport;
 			interpolator.interpolate(currentViewport, deltaTime / step1.duration_sec);
 
-			applyViewport(currentViewport);
+			//no need to refresh the screen (the frame is rendered offscreen)
+			applyViewport(currentViewport, false);
 
 			//render to image
 			QImage image = m_view3d->renderToImage(superRes, renderingMode == ZOOM, false, true);
@@ -1393,46 +1426,29 @@ void qAnimationDlg::render(bool asSeparateFrames)
 				break;
 			}
 
-			if (renderingMode == SUPER_RESOLUTION && superRes > 1)
+			if (!frameWriter.push(image, frameIndex))
 			{
-				image = image.scaled(image.width() / superRes, image.height() / superRes, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-			}
-
-			if (asSeparateFrames)
-			{
-				QString filename = QString("frame_%1.png").arg(frameIndex, 6, 10, QChar('0'));
-				QString fullPath = outputDir.filePath(filename);
-				if (!image.save(fullPath))
-				{
-					QMessageBox::critical(this, "Error", QString("Failed to save frame #%1").arg(frameIndex + 1));
-					success = false;
-					break;
-				}
-			}
-			else
-			{
-#ifdef QFFMPEG_SUPPORT
-				QString errorString;
-				if (!encoder->encodeImage(image, frameIndex, &errorString))
-				{
-					QMessageBox::critical(this, "Error", QString("Failed to encode frame #%1: %2").arg(frameIndex + 1).arg(errorString));
-					success = false;
-					break;
-				}
-#endif
+				QMessageBox::critical(this, "Error", frameWriter.errorMessage());
+				success = false;
+				break;
 			}
 			
 			//next frame
 			currentTime += timeStep;
 			++frameIndex;
 
-			progressDialog.setValue(frameIndex);
-			QApplication::processEvents();
-			if (progressDialog.wasCanceled())
+			//don't process the events for each frame (this would also redraw the screen)
+			if (eventsTimer.elapsed() > 100 || frameIndex == frameCount)
 			{
-				QMessageBox::warning(this, "Warning", QString("Process has been cancelled"));
-				success = false;
-				break;
+				progressDialog.setValue(frameIndex);
+				QApplication::processEvents();
+				eventsTimer.restart();
+				if (progressDialog.wasCanceled())
+				{
+					QMessageBox::warning(this, "Warning", QString("Process has been cancelled"));
+					success = false;
+					break;
+				}
 			}
 		}
 		else
@@ -1448,6 +1464,27 @@ void qAnimationDlg::render(bool asSeparateFrames)
 		}
 	}
 
+	if (success)
+	{
+		//wait for the last frames
+		if (!frameWriter.finish())
+		{
+			QMessageBox::critical(this, "Error", frameWriter.errorMessage());
+			success = false;
+		}
+	}
+	else
+	{
+		frameWriter.cancel();
+	}
+
+	if (success)
+	{
+		double elapsed_sec = renderTimer.elapsed() / 1000.0;
+		int frames = frameWriter.writtenFrameCount();
+		ccLog::Print(QString("[qAnimation] %1 frames rendered in %2 s (%3 fps)").arg(frames).arg(elapsed_sec, 0, 'f', 1).arg(elapsed_sec > 0 ? frames / elapsed_sec : 0.0, 0, 'f', 1));
+	}
+
 	m_view3d->setLODEnabled(lodWasEnabled);
 
 #ifdef QFFMPEG_SUPPORT
@@ -0,0 +1,105 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qBroom                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#      COPYRIGHT: Wesley Grimes (Collision Engineering Associates)       #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_BROOM_ENGINE_HEADER
+#define CC_BROOM_ENGINE_HEADER
+
+//qCC_db
+#include <ccOctree.h>
+
+//system
+#include <vector>
+
+//! Extracts the points lying inside the broom (or inside the cleaning areas)
+/** The non empty octree cells around the broom are gathered in a candidate set
+	that covers the queried boxes plus a margin (i.e. the area that the next moves
+	of the broom will most probably sweep). As long as the queried boxes stay in
+	this area, the candidate cells are reused.
+
+	For each query, the candidate cells are classified against the boxes: the points
+	of the cells lying completely inside a box are taken without any test, and only
+	the points of the cells crossing a box border are tested. The cells are processed
+	in parallel, and the points are tested by batches (their coordinates are copied
+	in small contiguous arrays so that the tests can be vectorized by the compiler).
+
+	\warning An engine instance should only be used by one thread at a time.
+**/
+class BroomEngine
+{
+public:
+
+	//! Oriented box
+	struct Box
+	{
+		//! Box center
+		CCVector3 center;
+		//! Box axes (unit vectors)
+		CCVector3 axes[3];
+		//! Box dimensions (along each axis)
+		CCVector3 dimensions;
+	};
+
+	//! Default constructor
+	BroomEngine();
+
+	//! Sets the octree of the cloud to clean (or releases the current one if null)
+	void setOctree(ccOctree::Shared octree);
+
+	//! Extracts the points lying inside at least one of the boxes
+	/** \param boxes query boxes
+		\param level octree level of the candidate cells
+		\param pointIndexes output point indexes (in no particular order)
+		\param maxThreadCount max number of threads (0 = all)
+		\return false if not enough memory
+	**/
+	bool extractPoints(	const std::vector<Box>& boxes,
+						unsigned char level,
+						std::vector<unsigned>& pointIndexes,
+						int maxThreadCount = 0);
+
+protected: //methods
+
+	//! Makes sure the candidate cells cover a given region (cell positions, inclusive)
+	bool updateCandidateCells(const Tuple3i& minPos, const Tuple3i& maxPos, unsigned char level, int margin);
+
+protected: //members
+
+	//! Candidate cell
+	struct Cell
+	{
+		//! Index of the first point of the cell (in the octree codes)
+		unsigned firstCodeIndex;
+		//! Number of points in the cell
+		unsigned pointCount;
+		//! Cell center
+		CCVector3 center;
+	};
+
+	//! Associated octree
+	ccOctree::Shared m_octree;
+
+	//! Candidate cells
+	std::vector<Cell> m_cells;
+	//! Octree level of the candidate cells
+	unsigned char m_cellsLevel;
+	//! Region covered by the candidate cells (min cell position)
+	Tuple3i m_cellsMinPos;
+	//! Region covered by the candidate cells (max cell position)
+	Tuple3i m_cellsMaxPos;
+};
+
+#endif
@@ -20,12 +20,19 @@
 
 #include "ui_broomDlg.h"
 
+//Local
+#include "BroomEngine.h"
+
 //CCCoreLib
 #include <CCGeom.h>
 
 //qCC_db
 #include <ccGLMatrix.h>
 
+//Qt
+#include <QFutureWatcher>
+#include <QThreadPool>
+
 //system
 #include <vector>
 #include <stdint.h>
@@ -105,6 +112,13 @@ protected:
 
 protected: //methods
 
+	//! Selection modes
+	enum SelectionModes {	INSIDE = 0,
+							ABOVE = 1,
+							BELOW = 2,
+							ABOVE_AND_BELOW = 3
+	};
+
 	struct BroomDimensions
 	{
 		PointCoordinateType length, width, thick, height;
@@ -128,6 +142,32 @@ protected: //methods
 	//! Select the points inside or above/below the broom
 	bool selectPoints(const ccGLMatrix& broomTrans, BroomDimensions* _broom = nullptr);
 
+	//! Requests the selection of the points inside or above/below the broom (in the background)
+	/** If a selection is already running, the broom position is queued and will be processed
+		right after it. The selected points are displayed as soon as each job finishes.
+	**/
+	void requestSelection(const ccGLMatrix& broomTrans);
+
+	//! Starts a background selection job with the queued broom positions (if any)
+	void startSelectionJob();
+
+	//! Slot called when a background selection job is finished
+	void onSelectionJobFinished();
+
+	//! Waits for the background selection job (if any) and processes the queued broom positions
+	void flushSelection();
+
+	//! Returns the selection boxes for a given broom position
+	void getSelectionBoxes(const ccGLMatrix& broomTrans, const BroomDimensions& broom, SelectionModes mode, std::vector<BroomEngine::Box>& boxes) const;
+
+	//! Extracts the points inside or above/below the broom
+	/** \warning May be called from a background thread (uses m_selectionEngine)
+	**/
+	bool computeSelection(const ccGLMatrix& broomTrans, const BroomDimensions& broom, SelectionModes mode, std::vector<unsigned>& pointIndexes);
+
+	//! Selects a set of points (and adds the corresponding undo step)
+	void applySelection(const ccGLMatrix& broomTrans, const std::vector<unsigned>& pointIndexes);
+
 	//! Automate the process
 	bool startAutomation();
 
@@ -276,13 +316,6 @@ protected: //members
 	//! Whether the initial click occurred on the broom or not
 	bool m_broomSelected;
 
-	//! Selection modes
-	enum SelectionModes {	INSIDE = 0,
-							ABOVE = 1,
-							BELOW = 2,
-							ABOVE_AND_BELOW = 3
-	};
-
 	//! Current selection mode
 	SelectionModes m_selectionMode;
 
@@ -292,6 +325,35 @@ protected: //members
 	//! Positions of the broom (for undo)
 	std::vector<ccGLMatrix> m_undoPositions;
 
+	//! Background selection job
+	struct SelectionJob
+	{
+		//! Broom dimensions
+		BroomDimensions broom;
+		//! Selection mode
+		SelectionModes mode;
+		//! Broom positions
+		std::vector<ccGLMatrix> positions;
+		//! Selected points (for each position)
+		std::vector< std::vector<unsigned> > pointIndexes;
+		//! Whether the job is running
+		bool running = false;
+	};
+
+	//! Current background selection job
+	SelectionJob m_selectionJob;
+	//! Broom positions waiting for the next background selection job
+	std::vector<ccGLMatrix> m_queuedPositions;
+	//! Background selection job watcher
+	QFutureWatcher<void> m_selectionWatcher;
+	//! Thread pool for the background selection jobs (one job at a time)
+	QThreadPool m_selectionThreadPool;
+
+	//! Engine for extracting the points to select
+	BroomEngine m_selectionEngine;
+	//! Engine for extracting the points below the broom (to stick to the 'floor')
+	mutable BroomEngine m_floorEngine;
+
 	//! Associated application
 	ccMainAppInterface* m_app;
 
@@ -0,0 +1,456 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qBroom                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#      COPYRIGHT: Wesley Grimes (Collision Engineering Associates)       #
+//#                                                                        #
+//##########################################################################
+
+#include "BroomEngine.h"
+
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
+//Qt
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//system
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+//number of points tested at once
+static const unsigned c_batchSize = 256;
+//approximate number of points per parallel task
+static const unsigned c_pointsPerTask = 16384;
+
+BroomEngine::BroomEngine()
+	: m_cellsLevel(0)
+	, m_cellsMinPos(0, 0, 0)
+	, m_cellsMaxPos(-1, -1, -1)
+{
+}
+
+void BroomEngine::setOctree(ccOctree::Shared octree)
+{
+	m_octree = octree;
+
+	//the candidate cells are not valid anymore
+	m_cells.clear();
+	m_cells.shrink_to_fit();
+	m_cellsLevel = 0;
+	m_cellsMinPos = Tuple3i(0, 0, 0);
+	m_cellsMaxPos = Tuple3i(-1, -1, -1);
+}
+
+bool BroomEngine::updateCandidateCells(const Tuple3i& minPos, const Tuple3i& maxPos, unsigned char level, int margin)
+{
+	assert(m_octree);
+
+	//are the current candidate cells still valid?
+	if (	level == m_cellsLevel
+		&&	minPos.x >= m_cellsMinPos.x && minPos.y >= m_cellsMinPos.y && minPos.z >= m_cellsMinPos.z
+		&&	maxPos.x <= m_cellsMaxPos.x && maxPos.y <= m_cellsMaxPos.y && maxPos.z <= m_cellsMaxPos.z )
+	{
+		return true;
+	}
+
+	//otherwise we take the cells of the (enlarged) region
+	const int maxCellPos = (1 << level) - 1;
+	Tuple3i regionMinPos;
+	Tuple3i regionMaxPos;
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		regionMinPos.u[d] = std::max(minPos.u[d] - margin, 0);
+		regionMaxPos.u[d] = std::min(maxPos.u[d] + margin, maxCellPos);
+	}
+
+	m_cells.clear();
+	m_cellsMaxPos = Tuple3i(-1, -1, -1); //in case of failure
+
+	const CCCoreLib::DgmOctree::cellsContainer& cellCodes = m_octree->pointsAndTheirCellCodes();
+	const unsigned char bitDec = CCCoreLib::DgmOctree::GET_BIT_SHIFT(level);
+	auto codeLessThan = [bitDec](const CCCoreLib::DgmOctree::IndexAndCode& a, CCCoreLib::DgmOctree::CellCode truncatedCode)
+	{
+		return (a.theCode >> bitDec) < truncatedCode;
+	};
+
+	try
+	{
+		Tuple3i cellPos;
+		for (cellPos.x = regionMinPos.x; cellPos.x <= regionMaxPos.x; ++cellPos.x)
+		{
+			for (cellPos.y = regionMinPos.y; cellPos.y <= regionMaxPos.y; ++cellPos.y)
+			{
+				for (cellPos.z = regionMinPos.z; cellPos.z <= regionMaxPos.z; ++cellPos.z)
+				{
+					CCCoreLib::DgmOctree::CellCode truncatedCode = CCCoreLib::DgmOctree::GenerateTruncatedCellCode(cellPos, level);
+
+					//the codes are sorted: binary search of the first point of the cell
+					CCCoreLib::DgmOctree::cellsContainer::const_iterator it = std::lower_bound(cellCodes.begin(), cellCodes.end(), truncatedCode, codeLessThan);
+					if (it == cellCodes.end() || (it->theCode >> bitDec) != truncatedCode)
+					{
+						//empty cell
+						continue;
+					}
+
+					Cell cell;
+					cell.firstCodeIndex = static_cast<unsigned>(it - cellCodes.begin());
+					cell.pointCount = 0;
+					for (; it != cellCodes.end() && (it->theCode >> bitDec) == truncatedCode; ++it)
+					{
+						++cell.pointCount;
+					}
+					m_octree->computeCellCenter(cellPos, level, cell.center);
+
+					m_cells.push_back(cell);
+				}
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		m_cells.clear();
+		return false;
+	}
+
+	m_cellsLevel = level;
+	m_cellsMinPos = regionMinPos;
+	m_cellsMaxPos = regionMaxPos;
+
+	return true;
+}
+
+bool BroomEngine::extractPoints(const std::vector<Box>& boxes,
+								unsigned char level,
+								std::vector<unsigned>& pointIndexes,
+								int maxThreadCount/*=0*/)
+{
+	pointIndexes.clear();
+
+	if (!m_octree || boxes.empty())
+	{
+		assert(false);
+		return false;
+	}
+
+	const PointCoordinateType cellSize = m_octree->getCellSize(level);
+	const PointCoordinateType halfCellSize = cellSize / 2;
+
+	//bounding box of the query boxes (in cell positions)
+	Tuple3i minPos;
+	Tuple3i maxPos;
+	PointCoordinateType maxBoxDim = 0;
+	{
+		const CCVector3& octreeMins = m_octree->getOctreeMins();
+		const int maxCellPos = (1 << level) - 1;
+
+		for (size_t b = 0; b < boxes.size(); ++b)
+		{
+			const Box& box = boxes[b];
+			for (unsigned char d = 0; d < 3; ++d)
+			{
+				PointCoordinateType halfExtent = 0;
+				for (unsigned char k = 0; k < 3; ++k)
+				{
+					halfExtent += std::abs(box.axes[k].u[d]) * box.dimensions.u[k] / 2;
+				}
+
+				int minCellPos = static_cast<int>(std::floor((box.center.u[d] - halfExtent - octreeMins.u[d]) / cellSize));
+				int maxCellPosForBox = static_cast<int>(std::floor((box.center.u[d] + halfExtent - octreeMins.u[d]) / cellSize));
+				minCellPos = std::max(0, std::min(minCellPos, maxCellPos));
+				maxCellPosForBox = std::max(0, std::min(maxCellPosForBox, maxCellPos));
+
+				if (b == 0 || minCellPos < minPos.u[d])
+					minPos.u[d] = minCellPos;
+				if (b == 0 || maxCellPosForBox > maxPos.u[d])
+					maxPos.u[d] = maxCellPosForBox;
+
+				maxBoxDim = std::max(maxBoxDim, box.dimensions.u[d]);
+			}
+		}
+	}
+
+	//the candidate cells cover the boxes plus a margin (~ the size of the boxes)
+	int margin = static_cast<int>(std::ceil(maxBoxDim / cellSize));
+	if (!updateCandidateCells(minPos, maxPos, level, margin))
+	{
+		return false;
+	}
+
+	//classify the candidate cells
+	std::vector<unsigned> innerCells;
+	std::vector<unsigned> borderCells;
+	try
+	{
+		for (unsigned i = 0; i < static_cast<unsigned>(m_cells.size()); ++i)
+		{
+			const Cell& cell = m_cells[i];
+
+			bool isInside = false;
+			bool crossesBorder = false;
+			for (const Box& box : boxes)
+			{
+				CCVector3 d = cell.center - box.center;
+				bool outside = false;
+				bool inside = true;
+				for (unsigned char k = 0; k < 3; ++k)
+				{
+					const CCVector3& axis = box.axes[k];
+					//projected distance between the centers
+					PointCoordinateType dk = std::abs(d.dot(axis));
+					//projected half size of the cell
+					PointCoordinateType rk = halfCellSize * (std::abs(axis.x) + std::abs(axis.y) + std::abs(axis.z));
+					PointCoordinateType halfDim = box.dimensions.u[k] / 2;
+					if (dk > halfDim + rk)
+					{
+						outside = true;
+						break;
+					}
+					if (dk + rk > halfDim)
+					{
+						inside = false;
+					}
+				}
+
+				if (outside)
+				{
+					continue;
+				}
+				if (inside)
+				{
+					isInside = true;
+					break;
+				}
+				crossesBorder = true;
+			}
+
+			if (isInside)
+			{
+				innerCells.push_back(i);
+			}
+			else if (crossesBorder)
+			{
+				borderCells.push_back(i);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	const CCCoreLib::DgmOctree::cellsContainer& cellCodes = m_octree->pointsAndTheirCellCodes();
+	CCCoreLib::GenericIndexedCloudPersist* cloud = m_octree->associatedCloud();
+
+	//the points of the inner cells are all selected
+	try
+	{
+		size_t innerPointCount = 0;
+		for (unsigned i : innerCells)
+		{
+			innerPointCount += m_cells[i].pointCount;
+		}
+		pointIndexes.reserve(innerPointCount);
+
+		for (unsigned i : innerCells)
+		{
+			const Cell& cell = m_cells[i];
+			for (unsigned j = 0; j < cell.pointCount; ++j)
+			{
+				pointIndexes.push_back(cellCodes[cell.firstCodeIndex + j].theIndex);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		pointIndexes.clear();
+		return false;
+	}
+
+	if (borderCells.empty())
+	{
+		return true;
+	}
+
+	//the border cells are grouped in tasks of roughly the same size
+	std::vector<unsigned> taskStarts;
+	try
+	{
+		unsigned taskPointCount = 0;
+		for (unsigned t = 0; t < static_cast<unsigned>(borderCells.size()); ++t)
+		{
+			if (t == 0 || taskPointCount >= c_pointsPerTask)
+			{
+				taskStarts.push_back(t);
+				taskPointCount = 0;
+			}
+			taskPointCount += m_cells[borderCells[t]].pointCount;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		pointIndexes.clear();
+		return false;
+	}
+
+	std::vector<unsigned> tasks;
+	std::vector< std::vector<unsigned> > taskIndexes;
+	try
+	{
+		tasks.resize(taskStarts.size());
+		taskIndexes.resize(taskStarts.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		pointIndexes.clear();
+		return false;
+	}
+	for (unsigned t = 0; t < static_cast<unsigned>(tasks.size()); ++t)
+	{
+		tasks[t] = t;
+	}
+
+	std::atomic<bool> processFailed(false);
+
+	auto processTask = [&](unsigned t)
+	{
+		if (processFailed)
+		{
+			return;
+		}
+
+		unsigned start = taskStarts[t];
+		unsigned stop = (t + 1 < taskStarts.size() ? taskStarts[t + 1] : static_cast<unsigned>(borderCells.size()));
+
+		//coordinates of the current batch of points
+		PointCoordinateType x[c_batchSize];
+		PointCoordinateType y[c_batchSize];
+		PointCoordinateType z[c_batchSize];
+		unsigned char inside[c_batchSize];
+
+		std::vector<unsigned>& indexes = taskIndexes[t];
+		try
+		{
+			for (unsigned c = start; c < stop; ++c)
+			{
+				const Cell& cell = m_cells[borderCells[c]];
+
+				for (unsigned batchStart = 0; batchStart < cell.pointCount; batchStart += c_batchSize)
+				{
+					unsigned batchSize = std::min(c_batchSize, cell.pointCount - batchStart);
+					unsigned firstCodeIndex = cell.firstCodeIndex + batchStart;
+
+					//gather the coordinates
+					for (unsigned k = 0; k < batchSize; ++k)
+					{
+						const CCVector3* P = cloud->getPoint(cellCodes[firstCodeIndex + k].theIndex);
+						x[k] = P->x;
+						y[k] = P->y;
+						z[k] = P->z;
+						inside[k] = 0;
+					}
+
+					//test them against each box (branchless, so that the loop can be vectorized)
+					for (const Box& box : boxes)
+					{
+						const CCVector3& C = box.center;
+						const CCVector3& U = box.axes[0];
+						const CCVector3& V = box.axes[1];
+						const CCVector3& W = box.axes[2];
+						const CCVector3 halfDim = box.dimensions / 2;
+
+						for (unsigned k = 0; k < batchSize; ++k)
+						{
+							PointCoordinateType dx = x[k] - C.x;
+							PointCoordinateType dy = y[k] - C.y;
+							PointCoordinateType dz = z[k] - C.z;
+							PointCoordinateType u = dx * U.x + dy * U.y + dz * U.z;
+							PointCoordinateType v = dx * V.x + dy * V.y + dz * V.z;
+							PointCoordinateType w = dx * W.x + dy * W.y + dz * W.z;
+							inside[k] |= static_cast<unsigned char>((std::abs(u) <= halfDim.x) & (std::abs(v) <= halfDim.y) & (std::abs(w) <= halfDim.z));
+						}
+					}
+
+					for (unsigned k = 0; k < batchSize; ++k)
+					{
+						if (inside[k])
+						{
+							indexes.push_back(cellCodes[firstCodeIndex + k].theIndex);
+						}
+					}
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			processFailed = true;
+		}
+	};
+
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+	}
+
+#ifndef _DEBUG
+	if (maxThreadCount > 1 && tasks.size() > 1)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+		QtConcurrent::blockingMap(tasks, processTask);
+	}
+	else
+#endif
+	{
+		for (unsigned t : tasks)
+		{
+			processTask(t);
+		}
+	}
+
+	if (processFailed)
+	{
+		pointIndexes.clear();
+		return false;
+	}
+
+	//merge the results of each task
+	try
+	{
+		size_t totalCount = pointIndexes.size();
+		for (const std::vector<unsigned>& indexes : taskIndexes)
+		{
+			totalCount += indexes.size();
+		}
+		pointIndexes.reserve(totalCount);
+
+		for (const std::vector<unsigned>& indexes : taskIndexes)
+		{
+			pointIndexes.insert(pointIndexes.end(), indexes.begin(), indexes.end());
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		pointIndexes.clear();
+		return false;
+	}
+
+	return true;
+}
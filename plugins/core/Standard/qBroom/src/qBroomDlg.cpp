@@ -37,6 +37,7 @@
 
 //CCCoreLib
 #include <DgmOctreeReferenceCloud.h>
+#include <ReferenceCloud.h>
 #include <Neighbourhood.h>
 
 //Qt
@@ -44,6 +45,7 @@
 #include <QMainWindow>
 #include <QSettings>
 #include <QCloseEvent>
+#include <QtConcurrentRun>
 
 //intersection between a plane (the broom plane) and a line (represented by two points)
 static bool Intersection(const ccGLMatrix& broomTrans, const CCVector3& A, const CCVector3& B, CCVector3& I)
@@ -97,6 +99,10 @@ qBroomDlg::qBroomDlg(ccMainAppInterface* app/*=nullptr*/)
 
 	lostTrackFrame->setVisible(false);
 
+	//the background selection jobs are processed one at a time
+	m_selectionThreadPool.setMaxThreadCount(1);
+	connect(&m_selectionWatcher, &QFutureWatcher<void>::finished, this, &qBroomDlg::onSelectionJobFinished);
+
 	//load persistent settings
 	int selectionMode = selectionModeComboBox->currentIndex();
 	{
@@ -181,6 +187,9 @@ qBroomDlg::qBroomDlg(ccMainAppInterface* app/*=nullptr*/)
 
 qBroomDlg::~qBroomDlg()
 {
+	//the background selection job (if any) uses the cloud and its octree
+	m_selectionWatcher.waitForFinished();
+
 	if (m_glWindow)
 	{
 		m_glWindow->getOwnDB()->removeAllChildren();
@@ -387,7 +396,15 @@ bool qBroomDlg::setCloud(ccPointCloud* cloud, bool ownCloud/*=false*/, bool auto
 		//nothing to do
 		return true;
 	}
-	
+
+	//wait for the background selection job (if any) and discard the queued positions
+	m_selectionWatcher.waitForFinished();
+	m_selectionJob.running = false;
+	m_queuedPositions.clear();
+
+	m_selectionEngine.setOctree(ccOctree::Shared(nullptr));
+	m_floorEngine.setOctree(ccOctree::Shared(nullptr));
+
 	if (m_cloud.ref)
 	{
 		m_glWindow->removeFromOwnDB(m_cloud.ref);
@@ -447,6 +464,8 @@ bool qBroomDlg::setCloud(ccPointCloud* cloud, bool ownCloud/*=false*/, bool auto
 				m_app->addToDB(cloud->getOctreeProxy());
 			}
 		}
+		m_selectionEngine.setOctree(cloud->getOctree());
+		m_floorEngine.setOctree(cloud->getOctree());
 
 		//we need colors
 		if (!cloud->hasColors())
@@ -524,6 +543,9 @@ bool qBroomDlg::setCloud(ccPointCloud* cloud, bool ownCloud/*=false*/, bool auto
 
 void qBroomDlg::onSelectionModeChanged(int mode)
 {
+	//the queued broom positions should be processed with the former mode
+	flushSelection();
+
 	SelectionModes formerMode = m_selectionMode;
 	m_selectionMode = static_cast<SelectionModes>(selectionModeComboBox->currentIndex());
 	m_selectionBox->setEnabled(m_selectionMode != INSIDE);
@@ -702,6 +724,9 @@ bool qBroomDlg::startAutomation()
 		return false;
 	}
 
+	//the automation is synchronous
+	flushSelection();
+
 	CCVector3 P0 = m_autoArea.clickedPoints[0];
 	CCVector3 P1 = m_autoArea.clickedPoints[1];
 	CCVector3 P2 = m_autoArea.clickedPoints[2];
@@ -1454,7 +1479,7 @@ void qBroomDlg::onMouseMoved(int x, int y, Qt::MouseButtons button)
 		if (!lostTrack)
 		{
 			m_boxes->setGLTransformation(broomTrans);
-			selectPoints(broomTrans);
+			requestSelection(broomTrans);
 			if (hasAlreadyLostTrack)
 			{
 				lostTrackFrame->setVisible(false);
@@ -1516,24 +1541,21 @@ bool qBroomDlg::moveBroom(ccGLMatrix& broomTrans, CCVector3d& broomDelta, bool s
 	if (stickToTheFloor)
 	{
 		//extract the points inside the broom
-		CCCoreLib::DgmOctree::BoxNeighbourhood bn;
+		BroomEngine::Box box;
+		box.dimensions = CCVector3(broom.length, broom.width, broom.thick);
+		box.center = broomTrans.getTranslationAsVec3D();
+		box.axes[0] = broomTrans.getColumnAsVec3D(0);
+		box.axes[1] = broomTrans.getColumnAsVec3D(1);
+		box.axes[2] = broomTrans.getColumnAsVec3D(2);
+		unsigned char level = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(std::max(broom.length/5, std::max(broom.width, broom.thick)));
+
+		std::vector<unsigned> pointIndexes;
+		if (!m_floorEngine.extractPoints(std::vector<BroomEngine::Box>{ box }, level, pointIndexes))
 		{
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.thick);
-
-			bn.center = broomTrans.getTranslationAsVec3D();
-			bn.axes = new CCVector3[3];
-			{
-				bn.axes[0] = broomTrans.getColumnAsVec3D(0);
-				bn.axes[1] = broomTrans.getColumnAsVec3D(1);
-				bn.axes[2] = broomTrans.getColumnAsVec3D(2);
-			}
-			bn.level = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(std::max(broom.length/5, std::max(broom.width, broom.thick)));
+			ccLog::Warning("Not enough memory to extract the points inside the broom. Lost track.");
+			return false;
 		}
-
-		size_t count = octree->getPointsInBoxNeighbourhood(bn);
-
-		delete[] bn.axes;
-		bn.axes = nullptr;
+		size_t count = pointIndexes.size();
 
 		//try to fit the box to the extracted points
 		if (count < 10)
@@ -1543,7 +1565,17 @@ bool qBroomDlg::moveBroom(ccGLMatrix& broomTrans, CCVector3d& broomDelta, bool s
 		}
 		else
 		{
-			CCCoreLib::DgmOctreeReferenceCloud neighboursCloud(&bn.neighbours);
+			CCCoreLib::ReferenceCloud neighboursCloud(m_cloud.ref);
+			if (!neighboursCloud.reserve(static_cast<unsigned>(count)))
+			{
+				ccLog::Warning("Not enough memory to extract the points inside the broom. Lost track.");
+				return false;
+			}
+			for (unsigned index : pointIndexes)
+			{
+				neighboursCloud.addPointIndex(index);
+			}
+
 			CCCoreLib::Neighbourhood n(&neighboursCloud);
 			const CCVector3* N = n.getLSPlaneNormal();
 			if (N)
@@ -1556,7 +1588,7 @@ bool qBroomDlg::moveBroom(ccGLMatrix& broomTrans, CCVector3d& broomDelta, bool s
 				Y.normalize();
 				X = Y.cross(Z);
 
-				CCVector3 O = bn.center; //the original center
+				CCVector3 O = box.center; //the original center
 				O.z = n.getGravityCenter()->z;
 
 				broomTrans = ccGLMatrix(X, Y, Z, O);
@@ -1574,17 +1606,6 @@ bool qBroomDlg::moveBroom(ccGLMatrix& broomTrans, CCVector3d& broomDelta, bool s
 
 bool qBroomDlg::selectPoints(const ccGLMatrix& broomTrans, BroomDimensions* _broom/*=nullptr*/)
 {
-	//we will need the octree (intensively ;)
-	ccOctree::Shared octree = m_cloud.ref ? m_cloud.ref->getOctree() : ccOctree::Shared(nullptr);
-	if (!octree)
-	{
-		assert(false);
-		return false;
-	}
-
-	CCVector3 broomCenter = broomTrans.getTranslationAsVec3D();
-	CCVector3 broomNormal = broomTrans.getColumnAsVec3D(2);
-
 	//broom dimensions
 	BroomDimensions broom;
 	if (_broom)
@@ -1596,81 +1617,206 @@ bool qBroomDlg::selectPoints(const ccGLMatrix& broomTrans, BroomDimensions* _bro
 		getBroomDimensions(broom);
 	}
 
-	//extract the points inside the selection area
-	CCCoreLib::DgmOctree::BoxNeighbourhood bn;
+	std::vector<unsigned> pointIndexes;
+	if (!computeSelection(broomTrans, broom, m_selectionMode, pointIndexes))
 	{
-		CCVector3 centerShift(0, 0, 0);
+		return false;
+	}
 
-		switch (m_selectionMode)
-		{
-		case INSIDE:
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.thick);
-			break;
+	applySelection(broomTrans, pointIndexes);
 
-		case ABOVE:
-		case ABOVE_AND_BELOW: //we start by ABOVE and we'll treat BELOW later
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.height);
-			centerShift = ((broom.thick + broom.height) / 2) * broomNormal;
-			break;
+	return true;
+}
 
-		case BELOW:
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.height);
-			centerShift = (-(broom.thick + broom.height) / 2) * broomNormal;
-			break;
+void qBroomDlg::getSelectionBoxes(const ccGLMatrix& broomTrans, const BroomDimensions& broom, SelectionModes mode, std::vector<BroomEngine::Box>& boxes) const
+{
+	CCVector3 broomCenter = broomTrans.getTranslationAsVec3D();
+	CCVector3 broomNormal = broomTrans.getColumnAsVec3D(2);
 
-		default:
-			assert(false);
-			break;
-		}
+	BroomEngine::Box box;
+	box.axes[0] = broomTrans.getColumnAsVec3D(0);
+	box.axes[1] = broomTrans.getColumnAsVec3D(1);
+	box.axes[2] = broomNormal;
 
-		bn.center = broomCenter + centerShift;
-		bn.axes = new CCVector3[3];
-		{
-			bn.axes[0] = broomTrans.getColumnAsVec3D(0);
-			bn.axes[1] = broomTrans.getColumnAsVec3D(1);
-			bn.axes[2] = broomNormal;
-		}
+	boxes.clear();
+	switch (mode)
+	{
+	case INSIDE:
+		box.dimensions = CCVector3(broom.length, broom.width, broom.thick);
+		box.center = broomCenter;
+		boxes.push_back(box);
+		break;
+
+	case ABOVE:
+		box.dimensions = CCVector3(broom.length, broom.width, broom.height);
+		box.center = broomCenter + ((broom.thick + broom.height) / 2) * broomNormal;
+		boxes.push_back(box);
+		break;
+
+	case BELOW:
+		box.dimensions = CCVector3(broom.length, broom.width, broom.height);
+		box.center = broomCenter - ((broom.thick + broom.height) / 2) * broomNormal;
+		boxes.push_back(box);
+		break;
+
+	case ABOVE_AND_BELOW:
+		box.dimensions = CCVector3(broom.length, broom.width, broom.height);
+		box.center = broomCenter + ((broom.thick + broom.height) / 2) * broomNormal;
+		boxes.push_back(box);
+		box.center = broomCenter - ((broom.thick + broom.height) / 2) * broomNormal;
+		boxes.push_back(box);
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+}
+
+bool qBroomDlg::computeSelection(const ccGLMatrix& broomTrans, const BroomDimensions& broom, SelectionModes mode, std::vector<unsigned>& pointIndexes)
+{
+	pointIndexes.clear();
+
+	//we will need the octree (intensively ;)
+	ccOctree::Shared octree = m_cloud.ref ? m_cloud.ref->getOctree() : ccOctree::Shared(nullptr);
+	if (!octree)
+	{
+		assert(false);
+		return false;
+	}
 
-		PointCoordinateType radius = std::max(bn.dimensions.x, std::max(bn.dimensions.y, bn.dimensions.z)) / 5; //emprirical ;)
-		bn.level = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(radius);
+	std::vector<BroomEngine::Box> boxes;
+	try
+	{
+		getSelectionBoxes(broomTrans, broom, mode, boxes);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
 	}
+	if (boxes.empty())
+	{
+		return false;
+	}
+
+	const CCVector3& dimensions = boxes.front().dimensions;
+	PointCoordinateType radius = std::max(dimensions.x, std::max(dimensions.y, dimensions.z)) / 5; //emprirical ;)
+	unsigned char level = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(radius);
 
-	if (m_selectionMode == ABOVE_AND_BELOW)
+	return m_selectionEngine.extractPoints(boxes, level, pointIndexes);
+}
+
+void qBroomDlg::applySelection(const ccGLMatrix& broomTrans, const std::vector<unsigned>& pointIndexes)
+{
+	if (pointIndexes.empty() || !m_cloud.ref)
 	{
-		//extract the first half
-		octree->getPointsInBoxNeighbourhood(bn);
-		//and prepare the next one
-		bn.center = broomCenter - ((broom.thick + broom.height) / 2) * broomNormal;
+		return;
 	}
 
-	size_t count = octree->getPointsInBoxNeighbourhood(bn);
+	//new selection
+	addUndoStep(broomTrans);
+	for (unsigned index : pointIndexes)
+	{
+		selectPoint(index);
+	}
 
-	delete[] bn.axes;
-	bn.axes = nullptr;
+	m_cloud.ref->showSF(false); //just in case!
+}
 
-	if (count)
+void qBroomDlg::requestSelection(const ccGLMatrix& broomTrans)
+{
+	try
 	{
-		//new selection
-		addUndoStep(broomTrans);
-		size_t selectedCount = 0;
-		for (size_t i=0; i<count; ++i)
+		m_queuedPositions.push_back(broomTrans);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return;
+	}
+
+	startSelectionJob();
+}
+
+void qBroomDlg::startSelectionJob()
+{
+	if (m_selectionJob.running || m_queuedPositions.empty())
+	{
+		//nothing to do (for now)
+		return;
+	}
+
+	getBroomDimensions(m_selectionJob.broom);
+	m_selectionJob.mode = m_selectionMode;
+	m_selectionJob.positions.swap(m_queuedPositions);
+	m_queuedPositions.clear();
+	m_selectionJob.pointIndexes.clear();
+	m_selectionJob.running = true;
+
+	m_selectionWatcher.setFuture(QtConcurrent::run(&m_selectionThreadPool, [this]()
+	{
+		SelectionJob& job = m_selectionJob;
+		try
+		{
+			job.pointIndexes.resize(job.positions.size());
+		}
+		catch (const std::bad_alloc&)
 		{
-			if (selectPoint(bn.neighbours[i].pointIndex))
+			//not enough memory
+			job.pointIndexes.clear();
+			return;
+		}
+
+		for (size_t i = 0; i < job.positions.size(); ++i)
+		{
+			if (!computeSelection(job.positions[i], job.broom, job.mode, job.pointIndexes[i]))
 			{
-				++selectedCount;
+				//not enough memory
+				job.pointIndexes.resize(i);
+				return;
 			}
 		}
+	}));
+}
 
-		//if (selectedCount == 0)
-		//{
-		//	//no point were selected! auto undo
-		//	undo(1);
-		//}
+void qBroomDlg::onSelectionJobFinished()
+{
+	if (!m_selectionJob.running)
+	{
+		//already processed (see flushSelection)
+		return;
+	}
+	m_selectionJob.running = false;
 
-		m_cloud.ref->showSF(false); //just in case!
+	if (m_selectionJob.pointIndexes.size() != m_selectionJob.positions.size())
+	{
+		ccLog::Warning("[qBroom] Not enough memory to select all the points");
 	}
 
-	return true;
+	for (size_t i = 0; i < m_selectionJob.pointIndexes.size(); ++i)
+	{
+		applySelection(m_selectionJob.positions[i], m_selectionJob.pointIndexes[i]);
+	}
+	m_selectionJob.positions.clear();
+	m_selectionJob.pointIndexes.clear();
+
+	if (m_glWindow)
+	{
+		m_glWindow->redraw();
+	}
+
+	//process the positions queued in the meantime (if any)
+	startSelectionJob();
+}
+
+void qBroomDlg::flushSelection()
+{
+	while (m_selectionJob.running)
+	{
+		m_selectionWatcher.waitForFinished();
+		onSelectionJobFinished(); //will start a new job if some positions have been queued
+	}
 }
 
 void qBroomDlg::onButtonReleased()
@@ -1835,6 +1981,8 @@ uint32_t qBroomDlg::addUndoStep(const ccGLMatrix& broomPos)
 
 void qBroomDlg::undo(uint32_t undoCount)
 {
+	flushSelection();
+
 	if (	!m_cloud.ref
 		||	m_selectionTable.size() != m_cloud.ref->size())
 	{
@@ -1984,6 +2132,8 @@ ccPointCloud* qBroomDlg::createSegmentedCloud(ccPointCloud* cloud, bool removeSe
 
 void qBroomDlg::apply()
 {
+	flushSelection();
+
 	//save persistent settings
 	savePersistentSettings();
 
@@ -2015,6 +2165,8 @@ void qBroomDlg::apply()
 
 void qBroomDlg::closeEvent(QCloseEvent* e)
 {
+	flushSelection();
+
 	if (!m_undoPositions.empty() || m_cloud.ownCloud)
 	{
 		if (QMessageBox::warning(this, "Cancel", "The selection/segmentation will be lost. Do you confirm?", QMessageBox::Yes, QMessageBox::No) == QMessageBox::No)
@@ -2038,6 +2190,8 @@ void qBroomDlg::savePersistentSettings()
 
 void qBroomDlg::validate()
 {
+	flushSelection();
+
 	//save persistent settings
 	savePersistentSettings();
 
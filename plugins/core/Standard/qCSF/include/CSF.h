@@ -34,6 +34,11 @@
 //system
 #include <vector>
 
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
+
 class ccMainAppInterface;
 class ccPointCloud;
 class QWidget;
@@ -54,6 +59,11 @@ public:
 		int rigidness = 3;
 		int iterations = 500;
 
+		// tiled mode
+		double tile_size = 0.0; // tile size (0 = the whole cloud is filtered at once)
+		double tile_overlap = 0.0; // overlap between neighboring tiles (0 = automatic)
+		int max_thread_count = 0; // max number of threads (0 = automatic)
+
 		// constants
 		const double clothYHeight = 0.05; // origin cloth height
 		const int clothBuffer = 2; // cloth buffer (grid margin size)
@@ -69,7 +79,20 @@ public:
 						ccMainAppInterface* app = nullptr,
 						QWidget* parent = nullptr);
 
+	//! Tiled filtering routine
+	/** The cloud is cut into overlapping tiles (in the horizontal plane) that are filtered independently
+		(in parallel). The label of each point is given by the tile it falls in (without the overlap).
+		\warning The cloth mesh can't be exported in this mode.
+	**/
+	static bool ApplyTiled(	const wl::PointCloud& csfPointCloud,
+							const Parameters& params,
+							std::vector<bool>& isGround,
+							ccMainAppInterface* app = nullptr,
+							CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
 	//! Shortcut for CloudCompare
+	/** Uses the tiled mode if params.tile_size > 0
+	**/
 	static bool Apply(	ccPointCloud* cloud,
 						const Parameters& params,
 						ccPointCloud*& groundCloud,
@@ -66,6 +66,12 @@ private:
 	std::vector<Particle> particles; // all particles that are part of this cloth
 //	std::vector<Constraint> constraints; // alle constraints between particles as part of this cloth
 
+	//particles state (structure of arrays, indexed as the particles)
+	std::vector<double> pos_y; // the current altitude of each particle
+	std::vector<double> old_pos_y; // the altitude of each particle at the previous time step (verlet integration)
+	std::vector<unsigned char> movable; // can the particle move or not ? used to pin parts of the cloth
+	double acceleration; // the current acceleration of all particles (along Y) - already multiplied by dt^2
+
 	//parameters of slope postpocessing
 	double smoothThreshold;
 	double heightThreshold;
@@ -98,6 +104,20 @@ public:
 
 	inline int getSize() const { return num_particles_width * num_particles_height; }
 
+	//particles state accessors
+	inline double getHeight(int index) const { return pos_y[index]; }
+	inline double getHeight(int x, int y) const { return pos_y[y*num_particles_width + x]; }
+	inline Vec3 getPos(int x, int y) const { return Vec3(origin_pos.x + x * step_x, getHeight(x, y), origin_pos.z + y * step_y); }
+	inline bool isMovable(int index) const { return movable[index] != 0; }
+	inline void makeUnmovable(int index) { movable[index] = 0; }
+	inline void offsetPos(int index, double dy)
+	{
+		if (movable[index])
+		{
+			pos_y[index] += dy;
+		}
+	}
+
 	inline std::vector<double>& getHeightvals() { return heightvals; }
 
 public:
@@ -119,13 +139,20 @@ public:
 	}
 
 	/** This is an important method where the time is progressed one time step for the entire cloth.
-		This includes calling satisfyConstraint() for every constraint, and calling timeStep() for all particles
+		This includes the verlet integration of all particles, and satisfying the constraints of every particle
+		\return the maximum displacement of the movable particles
 	**/
 	double timeStep();
 
 	/* used to add gravity to all particles */
 	void addForce(double f);
 
+	//number of 'colors' (along each dimension) used to satisfy the constraints in parallel
+	/** A particle constraints update modifies all the particles up to 2 cells away (5x5 stencil).
+		Particles 5 cells away from each other (i.e. with the same 'color') can be processed at the same time.
+	**/
+	static const int CONSTRAINT_COLOR_STRIDE = 5;
+
 	//detecting collision of cloth and terrain
 	void terrainCollision();
 
@@ -154,4 +181,9 @@ public:
 	//! Converts the cloth to a CC mesh structure
 	ccMesh* toMesh() const;
 
+protected:
+
+	//satisfies the constraints between a particle and all its neighbors
+	void satisfyConstraints(int x, int y, double singleMove, double doubleMove);
+
 };
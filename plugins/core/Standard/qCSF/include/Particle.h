@@ -31,19 +31,12 @@
 #include <vector>
 #include <limits>
 
-#include "Vec3.h"
-
-/* The particle class represents a particle that can move around in 3D space*/
+/* The particle class represents a node of the cloth grid.
+	The dynamic state of the particles (altitude, previous altitude and 'movable' flag) is stored
+	by the Cloth class, as arrays (so that the simulation loops can be parallelized and vectorized)
+*/
 class Particle
 {
-private:
-	bool movable; // can the particle move or not ? used to pin parts of the cloth
-	//double mass; // the mass of the particle (is always 1 in this example)
-	double acceleration; // the current acceleration of the particle (along Y) - DGM: already multiplied by dt^
-	//double time_step2; // square time step
-
-	Vec3 pos; // the current position of the particle in 3D space
-	double old_pos_y; // the altitude of the particle at the previous time step, used as part of the verlet numerical integration scheme
 public:
 	//these members are used in the process of edge smoothing after the cloth simulation step.
 	bool isVisited;
@@ -51,10 +44,8 @@ public:
 	int pos_y; // Y position in the cloth grid
 	int c_pos; // position in the group of movable points
 
-	//for constraint computation
-	std::vector<Particle*> neighborsList; //record all the neighbors in cloth grid
-
 	//for rasterization
+	std::vector<Particle*> neighborsList; //record all the neighbors in cloth grid
 	//std::vector<int> correspondingLidarPointList; // the correspoinding lidar point list (DGM: not used)
 	//std::size_t nearestPointIndex; // nearest lidar point (DGM: not used)
 	double nearestPointHeight; // the height(y) of the nearest lidar point
@@ -63,51 +54,11 @@ public:
 public:
 
 	Particle()
-		: movable(true)
-		//, mass(1.0)
-		, acceleration(0)
-		//, time_step2(0)
-		, isVisited(false)
+		: isVisited(false)
 		, pos_x(0)
 		, pos_y(0)
 		, c_pos(0)
-		, pos(0, 0, 0)
-		, old_pos_y(0)
 		, nearestPointHeight(std::numeric_limits<double>::lowest())
 		, nearestPointDist(std::numeric_limits<double>::max())
 	{}
-	
-	Particle(const Vec3& posVec/*, double squareTimeStep*/)
-		: Particle()
-	{
-		pos = posVec;
-		old_pos_y = posVec.y;
-		//time_step2 = squareTimeStep;
-	}
-
-	inline const Vec3& getPos() const { return pos; }
-	inline double getPreviousY() const { return old_pos_y; }
-
-	/* This is one of the important methods, where the time is progressed a single step size (TIME_STEPSIZE)
-	The method is called by Cloth.time_step()*/
-	void timeStep();
-
-	inline bool isMovable() const { return movable; }
-
-	inline void addForce(double f) { acceleration += f/*/ mass*/; }
-
-	inline void resetAcceleration() { acceleration = 0; }
-
-	inline void offsetPos(double dy)
-	{
-		if (movable)
-		{
-			pos.y += dy;
-		}
-	}
-
-	inline void makeUnmovable() { movable = false; }
-
-	//do constraint
-	void satisfyConstraintSelf(int constraintTimes);
 };
@@ -49,6 +49,9 @@ static const char COMMAND_CSF_MAX_ITERATION[] = "MAX_ITERATION";
 static const char COMMAND_CSF_CLASS_THRESHOLD[] = "CLASS_THRESHOLD";
 static const char COMMAND_CSF_EXPORT_GROUND[] = "EXPORT_GROUND";
 static const char COMMAND_CSF_EXPORT_OFFGROUND[] = "EXPORT_OFFGROUND";
+static const char COMMAND_CSF_TILE_SIZE[] = "TILE_SIZE";
+static const char COMMAND_CSF_TILE_OVERLAP[] = "TILE_OVERLAP";
+static const char COMMAND_CSF_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
 
 struct CommandCSF : public ccCommandLineInterface::Command
 {
@@ -72,6 +75,9 @@ struct CommandCSF : public ccCommandLineInterface::Command
 		int maxIteration = 500;
 		bool exportGround = false;
 		bool exportOffground = false;
+		double tileSize = 0.0;
+		double tileOverlap = 0.0;
+		int maxThreadCount = 0;
 
 		while (!cmd.arguments().empty())
 		{
@@ -153,6 +159,51 @@ struct CommandCSF : public ccCommandLineInterface::Command
 				cmd.print("Off-ground will be exported");
 				exportOffground = true;
 			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_TILE_SIZE))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QObject::tr("Missing parameter: tile size after \"-%1\"").arg(COMMAND_CSF_TILE_SIZE));
+				}
+				bool conv = false;
+				tileSize = cmd.arguments().takeFirst().toDouble(&conv);
+				if (!conv || tileSize < 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_TILE_SIZE));
+				}
+				cmd.print(QString("Tiled mode: tile size set to %1").arg(tileSize));
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_TILE_OVERLAP))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QObject::tr("Missing parameter: tile overlap after \"-%1\"").arg(COMMAND_CSF_TILE_OVERLAP));
+				}
+				bool conv = false;
+				tileOverlap = cmd.arguments().takeFirst().toDouble(&conv);
+				if (!conv || tileOverlap < 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_TILE_OVERLAP));
+				}
+				cmd.print(QString("Tiled mode: tile overlap set to %1").arg(tileOverlap));
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_MAX_THREAD_COUNT))
+			{
+				cmd.arguments().pop_front();
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QObject::tr("Missing parameter: max thread count after \"-%1\"").arg(COMMAND_CSF_MAX_THREAD_COUNT));
+				}
+				bool conv = false;
+				maxThreadCount = cmd.arguments().takeFirst().toInt(&conv);
+				if (!conv || maxThreadCount < 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_MAX_THREAD_COUNT));
+				}
+				cmd.print(QString("Max thread count set: %1").arg(maxThreadCount));
+			}
 			else
 			{
 				cmd.print("Set all parameters");
@@ -168,6 +219,14 @@ struct CommandCSF : public ccCommandLineInterface::Command
 			csfParams.cloth_resolution = clothResolution;
 			csfParams.rigidness = csfRigidness;
 			csfParams.iterations = maxIteration;
+			csfParams.tile_size = tileSize;
+			csfParams.tile_overlap = tileOverlap;
+			csfParams.max_thread_count = maxThreadCount;
+		}
+
+		if (tileSize > 0 && tileSize < clothResolution)
+		{
+			return cmd.error(QObject::tr("Tile size should be greater than the cloth resolution"));
 		}
 
 		std::vector<CLCloudDesc> newClouds;
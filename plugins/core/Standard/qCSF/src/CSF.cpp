@@ -41,12 +41,19 @@
 #include <ccPointCloud.h>
 #include <ccMesh.h>
 
+//CCCoreLib
+#include <GenericProgressCallback.h>
+
 //Qt
 #include <QProgressDialog>
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 //system
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iomanip>
 #include <fstream>
@@ -58,153 +65,423 @@
 #include <omp.h>
 #endif
 
-bool CSF::Apply(const wl::PointCloud& csfPointCloud,
-				const Parameters& params,
-				std::vector<bool>& isGround,
-				bool exportClothMesh,
-				ccMesh*& clothMesh,
-				ccMainAppInterface* app/*=nullptr*/,
-				QWidget* parent/*=nullptr*/)
+//! Runs the cloth simulation on a cloud (or a tile)
+/** \param csfPointCloud input cloud (CSF coordinates)
+	\param params CSF parameters
+	\param isGround output labels
+	\param exportClothMesh whether to export the cloth mesh
+	\param clothMesh output cloth mesh (if exportClothMesh is true)
+	\param app application interface (for logging timings, optional)
+	\param pDlg progress dialog (optional)
+	\param wasCancelled whether the process was cancelled by the user
+	\return success
+**/
+static bool SimulateCloth(	const wl::PointCloud& csfPointCloud,
+							const CSF::Parameters& params,
+							std::vector<bool>& isGround,
+							bool exportClothMesh,
+							ccMesh*& clothMesh,
+							ccMainAppInterface* app,
+							QProgressDialog* pDlg,
+							bool& wasCancelled)
 {
-	if (params.cloth_resolution < std::numeric_limits<double>::epsilon())
+	wasCancelled = false;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	//compute the terrain (cloud) bounding-box
+	wl::Point bbMin, bbMax;
+	csfPointCloud.computeBoundingBox(bbMin, bbMax);
+
+	//computing the number of cloth node
+	Vec3 origin_pos(	bbMin.x - params.clothBuffer * params.cloth_resolution,
+						bbMax.y + params.clothYHeight,
+						bbMin.z - params.clothBuffer * params.cloth_resolution);
+
+	int width_num = static_cast<int>((bbMax.x - bbMin.x) / params.cloth_resolution) + 2 * params.clothBuffer; //static_cast is equivalent to floor if value >= 0
+	int height_num = static_cast<int>((bbMax.z - bbMin.z) / params.cloth_resolution) + 2 * params.clothBuffer; //static_cast is equivalent to floor if value >= 0
+
+	//Cloth object
+	Cloth cloth(origin_pos, 
+				width_num,
+				height_num,
+				params.cloth_resolution,
+				params.cloth_resolution,
+				0.3,
+				9999,
+				params.rigidness/*,
+				params.time_step*/);
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Cloth creation: %1 ms").arg(timer.restart()));
+	}
+
+	if (!Rasterization::RasterTerrain(cloth, csfPointCloud, params.k_nearest_points))
 	{
-		app->dispToConsole("[CSF] Input cloth resolution is too small");
 		return false;
 	}
 
-	try
+	if (app)
 	{
-		QElapsedTimer timer;
-		timer.start();
-
-		//compute the terrain (cloud) bounding-box
-		wl::Point bbMin, bbMax;
-		csfPointCloud.computeBoundingBox(bbMin, bbMax);
-
-		//computing the number of cloth node
-		Vec3 origin_pos(	bbMin.x - params.clothBuffer * params.cloth_resolution,
-							bbMax.y + params.clothYHeight,
-							bbMin.z - params.clothBuffer * params.cloth_resolution);
-	
-		int width_num = static_cast<int>((bbMax.x - bbMin.x) / params.cloth_resolution) + 2 * params.clothBuffer; //static_cast is equivalent to floor if value >= 0
-		int height_num = static_cast<int>((bbMax.z - bbMin.z) / params.cloth_resolution) + 2 * params.clothBuffer; //static_cast is equivalent to floor if value >= 0
-		
-		//Cloth object
-		Cloth cloth(origin_pos, 
-					width_num,
-					height_num,
-					params.cloth_resolution,
-					params.cloth_resolution,
-					0.3,
-					9999,
-					params.rigidness/*,
-					params.time_step*/);
-		if (app)
+		app->dispToConsole(QString("[CSF] Rasterization: %1 ms").arg(timer.restart()));
+	}
+
+	double squareTimeStep = params.time_step * params.time_step;
+
+	//do the filtering
+	if (pDlg)
+	{
+		pDlg->setLabelText(QObject::tr("Cloth deformation\n%1 x %2 particles").arg(cloth.num_particles_width).arg(cloth.num_particles_height));
+		pDlg->setRange(0, params.iterations);
+		pDlg->show();
+		QCoreApplication::processEvents();
+	}
+
+	cloth.addForce(-params.gravity * squareTimeStep); // DGM: warning, the force is already mutliplied by dt^2, no need to do it later (in Cloth::timeStep())
+	for (int i = 0; i < params.iterations; i++)
+	{
+		double maxDiff = cloth.timeStep();
+		cloth.terrainCollision();
+
+		if (maxDiff != 0 && maxDiff < 0.005)
 		{
-			app->dispToConsole(QString("[CSF] Cloth creation: %1 ms").arg(timer.restart()));
+			//early stop
+			break;
 		}
 
-		if (!Rasterization::RasterTerrain(cloth, csfPointCloud, params.k_nearest_points))
+		if (pDlg)
 		{
-			return false;
+			pDlg->setValue(i);
+			QCoreApplication::processEvents();
+
+			if (pDlg->wasCanceled())
+			{
+				wasCancelled = true;
+				break;
+			}
 		}
-	
+	}
+
+	if (pDlg)
+	{
+		pDlg->close();
+		QCoreApplication::processEvents();
+	}
+
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Iterations: %1 ms").arg(timer.restart()));
+	}
+
+	if (wasCancelled)
+	{
+		return false;
+	}
+
+	//slope processing
+	if (params.smoothSlope)
+	{
+		cloth.movableFilter();
+
 		if (app)
 		{
-			app->dispToConsole(QString("[CSF] Rasterization: %1 ms").arg(timer.restart()));
+			app->dispToConsole(QString("[CSF] Movable filter: %1 ms").arg(timer.restart()));
 		}
+	}
+
+	//classification of the points
+	bool result = Cloud2CloudDist::Compute(cloth, csfPointCloud, params.class_threshold, isGround);
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Distance computation: %1 ms").arg(timer.restart()));
+	}
+
+	if (exportClothMesh)
+	{
+		clothMesh = cloth.toMesh();
+	}
+
+	return result;
+}
 
-		double squareTimeStep = params.time_step * params.time_step;
+bool CSF::Apply(const wl::PointCloud& csfPointCloud,
+				const Parameters& params,
+				std::vector<bool>& isGround,
+				bool exportClothMesh,
+				ccMesh*& clothMesh,
+				ccMainAppInterface* app/*=nullptr*/,
+				QWidget* parent/*=nullptr*/)
+{
+	if (params.cloth_resolution < std::numeric_limits<double>::epsilon())
+	{
+		app->dispToConsole("[CSF] Input cloth resolution is too small");
+		return false;
+	}
 
 #if defined(_OPENMP)
-		//save the current max number of threads before changing it
-		int maxThreadCount = omp_get_max_threads();
-		omp_set_num_threads(ccQtHelpers::GetMaxThreadCount(maxThreadCount));
+	//save the current max number of threads before changing it
+	int maxThreadCount = omp_get_max_threads();
+	omp_set_num_threads(params.max_thread_count > 0 ? params.max_thread_count : ccQtHelpers::GetMaxThreadCount(maxThreadCount));
 #endif
 
-		//do the filtering
+	bool result = false;
+	try
+	{
 		QProgressDialog pDlg(parent);
 		pDlg.setWindowTitle("CSF");
-		pDlg.setLabelText(QObject::tr("Cloth deformation\n%1 x %2 particles").arg(cloth.num_particles_width).arg(cloth.num_particles_height));
-		pDlg.setRange(0, params.iterations);
-		pDlg.show();
-		QCoreApplication::processEvents();
 
 		bool wasCancelled = false;
-		cloth.addForce(-params.gravity * squareTimeStep); // DGM: warning, the force is already mutliplied by dt^2, no need to do it later (in Particle::timeStep())
-		for (int i = 0; i < params.iterations; i++)
-		{
-			double maxDiff = cloth.timeStep();
-			cloth.terrainCollision();
+		result = SimulateCloth(csfPointCloud, params, isGround, exportClothMesh, clothMesh, app, &pDlg, wasCancelled);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		result = false;
+	}
 
-			if (maxDiff != 0 && maxDiff < 0.005)
-			{
-				//early stop
-				break;
-			}
+#if defined(_OPENMP)
+	//restore the original max number of threads
+	omp_set_num_threads(maxThreadCount);
+#endif
 
-			pDlg.setValue(i);
-			QCoreApplication::processEvents();
+	return result;
+}
 
-			if (pDlg.wasCanceled())
+bool CSF::ApplyTiled(	const wl::PointCloud& csfPointCloud,
+						const Parameters& params,
+						std::vector<bool>& isGround,
+						ccMainAppInterface* app/*=nullptr*/,
+						CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (params.cloth_resolution < std::numeric_limits<double>::epsilon())
+	{
+		if (app)
+			app->dispToConsole("[CSF] Input cloth resolution is too small");
+		return false;
+	}
+	if (params.tile_size < params.cloth_resolution)
+	{
+		if (app)
+			app->dispToConsole("[CSF] Tile size should be greater than the cloth resolution");
+		return false;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	//the tiles are defined in the horizontal plane (i.e. X and Z in CSF coordinates)
+	wl::Point bbMin, bbMax;
+	csfPointCloud.computeBoundingBox(bbMin, bbMax);
+
+	const double tileSize = params.tile_size;
+	const double overlap = (params.tile_overlap > 0 ? params.tile_overlap : std::max(0.1 * tileSize, 10 * params.cloth_resolution));
+	const int tileCountX = std::max(1, static_cast<int>(std::ceil((bbMax.x - bbMin.x) / tileSize)));
+	const int tileCountZ = std::max(1, static_cast<int>(std::ceil((bbMax.z - bbMin.z) / tileSize)));
+	const size_t tileCount = static_cast<size_t>(tileCountX) * static_cast<size_t>(tileCountZ);
+
+	auto TileCoord = [&](double relativePos, int count) -> int
+	{
+		return std::max(0, std::min(static_cast<int>(std::floor(relativePos / tileSize)), count - 1));
+	};
+
+	//the label of a point is always given by the tile that 'owns' it (i.e. the tile it falls in, without the overlap)
+	auto OwnerTile = [&](const wl::Point& P) -> size_t
+	{
+		int i = TileCoord(P.x - bbMin.x, tileCountX);
+		int j = TileCoord(P.z - bbMin.z, tileCountZ);
+		return static_cast<size_t>(j) * tileCountX + i;
+	};
+
+	//dispatch the points in the tiles (with their overlap)
+	std::vector< std::vector<unsigned> > tilePoints;
+	std::vector<unsigned char> labels;
+	try
+	{
+		tilePoints.resize(tileCount);
+		labels.resize(csfPointCloud.size(), 0);
+
+		for (size_t k = 0; k < csfPointCloud.size(); ++k)
+		{
+			const wl::Point& P = csfPointCloud[k];
+			double relX = P.x - bbMin.x;
+			double relZ = P.z - bbMin.z;
+			int iMin = TileCoord(relX - overlap, tileCountX);
+			int iMax = TileCoord(relX + overlap, tileCountX);
+			int jMin = TileCoord(relZ - overlap, tileCountZ);
+			int jMax = TileCoord(relZ + overlap, tileCountZ);
+			for (int j = jMin; j <= jMax; ++j)
 			{
-				wasCancelled = true;
-				break;
+				for (int i = iMin; i <= iMax; ++i)
+				{
+					tilePoints[static_cast<size_t>(j) * tileCountX + i].push_back(static_cast<unsigned>(k));
+				}
 			}
 		}
-		
-		pDlg.close();
-		QCoreApplication::processEvents();
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
 
-		if (app)
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Tiled mode: %1 x %2 tiles (size: %3 / overlap: %4)").arg(tileCountX).arg(tileCountZ).arg(tileSize).arg(overlap));
+	}
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(tileCount));
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
 		{
-			app->dispToConsole(QString("[CSF] Iterations: %1 ms").arg(timer.restart()));
+			progressCb->setMethodTitle("CSF");
+			progressCb->setInfo(qPrintable(QString("Tiles: %1 x %2").arg(tileCountX).arg(tileCountZ)));
 		}
+		progressCb->start();
+	}
+
+	std::atomic<bool> processFailed{ false };
+	std::atomic<bool> processCanceled{ false };
 
-		if (wasCancelled)
+	//each tile is filtered independently
+	auto FilterTile = [&](unsigned tileIndex)
+	{
+		std::vector<unsigned>& indexes = tilePoints[tileIndex];
+		if (processFailed || processCanceled || indexes.empty())
 		{
+			return;
+		}
+
 #if defined(_OPENMP)
-			//restore the original max number of threads
-			omp_set_num_threads(maxThreadCount);
+		//the tiles are already processed in parallel
+		int ompThreadCount = omp_get_max_threads();
+		omp_set_num_threads(1);
 #endif
-			return false;
-		}
 
-		//slope processing
-		if (params.smoothSlope)
+		try
 		{
-			cloth.movableFilter();
+			//we only need to simulate the tiles that own at least one point
+			bool ownsPoints = false;
+			for (unsigned index : indexes)
+			{
+				if (OwnerTile(csfPointCloud[index]) == tileIndex)
+				{
+					ownsPoints = true;
+					break;
+				}
+			}
 
-			if (app)
+			if (ownsPoints)
 			{
-				app->dispToConsole(QString("[CSF] Movable filter: %1 ms").arg(timer.restart()));
+				wl::PointCloud tileCloud;
+				tileCloud.resize(indexes.size());
+				for (size_t k = 0; k < indexes.size(); ++k)
+				{
+					tileCloud[k] = csfPointCloud[indexes[k]];
+				}
+
+				std::vector<bool> tileIsGround;
+				ccMesh* noClothMesh = nullptr;
+				bool wasCancelled = false;
+				if (SimulateCloth(tileCloud, params, tileIsGround, false, noClothMesh, nullptr, nullptr, wasCancelled))
+				{
+					for (size_t k = 0; k < indexes.size(); ++k)
+					{
+						if (OwnerTile(tileCloud[k]) == tileIndex)
+						{
+							labels[indexes[k]] = (tileIsGround[k] ? 1 : 0);
+						}
+					}
+				}
+				else
+				{
+					processFailed = true;
+				}
 			}
 		}
-	
-		//classification of the points
-		bool result = Cloud2CloudDist::Compute(cloth, csfPointCloud, params.class_threshold, isGround);
-		if (app)
+		catch (const std::bad_alloc&)
 		{
-			app->dispToConsole(QString("[CSF] Distance computation: %1 ms").arg(timer.restart()));
+			//not enough memory
+			processFailed = true;
 		}
 
-		if (exportClothMesh)
-		{
-			clothMesh = cloth.toMesh();
-		}
+		//release memory as soon as possible
+		indexes.clear();
+		indexes.shrink_to_fit();
 
 #if defined(_OPENMP)
-		//restore the original max number of threads
-		omp_set_num_threads(maxThreadCount);
+		omp_set_num_threads(ompThreadCount);
 #endif
 
-		return result;
+		if (progressCb && !nProgress.oneStep())
+		{
+			processCanceled = true;
+		}
+	};
+
+	//tiles are processed from the most populated to the least (better load balancing)
+	std::vector<unsigned> tileIndexes;
+	try
+	{
+		tileIndexes.resize(tileCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+	for (size_t t = 0; t < tileCount; ++t)
+	{
+		tileIndexes[t] = static_cast<unsigned>(t);
+	}
+	std::stable_sort(tileIndexes.begin(), tileIndexes.end(), [&](unsigned a, unsigned b) { return tilePoints[a].size() > tilePoints[b].size(); });
+
+	int maxThreadCount = (params.max_thread_count > 0 ? params.max_thread_count : ccQtHelpers::GetMaxThreadCount());
+	if (maxThreadCount > 1 && tileCount > 1)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+		QtConcurrent::blockingMap(tileIndexes, FilterTile);
+	}
+	else
+	{
+		//the tiles are streamed one after the other
+		for (unsigned tileIndex : tileIndexes)
+		{
+			FilterTile(tileIndex);
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (processFailed || processCanceled)
+	{
+		return false;
+	}
+
+	try
+	{
+		isGround.resize(csfPointCloud.size());
 	}
 	catch (const std::bad_alloc&)
 	{
 		//not enough memory
 		return false;
 	}
+	for (size_t k = 0; k < labels.size(); ++k)
+	{
+		isGround[k] = (labels[k] != 0);
+	}
+
+	if (app)
+	{
+		app->dispToConsole(QString("[CSF] Tiled filtering: %1 ms").arg(timer.elapsed()));
+	}
+
+	return true;
 }
 
 bool CSF::Apply(ccPointCloud* cloud,
@@ -261,7 +538,21 @@ bool CSF::Apply(ccPointCloud* cloud,
 
 		//filtering
 		std::vector<bool> isGround;
-		if (!CSF::Apply(csfPC, params, isGround, exportClothMesh, clothMesh, app))
+		bool success = false;
+		if (params.tile_size > 0)
+		{
+			if (exportClothMesh && app)
+			{
+				app->dispToConsole("[CSF] The cloth mesh can't be exported in tiled mode", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			}
+			success = CSF::ApplyTiled(csfPC, params, isGround, app);
+		}
+		else
+		{
+			success = CSF::Apply(csfPC, params, isGround, exportClothMesh, clothMesh, app);
+		}
+
+		if (!success)
 		{
 			if (app)
 			{
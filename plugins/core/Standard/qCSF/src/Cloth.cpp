@@ -37,6 +37,19 @@
 #include <cmath>
 #include <queue>
 
+/* Some physics constants */
+constexpr double DAMPING = 0.01; // how much to damp the cloth simulation each frame
+
+/* We precompute the overall displacement of a particle accroding to the rigidness */
+static const double SingleMove1[15]{ 0, 0.3, 0.51, 0.657, 0.7599, 0.83193, 0.88235, 0.91765, 0.94235, 0.95965, 0.97175, 0.98023, 0.98616, 0.99031, 0.99322 };
+static const double DoubleMove1[15]{ 0, 0.3, 0.42, 0.468, 0.4872, 0.4949, 0.498, 0.4992, 0.4997, 0.4999, 0.4999, 0.5, 0.5, 0.5, 0.5 };
+
+/* The neighbors of a particle (distance 1, sqrt(2), 2 and sqrt(8) in the grid) */
+static const int NeighborOffsets[16][2]{	{ -1,  0 }, { 1, 0 }, {  0, -1 }, { 0, 1 },
+											{ -1, -1 }, { 1, 1 }, {  1, -1 }, { -1, 1 },
+											{ -2,  0 }, { 2, 0 }, {  0, -2 }, { 0, 2 },
+											{ -2, -2 }, { 2, 2 }, {  2, -2 }, { -2, 2 } };
+
 Cloth::Cloth(	const Vec3& _origin_pos,
 				int _num_particles_width,
 				int _num_particles_height,
@@ -47,6 +60,7 @@ Cloth::Cloth(	const Vec3& _origin_pos,
 				int rigidness/*,
 				double _time_step*/)
 	: constraint_iterations(rigidness)
+	, acceleration(0)
 	//, time_step(_time_step)
 	, smoothThreshold(_smoothThreshold)
 	, heightThreshold(_heightThreshold)
@@ -56,7 +70,11 @@ Cloth::Cloth(	const Vec3& _origin_pos,
 	, step_x(_step_x)
 	, step_y(_step_y)
 {
-	particles.resize(static_cast<size_t>(num_particles_width)*static_cast<size_t>(num_particles_height)); //I am essentially using this vector as an array with room for num_particles_width*num_particles_height particles
+	size_t particleCount = static_cast<size_t>(num_particles_width)*static_cast<size_t>(num_particles_height);
+	particles.resize(particleCount); //I am essentially using this vector as an array with room for num_particles_width*num_particles_height particles
+	pos_y.resize(particleCount, origin_pos.y);
+	old_pos_y.resize(particleCount, origin_pos.y);
+	movable.resize(particleCount, 1);
 
 	//double squareTimeStep = time_step * time_step;
 
@@ -65,11 +83,7 @@ Cloth::Cloth(	const Vec3& _origin_pos,
 	{
 		for (int j = 0; j < num_particles_height; j++)
 		{
-			Vec3 pos(	origin_pos.x + i * step_x,
-						origin_pos.y,
-						origin_pos.z + j * step_y);
-
-			particles[j*num_particles_width + i] = Particle(pos/*, squareTimeStep*/); // insert particle in column i at j'th row
+			// particle in column i at j'th row (its altitude is stored in pos_y)
 			particles[j*num_particles_width + i].pos_x = i;
 			particles[j*num_particles_width + i].pos_y = j;
 		}
@@ -145,9 +159,10 @@ ccMesh* Cloth::toMesh() const
 	for (int i = 0; i < getSize(); ++i)
 	{
 		const Particle& particle = particles[i];
-		vertices->addPoint(CCVector3(	static_cast<PointCoordinateType>(particle.getPos().x),
-										static_cast<PointCoordinateType>(particle.getPos().z),
-										static_cast<PointCoordinateType>(-particle.getPos().y)));
+		Vec3 pos = getPos(particle.pos_x, particle.pos_y);
+		vertices->addPoint(CCVector3(	static_cast<PointCoordinateType>(pos.x),
+										static_cast<PointCoordinateType>(pos.z),
+										static_cast<PointCoordinateType>(-pos.y)));
 	}
 
 	//and create the triangles
@@ -170,34 +185,105 @@ ccMesh* Cloth::toMesh() const
 	return mesh;
 }
 
+void Cloth::satisfyConstraints(int x, int y, double singleMove, double doubleMove)
+{
+	const int index = y*num_particles_width + x;
+	for (const int* offset : NeighborOffsets)
+	{
+		const int nx = x + offset[0];
+		const int ny = y + offset[1];
+		if (nx < 0 || ny < 0 || nx >= num_particles_width || ny >= num_particles_height)
+		{
+			continue;
+		}
+		const int neighborIndex = ny*num_particles_width + nx;
+
+		double correctionHeight = pos_y[neighborIndex] - pos_y[index];
+		if (movable[index] && movable[neighborIndex])
+		{
+			double correctionVectorHalf = correctionHeight * doubleMove; // Lets make it half that length, so that we can move BOTH particles.
+			pos_y[index] += correctionVectorHalf;
+			pos_y[neighborIndex] -= correctionVectorHalf;
+		}
+		else if (movable[index])
+		{
+			pos_y[index] += correctionHeight * singleMove;
+		}
+		else if (movable[neighborIndex])
+		{
+			pos_y[neighborIndex] -= correctionHeight * singleMove;
+		}
+	}
+}
+
 double Cloth::timeStep()
 {
-	int particleCount = static_cast<int>(particles.size());
+	const int particleCount = getSize();
 
-#pragma omp parallel for
-	for (int i = 0; i < particleCount; i++)
+	//verlet integration
 	{
-		particles[i].timeStep();
+		double* y = pos_y.data();
+		double* oldY = old_pos_y.data();
+		const unsigned char* isMovable = movable.data();
+		const double acc = acceleration;
+
+#pragma omp parallel for
+		for (int i = 0; i < particleCount; i++)
+		{
+			const double currentY = y[i];
+			const double nextY = currentY + (currentY - oldY[i]) * (1.0 - DAMPING) + acc; // acceleration is already multiplied by dt^2 (see CSF.cpp)
+			if (isMovable[i])
+			{
+				oldY[i] = currentY;
+				y[i] = nextY;
+			}
+		}
 	}
 
 	//Instead of interating over all the constraints several times, we 
 	//compute the overall displacement of a particle accroding to the rigidness
-//#pragma omp parallel for //DGM: satisfyConstraintSelf is not thread safe at all!
-	for (int j = 0; j < particleCount; j++)
+	const double singleMove = (constraint_iterations > 14 ? 1.0 : SingleMove1[constraint_iterations]);
+	const double doubleMove = (constraint_iterations > 14 ? 0.5 : DoubleMove1[constraint_iterations]);
+
+	//As the constraints of a particle also modify its neighbors, we process the particles by 'color'
+	//(particles of the same color are too far from each other to share any neighbor)
+	for (int colorY = 0; colorY < CONSTRAINT_COLOR_STRIDE; ++colorY)
 	{
-		particles[j].satisfyConstraintSelf(constraint_iterations);
+		for (int colorX = 0; colorX < CONSTRAINT_COLOR_STRIDE; ++colorX)
+		{
+#pragma omp parallel for
+			for (int y = colorY; y < num_particles_height; y += CONSTRAINT_COLOR_STRIDE)
+			{
+				for (int x = colorX; x < num_particles_width; x += CONSTRAINT_COLOR_STRIDE)
+				{
+					satisfyConstraints(x, y, singleMove, doubleMove);
+				}
+			}
+		}
 	}
 
+	//max displacement (no 'max' reduction in OpenMP 2.0, hence the per-thread maximum)
 	double maxDiff = 0.0;
-//#pragma omp parallel for //see https://github.com/CloudCompare/CloudCompare/issues/909
-	for (int i = 0; i < particleCount; i++)
+#pragma omp parallel
 	{
-		if (particles[i].isMovable())
+		double threadMaxDiff = 0.0;
+#pragma omp for
+		for (int i = 0; i < particleCount; i++)
 		{
-			double diff = std::abs(particles[i].getPreviousY() - particles[i].getPos().y);
-			if (diff > maxDiff)
+			if (movable[i])
 			{
-				maxDiff = diff;
+				double diff = std::abs(old_pos_y[i] - pos_y[i]);
+				if (diff > threadMaxDiff)
+				{
+					threadMaxDiff = diff;
+				}
+			}
+		}
+#pragma omp critical
+		{
+			if (threadMaxDiff > maxDiff)
+			{
+				maxDiff = threadMaxDiff;
 			}
 		}
 	}
@@ -207,14 +293,8 @@ double Cloth::timeStep()
 
 void Cloth::addForce(double f)
 {
-	int particleCount = static_cast<int>(particles.size());
-
-	// add the forces to each particle
-#pragma omp parallel for
-	for (int i = 0; i < particleCount; i++)
-	{
-		particles[i].addForce(f);
-	}
+	// add the forces to all particles
+	acceleration += f/*/ mass*/;
 }
 
 //testing the collision
@@ -222,15 +302,14 @@ void Cloth::terrainCollision()
 {
 	assert(particles.size() == heightvals.size());
 
-	int particleCount = static_cast<int>(particles.size());
+	int particleCount = getSize();
 #pragma omp parallel for
 	for (int i = 0; i < particleCount; i++)
 	{
-		Particle& particle = particles[i];
-		if (particle.getPos().y < heightvals[i]) // if the particle is inside the ball
+		if (pos_y[i] < heightvals[i]) // if the particle is inside the ball
 		{
-			particle.offsetPos(heightvals[i] - particle.getPos().y);
-			particle.makeUnmovable();
+			offsetPos(i, heightvals[i] - pos_y[i]);
+			makeUnmovable(i);
 		}
 	}
 }
@@ -242,7 +321,7 @@ void Cloth::movableFilter()
 		for (int y = 0; y < num_particles_height; y++)
 		{
 			Particle& ptc = getParticle(x, y);
-			if (ptc.isMovable() && !ptc.isVisited)
+			if (isMovable(y*num_particles_width + x) && !ptc.isVisited)
 			{
 				std::queue<int> que;
 				std::vector<XY> connected; //store the connected component
@@ -265,7 +344,7 @@ void Cloth::movableFilter()
 					if (cur_x > 0)
 					{
 						Particle& ptc_left = getParticle(cur_x - 1, cur_y);
-						if (ptc_left.isMovable())
+						if (isMovable(num_particles_width*cur_y + cur_x - 1))
 						{
 							if (!ptc_left.isVisited)
 							{
@@ -286,7 +365,7 @@ void Cloth::movableFilter()
 					if (cur_x < num_particles_width - 1)
 					{
 						Particle& ptc_right = getParticle(cur_x + 1, cur_y);
-						if (ptc_right.isMovable())
+						if (isMovable(num_particles_width*cur_y + cur_x + 1))
 						{
 							if (!ptc_right.isVisited)
 							{
@@ -307,7 +386,7 @@ void Cloth::movableFilter()
 					if (cur_y > 0)
 					{
 						Particle& ptc_bottom = getParticle(cur_x, cur_y - 1);
-						if (ptc_bottom.isMovable())
+						if (isMovable(num_particles_width*(cur_y - 1) + cur_x))
 						{
 							if (!ptc_bottom.isVisited)
 							{
@@ -328,7 +407,7 @@ void Cloth::movableFilter()
 					if (cur_y < num_particles_height - 1)
 					{
 						Particle& ptc_top = getParticle(cur_x, cur_y + 1);
-						if (ptc_top.isMovable())
+						if (isMovable(num_particles_width*(cur_y + 1) + cur_x))
 						{
 							if (!ptc_top.isVisited)
 							{
@@ -369,18 +448,16 @@ void Cloth::findUnmovablePoint(	const std::vector<XY>& connected,
 		int x = connected[i].x;
 		int y = connected[i].y;
 		int index = y*num_particles_width + x;
-		Particle& ptc = getParticle(x, y);
 		if (x > 0)
 		{
-			const Particle& ptc_x = getParticle(x - 1, y);
-			if (!ptc_x.isMovable())
+			int index_ref = y*num_particles_width + x - 1;
+			if (!isMovable(index_ref))
 			{
-				int index_ref = y*num_particles_width + x - 1;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.getPos().y - heightvals[index] < heightThreshold)
+				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && pos_y[index] - heightvals[index] < heightThreshold)
 				{
-					double offsetY = heightvals[index] - ptc.getPos().y;
-					particles[index].offsetPos(offsetY);
-					ptc.makeUnmovable();
+					double offsetY = heightvals[index] - pos_y[index];
+					offsetPos(index, offsetY);
+					makeUnmovable(index);
 					edgePoints.push_back(static_cast<int>(i));
 					continue;
 				}
@@ -389,15 +466,14 @@ void Cloth::findUnmovablePoint(	const std::vector<XY>& connected,
 
 		if (x < num_particles_width - 1)
 		{
-			const Particle& ptc_x = getParticle(x + 1, y);
-			if (!ptc_x.isMovable())
+			int index_ref = y*num_particles_width + x + 1;
+			if (!isMovable(index_ref))
 			{
-				int index_ref = y*num_particles_width + x + 1;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.getPos().y - heightvals[index] < heightThreshold)
+				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && pos_y[index] - heightvals[index] < heightThreshold)
 				{
-					double offsetY = heightvals[index] - ptc.getPos().y;
-					particles[index].offsetPos(offsetY);
-					ptc.makeUnmovable();
+					double offsetY = heightvals[index] - pos_y[index];
+					offsetPos(index, offsetY);
+					makeUnmovable(index);
 					edgePoints.push_back(static_cast<int>(i));
 					continue;
 				}
@@ -406,15 +482,14 @@ void Cloth::findUnmovablePoint(	const std::vector<XY>& connected,
 
 		if (y > 0)
 		{
-			const Particle& ptc_y = getParticle(x, y - 1);
-			if (!ptc_y.isMovable())
+			int index_ref = (y - 1)*num_particles_width + x;
+			if (!isMovable(index_ref))
 			{
-				int index_ref = (y - 1)*num_particles_width + x;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.getPos().y - heightvals[index] < heightThreshold)
+				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && pos_y[index] - heightvals[index] < heightThreshold)
 				{
-					double offsetY = heightvals[index] - ptc.getPos().y;
-					particles[index].offsetPos(offsetY);
-					ptc.makeUnmovable();
+					double offsetY = heightvals[index] - pos_y[index];
+					offsetPos(index, offsetY);
+					makeUnmovable(index);
 					edgePoints.push_back(static_cast<int>(i));
 					continue;
 				}
@@ -424,15 +499,14 @@ void Cloth::findUnmovablePoint(	const std::vector<XY>& connected,
 
 		if (y < num_particles_height - 1)
 		{
-			const Particle& ptc_y = getParticle(x, y + 1);
-			if (!ptc_y.isMovable())
+			int index_ref = (y + 1)*num_particles_width + x;
+			if (!isMovable(index_ref))
 			{
-				int index_ref = (y + 1)*num_particles_width + x;
-				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && ptc.getPos().y - heightvals[index] < heightThreshold)
+				if (std::abs(heightvals[index] - heightvals[index_ref]) < smoothThreshold && pos_y[index] - heightvals[index] < heightThreshold)
 				{
-					double offsetY = heightvals[index] - ptc.getPos().y;
-					particles[index].offsetPos(offsetY);
-					ptc.makeUnmovable();
+					double offsetY = heightvals[index] - pos_y[index];
+					offsetPos(index, offsetY);
+					makeUnmovable(index);
 					edgePoints.push_back(static_cast<int>(i));
 					continue;
 				}
@@ -465,11 +539,11 @@ void Cloth::handle_slop_connected(	const std::vector<int>& edgePoints,
 		for (size_t i = 0; i < neibors[index].size(); i++)
 		{
 			int index_neibor = connected[neibors[index][i]].y*num_particles_width + connected[neibors[index][i]].x;
-			if (std::abs(heightvals[index_center] - heightvals[index_neibor]) < smoothThreshold && std::abs(particles[index_neibor].getPos().y - heightvals[index_neibor]) < heightThreshold)
+			if (std::abs(heightvals[index_center] - heightvals[index_neibor]) < smoothThreshold && std::abs(pos_y[index_neibor] - heightvals[index_neibor]) < heightThreshold)
 			{
-				double offsetY =heightvals[index_neibor] - particles[index_neibor].getPos().y;
-				particles[index_neibor].offsetPos(offsetY);
-				particles[index_neibor].makeUnmovable();
+				double offsetY =heightvals[index_neibor] - pos_y[index_neibor];
+				offsetPos(index_neibor, offsetY);
+				makeUnmovable(index_neibor);
 				if (visited[neibors[index][i]] == false)
 				{
 					que.push(neibors[index][i]);
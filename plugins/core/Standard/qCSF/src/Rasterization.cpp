@@ -143,8 +143,9 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, unsign
 			{
 				Particle& pt = cloth.getParticle(col, row);
 
-				double dx = pt.getPos().x - pc_x;
-				double dz = pt.getPos().z - pc_z;
+				Vec3 ptPos = cloth.getPos(col, row);
+				double dx = ptPos.x - pc_x;
+				double dz = ptPos.z - pc_z;
 				double pc2particleDist = dx * dx + dz * dz;
 
 				if (pc2particleDist < pt.nearestPointDist)
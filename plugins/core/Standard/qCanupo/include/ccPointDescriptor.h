@@ -75,6 +75,11 @@ public:
 	//! Returns whether the computer requires a scalar field or not
 	virtual bool needSF() const { return false; }
 
+	//! Returns a new instance of this computer
+	/** Computers are stateful (see reset): each thread must use its own instance.
+	**/
+	virtual ScaleParamsComputer* clone() const = 0;
+
 	//! Called once before computing parameters at first scale
 	virtual void reset() = 0;
 	
@@ -87,6 +92,22 @@ public:
 	**/
 	virtual void computeScaleParams(CCCoreLib::ReferenceCloud& neighbors, double radius, float params[], bool& invalidScale) = 0;
 
+	//! Returns whether the parameters only depend on the covariance matrix of the neighbors
+	/** In this case, computeScaleParamsFromCovariance is called instead of computeScaleParams.
+		This lets the caller update the covariance matrix incrementally from one scale to the other.
+	**/
+	virtual bool usesCovarianceOnly() const { return false; }
+
+	//! Computes the parameters at a given scale from the covariance matrix of the neighbors
+	/** Scales are always called in decreasing order.
+		\param[in] covariance the covariance matrix coefficients (XX, XY, XZ, YY, YZ, ZZ)
+		\param[in] neighborCount the number of neighbors at the current scale
+		\param[in] radius current radius (half scale) value
+		\param[out] params the computed parameters
+		\param[out] invalidScale whether this scale is 'invalid' (i.e. parameters couldn't be computed, default one have been returned instead)
+	**/
+	virtual void computeScaleParamsFromCovariance(const double covariance[6], unsigned neighborCount, double radius, float params[], bool& invalidScale) { invalidScale = true; }
+
 protected:
 };
 
@@ -29,7 +29,9 @@
 #include <QMap>
 
 //system
+#include <algorithm>
 #include <fstream>
+#include <limits>
 
 /**** SCALE PARAMETERS COMPUTERS ****/
 /*									*/
@@ -42,6 +44,57 @@
 //useful constant
 static const double SQRT_3_DIV_2 = sqrt(3.0) / 2;
 
+//! Computes the eigenvalues of a 3x3 symmetric matrix (closed form)
+/** Much faster than the Jacobi method when only the eigenvalues are needed.
+	\param[in] m the matrix coefficients (XX, XY, XZ, YY, YZ, ZZ)
+	\param[out] eigValues the eigenvalues (in decreasing order)
+**/
+static void ComputeSymmetricEigenValues(const double m[6], double eigValues[3])
+{
+	const double p1 = m[1] * m[1] + m[2] * m[2] + m[4] * m[4];
+	const double q = (m[0] + m[3] + m[5]) / 3;
+
+	if (p1 <= std::numeric_limits<double>::epsilon() * q * q)
+	{
+		//diagonal matrix
+		eigValues[0] = m[0];
+		eigValues[1] = m[3];
+		eigValues[2] = m[5];
+	}
+	else
+	{
+		const double b0 = m[0] - q;
+		const double b3 = m[3] - q;
+		const double b5 = m[5] - q;
+		const double p = sqrt((b0 * b0 + b3 * b3 + b5 * b5 + 2 * p1) / 6);
+
+		//half determinant of (M - q.I) / p
+		const double det = b0 * (b3 * b5 - m[4] * m[4])
+						 - m[1] * (m[1] * b5 - m[4] * m[2])
+						 + m[2] * (m[1] * m[4] - b3 * m[2]);
+		const double r = det / (2 * p * p * p);
+
+		const double phi = (r <= -1.0 ? M_PI / 3 : (r >= 1.0 ? 0.0 : acos(r) / 3));
+		eigValues[0] = q + 2 * p * cos(phi);
+		eigValues[2] = q + 2 * p * cos(phi + 2 * M_PI / 3);
+		eigValues[1] = 3 * q - eigValues[0] - eigValues[2];
+	}
+
+	//sort them (decreasing order)
+	if (eigValues[0] < eigValues[1])
+		std::swap(eigValues[0], eigValues[1]);
+	if (eigValues[1] < eigValues[2])
+		std::swap(eigValues[1], eigValues[2]);
+	if (eigValues[0] < eigValues[1])
+		std::swap(eigValues[0], eigValues[1]);
+
+	//a covariance matrix is positive semi-definite
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		eigValues[i] = std::max(0.0, eigValues[i]);
+	}
+}
+
 //! Per-scale "dimensionality" parameters computer (i.e. same as the original CANUPO suite)
 class DimensionalityScaleParamsComputer : public ScaleParamsComputer
 {
@@ -59,6 +112,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 2; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new DimensionalityScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
@@ -136,6 +192,48 @@ public:
 		}
 	}
 
+	//inherited from ScaleParamsComputer
+	bool usesCovarianceOnly() const override { return true; }
+
+	//inherited from ScaleParamsComputer
+	void computeScaleParamsFromCovariance(const double covariance[6], unsigned neighborCount, double radius, float params[], bool& invalidScale) override
+	{
+		if (neighborCount >= 3)
+		{
+			double eigValues[3];
+			ComputeSymmetricEigenValues(covariance, eigValues);
+
+			double totalVariance = eigValues[0] + eigValues[1] + eigValues[2];
+			if (totalVariance < CCCoreLib::ZERO_TOLERANCE_D)
+			{
+				invalidScale = true;
+				params[0] = m_defaultParams[0];
+				params[1] = m_defaultParams[1];
+				return;
+			}
+			double x = eigValues[0] / totalVariance;
+			double y = eigValues[1] / totalVariance;
+
+			//same barycentric coordinates as above
+			double a = std::min<double>(1.0, std::max<double>(0.0, x - y));
+			double b = std::min<double>(1.0, std::max<double>(0.0, 2 * x + 4 * y - 2.0));
+			double c = 1.0 - a - b;
+			params[0] = static_cast<float>(b + c / 2);
+			params[1] = static_cast<float>(c * SQRT_3_DIV_2);
+
+			//save parameters for next scale
+			m_defaultParams[0] = params[0];
+			m_defaultParams[1] = params[1];
+			m_firstScale = false;
+		}
+		else if (m_firstScale) //less than 3 points at the biggest scale?!
+		{
+			invalidScale = true;
+			params[0] = m_defaultParams[0];
+			params[1] = m_defaultParams[1];
+		}
+	}
+
 protected:
 
 	//! Default parameters (or last computed scale's ones!)
@@ -163,6 +261,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 3; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new DimensionalityAndSFScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	bool needSF() const override { return true; }
 
@@ -295,6 +396,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 1; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new CurvatureScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
@@ -347,6 +451,9 @@ public:
 	//inherited from ScaleParamsComputer
 	unsigned dimPerScale() const override { return 1; }
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new CustomScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	void reset() override
 	{
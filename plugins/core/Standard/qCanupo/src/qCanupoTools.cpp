@@ -26,6 +26,7 @@
 #include <ParallelSort.h>
 
 //qCC_db
+#include <ccCloudBatches.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
@@ -40,160 +41,311 @@
 #include <QMainWindow>
 #include <QtConcurrentMap>
 
-//ComputeCorePointsDescriptors parameters
-static struct
+//system
+#include <atomic>
+#include <memory>
+
+//! ComputeCorePointsDescriptors parameters
+struct ComputeCorePointsDescParams
 {
-	CCCoreLib::GenericIndexedCloud* corePoints;
-	ccGenericPointCloud* sourceCloud;
-	CCCoreLib::DgmOctree* octree;
-	unsigned char octreeLevel;
-	CorePointDescSet* descriptors;
-	bool invalidDescriptors;
+	CCCoreLib::GenericIndexedCloud* corePoints = nullptr;
+	ccGenericPointCloud* sourceCloud = nullptr;
+	CCCoreLib::DgmOctree* octree = nullptr;
+	unsigned char octreeLevel = 0;
+	CorePointDescSet* descriptors = nullptr;
+
+	const ScaleParamsComputer* computer = nullptr; //the per-scale parameters computer (cloned by each batch)
 
-	CCCoreLib::NormalizedProgress* nProgress;
-	bool processCanceled;
-	bool errorOccurred;
+	std::vector<ccScalarField*>* roughnessSFs = nullptr; //for test
 
-	ScaleParamsComputer* computer; //the per-scale parameters computer 
+	//core point indexes (sorted by batch)
+	std::vector<unsigned> sortedIndexes;
+	//start position of each batch in sortedIndexes (plus one last 'end' position)
+	std::vector<size_t> batchStarts;
 
-	std::vector<ccScalarField*>* roughnessSFs; //for test
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	std::atomic<bool> processCanceled { false };
+	std::atomic<bool> errorOccurred { false };
+	std::atomic<bool> invalidDescriptors { false };
+};
 
+//! Covariance moments of a set of points (relatively to the core point)
+struct CovarianceMoments
+{
+	double sum[3] = { 0, 0, 0 };
+	double sum2[6] = { 0, 0, 0, 0, 0, 0 }; //XX, XY, XZ, YY, YZ, ZZ
 
-} s_computeCorePointsDescParams;
+	//! Adds a point
+	inline void add(double x, double y, double z)
+	{
+		sum[0] += x; sum[1] += y; sum[2] += z;
+		sum2[0] += x * x; sum2[1] += x * y; sum2[2] += x * z;
+		sum2[3] += y * y; sum2[4] += y * z; sum2[5] += z * z;
+	}
 
-//! Per-point descriptor computer (all the parameters are stored in s_computeCorePointsDescParams)
-void ComputeCorePointDescriptor(unsigned index)
+	//! Returns the covariance matrix coefficients (XX, XY, XZ, YY, YZ, ZZ)
+	inline void toCovariance(size_t count, double covariance[6]) const
+	{
+		double mx = sum[0] / count;
+		double my = sum[1] / count;
+		double mz = sum[2] / count;
+		covariance[0] = sum2[0] / count - mx * mx;
+		covariance[1] = sum2[1] / count - mx * my;
+		covariance[2] = sum2[2] / count - mx * mz;
+		covariance[3] = sum2[3] / count - my * my;
+		covariance[4] = sum2[4] / count - my * mz;
+		covariance[5] = sum2[5] / count - mz * mz;
+	}
+};
+
+//! Computes the descriptors of all the core points of a given batch
+/** The neighbors of all the core points of the batch are extracted with a single
+	octree query (around the batch bounding sphere). Each core point then only has
+	to filter this shared set of candidates.
+**/
+static void ComputeBatchDescriptors(unsigned batchIndex, ComputeCorePointsDescParams& params)
 {
-	if (s_computeCorePointsDescParams.processCanceled)
+	if (params.processCanceled)
 		return;
 
-	const CCVector3* P = s_computeCorePointsDescParams.corePoints->getPoint(index);
-	CCCoreLib::DgmOctree::NeighboursSet neighbours;
+	const size_t batchStart = params.batchStarts[batchIndex];
+	const size_t batchSize = params.batchStarts[batchIndex + 1] - batchStart;
+	const unsigned* indexes = params.sortedIndexes.data() + batchStart;
+
+	const std::vector<float>& scales = params.descriptors->scales();
+	const size_t scaleCount = scales.size();
+	const unsigned dimPerScale = params.descriptors->dimPerScale();
+	const PointCoordinateType maxRadius = scales.front() / 2;
+	const PointCoordinateType maxSquareRadius = maxRadius * maxRadius;
 
-	//extract the neighbors (maximum radius)
-	float maxRadius = s_computeCorePointsDescParams.descriptors->scales().front() / 2;
-	int n = s_computeCorePointsDescParams.octree->getPointsInSphericalNeighbourhood(*P,
-																				maxRadius,
-																				neighbours,
-																				s_computeCorePointsDescParams.octreeLevel);
+	const bool useCovariance = params.computer->usesCovarianceOnly();
+	const bool needSubset = (!useCovariance || params.roughnessSFs != nullptr);
 
-	if (n != 0)
+	try
 	{
-		size_t scaleCount = s_computeCorePointsDescParams.descriptors->scales().size();
+		//computers are stateful: each batch uses its own instance
+		std::unique_ptr<ScaleParamsComputer> computer(params.computer->clone());
 
-		//get reference on corresponding descriptor
-		assert(s_computeCorePointsDescParams.descriptors->size() > index);
-		CorePointDesc& desc = s_computeCorePointsDescParams.descriptors->at(index);
+		//bounding sphere of the batch
+		CCVector3 bbMin = *params.corePoints->getPoint(indexes[0]);
+		CCVector3 bbMax = bbMin;
+		for (size_t i = 1; i < batchSize; ++i)
+		{
+			const CCVector3* P = params.corePoints->getPoint(indexes[i]);
+			bbMin.x = std::min(bbMin.x, P->x);
+			bbMin.y = std::min(bbMin.y, P->y);
+			bbMin.z = std::min(bbMin.z, P->z);
+			bbMax.x = std::max(bbMax.x, P->x);
+			bbMax.y = std::max(bbMax.y, P->y);
+			bbMax.z = std::max(bbMax.z, P->z);
+		}
+		const CCVector3 batchCenter = (bbMin + bbMax) / 2;
+		const PointCoordinateType batchRadius = (bbMax - bbMin).norm() / 2;
+
+		//extract the candidates shared by all the core points of the batch
+		CCCoreLib::DgmOctree::NeighboursSet candidates;
+		params.octree->getPointsInSphericalNeighbourhood(batchCenter, batchRadius + maxRadius, candidates, params.octreeLevel);
+		const size_t candidateCount = candidates.size();
+
+		//we store the candidates coordinates (relatively to the batch center) in contiguous arrays
+		std::vector<PointCoordinateType> cx(candidateCount);
+		std::vector<PointCoordinateType> cy(candidateCount);
+		std::vector<PointCoordinateType> cz(candidateCount);
+		for (size_t j = 0; j < candidateCount; ++j)
+		{
+			CCVector3 Q = *candidates[j].point - batchCenter;
+			cx[j] = Q.x;
+			cy[j] = Q.y;
+			cz[j] = Q.z;
+		}
 
-		unsigned dimPerScale = s_computeCorePointsDescParams.descriptors->dimPerScale();
-		assert(desc.params.size() == scaleCount * dimPerScale);
+		std::vector<PointCoordinateType> squareDists(candidateCount);
+		std::vector<std::pair<PointCoordinateType, unsigned>> neighbours; //(square distance, candidate index)
+		neighbours.reserve(candidateCount);
+		std::vector<size_t> scaleCounts(scaleCount);
+		std::vector<double> covariances(useCovariance ? 6 * scaleCount : 0);
+		CCCoreLib::ReferenceCloud subset(params.sourceCloud);
 
-		//init the whole neighborhood subset (we will prune it each time)
-		CCCoreLib::ReferenceCloud subset(s_computeCorePointsDescParams.sourceCloud);
+		for (size_t b = 0; b < batchSize; ++b)
 		{
-			if (!subset.reserve(n))
+			if (params.processCanceled)
+				break;
+
+			const unsigned index = indexes[b];
+			const CCVector3 P = *params.corePoints->getPoint(index) - batchCenter;
+
+			//squared distances to all the candidates (branchless loop on contiguous arrays, so that the compiler can vectorize it)
 			{
-				//not enough memory!
-				s_computeCorePointsDescParams.errorOccurred = true;
-				s_computeCorePointsDescParams.processCanceled = true; //to make the loop stop!
-				return;
+				const PointCoordinateType* px = cx.data();
+				const PointCoordinateType* py = cy.data();
+				const PointCoordinateType* pz = cz.data();
+				PointCoordinateType* pd = squareDists.data();
+				for (size_t j = 0; j < candidateCount; ++j)
+				{
+					PointCoordinateType dx = px[j] - P.x;
+					PointCoordinateType dy = py[j] - P.y;
+					PointCoordinateType dz = pz[j] - P.z;
+					pd[j] = dx * dx + dy * dy + dz * dz;
+				}
 			}
 
-			//sort the neighbors by increasing distance
-			ParallelSort(neighbours.begin(), neighbours.end(), CCCoreLib::DgmOctree::PointDescriptor::distComp);
+			//keep the neighbors (maximum radius)
+			neighbours.clear();
+			for (size_t j = 0; j < candidateCount; ++j)
+			{
+				if (squareDists[j] <= maxSquareRadius)
+				{
+					neighbours.emplace_back(squareDists[j], static_cast<unsigned>(j));
+				}
+			}
 
-			for (int j = 0; j < n; ++j)
+			if (neighbours.empty())
 			{
-				subset.addPointIndex(neighbours[j].pointIndex);
+				//if the widest neighborhood is empty, we can't compute a valid descriptor!
+				params.invalidDescriptors = true;
+				continue;
 			}
-		}
 
-		s_computeCorePointsDescParams.computer->reset();
+			//sort the neighbors by increasing distance
+			std::sort(neighbours.begin(), neighbours.end());
 
-		for (size_t i = 0; i < scaleCount; ++i)
-		{
-			const double radius = s_computeCorePointsDescParams.descriptors->scales()[i] / 2; //we start from the biggest
+			//number of neighbors at each scale (the neighborhoods are nested, we start from the biggest)
+			scaleCounts[0] = neighbours.size();
+			for (size_t i = 1; i < scaleCount; ++i)
+			{
+				const PointCoordinateType radius = scales[i] / 2;
+				const PointCoordinateType squareRadius = radius * radius;
+				auto up = std::upper_bound(	neighbours.begin(),
+											neighbours.begin() + scaleCounts[i - 1],
+											squareRadius,
+											[](PointCoordinateType d2, const std::pair<PointCoordinateType, unsigned>& n) { return d2 < n.first; } );
+				scaleCounts[i] = std::max<size_t>(1, up - neighbours.begin());
+			}
 
-			if (i != 0)
+			//incremental covariance: we add the neighbors by increasing distance, and
+			//save the covariance matrix each time we reach the boundary of a scale
+			if (useCovariance)
 			{
-				//trim the points that don't fall in the current neighborhood
-				double squareRadius = radius * radius;
-				CCCoreLib::DgmOctree::PointDescriptor fakeDesc(nullptr, 0, squareRadius);
-				CCCoreLib::DgmOctree::NeighboursSet::iterator up = std::upper_bound(neighbours.begin(), neighbours.end(), fakeDesc, CCCoreLib::DgmOctree::PointDescriptor::distComp);
-				if (up != neighbours.end())
+				CovarianceMoments moments;
+				size_t count = 0;
+				for (size_t i = scaleCount; i-- > 0;)
 				{
-					size_t count = std::max<size_t>(1, up - neighbours.begin());
+					for (; count < scaleCounts[i]; ++count)
+					{
+						unsigned j = neighbours[count].second;
+						moments.add(	static_cast<double>(cx[j]) - P.x,
+										static_cast<double>(cy[j]) - P.y,
+										static_cast<double>(cz[j]) - P.z );
+					}
+					moments.toCovariance(count, covariances.data() + 6 * i);
+				}
+			}
 
-					neighbours.resize(count);
-					subset.resize(static_cast<unsigned>(count));
+			//init the whole neighborhood subset (we will prune it each time)
+			if (needSubset)
+			{
+				subset.clear(false);
+				if (!subset.reserve(static_cast<unsigned>(neighbours.size())))
+				{
+					throw std::bad_alloc();
+				}
+				for (const auto& n : neighbours)
+				{
+					subset.addPointIndex(candidates[n.second].pointIndex);
 				}
 			}
 
-			//optional: compute per-level roughness
-			if (s_computeCorePointsDescParams.roughnessSFs)
+			//get reference on corresponding descriptor
+			assert(params.descriptors->size() > index);
+			CorePointDesc& desc = params.descriptors->at(index);
+			assert(desc.params.size() == scaleCount * dimPerScale);
+
+			computer->reset();
+
+			for (size_t i = 0; i < scaleCount; ++i)
 			{
-				ScalarType roughness = CCCoreLib::NAN_VALUE;
+				const double radius = scales[i] / 2; //we start from the biggest
+
+				if (needSubset && i != 0)
+				{
+					//trim the points that don't fall in the current neighborhood
+					subset.resize(static_cast<unsigned>(scaleCounts[i]));
+				}
 
-				if (subset.size() >= 3)
+				//optional: compute per-level roughness
+				if (params.roughnessSFs)
 				{
-					//to compute we take the nearest point to the query point as 'central' point
-					//warning: it should work in most of the cases, apart if the core points have nothing to do
-					//with the global cloud!!!
-					unsigned lastIndex = subset.size() - 1;
-					subset.swap(0, lastIndex);
-
-					//temporarily remove the central point (now at the end)
-					unsigned globalIndex = subset.getPointGlobalIndex(lastIndex);
-					subset.resize(lastIndex);
-
-					CCCoreLib::Neighbourhood Z(&subset);
-					const PointCoordinateType* lsPlane = Z.getLSPlane();
-					if (lsPlane)
+					ScalarType roughness = CCCoreLib::NAN_VALUE;
+
+					if (subset.size() >= 3)
 					{
-						//distance to the LS plane fitted on the nearest neighbors
-						const CCVector3* centralPoint = s_computeCorePointsDescParams.sourceCloud->getPoint(globalIndex);
-						roughness = std::abs(CCCoreLib::DistanceComputationTools::computePoint2PlaneDistance(centralPoint, lsPlane));
+						//to compute we take the nearest point to the query point as 'central' point
+						//warning: it should work in most of the cases, apart if the core points have nothing to do
+						//with the global cloud!!!
+						unsigned lastIndex = subset.size() - 1;
+						subset.swap(0, lastIndex);
+
+						//temporarily remove the central point (now at the end)
+						unsigned globalIndex = subset.getPointGlobalIndex(lastIndex);
+						subset.resize(lastIndex);
+
+						CCCoreLib::Neighbourhood Z(&subset);
+						const PointCoordinateType* lsPlane = Z.getLSPlane();
+						if (lsPlane)
+						{
+							//distance to the LS plane fitted on the nearest neighbors
+							const CCVector3* centralPoint = params.sourceCloud->getPoint(globalIndex);
+							roughness = std::abs(CCCoreLib::DistanceComputationTools::computePoint2PlaneDistance(centralPoint, lsPlane));
+						}
+
+						//put back the point at its original place!
+						subset.addPointIndex(globalIndex);
+						subset.swap(0, lastIndex);
 					}
 
-					//put back the point at its original place!
-					subset.addPointIndex(globalIndex);
-					subset.swap(0, lastIndex);
+					assert(params.roughnessSFs->size() == scaleCount);
+					ccScalarField* sf = params.roughnessSFs->at(i);
+					assert(sf && sf->currentSize() > index);
+					sf->setValue(index, roughness);
 				}
 
-				assert(s_computeCorePointsDescParams.roughnessSFs->size() == scaleCount);
-				ccScalarField* sf = s_computeCorePointsDescParams.roughnessSFs->at(i);
-				assert(sf && sf->currentSize() > index);
-				sf->setValue(index, roughness);
-			}
-
-			bool invalidScale = false;
-			s_computeCorePointsDescParams.computer->computeScaleParams(subset, radius, &(desc.params[i*dimPerScale]), invalidScale);
+				bool invalidScale = false;
+				float* scaleParams = &(desc.params[i * dimPerScale]);
+				if (useCovariance)
+				{
+					computer->computeScaleParamsFromCovariance(covariances.data() + 6 * i, static_cast<unsigned>(scaleCounts[i]), radius, scaleParams, invalidScale);
+				}
+				else
+				{
+					computer->computeScaleParams(subset, radius, scaleParams, invalidScale);
+				}
 
-			if (invalidScale)
-			{
-				s_computeCorePointsDescParams.invalidDescriptors = true;
-				//no need to compute the remaining scales!
-				for (size_t j = i + 1; j < scaleCount; ++j)
+				if (invalidScale)
 				{
-					//copy the same parameters for all scales (see CANUPO paper)
-					memcpy(&(desc.params[j*dimPerScale]), &(desc.params[i*dimPerScale]), sizeof(float)*dimPerScale);
+					params.invalidDescriptors = true;
+					//no need to compute the remaining scales!
+					for (size_t j = i + 1; j < scaleCount; ++j)
+					{
+						//copy the same parameters for all scales (see CANUPO paper)
+						memcpy(&(desc.params[j * dimPerScale]), scaleParams, sizeof(float) * dimPerScale);
+					}
+					break;
 				}
-				//neighbours.clear();
-				//subset.clear(true);
-				break;
 			}
 		}
 	}
-	else
+	catch (const std::bad_alloc&)
 	{
-		//if the widest neighborhood has less than 3 points, we can't compute a valid descriptor!
-		s_computeCorePointsDescParams.invalidDescriptors = true;
+		//not enough memory!
+		params.errorOccurred = true;
+		params.processCanceled = true; //to make the loop stop!
+		return;
 	}
-	
+
 	//progress notification
-	if (s_computeCorePointsDescParams.nProgress && !s_computeCorePointsDescParams.nProgress->oneStep())
+	if (params.nProgress && !params.nProgress->steps(static_cast<unsigned>(batchSize)))
 	{
-		s_computeCorePointsDescParams.processCanceled = true;
+		params.processCanceled = true;
 	}
 }
 
@@ -229,20 +381,20 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	}
 
 	//descriptor (computer)
-	s_computeCorePointsDescParams.computer = ScaleParamsComputer::GetByID(descriptorID);
-	if (!s_computeCorePointsDescParams.computer)
+	ScaleParamsComputer* computer = ScaleParamsComputer::GetByID(descriptorID);
+	if (!computer)
 	{
 		error = QString("Unhandled descriptor ID (%1)!").arg(descriptorID);
 		return false;
 	}
-	if (s_computeCorePointsDescParams.computer->needSF() && !corePoints->enableScalarField())
+	if (computer->needSF() && !corePoints->enableScalarField())
 	{
 		error = "Couldn't allocate a scalar field for core points!";
 		return false;
 	}
 
 	corePointsDescriptors.setDescriptorID(descriptorID);
-	corePointsDescriptors.setDimPerScale(s_computeCorePointsDescParams.computer->dimPerScale());
+	corePointsDescriptors.setDimPerScale(computer->dimPerScale());
 
 	CCCoreLib::DgmOctree* theOctree = inputOctree;
 	if (!theOctree)
@@ -289,19 +441,31 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 		return false;
 	}
 
-	PointCoordinateType biggestRadius = sortedScales.front() / 2; //we extract the biggest neighborhood
-	unsigned char octreeLevel = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(biggestRadius);
+	ComputeCorePointsDescParams params;
+	params.corePoints = corePoints;
+	params.descriptors = &corePointsDescriptors;
+	params.sourceCloud = sourceCloud;
+	params.octree = theOctree;
+	params.computer = computer;
+	params.nProgress = progressCb ? &nProgress : nullptr;
+	params.roughnessSFs = roughnessSFs;
+
+	//we group the core points by cells of half the biggest radius
+	PointCoordinateType biggestRadius = sortedScales.front() / 2;
+	PointCoordinateType batchCellSize = biggestRadius / 2;
+	if (!ccCloudBatches::BuildGridBatches(params.corePoints, batchCellSize, params.sortedIndexes, params.batchStarts))
+	{
+		error = "Not enough memory to compute core points!";
+		if (progressCb)
+			progressCb->stop();
+		if (!inputOctree)
+			delete theOctree;
+		return false;
+	}
+	unsigned batchCount = static_cast<unsigned>(params.batchStarts.size() - 1);
 
-	s_computeCorePointsDescParams.corePoints = corePoints;
-	s_computeCorePointsDescParams.descriptors = &corePointsDescriptors;
-	s_computeCorePointsDescParams.sourceCloud = sourceCloud;
-	s_computeCorePointsDescParams.octree = theOctree;
-	s_computeCorePointsDescParams.octreeLevel = octreeLevel;
-	s_computeCorePointsDescParams.nProgress = progressCb ? &nProgress : nullptr;
-	s_computeCorePointsDescParams.processCanceled = false;
-	s_computeCorePointsDescParams.errorOccurred = false;
-	s_computeCorePointsDescParams.invalidDescriptors = false;
-	s_computeCorePointsDescParams.roughnessSFs = roughnessSFs;
+	//we extract the biggest neighborhood (around each batch)
+	params.octreeLevel = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(biggestRadius + batchCellSize * static_cast<PointCoordinateType>(sqrt(3.0) / 2));
 
 	//we try the parallel way (if we have enough memory)
 	bool useParallelStrategy = true;
@@ -309,12 +473,12 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	useParallelStrategy = false;
 #endif
 
-	std::vector<unsigned> corePointsIndexes;
+	std::vector<unsigned> batchIndexes;
 	if (useParallelStrategy)
 	{
 		try
 		{
-			corePointsIndexes.resize(corePtsCount);
+			batchIndexes.resize(batchCount);
 		}
 		catch (const std::bad_alloc&)
 		{
@@ -325,9 +489,9 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 
 	if (useParallelStrategy)
 	{
-		for (unsigned i = 0; i < corePtsCount; ++i)
+		for (unsigned i = 0; i < batchCount; ++i)
 		{
-			corePointsIndexes[i] = i;
+			batchIndexes[i] = i;
 		}
 
 		if (maxThreadCount == 0)
@@ -336,37 +500,25 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 		}
 		assert(maxThreadCount <= QThread::idealThreadCount());
 		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-		QtConcurrent::blockingMap(corePointsIndexes, ComputeCorePointDescriptor);
+		QtConcurrent::blockingMap(batchIndexes, [&params](unsigned batchIndex) { ComputeBatchDescriptors(batchIndex, params); });
 	}
 	else
 	{
-		//manually call the static per-point method!
-		for (unsigned i = 0; i < corePtsCount; ++i)
+		//manually call the per-batch method!
+		for (unsigned i = 0; i < batchCount; ++i)
 		{
-			ComputeCorePointDescriptor(i);
+			ComputeBatchDescriptors(i, params);
 		}
 	}
 
 	//output flags
-	bool wasCanceled = s_computeCorePointsDescParams.processCanceled;
-	bool errorOccurred = s_computeCorePointsDescParams.errorOccurred;
+	bool wasCanceled = params.processCanceled;
+	bool errorOccurred = params.errorOccurred;
 	if (errorOccurred)
 		error = "An error occurred during descriptors computation!";
 	else if (wasCanceled)
 		error = "Process has been cancelled by the user";
-	invalidDescriptors = s_computeCorePointsDescParams.invalidDescriptors;
-
-	//reset static parameters (just to be clean ;)
-	s_computeCorePointsDescParams.corePoints = nullptr;
-	s_computeCorePointsDescParams.descriptors = nullptr;
-	s_computeCorePointsDescParams.sourceCloud = nullptr;
-	s_computeCorePointsDescParams.octree = nullptr;
-	s_computeCorePointsDescParams.octreeLevel = 0;
-	s_computeCorePointsDescParams.nProgress = nullptr;
-	s_computeCorePointsDescParams.processCanceled = false;
-	s_computeCorePointsDescParams.errorOccurred = false;
-	s_computeCorePointsDescParams.invalidDescriptors = false;
-	s_computeCorePointsDescParams.computer = nullptr;
+	invalidDescriptors = params.invalidDescriptors;
 
 	if (progressCb)
 	{
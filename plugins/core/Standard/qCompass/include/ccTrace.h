@@ -42,6 +42,7 @@
 #include <vector>
 #include <algorithm>
 #include <deque>
+#include <unordered_map>
 
 /*
 A ccTrace object is essentially a ccPolyline that is controlled/created by "waypoints" and a least-cost path algorithm
@@ -131,6 +132,7 @@ public:
 
 	/*
 	Calculates the most "structure-like" path between each waypoint using the A* least cost path algorithm. Can be expensive...
+	The heuristic is the minimum number of steps (of length search_r) to the end point, times the minimum segment cost.
 
 	@Args
 	*maxIterations* = the maximum number of search iterations that are run before the algorithm gives up. Default is lots.
@@ -201,6 +203,9 @@ protected:
 	//contains grunt of shortest path algorithm. "offset" inserts points at the specified distance from the END of the trace (used for updating)
 	std::deque<int> optimizeSegment(int start, int end, int offset = 0);
 
+	//same as getSegmentCost, but relies on the cost terms resolved by updateCostTerms (i.e. once per search)
+	int computeSegmentCost(int p1, int p2);
+
 	//specific cost algorithms (getSegmentCost(...) sums combinations of these depending on the COST_MODE flag.
 	//NOTE: to ensure each cost function makes an equal contribution to the result (when multiples are being used), each
 	//      returns a value between 0 and 765 (the maximum  r + g + bvalue), with the exception of 
@@ -228,38 +233,41 @@ protected:
 
 private:
 
-	//class for storing point index & path costs (from the path start) in sorted lists
-	class Node
+	//pooled A* search node (point index & path cost from the path start)
+	struct Node
 	{
-	public:
-
-		void set(int node_index, int node_total_cost, Node* prev_node)
-		{
-			index = node_index;
-			total_cost = node_total_cost;
-			previous = prev_node;
-		}
-
 		int index = -1;
 		int total_cost = 0;
-		Node* previous = nullptr;
+		int previous = -1; //index of the previous node in the pool
+		bool closed = false;
 	};
 
-	//class for comparing Node pointers in priority_queue
-	class Compare
+	//entry of the A* open set (sorted by estimated total cost)
+	struct OpenNode
 	{
-	public:
+		int estimated_cost;
+		int node; //index of the node in the pool
 
-		bool operator() (Node* t1, Node* t2)
-		{
-			//n.b. the priority queue puts "higher" priorities at the front of the queue.
-			//in this case, lower total_cost = "higher priority"
-			//hence we compare total_cost with the > operator
-			//i.e. t1 is less important than t2 if this.total_cost > t1.total_cost 
-			return t1->total_cost > t2->total_cost; //compare based on cost
-		}
+		//n.b. used with std::greater to get a min-heap
+		bool operator> (const OpenNode& other) const { return estimated_cost > other.estimated_cost; }
 	};
 
+	//A* buffers (kept between searches to avoid reallocations)
+	std::vector<Node> m_nodePool;
+	std::vector<OpenNode> m_openSet;
+	std::unordered_map<int, int> m_pointToNode;
+
+	//cost terms, resolved once before each search (see updateCostTerms)
+	ccScalarField* m_gradientSF = nullptr;
+	ccScalarField* m_curvatureSF = nullptr;
+	ccScalarField* m_displayedSF = nullptr;
+	ScalarType m_gradientMax = 0;
+	ScalarType m_curvatureMax = 0;
+	int m_minSegmentCost = 1; //lower bound of getSegmentCost (used by the A* heuristic)
+
+	//resolves the scalar fields used by the cost functions (and the min segment cost)
+	void updateCostTerms();
+
 	//random vars that we keep to optimise speed
 	int m_start_rgb[3];
 	int m_end_rgb[3]; //[r,g,b] values for start and end nodes
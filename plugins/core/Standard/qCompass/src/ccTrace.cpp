@@ -19,9 +19,49 @@
 
 #include <GeometricalAnalysisTools.h>
 
+#include <ccQtHelpers.h>
+
 #include <QMessageBox>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <functional>
+
+//applies a function to each point index of a cloud (in parallel, by chunks)
+template <class Function> static void ForEachPoint(unsigned pointCount, Function func)
+{
+	static const unsigned c_chunkSize = 65536;
+
+	std::vector<unsigned> chunkStarts;
+	for (unsigned start = 0; start < pointCount; start += c_chunkSize)
+	{
+		chunkStarts.push_back(start);
+	}
+
+	auto processChunk = [&](unsigned start)
+	{
+		unsigned stop = std::min(start + c_chunkSize, pointCount);
+		for (unsigned i = start; i < stop; ++i)
+		{
+			func(i);
+		}
+	};
 
-#include <queue>
+#ifndef _DEBUG
+	if (chunkStarts.size() > 1)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(ccQtHelpers::GetMaxThreadCount());
+		QtConcurrent::blockingMap(chunkStarts, processChunk);
+	}
+	else
+#endif
+	{
+		for (unsigned start : chunkStarts)
+		{
+			processChunk(start);
+		}
+	}
+}
 
 ccTrace::ccTrace(ccPointCloud* associatedCloud) : ccPolyline(associatedCloud)
 {
@@ -321,149 +361,159 @@ std::deque<int> ccTrace::optimizeSegment(int start, int end, int offset)
 	//get location of target node - used to optimise algorithm to stop searching paths leading away from the target
 	const CCVector3* end_v = m_cloud->getPoint(end);
 
-	//code essentially taken from wikipedia page for Djikstra: https://en.wikipedia.org/wiki/Dijkstra%27s_algorithm
-	std::vector<bool> visited; //an array of bits to check if node has been visited
-	std::priority_queue<Node*,std::vector<Node*>,Compare> openQueue; //priority queue that stores nodes that haven't yet been explored/opened
-	std::vector<Node*> nodes; //list of visited nodes. Used to cleanup memory after re-constructing shortest path.
-
-	//set size of visited such that there is one bit per point in the cloud
-	visited.resize(m_cloud->size(), false); //n.b. for 400 million points, this will still only be ~50Mb =)
+	//resolve the cost terms once (instead of for each segment cost)
+	updateCostTerms();
 
-	//declare variables used in the loop
-	Node* current = nullptr;
-	int current_idx = 0;
-	int cost = 0;
-	int smallest_cost = 999999;
-	int iter_count = 0;
-	float cur_d2 = 0.0f;
-	float next_d2 = 0.0f;
+	//A* search: https://en.wikipedia.org/wiki/A*_search_algorithm
+	//n.b. a step can't be longer than the search radius, and can't cost less than m_minSegmentCost,
+	//hence the heuristic below never over-estimates the remaining cost (and the path is still optimal)
+	const float inv_search_r = 1.0f / m_search_r;
+	auto heuristic = [&](const CCVector3& P) -> int
+	{
+		return static_cast<int>((P - *end_v).norm() * inv_search_r) * m_minSegmentCost;
+	};
 
-	//setup buffer for storing nodes
-	int bufferSize = 500000; //500k node buffer (~1.5-2Mb). This should be enough for most small-medium size traces. More buffers will be created for bigger ones.
-	Node* node_buffer = new Node[bufferSize]; 
-	nodes.push_back(node_buffer); //store buffer in nodes list (for cleanup)
-	int nodeCount = 1; //start node will be added shortly
+	//the buffers are kept between searches (only their content is cleared)
+	m_nodePool.clear();
+	m_openSet.clear();
+	m_pointToNode.clear();
+	std::greater<OpenNode> openSetCompare;
 
 	//setup octree & values for nearest neighbour searches
 	ccOctree::Shared oct = m_cloud->getOctree();
 	if (!oct)
 	{
 		oct = m_cloud->computeOctree(); //if the user clicked "no" when asked to compute the octree then tough....
+		if (!oct)
+		{
+			return std::deque<int>(); //not enough memory
+		}
 	}
 	unsigned char level = oct->findBestLevelForAGivenNeighbourhoodSizeExtraction(m_search_r);
 
-	//initialize start node on node_buffer and add to openQueue
-	node_buffer[0].set(start, 0, nullptr);
-	openQueue.push(&node_buffer[0]);
+	//initialize start node and add it to the open set
+	try
+	{
+		m_nodePool.push_back({ start, 0, -1, false });
+		m_pointToNode[start] = 0;
+		m_openSet.push_back({ heuristic(*m_cloud->getPoint(start)), 0 });
+	}
+	catch (const std::bad_alloc&)
+	{
+		return std::deque<int>(); //not enough memory
+	}
 
-	//mark start node as visited
-	visited[start] = true;
+	//declare variables used in the loop
+	int iter_count = 0;
+	float cur_d2 = 0.0f;
+	float next_d2 = 0.0f;
 
-	while (openQueue.size() > 0) //while unvisited nodes exist
+	while (!m_openSet.empty()) //while unexplored nodes exist
 	{
 		//check if we excede max iterations
 		if (iter_count > m_maxIterations)
 		{
-			//cleanup buffers
-			for (Node* n : nodes)
-			{
-				delete[] n;
-			}
-
-			//bail
 			return std::deque<int>(); //bail
 		}
 
-		iter_count++;
+		//get lowest (estimated) cost node for expansion & remove it from the open set
+		std::pop_heap(m_openSet.begin(), m_openSet.end(), openSetCompare);
+		int currentNode = m_openSet.back().node;
+		m_openSet.pop_back();
+
+		if (m_nodePool[currentNode].closed)
+		{
+			continue; //outdated entry (this node has already been reached with a lower cost)
+		}
+		m_nodePool[currentNode].closed = true;
 
-		//get lowest cost node for expansion
-		current = openQueue.top();
-		current_idx = current->index;
+		iter_count++;
 
-		//remove node from open set
-		openQueue.pop(); //remove node from open set (queue)
+		//n.b. don't keep a reference on the node (the pool may be reallocated below)
+		int current_idx = m_nodePool[currentNode].index;
+		int current_cost = m_nodePool[currentNode].total_cost;
 
 		if (current_idx == end) //we've found it!
 		{
 			std::deque<int> path;
-			path.push_back(end); //add end node
 
 			//traverse backwards to reconstruct path
-			while (current->index != start)
+			for (int n = currentNode; n >= 0; n = m_nodePool[n].previous)
 			{
-				current = current->previous;
-				path.push_front(current->index);
+				path.push_front(m_nodePool[n].index);
 			}
 
 			path.push_front(start);
 
-			//cleanup node buffers
-			for (Node* n : nodes)
-			{
-				delete[] n;
-			}
-
 			//return
 			return path;
 		}
 
 		//calculate distance from current nodes parent to end -> avoid going backwards (in euclidean space) [essentially stops fracture turning > 90 degrees)
 		const CCVector3* cur = m_cloud->getPoint(current_idx);
-		cur_d2 =	(cur->x - end_v->x)*(cur->x - end_v->x) +
-					(cur->y - end_v->y)*(cur->y - end_v->y) +
-					(cur->z - end_v->z)*(cur->z - end_v->z);
+		cur_d2 = (*cur - *end_v).norm2();
 
 		//fill "neighbours" with nodes - essentially get results of a "sphere" search around active current point
 		m_neighbours.clear();
-    
 		oct->getPointsInSphericalNeighbourhood(*cur, PointCoordinateType(m_search_r), m_neighbours, level);
 
 		//loop through neighbours
 		for (size_t i = 0; i < m_neighbours.size(); i++)
 		{
 			m_p = m_neighbours[i];
-			
-			if (visited[m_p.pointIndex]) //Has this node been visited before? If so then bail.
-				continue;
 
 			//calculate (squared) distance from this neighbour to the end
-			next_d2 =	(m_p.point->x - end_v->x)*(m_p.point->x - end_v->x) +
-						(m_p.point->y - end_v->y)*(m_p.point->y - end_v->y) +
-						(m_p.point->z - end_v->z)*(m_p.point->z - end_v->z);
+			next_d2 = (*m_p.point - *end_v).norm2();
 
 			if (next_d2 >= cur_d2) //Bigger than the original distance? If so then bail.
 				continue;
 
+			//Has this node already been explored? If so then bail.
+			int pointIndex = static_cast<int>(m_p.pointIndex);
+			auto it = m_pointToNode.find(pointIndex);
+			if (it != m_pointToNode.end() && m_nodePool[it->second].closed)
+				continue;
+
 			//calculate cost to this neighbour
-			cost = getSegmentCost(current_idx, m_p.pointIndex);
+			int cost = computeSegmentCost(current_idx, pointIndex);
 
 			#ifdef DEBUG_PATH
 			m_cloud->setPointScalarValue(m_p.pointIndex, static_cast<ScalarType>(cost)); //STORE VISITED NODES (AND COST) FOR DEBUG VISUALISATIONS
 			#endif
 
 			//transform into cost from start node
-			cost += current->total_cost;
+			cost += current_cost;
 
-			//check that the node buffer isn't full
-			if (nodeCount == bufferSize)
+			int nodeIndex = -1;
+			try
 			{
-				//buffer is full - create a new one
-				node_buffer = new Node[bufferSize];
-				nodes.push_back(node_buffer);
-				nodeCount = 0;
-			}
-
-			//initialize node on node buffer
-			node_buffer[nodeCount].set(m_p.pointIndex, cost, current);
-
-			//push node to open set
-			openQueue.push(&node_buffer[nodeCount]);
-
-			//we now have one more node
-			nodeCount++;
+				if (it == m_pointToNode.end())
+				{
+					//new node
+					nodeIndex = static_cast<int>(m_nodePool.size());
+					m_nodePool.push_back({ pointIndex, cost, currentNode, false });
+					m_pointToNode[pointIndex] = nodeIndex;
+				}
+				else if (cost < m_nodePool[it->second].total_cost)
+				{
+					//cheaper path to an already opened node
+					nodeIndex = it->second;
+					m_nodePool[nodeIndex].total_cost = cost;
+					m_nodePool[nodeIndex].previous = currentNode;
+				}
+				else
+				{
+					continue;
+				}
 
-			//mark node as visited
-			visited[m_p.pointIndex] = true;
+				//push node to open set
+				m_openSet.push_back({ cost + heuristic(*m_p.point), nodeIndex });
+				std::push_heap(m_openSet.begin(), m_openSet.end(), openSetCompare);
+			}
+			catch (const std::bad_alloc&)
+			{
+				return std::deque<int>(); //not enough memory
+			}
 		}
 	}
 
@@ -473,7 +523,54 @@ std::deque<int> ccTrace::optimizeSegment(int start, int end, int offset)
 	return {};
 }
 
+void ccTrace::updateCostTerms()
+{
+	m_gradientSF = nullptr;
+	m_curvatureSF = nullptr;
+	m_displayedSF = nullptr;
+	m_gradientMax = 0;
+	m_curvatureMax = 0;
+	m_minSegmentCost = 1; //see getSegmentCost
+
+	if (!m_cloud)
+	{
+		return;
+	}
+
+	int idx = m_cloud->getScalarFieldIndexByName("Gradient"); //look for pre-existing gradient SF
+	if (idx != -1)
+	{
+		m_gradientSF = static_cast<ccScalarField*>(m_cloud->getScalarField(idx));
+		m_gradientMax = m_gradientSF->getMax();
+	}
+
+	idx = m_cloud->getScalarFieldIndexByName("Curvature"); //look for pre-existing curvature SF
+	if (idx != -1)
+	{
+		m_curvatureSF = static_cast<ccScalarField*>(m_cloud->getScalarField(idx));
+		m_curvatureMax = m_curvatureSF->getMax();
+	}
+
+	if (m_cloud->hasDisplayedScalarField())
+	{
+		m_displayedSF = static_cast<ccScalarField*>(m_cloud->getCurrentDisplayedScalarField());
+	}
+
+	//all the other cost functions can return 0
+	if (COST_MODE & MODE::DISTANCE)
+	{
+		m_minSegmentCost += getSegmentCostDist(0, 0);
+	}
+}
+
 int ccTrace::getSegmentCost(int p1, int p2)
+{
+	updateCostTerms();
+
+	return computeSegmentCost(p1, p2);
+}
+
+int ccTrace::computeSegmentCost(int p1, int p2)
 {
 	if (!m_cloud)
 	{
@@ -492,7 +589,7 @@ int ccTrace::getSegmentCost(int p1, int p2)
 		if (COST_MODE & MODE::GRADIENT)
 			cost += getSegmentCostGrad(p1, p2, m_search_r);
 	}
-	if (m_cloud->hasDisplayedScalarField()) //check cloud has scalar field data
+	if (m_displayedSF) //check cloud has scalar field data
 	{
 		if (COST_MODE & MODE::SCALAR)
 			cost += getSegmentCostScalar(p1, p2);
@@ -573,14 +670,10 @@ int ccTrace::getSegmentCostCurve(int p1, int p2)
 		return 0;
 	}
 
-	int idx = m_cloud->getScalarFieldIndexByName("Curvature"); //look for pre-existing gradient SF
-	if (isCurvaturePrecomputed()) //scalar field found - return from precomputed cost]
+	if (m_curvatureSF) //scalar field found - return from precomputed cost (see updateCostTerms)
 	{
-		//activate SF
-		m_cloud->setCurrentScalarField(idx);
-
 		//return inverse of p2 value
-		return m_cloud->getScalarField(idx)->getMax() - m_cloud->getPointScalarValue(p2);
+		return m_curvatureMax - m_curvatureSF->getValue(p2);
 	}
 	else //scalar field not found - do slow calculation...
 	{
@@ -619,14 +712,10 @@ int ccTrace::getSegmentCostGrad(int p1, int p2, float search_r)
 		return 0;
 	}
 
-	int idx = m_cloud->getScalarFieldIndexByName("Gradient"); //look for pre-existing gradient SF
-	if (idx != -1) //found precomputed gradient
+	if (m_gradientSF) //found precomputed gradient (see updateCostTerms)
 	{
-		//activate SF
-		m_cloud->setCurrentScalarField(idx);
-
 		//return inverse of p2 value
-		return m_cloud->getScalarField(idx)->getMax() - m_cloud->getPointScalarValue(p2);
+		return m_gradientMax - m_gradientSF->getValue(p2);
 	}
 	else //not found... do expensive calculation
 	{
@@ -690,8 +779,7 @@ int ccTrace::getSegmentCostScalar(int p1, int p2)
 		return 0;
 	}
 
-	//m_cloud->getCurrentDisplayedScalarFieldIndex();
-	ccScalarField* sf = static_cast<ccScalarField*>(m_cloud->getCurrentDisplayedScalarField());
+	ccScalarField* sf = m_displayedSF; //see updateCostTerms
 	if (!sf)
 	{
 		assert(false);
@@ -707,7 +795,7 @@ int ccTrace::getSegmentCostScalarInv(int p1, int p2)
 		return 0;
 	}
 
-	ccScalarField* sf = static_cast<ccScalarField*>(m_cloud->getCurrentDisplayedScalarField());
+	ccScalarField* sf = m_displayedSF; //see updateCostTerms
 	if (!sf)
 	{
 		assert(false);
@@ -735,11 +823,17 @@ void ccTrace::buildGradientCost(QWidget* parent)
 	m_cloud->setCurrentScalarField(idx);
 
 	//make colours greyscale and push to SF (otherwise copy active SF)
-	for (unsigned i = 0; i < m_cloud->size(); i++)
+	CCCoreLib::ScalarField* greySF = m_cloud->getScalarField(idx);
+	auto setGreyValue = [&](unsigned i)
 	{
 		const ccColor::Rgb& col = m_cloud->getPointColor(i);
-		m_cloud->setPointScalarValue(i, static_cast<ScalarType>((static_cast<int>(col.r) + col.g) + col.b));
+		greySF->setValue(i, static_cast<ScalarType>((static_cast<int>(col.r) + col.g) + col.b));
+	};
+	if (m_cloud->size() != 0)
+	{
+		setGreyValue(0); //the first value is set beforehand, as it may initialize the scalar field offset
 	}
+	ForEachPoint(m_cloud->size(), setGreyValue);
 	//compute min/max
 	m_cloud->getScalarField(idx)->computeMinAndMax();
 
@@ -788,14 +882,15 @@ void ccTrace::buildGradientCost(QWidget* parent)
 	
 	//normalize and log-transform
 	m_cloud->setCurrentScalarField(gIdx);
-	float logMax = log(m_cloud->getScalarField(gIdx)->getMax() + 10);
-	for (unsigned i = 0; i < m_cloud->size(); i++)
+	CCCoreLib::ScalarField* gradientSF = m_cloud->getScalarField(gIdx);
+	float logMax = log(gradientSF->getMax() + 10);
+	ForEachPoint(m_cloud->size(), [&](unsigned i)
 	{
-		int nVal = 765 * log(m_cloud->getPointScalarValue(i) + 10) / logMax;
+		int nVal = 765 * log(gradientSF->getValue(i) + 10) / logMax;
 		if (nVal < 0) //this is caused by isolated points that were assigned "null" value gradients
 			nVal = 1; //set to low gradient by default
-		m_cloud->setPointScalarValue(i, nVal);
-	}
+		gradientSF->setValue(i, nVal);
+	});
 
 	//recompute min-max...
 	m_cloud->getScalarField(gIdx)->computeMinAndMax();
@@ -852,14 +947,15 @@ void ccTrace::buildCurvatureCost(QWidget* parent)
 	m_cloud->getScalarField(idx)->computeMinAndMax();
 
 	//normalize and log-transform
-	float logMax = log(m_cloud->getScalarField(idx)->getMax() + 10);
-	for (unsigned i = 0; i < m_cloud->size(); i++)
+	CCCoreLib::ScalarField* curvatureSF = m_cloud->getScalarField(idx);
+	float logMax = log(curvatureSF->getMax() + 10);
+	ForEachPoint(m_cloud->size(), [&](unsigned i)
 	{
-		int nVal = 765 * log(m_cloud->getPointScalarValue(i) + 10) / logMax;
+		int nVal = 765 * log(curvatureSF->getValue(i) + 10) / logMax;
 		if (nVal < 0) //this is caused by isolated points that were assigned "null" value curvatures
 			nVal = 1; //set to low gradient by default
-		m_cloud->setPointScalarValue(i, nVal);
-	}
+		curvatureSF->setValue(i, nVal);
+	});
 
 	//recompute min-max...
 	m_cloud->getScalarField(idx)->computeMinAndMax();
@@ -0,0 +1,37 @@
+//##########################################################################
+//#                                                                        #
+//#                     CLOUDCOMPARE PLUGIN: qFacets                       #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                      COPYRIGHT: Thomas Dewez, BRGM                     #
+//#                                                                        #
+//##########################################################################
+
+#ifndef QFACETS_COMMAND_HEADER
+#define QFACETS_COMMAND_HEADER
+
+#include "ccCommandLineInterface.h"
+
+//! Facets extraction command (-FACETS)
+/** The facets of each loaded cloud are always saved (as a group), as the
+	command line only keeps track of clouds and meshes.
+**/
+class FacetsCommand : public ccCommandLineInterface::Command
+{
+public:
+	FacetsCommand();
+
+	~FacetsCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+#endif //QFACETS_COMMAND_HEADER
@@ -46,6 +46,32 @@ public:
 							bool closestFirst = true,
 							CCCoreLib::GenericProgressCallback* progressCb = nullptr);
 
+	//! Fuses cells (parallel union-find strategy)
+	/** Creates a new scalar fields with the groups indexes.
+		All the pairs of neighbor cells are tested in parallel (same angle, distance and
+		error criteria as FuseCells). The compatible pairs are then merged by increasing
+		error, as long as the merged sets remain planar (i.e. the angle between their
+		normals is below maxAngle_deg and their error is below maxError). The RMS is
+		estimated from the aggregated moments of both sets. The other error measures
+		are bounded by a conservative estimate of the max distance (from the extents of
+		both sets): the points of the merged set are only checked if this bound exceeds
+		maxError (in which case the cost is linear in the size of the merged set).
+		\param kdTree Kd-tree
+		\param maxError max error after fusion (see errorMeasure)
+		\param errorMeasure error measure type
+		\param maxAngle_deg maximum angle between two sets to allow fusion (in degrees)
+		\param overlapCoef maximum relative distance between two sets to accept fusion (1 = no distance, < 1 = overlap, > 1 = gap)
+		\param maxThreadCount max number of threads (0 = all)
+		\param progressCb for progress notifications (optional)
+	**/
+	static bool FuseCellsUnionFind(	ccKdTree* kdTree,
+									double maxError,
+									CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+									double maxAngle_deg,
+									PointCoordinateType overlapCoef = 1,
+									int maxThreadCount = 0,
+									CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
 };
 
 #endif //QFACET_KD_TREE_BASED_FACET_EXTRACTION_HEADER
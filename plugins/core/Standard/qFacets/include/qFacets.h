@@ -29,6 +29,7 @@
 
 //CCCoreLib
 #include <AutoSegmentationTools.h>
+#include <DistanceComputationTools.h>
 #include <ReferenceCloud.h>
 
 //System
@@ -63,6 +64,51 @@ public:
 	//inherited from ccStdPluginInterface
 	virtual void onNewSelection(const ccHObject::Container& selectedEntities) override;
 	virtual QList<QAction *> getActions() override;
+	virtual void registerCommands(ccCommandLineInterface* cmd) override;
+
+	//! Facet extraction parameters
+	struct ExtractionParams
+	{
+		//! Cells fusion algorithm
+		CellsFusionDlg::Algorithm algo = CellsFusionDlg::ALGO_KD_TREE;
+		//! Octree level (Fast Marching only)
+		unsigned char octreeLevel = 8;
+		//! Whether to use the retro-projection error (Fast Marching only)
+		bool useRetroProjectionError = false;
+		//! Min number of points per facet
+		unsigned minPointsPerFacet = 10;
+		//! Max error per facet
+		double errorMaxPerFacet = 0.2;
+		//! Error measure
+		CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure = CCCoreLib::DistanceComputationTools::MAX_DIST_99_PERCENT;
+		//! Max angle between cells (Kd-tree only)
+		double kdTreeFusionMaxAngle_deg = 20.0;
+		//! Max relative distance between cells (Kd-tree only)
+		double kdTreeFusionMaxRelativeDistance = 1.0;
+		//! Whether to use the parallel union-find fusion (Kd-tree only)
+		bool kdTreeUnionFindFusion = false;
+		//! Max edge length of the facets contours
+		double maxEdgeLength = 1.0;
+		//! Max number of threads (0 = all)
+		int maxThreadCount = 0;
+	};
+
+	//! Extracts planar facets from a cloud
+	/** \param cloud input cloud
+		\param params extraction parameters
+		\param error whether an error occurred during the creation of the facets (result may be incomplete)
+		\param errorMessage error message (if the process failed)
+		\param progressCb progress callback (optional)
+		\return a group containing the facets (or nullptr if no facet could be extracted)
+	**/
+	static ccHObject* ExtractFacets(ccPointCloud* cloud,
+	                                const ExtractionParams& params,
+	                                bool& error,
+	                                QString& errorMessage,
+	                                CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Converts an 'error measure' combo-box index to the corresponding enum
+	static CCCoreLib::DistanceComputationTools::ERROR_MEASURES ErrorMeasureFromIndex(int index);
 
 protected:
 
@@ -90,12 +136,16 @@ protected:
 	void extractFacets(CellsFusionDlg::Algorithm algo);
 
 	//! Creates facets from components
-	ccHObject* createFacets(ccPointCloud* cloud,
-	                        CCCoreLib::ReferenceCloudContainer& components,
-	                        unsigned minPointsPerComponent,
-	                        double maxEdgeLength,
-	                        bool randomColors,
-	                        bool& error);
+	/** The facets are created in parallel. The components are released.
+	**/
+	static ccHObject* CreateFacets(ccPointCloud* cloud,
+	                               CCCoreLib::ReferenceCloudContainer& components,
+	                               unsigned minPointsPerComponent,
+	                               double maxEdgeLength,
+	                               bool randomColors,
+	                               bool& error,
+	                               int maxThreadCount = 0,
+	                               CCCoreLib::GenericProgressCallback* progressCb = nullptr);
 
 	//! Set of facets (pointers)
 	typedef std::unordered_set<ccFacet*> FacetSet;
@@ -0,0 +1,283 @@
+//##########################################################################
+//#                                                                        #
+//#                     CLOUDCOMPARE PLUGIN: qFacets                       #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                      COPYRIGHT: Thomas Dewez, BRGM                     #
+//#                                                                        #
+//##########################################################################
+
+#include "FacetsCommand.h"
+
+//Local
+#include "qFacets.h"
+
+//qCC_db
+#include <ccOctree.h>
+#include <ccPointCloud.h>
+#include <ccProgressDialog.h>
+
+//Qt
+#include <QElapsedTimer>
+#include <QScopedPointer>
+
+constexpr char COMMAND_FACETS[] = "FACETS";
+constexpr char COMMAND_FACETS_ALGO[] = "ALGO";
+constexpr char COMMAND_FACETS_ALGO_KD_TREE[] = "KD_TREE";
+constexpr char COMMAND_FACETS_ALGO_FAST_MARCHING[] = "FAST_MARCHING";
+constexpr char COMMAND_FACETS_ERROR_MAX[] = "ERROR_MAX";
+constexpr char COMMAND_FACETS_ERROR_MEASURE[] = "ERROR_MEASURE";
+constexpr char COMMAND_FACETS_MAX_ANGLE[] = "MAX_ANGLE";
+constexpr char COMMAND_FACETS_MAX_REL_DIST[] = "MAX_REL_DIST";
+constexpr char COMMAND_FACETS_MIN_POINTS[] = "MIN_POINTS";
+constexpr char COMMAND_FACETS_MAX_EDGE_LENGTH[] = "MAX_EDGE_LENGTH";
+constexpr char COMMAND_FACETS_OCTREE_LEVEL[] = "OCTREE_LEVEL";
+constexpr char COMMAND_FACETS_UNION_FIND[] = "UNION_FIND";
+constexpr char COMMAND_FACETS_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
+
+FacetsCommand::FacetsCommand()
+	: Command("Facets", COMMAND_FACETS)
+{
+}
+
+bool FacetsCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[FACETS]");
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+
+	qFacets::ExtractionParams params;
+	bool customMaxEdgeLength = false;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_ALGO))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: algorithm after \"-%1\"").arg(COMMAND_FACETS_ALGO));
+			}
+			QString algo = cmd.arguments().takeFirst().toUpper();
+			if (algo == COMMAND_FACETS_ALGO_KD_TREE)
+			{
+				params.algo = CellsFusionDlg::ALGO_KD_TREE;
+			}
+			else if (algo == COMMAND_FACETS_ALGO_FAST_MARCHING)
+			{
+				params.algo = CellsFusionDlg::ALGO_FAST_MARCHING;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Invalid parameter: unknown algorithm \"%1\" (%2 or %3 expected)").arg(algo).arg(COMMAND_FACETS_ALGO_KD_TREE).arg(COMMAND_FACETS_ALGO_FAST_MARCHING));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_ERROR_MAX))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max error after \"-%1\"").arg(COMMAND_FACETS_ERROR_MAX));
+			}
+			bool conversionOk = false;
+			params.errorMaxPerFacet = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || params.errorMaxPerFacet <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_FACETS_ERROR_MAX));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_ERROR_MEASURE))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: error measure after \"-%1\"").arg(COMMAND_FACETS_ERROR_MEASURE));
+			}
+			bool conversionOk = false;
+			//same order as the dialog combo-box (0 = RMS, 1 = max dist @ 68%, 2 = @ 95%, 3 = @ 99%, 4 = max dist)
+			int index = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || index < 0 || index > 4)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\" (should be between 0 and 4)").arg(COMMAND_FACETS_ERROR_MEASURE));
+			}
+			params.errorMeasure = qFacets::ErrorMeasureFromIndex(index);
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_MAX_ANGLE))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max angle after \"-%1\"").arg(COMMAND_FACETS_MAX_ANGLE));
+			}
+			bool conversionOk = false;
+			params.kdTreeFusionMaxAngle_deg = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || params.kdTreeFusionMaxAngle_deg < 0 || params.kdTreeFusionMaxAngle_deg > 90.0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\" (should be between 0 and 90 degrees)").arg(COMMAND_FACETS_MAX_ANGLE));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_MAX_REL_DIST))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max relative distance after \"-%1\"").arg(COMMAND_FACETS_MAX_REL_DIST));
+			}
+			bool conversionOk = false;
+			params.kdTreeFusionMaxRelativeDistance = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || params.kdTreeFusionMaxRelativeDistance < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_FACETS_MAX_REL_DIST));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_MIN_POINTS))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: min points per facet after \"-%1\"").arg(COMMAND_FACETS_MIN_POINTS));
+			}
+			bool conversionOk = false;
+			params.minPointsPerFacet = cmd.arguments().takeFirst().toUInt(&conversionOk);
+			if (!conversionOk || params.minPointsPerFacet < 3)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\" (at least 3 points)").arg(COMMAND_FACETS_MIN_POINTS));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_MAX_EDGE_LENGTH))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max edge length after \"-%1\"").arg(COMMAND_FACETS_MAX_EDGE_LENGTH));
+			}
+			bool conversionOk = false;
+			params.maxEdgeLength = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || params.maxEdgeLength < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_FACETS_MAX_EDGE_LENGTH));
+			}
+			customMaxEdgeLength = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_OCTREE_LEVEL))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: octree level after \"-%1\"").arg(COMMAND_FACETS_OCTREE_LEVEL));
+			}
+			bool conversionOk = false;
+			int octreeLevel = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || octreeLevel < 1 || octreeLevel > CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_FACETS_OCTREE_LEVEL));
+			}
+			params.octreeLevel = static_cast<unsigned char>(octreeLevel);
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_UNION_FIND))
+		{
+			cmd.arguments().pop_front();
+			params.kdTreeUnionFindFusion = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_FACETS_MAX_THREAD_COUNT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after \"-%1\"").arg(COMMAND_FACETS_MAX_THREAD_COUNT));
+			}
+			bool conversionOk = false;
+			params.maxThreadCount = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || params.maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_FACETS_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	QScopedPointer<ccProgressDialog> progressDialog;
+	if (!cmd.silentMode())
+	{
+		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
+		progressDialog->setAutoClose(false);
+	}
+
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		ccPointCloud* cloud = desc.pc;
+		assert(cloud);
+
+		if (!customMaxEdgeLength)
+		{
+			//same default value as the dialog
+			params.maxEdgeLength = static_cast<double>(cloud->getOwnBB().getMinBoxDim()) / 50;
+		}
+
+		QElapsedTimer eTimer;
+		eTimer.start();
+
+		bool error = false;
+		QString errorMessage;
+		ccHObject* group = qFacets::ExtractFacets(cloud, params, error, errorMessage, progressDialog.data());
+
+		if (!group)
+		{
+			if (!errorMessage.isEmpty())
+			{
+				return cmd.error(errorMessage);
+			}
+			cmd.warning(QObject::tr("No facet extracted from cloud '%1'! Check the parameters (min size, etc.)").arg(cloud->getName()));
+			continue;
+		}
+		if (error)
+		{
+			cmd.warning(QObject::tr("Error(s) occurred during the generation of facets! Result may be incomplete"));
+		}
+
+		double elapsed_s = eTimer.elapsed() / 1.0e3;
+		unsigned count = group->getChildrenNumber();
+		cmd.print(QObject::tr("%1 facet(s) extracted from cloud '%2' in %3 s (%4 facets/s)")
+					.arg(count)
+					.arg(cloud->getName())
+					.arg(elapsed_s, 0, 'f', 3)
+					.arg(elapsed_s > 0 ? count / elapsed_s : 0.0, 0, 'f', 1));
+
+		//save the facets
+		CLGroupDesc groupDesc(group, desc.basename + QString("_FACETS"), desc.path);
+		QString errorStr = cmd.exportEntity(groupDesc, QString(), nullptr, ccCommandLineInterface::ExportOption::ForceHierarchy);
+		delete group;
+		group = nullptr;
+		if (!errorStr.isEmpty())
+		{
+			return cmd.error(errorStr);
+		}
+
+		//the cloud now has a 'facet indexes' scalar field
+		if (cmd.autoSaveMode())
+		{
+			errorStr = cmd.exportEntity(desc, "FACET_INDEXES");
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
+		}
+	}
+
+	return true;
+}
@@ -19,14 +19,25 @@
 
 //CCCoreLib
 #include <GenericProgressCallback.h>
+#include <Jacobi.h>
 #include <Neighbourhood.h>
 #include <ParallelSort.h>
 
 //qCC_db
 #include <ccPointCloud.h>
 
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
 //Qt
 #include <QApplication>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//System
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 
 //static bool AscendingLeafErrorComparison(const ccKdTree::Leaf* a, const ccKdTree::Leaf* b)
 //{
@@ -387,3 +398,563 @@ bool ccKdTreeForFacetExtraction::FuseCells(	ccKdTree* kdTree,
 
 	return !cancelled;
 }
+
+//! First and second order moments of a set of points
+struct Moments
+{
+	double n = 0;
+	double s[3] = { 0, 0, 0 };
+	double s2[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+
+	//! Adds a point (coordinates should be expressed relatively to a common reference)
+	void add(const CCVector3d& P)
+	{
+		n += 1.0;
+		for (unsigned i = 0; i < 3; ++i)
+		{
+			s[i] += P.u[i];
+			for (unsigned j = 0; j < 3; ++j)
+			{
+				s2[i][j] += P.u[i] * P.u[j];
+			}
+		}
+	}
+
+	//! Adds the moments of another set
+	void add(const Moments& m)
+	{
+		n += m.n;
+		for (unsigned i = 0; i < 3; ++i)
+		{
+			s[i] += m.s[i];
+			for (unsigned j = 0; j < 3; ++j)
+			{
+				s2[i][j] += m.s2[i][j];
+			}
+		}
+	}
+
+	//! Computes the least squares plane normal and the RMS of the distances to this plane
+	bool fitPlane(CCVector3d& N, double& rms) const
+	{
+		if (n < 3)
+			return false;
+
+		CCCoreLib::SquareMatrixd cov(3);
+		for (unsigned i = 0; i < 3; ++i)
+		{
+			for (unsigned j = 0; j < 3; ++j)
+			{
+				cov.m_values[i][j] = s2[i][j] / n - (s[i] / n) * (s[j] / n);
+			}
+		}
+
+		CCCoreLib::SquareMatrixd eigVectors;
+		std::vector<double> eigValues;
+		if (!CCCoreLib::Jacobi<double>::ComputeEigenValuesAndVectors(cov, eigVectors, eigValues, true))
+			return false;
+
+		double minEigValue = 0;
+		if (!CCCoreLib::Jacobi<double>::GetMinEigenValueAndVector(eigVectors, eigValues, minEigValue, N.u))
+			return false;
+
+		N.normalize();
+		rms = sqrt(std::max(0.0, minEigValue));
+		return true;
+	}
+};
+
+//! Conservative extents of a set of points (union-find strategy)
+struct SetExtents
+{
+	//! Centroid (relatively to the cloud center)
+	CCVector3d G;
+	//! Upper bound of the distances between the points and the set plane (going through G)
+	double thickness = 0;
+	//! Upper bound of the distances between the points and G
+	double radius = 0;
+
+	//! Returns an upper bound of the distances between the points and another plane
+	/** \param N other plane normal
+		\param C a point of the other plane (relatively to the cloud center)
+		\param setN set plane normal
+	**/
+	double maxDistTo(const CCVector3d& N, const CCVector3d& C, const CCVector3d& setN) const
+	{
+		//any point P = G + a.setN + b (with |a| <= thickness, ||b|| <= radius and b orthogonal to setN)
+		double cosTheta = std::min(1.0, std::abs(N.dot(setN)));
+		double sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+		return std::abs(N.dot(G - C)) + thickness * cosTheta + radius * sinTheta;
+	}
+};
+
+//! Fusion candidate pair (union-find strategy)
+struct LeafPair
+{
+	unsigned a;
+	unsigned b;
+	double error;
+
+	bool operator < (const LeafPair& other) const
+	{
+		//sort by increasing error (and indexes, so that the result doesn't depend on the threads)
+		if (error != other.error)
+			return error < other.error;
+		if (a != other.a)
+			return a < other.a;
+		return b < other.b;
+	}
+};
+
+//! Returns the min distance between a point and a set of points
+static PointCoordinateType MinDistTo(const CCVector3& P, CCCoreLib::ReferenceCloud* set)
+{
+	PointCoordinateType minDist2 = 0;
+	for (unsigned j = 0; j < set->size(); ++j)
+	{
+		PointCoordinateType d2 = (*set->getPoint(j) - P).norm2();
+		if (d2 < minDist2 || j == 0)
+			minDist2 = d2;
+	}
+	return sqrt(minDist2);
+}
+
+bool ccKdTreeForFacetExtraction::FuseCellsUnionFind(ccKdTree* kdTree,
+													double maxError,
+													CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+													double maxAngle_deg,
+													PointCoordinateType overlapCoef/*=1*/,
+													int maxThreadCount/*=0*/,
+													CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (!kdTree)
+		return false;
+
+	ccGenericPointCloud* associatedGenericCloud = kdTree->associatedGenericCloud();
+	if (!associatedGenericCloud || !associatedGenericCloud->isA(CC_TYPES::POINT_CLOUD) || maxError < 0.0)
+		return false;
+
+	//get leaves
+	std::vector<ccKdTree::Leaf*> leaves;
+	if (!kdTree->getLeaves(leaves) || leaves.empty())
+		return false;
+
+	ccPointCloud* pc = static_cast<ccPointCloud*>(associatedGenericCloud);
+
+	//sort cells based on their population size (the biggest ones get the first indexes)
+	ParallelSort(leaves.begin(), leaves.end(), DescendingLeafSizeComparison);
+
+	unsigned leafCount = static_cast<unsigned>(leaves.size());
+
+	std::vector<Candidate> leafInfo;
+	std::vector<Moments> leafMoments;
+	std::vector< std::vector<LeafPair> > leafPairs;
+	std::vector<unsigned> leafIndexes;
+	std::unordered_map<ccKdTree::Leaf*, unsigned> leafToIndex;
+	try
+	{
+		leafInfo.resize(leafCount);
+		leafMoments.resize(leafCount);
+		leafPairs.resize(leafCount);
+		leafIndexes.resize(leafCount);
+		leafToIndex.reserve(leafCount);
+		for (unsigned i = 0; i < leafCount; ++i)
+		{
+			leafIndexes[i] = i;
+			leafToIndex[leaves[i]] = i;
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory!
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+
+	//progress notification (one step per cell for each of the 2 passes)
+	CCCoreLib::NormalizedProgress nProgress(progressCb, 2 * leafCount);
+	if (progressCb)
+	{
+		progressCb->update(0);
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Fuse Kd-tree cells (union-find)");
+			progressCb->setInfo(qPrintable(QString("Cells: %1\nMax error: %2").arg(leafCount).arg(maxError)));
+		}
+		progressCb->start();
+	}
+
+	// cosine of the max angle between fused 'planes'
+	const double c_minCosNormAngle = cos( CCCoreLib::DegreesToRadians( maxAngle_deg ) );
+
+	//the moments are expressed relatively to the cloud center (to limit numerical issues)
+	const CCVector3d center = pc->getOwnBB().getCenter().toDouble();
+	//must be done before the parallel passes (the tree bounding-box may be computed on the fly)
+	kdTree->getOwnBB(false);
+
+	//with other error measures than the RMS, the merged sets must be checked with their points
+	const bool checkSetPoints = (errorMeasure != CCCoreLib::DistanceComputationTools::RMS);
+	std::vector<SetExtents> setExtents;
+	if (checkSetPoints)
+	{
+		try
+		{
+			setExtents.resize(leafCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+			return false;
+		}
+	}
+
+	std::atomic<bool> cancelled(false);
+	std::atomic<bool> failed(false);
+
+	//first pass: cells centroid, radius and moments
+	auto computeLeafInfo = [&](unsigned i)
+	{
+		if (cancelled || failed)
+			return;
+
+		ccKdTree::Leaf* leaf = leaves[i];
+		leafInfo[i] = Candidate(leaf);
+		for (unsigned j = 0; j < leaf->points->size(); ++j)
+		{
+			leafMoments[i].add(leaf->points->getPoint(j)->toDouble() - center);
+		}
+
+		if (checkSetPoints && leafMoments[i].n > 0)
+		{
+			//exact extents of the cell (with respect to its own plane)
+			SetExtents& extents = setExtents[i];
+			extents.G = CCVector3d(leafMoments[i].s[0], leafMoments[i].s[1], leafMoments[i].s[2]) / leafMoments[i].n;
+			CCVector3d N = CCVector3(leaf->planeEq).toDouble();
+			for (unsigned j = 0; j < leaf->points->size(); ++j)
+			{
+				CCVector3d GP = leaf->points->getPoint(j)->toDouble() - center - extents.G;
+				extents.thickness = std::max(extents.thickness, std::abs(GP.dot(N)));
+				extents.radius = std::max(extents.radius, GP.norm());
+			}
+		}
+
+		if (progressCb && !nProgress.oneStep())
+			cancelled = true;
+	};
+
+	//second pass: test the pairs of neighbor cells
+	auto testNeighborPairs = [&](unsigned i)
+	{
+		if (cancelled || failed)
+			return;
+
+		ccKdTree::Leaf* leaf = leaves[i];
+		if (leaf->error < maxError)
+		{
+			ccKdTree::LeafSet neighbors;
+			if (!kdTree->getNeighborLeaves(leaf, neighbors))
+			{
+				failed = true;
+				return;
+			}
+
+			CCVector3 N(leaf->planeEq);
+			for (ccKdTree::Leaf* neighbor : neighbors)
+			{
+				auto it = leafToIndex.find(neighbor);
+				if (it == leafToIndex.end())
+				{
+					assert(false);
+					continue;
+				}
+				unsigned j = it->second;
+				//each pair is only tested once
+				if (j <= i || neighbor->error >= maxError)
+					continue;
+
+				//if the leaf orientation is too different
+				if (std::abs(CCVector3(neighbor->planeEq).dot(N)) < c_minCosNormAngle)
+					continue;
+
+				//if the leaves are too far
+				if (	leafInfo[j].radius < MinDistTo(leafInfo[j].centroid, leaf->points) / overlapCoef
+					&&	leafInfo[i].radius < MinDistTo(leafInfo[i].centroid, neighbor->points) / overlapCoef)
+				{
+					continue;
+				}
+
+				//fit a plane on both sets and estimate the resulting error
+				CCCoreLib::ReferenceCloud fused(*leaf->points);
+				if (!fused.add(*neighbor->points))
+				{
+					failed = true;
+					return;
+				}
+
+				double error = -1.0;
+				const PointCoordinateType* planeEquation = CCCoreLib::Neighbourhood(&fused).getLSPlane();
+				if (planeEquation)
+					error = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(&fused, planeEquation, errorMeasure);
+
+				if (error >= 0.0 && error <= maxError)
+				{
+					try
+					{
+						leafPairs[i].push_back({ i, j, error });
+					}
+					catch (const std::bad_alloc&)
+					{
+						failed = true;
+						return;
+					}
+				}
+			}
+		}
+
+		if (progressCb && !nProgress.oneStep())
+			cancelled = true;
+	};
+
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+	}
+
+#ifndef _DEBUG
+	if (maxThreadCount > 1)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+		QtConcurrent::blockingMap(leafIndexes, computeLeafInfo);
+		QtConcurrent::blockingMap(leafIndexes, testNeighborPairs);
+	}
+	else
+#endif
+	{
+		for (unsigned i : leafIndexes)
+			computeLeafInfo(i);
+		for (unsigned i : leafIndexes)
+			testNeighborPairs(i);
+	}
+
+	if (failed)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+	if (cancelled)
+	{
+		return false;
+	}
+
+	//gather all the valid pairs
+	std::vector<LeafPair> pairs;
+	try
+	{
+		size_t pairCount = 0;
+		for (const std::vector<LeafPair>& p : leafPairs)
+			pairCount += p.size();
+		pairs.reserve(pairCount);
+		for (std::vector<LeafPair>& p : leafPairs)
+		{
+			pairs.insert(pairs.end(), p.begin(), p.end());
+			p.clear();
+			p.shrink_to_fit();
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+	ParallelSort(pairs.begin(), pairs.end());
+
+	//union-find (the sets are merged by increasing error)
+	std::vector<unsigned> parent(leafIndexes);
+	std::vector<CCVector3d> setNormals(leafCount);
+	for (unsigned i = 0; i < leafCount; ++i)
+	{
+		setNormals[i] = CCVector3(leaves[i]->planeEq).toDouble();
+	}
+
+	//points of each set (only the roots are valid, and the bigger set absorbs the smaller one at each merge)
+	std::vector< std::unique_ptr<CCCoreLib::ReferenceCloud> > setPoints;
+	if (checkSetPoints)
+	{
+		try
+		{
+			setPoints.resize(leafCount);
+			for (unsigned i = 0; i < leafCount; ++i)
+			{
+				setPoints[i].reset(new CCCoreLib::ReferenceCloud(*leaves[i]->points));
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+			return false;
+		}
+	}
+
+	auto findRoot = [&parent](unsigned i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]]; //path halving
+			i = parent[i];
+		}
+		return i;
+	};
+
+	unsigned fusionCount = 0;
+	unsigned exactCheckCount = 0;
+	for (const LeafPair& pair : pairs)
+	{
+		unsigned rootA = findRoot(pair.a);
+		unsigned rootB = findRoot(pair.b);
+		if (rootA == rootB)
+			continue;
+
+		//the sets orientations should be similar
+		if (std::abs(setNormals[rootA].dot(setNormals[rootB])) < c_minCosNormAngle)
+			continue;
+
+		//and the merged set should remain planar
+		Moments merged = leafMoments[rootA];
+		merged.add(leafMoments[rootB]);
+		CCVector3d N;
+		double rms = 0;
+		if (!merged.fitPlane(N, rms))
+			continue;
+		SetExtents mergedExtents;
+		if (!checkSetPoints)
+		{
+			if (rms > maxError)
+				continue;
+		}
+		else
+		{
+			//the max distance can't be smaller than the RMS
+			if (errorMeasure == CCCoreLib::DistanceComputationTools::MAX_DIST && rms > maxError)
+				continue;
+
+			//all the error measures are bounded by the max distance: the points are only checked
+			//if the conservative bound (computed from the sets extents) is not sufficient
+			mergedExtents.G = CCVector3d(merged.s[0], merged.s[1], merged.s[2]) / merged.n;
+			mergedExtents.thickness = std::max(	setExtents[rootA].maxDistTo(N, mergedExtents.G, setNormals[rootA]),
+												setExtents[rootB].maxDistTo(N, mergedExtents.G, setNormals[rootB]) );
+			mergedExtents.radius = std::max(	(setExtents[rootA].G - mergedExtents.G).norm() + setExtents[rootA].radius,
+												(setExtents[rootB].G - mergedExtents.G).norm() + setExtents[rootB].radius );
+
+			if (mergedExtents.thickness > maxError)
+			{
+				//exact error of the merged set (with respect to its least squares plane)
+				++exactCheckCount;
+				CCVector3d G = mergedExtents.G + center;
+				PointCoordinateType planeEquation[4] = {	static_cast<PointCoordinateType>(N.x),
+															static_cast<PointCoordinateType>(N.y),
+															static_cast<PointCoordinateType>(N.z),
+															static_cast<PointCoordinateType>(N.dot(G)) };
+
+				double error = -1.0;
+				if (errorMeasure == CCCoreLib::DistanceComputationTools::MAX_DIST)
+				{
+					//no need to gather the points of both sets
+					double errorA = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(setPoints[rootA].get(), planeEquation, errorMeasure);
+					double errorB = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(setPoints[rootB].get(), planeEquation, errorMeasure);
+					if (errorA >= 0.0 && errorB >= 0.0)
+					{
+						error = std::max(errorA, errorB);
+						//exact thickness
+						mergedExtents.thickness = error;
+					}
+				}
+				else
+				{
+					CCCoreLib::ReferenceCloud fusedSet(*setPoints[rootA]);
+					if (!fusedSet.add(*setPoints[rootB]))
+					{
+						ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+						return false;
+					}
+					error = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(&fusedSet, planeEquation, errorMeasure);
+				}
+
+				if (error < 0.0 || error > maxError)
+					continue;
+			}
+		}
+
+		//the root with the smallest index (i.e. the biggest cell) is kept
+		unsigned newRoot = std::min(rootA, rootB);
+		unsigned oldRoot = std::max(rootA, rootB);
+		if (checkSetPoints)
+		{
+			//the points of the smaller set are appended to the bigger one
+			if (setPoints[newRoot]->size() < setPoints[oldRoot]->size())
+			{
+				std::swap(setPoints[newRoot], setPoints[oldRoot]);
+			}
+			if (!setPoints[newRoot]->add(*setPoints[oldRoot]))
+			{
+				ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+				return false;
+			}
+			setPoints[oldRoot].reset();
+			setExtents[newRoot] = mergedExtents;
+		}
+		parent[oldRoot] = newRoot;
+		leafMoments[newRoot] = merged;
+		setNormals[newRoot] = N;
+		++fusionCount;
+	}
+
+	ccLog::Print(QString("[ccKdTreeForFacetExtraction] Cells: %1 - valid pairs: %2 - fusions: %3").arg(leafCount).arg(pairs.size()).arg(fusionCount));
+	if (checkSetPoints)
+	{
+		ccLog::Print(QString("[ccKdTreeForFacetExtraction] Merges checked with the points: %1").arg(exactCheckCount));
+	}
+	setPoints.clear();
+
+	//convert fused indexes to SF
+	if (!pc->enableScalarField())
+	{
+		ccLog::Error("Not enough memory");
+		return false;
+	}
+
+	std::vector<int> rootIndex(leafCount, -1);
+	int macroIndex = 1; //starts at 1 (0 was reserved for cells already above the max error)
+	for (unsigned i = 0; i < leafCount; ++i)
+	{
+		if (leaves[i]->error < maxError)
+		{
+			unsigned root = findRoot(i);
+			if (rootIndex[root] < 0)
+				rootIndex[root] = macroIndex++;
+			leaves[i]->userData = rootIndex[root];
+		}
+		else
+		{
+			leaves[i]->userData = 0;
+		}
+	}
+
+	for (unsigned i = 0; i < leafCount; ++i)
+	{
+		CCCoreLib::ReferenceCloud* subset = leaves[i]->points;
+		if (subset)
+		{
+			ScalarType scalar = static_cast<ScalarType>(leaves[i]->userData);
+			if (leaves[i]->userData <= 0) //for cells above the max error, we create new individual groups
+			{
+				scalar = static_cast<ScalarType>(macroIndex++);
+			}
+			for (unsigned j = 0; j < subset->size(); ++j)
+			{
+				subset->setPointScalarValue(j, scalar);
+			}
+		}
+	}
+
+	return true;
+}
@@ -25,6 +25,7 @@
 #include "kdTreeForFacetExtraction.h"
 #include "fastMarchingForFacetExtraction.h"
 #include "disclaimerDialog.h"
+#include "FacetsCommand.h"
 
 //Qt
 #include <QtGui>
@@ -33,6 +34,8 @@
 #include <QSettings>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 //CCCoreLib
 #include <Neighbourhood.h>
@@ -49,6 +52,12 @@
 //qCC_io
 #include <ShpFilter.h>
 
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
+//System
+#include <atomic>
+
 
 //semi-persistent dialog values
 static unsigned s_octreeLevel = 8;
@@ -61,6 +70,7 @@ static double	s_maxEdgeLength = 1.0;
 
 static double	s_kdTreeFusionMaxAngle_deg = 20.0;
 static double	s_kdTreeFusionMaxRelativeDistance = 1.0;
+static bool		s_kdTreeUnionFindFusion = false;
 
 static double	s_classifAngleStep = 30.0;
 static double	s_classifMaxDist = 1.0;
@@ -152,6 +162,16 @@ QList<QAction *> qFacets::getActions()
 	};
 }
 
+void qFacets::registerCommands(ccCommandLineInterface* cmd)
+{
+	if (!cmd)
+	{
+		assert(false);
+		return;
+	}
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new FacetsCommand));
+}
+
 void qFacets::onNewSelection(const ccHObject::Container& selectedEntities)
 {
 	if (m_doFuseKdTreeCells)
@@ -222,6 +242,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	fusionDlg.maxRMSDoubleSpinBox->setValue(s_errorMaxPerFacet);
 	fusionDlg.maxAngleDoubleSpinBox->setValue(s_kdTreeFusionMaxAngle_deg);
 	fusionDlg.maxRelativeDistDoubleSpinBox->setValue(s_kdTreeFusionMaxRelativeDistance);
+	fusionDlg.unionFindCheckBox->setChecked(s_kdTreeUnionFindFusion);
 	fusionDlg.maxEdgeLengthDoubleSpinBox->setValue(s_maxEdgeLength);
 	//"no normal" warning
 	fusionDlg.noNormalWarningLabel->setVisible(!pc->hasNormals());
@@ -236,32 +257,93 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	s_errorMaxPerFacet = fusionDlg.maxRMSDoubleSpinBox->value();
 	s_kdTreeFusionMaxAngle_deg = fusionDlg.maxAngleDoubleSpinBox->value();
 	s_kdTreeFusionMaxRelativeDistance = fusionDlg.maxRelativeDistDoubleSpinBox->value();
+	s_kdTreeUnionFindFusion = fusionDlg.unionFindCheckBox->isChecked();
 	s_maxEdgeLength = fusionDlg.maxEdgeLengthDoubleSpinBox->value();
 
-	//convert 'errorMeasureComboBox' index to enum
-	CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure = CCCoreLib::DistanceComputationTools::RMS;
-	switch (s_errorMeasureType)
+	ExtractionParams params;
+	params.algo = algo;
+	params.octreeLevel = static_cast<unsigned char>(s_octreeLevel);
+	params.useRetroProjectionError = s_fmUseRetroProjectionError;
+	params.minPointsPerFacet = s_minPointsPerFacet;
+	params.errorMaxPerFacet = s_errorMaxPerFacet;
+	params.errorMeasure = ErrorMeasureFromIndex(s_errorMeasureType);
+	params.kdTreeFusionMaxAngle_deg = s_kdTreeFusionMaxAngle_deg;
+	params.kdTreeFusionMaxRelativeDistance = s_kdTreeFusionMaxRelativeDistance;
+	params.kdTreeUnionFindFusion = s_kdTreeUnionFindFusion;
+	params.maxEdgeLength = s_maxEdgeLength;
+
+	//computation
+	ccProgressDialog pDlg(true, m_app->getMainWindow());
+
+	bool error = false;
+	QString errorMessage;
+	ccHObject* group = ExtractFacets(pc, params, error, errorMessage, &pDlg);
+
+	if (group)
+	{
+		unsigned count = group->getChildrenNumber();
+		m_app->dispToConsole(QString("[qFacets] %1 facet(s) where created from cloud '%2'").arg(count).arg(pc->getName()));
+
+		if (error)
+		{
+			m_app->dispToConsole("Error(s) occurred during the generation of facets! Result may be incomplete", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		}
+
+		//pc->setEnabled(false);
+		m_app->addToDB(group);
+		group->prepareDisplayForRefresh();
+	}
+	else if (!errorMessage.isEmpty())
+	{
+		m_app->dispToConsole(errorMessage, ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+	}
+	else
+	{
+		m_app->dispToConsole("No facet remains! Check the parameters (min size, etc.)", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+	}
+
+	//currently selected entities appearance may have changed!
+	m_app->redrawAll();
+}
+
+CCCoreLib::DistanceComputationTools::ERROR_MEASURES qFacets::ErrorMeasureFromIndex(int index)
+{
+	//same order as 'errorMeasureComboBox'
+	switch (index)
 	{
 	case 0:
-		errorMeasure = CCCoreLib::DistanceComputationTools::RMS;
-		break;
+		return CCCoreLib::DistanceComputationTools::RMS;
 	case 1:
-		errorMeasure = CCCoreLib::DistanceComputationTools::MAX_DIST_68_PERCENT;
-		break;
+		return CCCoreLib::DistanceComputationTools::MAX_DIST_68_PERCENT;
 	case 2:
-		errorMeasure = CCCoreLib::DistanceComputationTools::MAX_DIST_95_PERCENT;
-		break;
+		return CCCoreLib::DistanceComputationTools::MAX_DIST_95_PERCENT;
 	case 3:
-		errorMeasure = CCCoreLib::DistanceComputationTools::MAX_DIST_99_PERCENT;
-		break;
+		return CCCoreLib::DistanceComputationTools::MAX_DIST_99_PERCENT;
 	case 4:
-		errorMeasure = CCCoreLib::DistanceComputationTools::MAX_DIST;
-		break;
+		return CCCoreLib::DistanceComputationTools::MAX_DIST;
 	default:
 		assert(false);
 		break;
 	}
 
+	return CCCoreLib::DistanceComputationTools::RMS;
+}
+
+ccHObject* qFacets::ExtractFacets(	ccPointCloud* pc,
+									const ExtractionParams& params,
+									bool& error,
+									QString& errorMessage,
+									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	error = false;
+	errorMessage.clear();
+
+	if (!pc)
+	{
+		assert(false);
+		return nullptr;
+	}
+
 	//create scalar field to host the fusion result
 	const char c_defaultSFName[] = "facet indexes";
 	int sfIdx = pc->getScalarFieldIndexByName(c_defaultSFName);
@@ -269,58 +351,81 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 		sfIdx = pc->addScalarField(c_defaultSFName);
 	if (sfIdx < 0)
 	{
-		m_app->dispToConsole("Couldn't allocate a new scalar field for computing fusion labels! Try to free some memory ...", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-		return;
+		errorMessage = "Couldn't allocate a new scalar field for computing fusion labels! Try to free some memory ...";
+		return nullptr;
 	}
 	pc->setCurrentScalarField(sfIdx);
 
-	//computation
-	QElapsedTimer eTimer;
-	eTimer.start();
-	ccProgressDialog pDlg(true, m_app->getMainWindow());
-
 	bool success = true;
-	if (algo == CellsFusionDlg::ALGO_KD_TREE)
+	if (params.algo == CellsFusionDlg::ALGO_KD_TREE)
 	{
 		//we need a kd-tree
 		QElapsedTimer eTimer;
 		eTimer.start();
 		ccKdTree kdtree(pc);
 
-		if (kdtree.build(s_errorMaxPerFacet / 2, errorMeasure, s_minPointsPerFacet, 1000, &pDlg))
+		if (kdtree.build(params.errorMaxPerFacet / 2, params.errorMeasure, params.minPointsPerFacet, 1000, progressCb))
 		{
 			qint64 elapsedTime_ms = eTimer.elapsed();
-			m_app->dispToConsole(QString("[qFacets] Kd-tree construction timing: %1 s").arg(static_cast<double>(elapsedTime_ms) / 1.0e3, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
-
-			success = ccKdTreeForFacetExtraction::FuseCells(
-				&kdtree,
-				s_errorMaxPerFacet,
-				errorMeasure,
-				s_kdTreeFusionMaxAngle_deg,
-				static_cast<PointCoordinateType>(s_kdTreeFusionMaxRelativeDistance),
-				true,
-				&pDlg);
+			ccLog::Print(QString("[qFacets] Kd-tree construction timing: %1 s").arg(static_cast<double>(elapsedTime_ms) / 1.0e3, 0, 'f', 3));
+
+			eTimer.restart();
+			if (params.kdTreeUnionFindFusion)
+			{
+				success = ccKdTreeForFacetExtraction::FuseCellsUnionFind(
+					&kdtree,
+					params.errorMaxPerFacet,
+					params.errorMeasure,
+					params.kdTreeFusionMaxAngle_deg,
+					static_cast<PointCoordinateType>(params.kdTreeFusionMaxRelativeDistance),
+					params.maxThreadCount,
+					progressCb);
+			}
+			else
+			{
+				success = ccKdTreeForFacetExtraction::FuseCells(
+					&kdtree,
+					params.errorMaxPerFacet,
+					params.errorMeasure,
+					params.kdTreeFusionMaxAngle_deg,
+					static_cast<PointCoordinateType>(params.kdTreeFusionMaxRelativeDistance),
+					true,
+					progressCb);
+			}
+
+			if (success)
+			{
+				elapsedTime_ms = eTimer.elapsed();
+				ccLog::Print(QString("[qFacets] Kd-tree cells fusion timing: %1 s").arg(static_cast<double>(elapsedTime_ms) / 1.0e3, 0, 'f', 3));
+			}
 		}
 		else
 		{
-			m_app->dispToConsole("Failed to build Kd-tree! (not enough memory?)", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			success = false;
+			errorMessage = "Failed to build Kd-tree! (not enough memory?)";
+			pc->deleteScalarField(sfIdx);
+			return nullptr;
 		}
 	}
-	else if (algo == CellsFusionDlg::ALGO_FAST_MARCHING)
+	else if (params.algo == CellsFusionDlg::ALGO_FAST_MARCHING)
 	{
 		int result = FastMarchingForFacetExtraction::ExtractPlanarFacets(
 			pc,
-			static_cast<unsigned char>(s_octreeLevel),
-			static_cast<ScalarType>(s_errorMaxPerFacet),
-			errorMeasure,
-			s_fmUseRetroProjectionError,
-			&pDlg,
+			params.octreeLevel,
+			static_cast<ScalarType>(params.errorMaxPerFacet),
+			params.errorMeasure,
+			params.useRetroProjectionError,
+			progressCb,
 			pc->getOctree().data());
 
 		success = (result >= 0);
 	}
+	else
+	{
+		assert(false);
+		success = false;
+	}
 
+	ccHObject* group = nullptr;
 	if (success)
 	{
 		pc->setCurrentScalarField(sfIdx); //for AutoSegmentationTools::extractConnectedComponents
@@ -328,7 +433,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 		CCCoreLib::ReferenceCloudContainer components;
 		if (!CCCoreLib::AutoSegmentationTools::extractConnectedComponents(pc, components))
 		{
-			m_app->dispToConsole("Failed to extract fused components! (not enough memory?)", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			errorMessage = "Failed to extract fused components! (not enough memory?)";
 		}
 		else
 		{
@@ -337,59 +442,50 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 			if (!indexSF)
 			{
 				assert(false);
-				return;
+				return nullptr;
 			}
 			indexSF->link(); //to prevent deletion when calling deleteScalarField below
 			pc->deleteScalarField(sfIdx);
 			sfIdx = -1;
 
-			bool error = false;
-			ccHObject* group = createFacets(pc, components, s_minPointsPerFacet, s_maxEdgeLength, false, error);
+			QElapsedTimer eTimer;
+			eTimer.start();
+
+			group = CreateFacets(pc, components, params.minPointsPerFacet, params.maxEdgeLength, false, error, params.maxThreadCount, progressCb);
 
 			if (group)
 			{
-				switch (algo)
+				ccLog::Print(QString("[qFacets] Facets creation timing: %1 s").arg(static_cast<double>(eTimer.elapsed()) / 1.0e3, 0, 'f', 3));
+
+				switch (params.algo)
 				{
 				case CellsFusionDlg::ALGO_KD_TREE:
-					group->setName(group->getName() + QString(" [Kd-tree][error < %1][angle < %2 deg.]").arg(s_errorMaxPerFacet).arg(s_kdTreeFusionMaxAngle_deg));
+					group->setName(group->getName() + QString(" [Kd-tree][error < %1][angle < %2 deg.]").arg(params.errorMaxPerFacet).arg(params.kdTreeFusionMaxAngle_deg));
 					break;
 				case CellsFusionDlg::ALGO_FAST_MARCHING:
-					group->setName(group->getName() + QString(" [FM][level %2][error < %1]").arg(s_octreeLevel).arg(s_errorMaxPerFacet));
+					group->setName(group->getName() + QString(" [FM][level %2][error < %1]").arg(params.octreeLevel).arg(params.errorMaxPerFacet));
 					break;
 				default:
 					break;
 				}
 
-				unsigned count = group->getChildrenNumber();
-				m_app->dispToConsole(QString("[qFacets] %1 facet(s) where created from cloud '%2'").arg(count).arg(pc->getName()));
-
-				if (error)
-				{
-					m_app->dispToConsole("Error(s) occurred during the generation of facets! Result may be incomplete", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-				}
-				else
+				if (!error)
 				{
 					//we put the scalar field back
 					sfIdx = pc->addScalarField(indexSF);
 				}
-
-				//pc->setEnabled(false);
-				m_app->addToDB(group);
-				group->prepareDisplayForRefresh();
 			}
 			else if (error)
 			{
-				m_app->dispToConsole("An error occurred during the generation of facets!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-			}
-			else
-			{
-				m_app->dispToConsole("No facet remains! Check the parameters (min size, etc.)", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+				errorMessage = "An error occurred during the generation of facets!";
 			}
+
+			indexSF->release();
 		}
 	}
 	else
 	{
-		m_app->dispToConsole("An error occurred during the fusion process!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		errorMessage = "An error occurred during the fusion process!";
 	}
 
 	if (sfIdx >= 0)
@@ -401,124 +497,204 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 #endif
 	}
 
-	//currently selected entities appearance may have changed!
-	m_app->redrawAll();
+	return group;
 }
 
-ccHObject* qFacets::createFacets(	ccPointCloud* cloud,
+ccHObject* qFacets::CreateFacets(	ccPointCloud* cloud,
 									CCCoreLib::ReferenceCloudContainer& components,
 									unsigned minPointsPerComponent,
 									double maxEdgeLength,
 									bool randomColors,
-									bool& error )
+									bool& error,
+									int maxThreadCount/*=0*/,
+									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
 {
+	error = false;
+
 	if (!cloud)
 	{
 		return nullptr;
 	}
 
-	//we create a new group to store all input CCs as 'facets'
-	ccHObject* ccGroup = new ccHObject(cloud->getName() + QString(" [facets]"));
-	ccGroup->setDisplay(cloud->getDisplay());
-	ccGroup->setVisible(true);
-
 	bool cloudHasNormal = cloud->hasNormals();
 
+	//we only keep the components with enough points (the last ones first, as before)
+	std::vector<CCCoreLib::ReferenceCloud*> validComponents;
+	try
+	{
+		validComponents.reserve(components.size());
+		for (auto it = components.rbegin(); it != components.rend(); ++it)
+		{
+			if (*it && (*it)->size() >= minPointsPerComponent)
+				validComponents.push_back(*it);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory!
+		error = true;
+		for (CCCoreLib::ReferenceCloud* compIndexes : components)
+		{
+			delete compIndexes;
+		}
+		components.clear();
+		return nullptr;
+	}
+
 	//number of input components
-	size_t componentCount = components.size();
+	unsigned componentCount = static_cast<unsigned>(validComponents.size());
 
 	//progress notification
-	ccProgressDialog pDlg(true, m_app->getMainWindow());
-	pDlg.setMethodTitle(QObject::tr("Facets creation"));
-	pDlg.setInfo(QObject::tr("Components: %1").arg(componentCount));
-	pDlg.setMaximum(static_cast<int>(componentCount));
-	pDlg.show();
-	QApplication::processEvents();
+	CCCoreLib::NormalizedProgress nProgress(progressCb, componentCount);
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Facets creation");
+			progressCb->setInfo(qPrintable(QString("Components: %1").arg(componentCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
 
-	//for each component
-	error = false;
-	while (!components.empty())
+	//the facets are created in parallel
+	std::vector<ccFacet*> facets(componentCount, nullptr);
+	std::vector<unsigned> componentIndexes(componentCount);
+	for (unsigned i = 0; i < componentCount; ++i)
 	{
-		CCCoreLib::ReferenceCloud* compIndexes = components.back();
-		components.pop_back();
+		componentIndexes[i] = i;
+	}
+	std::atomic<bool> memoryError(false);
+
+	auto createFacet = [&](unsigned i)
+	{
+		CCCoreLib::ReferenceCloud* compIndexes = validComponents[i];
 
-		//if it has enough points
-		if (compIndexes && compIndexes->size() >= minPointsPerComponent)
+		ccPointCloud* facetCloud = cloud->partialClone(compIndexes);
+		if (!facetCloud)
 		{
-			ccPointCloud* facetCloud = cloud->partialClone(compIndexes);
-			if (!facetCloud)
-			{
-				//not enough  memory!
-				error = true;
-				delete facetCloud;
-				facetCloud = nullptr;
-			}
-			else
+			//not enough  memory!
+			memoryError = true;
+		}
+		else
+		{
+			ccFacet* facet = ccFacet::Create(facetCloud, static_cast<PointCoordinateType>(maxEdgeLength), true);
+			if (facet)
 			{
-				ccFacet* facet = ccFacet::Create(facetCloud, static_cast<PointCoordinateType>(maxEdgeLength), true);
-				if (facet)
+				if (facet->getPolygon())
 				{
-					QString facetName = QString("facet %1 (RMS=%2)").arg(ccGroup->getChildrenNumber()).arg(facet->getRMS());
-					facet->setName(facetName);
-					if (facet->getPolygon())
-					{
-						facet->getPolygon()->enableStippling(false);
-						facet->getPolygon()->showNormals(false);
-					}
-					if (facet->getContour())
-					{
-						facet->getContour()->copyGlobalShiftAndScale(*facetCloud);
-					}
-
-					//check the facet normal sign
-					if (cloudHasNormal)
-					{
-						CCVector3 N = ccOctree::ComputeAverageNorm(compIndexes, cloud);
-
-						if (N.dot(facet->getNormal()) < 0)
-							facet->invertNormal();
-					}
+					facet->getPolygon()->enableStippling(false);
+					facet->getPolygon()->showNormals(false);
+				}
+				if (facet->getContour())
+				{
+					facet->getContour()->copyGlobalShiftAndScale(*facetCloud);
+				}
+
+				//check the facet normal sign
+				if (cloudHasNormal)
+				{
+					CCVector3 N = ccOctree::ComputeAverageNorm(compIndexes, cloud);
+
+					if (N.dot(facet->getNormal()) < 0)
+						facet->invertNormal();
+				}
 
 #ifdef _DEBUG
-					facet->showNormalVector(true);
+				facet->showNormalVector(true);
 #endif
 
-					//shall we colorize it with a random color?
-					ccColor::Rgb col;
-					ccColor::Rgb darkCol;
-					if (randomColors)
-					{
-						col = ccColor::Generator::Random();
-						assert(c_darkColorRatio <= 1.0);
-						darkCol.r = static_cast<ColorCompType>(static_cast<double>(col.r) * c_darkColorRatio);
-						darkCol.g = static_cast<ColorCompType>(static_cast<double>(col.g) * c_darkColorRatio);
-						darkCol.b = static_cast<ColorCompType>(static_cast<double>(col.b) * c_darkColorRatio);
-					}
-					else
-					{
-						//use normal-based HSV coloring
-						CCVector3 N = facet->getNormal();
-						PointCoordinateType dip = 0;
-						PointCoordinateType dipDir = 0;
-						ccNormalVectors::ConvertNormalToDipAndDipDir(N, dip, dipDir);
-						FacetsClassifier::GenerateSubfamilyColor(col, dip, dipDir, 0, 1, &darkCol);
-					}
-					facet->setColor(col);
-					if (facet->getContour())
-					{
-						facet->getContour()->setColor(darkCol);
-						facet->getContour()->setWidth(2);
-					}
-					ccGroup->addChild(facet);
-				}
+				facets[i] = facet;
 			}
+			else
+			{
+				//the cloud is not owned by the facet
+				delete facetCloud;
+			}
+		}
 
-			delete compIndexes;
-			compIndexes = nullptr;
+		if (progressCb)
+		{
+			nProgress.oneStep();
 		}
+	};
+
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+	}
+
+#ifndef _DEBUG
+	if (maxThreadCount > 1 && componentCount > 1)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+		QtConcurrent::blockingMap(componentIndexes, createFacet);
+	}
+	else
+#endif
+	{
+		for (unsigned i : componentIndexes)
+		{
+			createFacet(i);
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	error = memoryError;
 
-		pDlg.setValue(static_cast<int>(componentCount - components.size()));
-		//QApplication::processEvents();
+	//we release the components
+	for (CCCoreLib::ReferenceCloud* compIndexes : components)
+	{
+		delete compIndexes;
+	}
+	components.clear();
+
+	//we create a new group to store all input CCs as 'facets'
+	ccHObject* ccGroup = new ccHObject(cloud->getName() + QString(" [facets]"));
+	ccGroup->setDisplay(cloud->getDisplay());
+	ccGroup->setVisible(true);
+
+	for (ccFacet* facet : facets)
+	{
+		if (!facet)
+		{
+			continue;
+		}
+
+		QString facetName = QString("facet %1 (RMS=%2)").arg(ccGroup->getChildrenNumber()).arg(facet->getRMS());
+		facet->setName(facetName);
+
+		//shall we colorize it with a random color?
+		ccColor::Rgb col;
+		ccColor::Rgb darkCol;
+		if (randomColors)
+		{
+			col = ccColor::Generator::Random();
+			assert(c_darkColorRatio <= 1.0);
+			darkCol.r = static_cast<ColorCompType>(static_cast<double>(col.r) * c_darkColorRatio);
+			darkCol.g = static_cast<ColorCompType>(static_cast<double>(col.g) * c_darkColorRatio);
+			darkCol.b = static_cast<ColorCompType>(static_cast<double>(col.b) * c_darkColorRatio);
+		}
+		else
+		{
+			//use normal-based HSV coloring
+			CCVector3 N = facet->getNormal();
+			PointCoordinateType dip = 0;
+			PointCoordinateType dipDir = 0;
+			ccNormalVectors::ConvertNormalToDipAndDipDir(N, dip, dipDir);
+			FacetsClassifier::GenerateSubfamilyColor(col, dip, dipDir, 0, 1, &darkCol);
+		}
+		facet->setColor(col);
+		if (facet->getContour())
+		{
+			facet->getContour()->setColor(darkCol);
+			facet->getContour()->setWidth(2);
+		}
+		ccGroup->addChild(facet);
 	}
 
 	if (ccGroup->getChildrenNumber() == 0)
@@ -21,9 +21,9 @@
 /*========= qh definition -- globals defined in libqhull.h =======================*/
 
 #if qh_QHpointer
-qhT *qh_qh= NULL;       /* pointer to all global variables */
+qh_THREADLOCAL qhT *qh_qh= NULL;       /* pointer to all global variables */
 #else
-qhT qh_qh;              /* all global variables.
+qh_THREADLOCAL qhT qh_qh;              /* all global variables.
                            Add "= {0}" if this causes a compiler error.
                            Also qh_qhstat in stat.c and qhmem in mem.c.  */
 #endif
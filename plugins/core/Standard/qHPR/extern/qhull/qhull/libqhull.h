@@ -445,7 +445,7 @@ __declspec(dllimport) extern qhT *qh_qh;     /* allocated in global.c */
 
 #elif qh_QHpointer
 #define qh qh_qh->
-extern qhT *qh_qh;     /* allocated in global.c */
+extern qh_THREADLOCAL qhT *qh_qh;     /* allocated in global.c */
 #define QHULL_LIB_TYPE QHULL_QH_POINTER
 
 #elif qh_dllimport
@@ -455,7 +455,7 @@ __declspec(dllimport) extern qhT qh_qh;      /* allocated in global.c */
 
 #else
 #define qh qh_qh.
-extern qhT qh_qh;
+extern qh_THREADLOCAL qhT qh_qh;
 #define QHULL_LIB_TYPE QHULL_NON_REENTRANT
 #endif
 
@@ -105,7 +105,7 @@ typedef long ptr_intT;
    contents of qhmem.
 */
 typedef struct qhmemT qhmemT;
-extern qhmemT qhmem;
+extern qh_THREADLOCAL qhmemT qhmem;
 
 #ifndef DEFsetT
 #define DEFsetT 1
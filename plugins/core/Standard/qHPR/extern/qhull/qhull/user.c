@@ -133,7 +133,7 @@ int qh_new_qhull(int dim, int numpoints, coordT *points, boolT ismalloc,
      See http://stackoverflow.com/questions/7721854/what-sense-do-these-clobbered-variable-warnings-make */
   int exitcode, hulldim;
   boolT new_ismalloc;
-  static boolT firstcall = True;
+  static qh_THREADLOCAL boolT firstcall = True; /* qhmem is thread-local */
   coordT *new_points;
   if(!errfile){
       errfile= stderr;
@@ -614,6 +614,25 @@ stop after qh_JOGGLEmaxretry attempts
 #error QH6234 Qhull error: Use qh_dllimport instead of qh_QHpointer_dllimport when qh_QHpointer is not defined
 #endif
 #endif
+
+/*-<a                             href="qh-user.htm#TOC"
+  >--------------------------------</a><a name="THREADLOCAL">-</a>
+
+  qh_THREADLOCAL
+    storage class of the global data structures (qh_qh, qhmem, qhstat and the random seed)
+
+  notes:
+    [CloudCompare] the global state is stored in thread-local storage, so that
+    independent qhull computations can run concurrently in different threads
+    (one active instance per thread). The reentrant libqhull_r is not shipped
+    with this plugin.
+*/
+#if defined(_MSC_VER)
+#define qh_THREADLOCAL __declspec(thread)
+#else
+#define qh_THREADLOCAL __thread
+#endif
+
 #if 0  /* sample code */
     qhT *oldqhA, *oldqhB;
 
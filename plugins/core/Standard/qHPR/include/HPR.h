@@ -0,0 +1,101 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_HPR_HEADER
+#define Q_HPR_HEADER
+
+//CCCoreLib
+#include <GenericProgressCallback.h>
+#include <ReferenceCloud.h>
+
+//Qt
+#include <QString>
+
+class ccPointCloud;
+
+//! "Hidden Point Removal" algorithm for approximating points visibility in a point cloud, as seen from a given viewpoint
+/** "Direct Visibility of Point Sets", Sagi Katz, Ayellet Tal, and Ronen Basri.
+	SIGGRAPH 2007
+	http://www.mathworks.com/matlabcentral/fileexchange/16581-hidden-point-removal
+**/
+class HPR
+{
+public:
+
+	//! HPR parameters
+	struct Parameters
+	{
+		//! Spherical flipping parameter (the flipping radius is 2 * 10^fParam times the max distance to the viewpoint)
+		double fParam = 3.5;
+
+		//! Number of subdivisions of the sectors grid (0 = a single convex hull for the whole cloud)
+		/** The directions around the viewpoint are split in 6 * N * N sectors (N x N sectors on
+			each face of a cube centered on the viewpoint). A convex hull is computed for each
+			sector, so that only the convex hull (qhull) memory is bounded, by the size of the
+			largest sectors times the number of threads (see maxThreadCount).
+			\warning This is not an out-of-core mode: the per-point arrays (relative positions,
+			sector owners, visibility flags) still scale with the whole cloud, and all the sector
+			index lists are built beforehand (the points in the overlap areas are listed in
+			several sectors).
+		**/
+		unsigned sectorSubdivisions = 0;
+
+		//! Angular overlap between neighboring sectors (in degrees)
+		/** A sector hull also includes the points of its neighbors up to this angle, but only the
+			visibility of its own points is kept. This discards the spurious hull vertices along the
+			sector borders. The larger the overlap, the closer to the single hull result.
+		**/
+		double sectorOverlap_deg = 5.0;
+
+		//! Max number of threads (0 = all)
+		int maxThreadCount = 0;
+	};
+
+	//! Katz et al. algorithm
+	/** \param cloud input cloud
+		\param viewPoint viewpoint
+		\param params parameters
+		\param progressCb progress callback (optional)
+		\return the visible points (or nullptr if an error occurred)
+	**/
+	static CCCoreLib::ReferenceCloud* RemoveHiddenPoints(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+															const CCVector3d& viewPoint,
+															const Parameters& params,
+															CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Computes the visible points of a cloud (on a simplified version of the cloud)
+	/** The cloud is first simplified (one point per octree cell at the given level).
+		Then all the points of the visible cells are considered as visible.
+		\param cloud input cloud (its octree will be computed if necessary)
+		\param octreeLevel octree level (for the simplification)
+		\param viewPoint viewpoint
+		\param params parameters
+		\param visiblePoints output visible points (should be associated to the input cloud)
+		\param progressCb progress callback (optional)
+		\param errorMessage error message (if any)
+		\return success
+	**/
+	static bool ComputeVisiblePoints(	ccPointCloud* cloud,
+										unsigned char octreeLevel,
+										const CCVector3d& viewPoint,
+										const Parameters& params,
+										CCCoreLib::ReferenceCloud& visiblePoints,
+										CCCoreLib::GenericProgressCallback* progressCb,
+										QString& errorMessage);
+};
+
+#endif //Q_HPR_HEADER
@@ -0,0 +1,37 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#ifndef HPR_COMMAND_HEADER
+#define HPR_COMMAND_HEADER
+
+#include "ccCommandLineInterface.h"
+
+//! Hidden Point Removal command (-HPR)
+/** The viewpoint is either set with the -VIEWPOINT sub-option, or taken
+	from the (first) ground based sensor of each cloud (i.e. the scanner position).
+**/
+class HPRCommand : public ccCommandLineInterface::Command
+{
+public:
+	HPRCommand();
+
+	~HPRCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+#endif
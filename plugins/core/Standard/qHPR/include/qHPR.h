@@ -20,13 +20,8 @@
 
 #include "ccStdPluginInterface.h"
 
-//CCCoreLib
-#include <ReferenceCloud.h>
-
 //! Wrapper to the "Hidden Point Removal" algorithm for approximating points visibility in an N dimensional point cloud, as seen from a given viewpoint
-/** "Direct Visibility of Point Sets", Sagi Katz, Ayellet Tal, and Ronen Basri.
-	SIGGRAPH 2007
-	http://www.mathworks.com/matlabcentral/fileexchange/16581-hidden-point-removal
+/** See HPR.
 **/
 class qHPR : public QObject, public ccStdPluginInterface
 {
@@ -45,6 +40,7 @@ public:
 	//inherited from ccStdPluginInterface
 	virtual void onNewSelection(const ccHObject::Container& selectedEntities) override;
 	virtual QList<QAction *> getActions() override;
+	virtual void registerCommands(ccCommandLineInterface* cmd) override;
 
 protected:
 
@@ -53,9 +49,6 @@ protected:
 
 protected:
 
-	//! Katz et al. algorithm
-	CCCoreLib::ReferenceCloud* removeHiddenPoints(CCCoreLib::GenericIndexedCloudPersist* theCloud, const CCVector3d& viewPoint, double fParam);
-
 	//! Associated action
 	QAction* m_action;
 };
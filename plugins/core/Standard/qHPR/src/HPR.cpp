@@ -0,0 +1,605 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#include "HPR.h"
+
+//qCC_db
+#include <ccLog.h>
+#include <ccOctree.h>
+#include <ccPointCloud.h>
+
+//CCCoreLib
+#include <CCMath.h>
+#include <CloudSamplingTools.h>
+
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
+//Qt
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//Qhull
+extern "C"
+{
+#include <qhull_a.h>
+}
+
+//system
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+//! Flags the points lying on the convex hull
+/** The qhull library shipped with this plugin keeps its global state in
+	thread-local storage (see qh_THREADLOCAL in user.h): this function can
+	be called concurrently from different threads.
+	\param ptArray points coordinates (3 values per point)
+	\param pointCount number of points
+	\param pointBelongsToCvxHull output flags (one per point)
+	\return success
+**/
+static bool FlagConvexHullVertices(coordT* ptArray, unsigned pointCount, std::vector<bool>& pointBelongsToCvxHull)
+{
+	bool success = false;
+
+	static char qHullCommand[] = "qhull QJ Qci";
+	if (!qh_new_qhull(3, static_cast<int>(pointCount), ptArray, False, qHullCommand, nullptr, stderr))
+	{
+		try
+		{
+			pointBelongsToCvxHull.assign(pointCount, false);
+			success = true;
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory!
+		}
+
+		if (success)
+		{
+			vertexT *vertex = nullptr;
+			vertexT **vertexp = nullptr;
+			facetT *facet = nullptr;
+
+			FORALLfacets
+			{
+				//if (!facet->simplicial)
+				//	error("convhulln: non-simplicial facet"); // should never happen with QJ
+
+				setT* vertices = qh_facet3vertex(facet);
+				FOREACHvertex_(vertices)
+				{
+					pointBelongsToCvxHull[qh_pointid(vertex->point)] = true;
+				}
+				qh_settempfree(&vertices);
+			}
+		}
+	}
+
+	qh_freeqhull(!qh_ALL);
+	//free long memory
+	int curlong = 0;
+	int totlong = 0;
+	qh_memfreeshort(&curlong, &totlong);
+	//free short memory and memory allocator
+
+	return success;
+}
+
+//! Sectors grid around the viewpoint
+/** Each face of a cube centered on the viewpoint is divided in N x N sectors.
+	A direction belongs to the sector of the face it hits first (i.e. along its
+	dominant dimension). The sector borders are planes going through the viewpoint.
+**/
+class SectorGrid
+{
+public:
+
+	//! Default constructor
+	SectorGrid(unsigned subdivisions, double overlap_deg)
+		: m_n(subdivisions)
+		//the sector borders are enlarged in the face plane (where the angles are the most
+		//compressed along the face edges, i.e. tan(PI/4 + overlap) - 1 for an angle 'overlap')
+		, m_margin(std::tan(CCCoreLib::DegreesToRadians(45.0 + std::min(overlap_deg, 44.0))) - 1.0)
+	{}
+
+	//! Returns the number of sectors
+	unsigned count() const { return 6 * m_n * m_n; }
+
+	//! Returns the sector a direction belongs to
+	unsigned owner(const CCVector3d& d) const
+	{
+		unsigned char dim = 0;
+		if (std::abs(d.y) > std::abs(d.u[dim]))
+			dim = 1;
+		if (std::abs(d.z) > std::abs(d.u[dim]))
+			dim = 2;
+
+		unsigned face = 2 * dim + (d.u[dim] < 0 ? 1 : 0);
+		double w = std::abs(d.u[dim]);
+		if (w == 0)
+		{
+			//the viewpoint itself
+			return 0;
+		}
+
+		double u = d.u[(dim + 1) % 3] / w;
+		double v = d.u[(dim + 2) % 3] / w;
+		return sectorIndex(face, cellIndex(u), cellIndex(v));
+	}
+
+	//! Calls a function for each (enlarged) sector a direction belongs to
+	template <class Func> void forEachSector(const CCVector3d& d, Func func) const
+	{
+		for (unsigned char dim = 0; dim < 3; ++dim)
+		{
+			for (unsigned char sign = 0; sign < 2; ++sign)
+			{
+				double w = (sign == 0 ? d.u[dim] : -d.u[dim]);
+				if (w <= 0)
+				{
+					//the direction doesn't hit this face
+					continue;
+				}
+
+				double u = d.u[(dim + 1) % 3] / w;
+				double v = d.u[(dim + 2) % 3] / w;
+				if (	u - m_margin > 1.0 || u + m_margin < -1.0
+					||	v - m_margin > 1.0 || v + m_margin < -1.0)
+				{
+					continue;
+				}
+
+				unsigned face = 2 * dim + sign;
+				unsigned iu0 = cellIndex(u - m_margin);
+				unsigned iu1 = cellIndex(u + m_margin);
+				unsigned iv0 = cellIndex(v - m_margin);
+				unsigned iv1 = cellIndex(v + m_margin);
+				for (unsigned iu = iu0; iu <= iu1; ++iu)
+				{
+					for (unsigned iv = iv0; iv <= iv1; ++iv)
+					{
+						func(sectorIndex(face, iu, iv));
+					}
+				}
+			}
+		}
+	}
+
+protected:
+
+	//! Returns the index of the cell (along one dimension of a face) for a given position in [-1 ; 1]
+	unsigned cellIndex(double u) const
+	{
+		double c = std::floor((u + 1.0) / 2.0 * m_n);
+		return static_cast<unsigned>(std::max(0.0, std::min(c, static_cast<double>(m_n - 1))));
+	}
+
+	//! Returns the sector index
+	unsigned sectorIndex(unsigned face, unsigned iu, unsigned iv) const
+	{
+		return (face * m_n + iu) * m_n + iv;
+	}
+
+	//! Number of subdivisions (per face edge)
+	unsigned m_n;
+	//! Sector margin (in the face plane)
+	double m_margin;
+};
+
+CCCoreLib::ReferenceCloud* HPR::RemoveHiddenPoints(	CCCoreLib::GenericIndexedCloudPersist* theCloud,
+													const CCVector3d& viewPoint,
+													const Parameters& params,
+													CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	assert(theCloud);
+
+	unsigned nbPoints = theCloud->size();
+	if (nbPoints == 0)
+		return nullptr;
+
+	//less than 4 points? no need for calculation, we return the whole cloud
+	if (nbPoints < 4)
+	{
+		CCCoreLib::ReferenceCloud* visiblePoints = new CCCoreLib::ReferenceCloud(theCloud);
+		if (!visiblePoints->addPointIndex(0, nbPoints)) //well even for less than 4 points we never know ;)
+		{
+			//not enough memory!
+			delete visiblePoints;
+			visiblePoints = nullptr;
+		}
+		return visiblePoints;
+	}
+
+	//array to flag the visible points
+	std::vector<char> pointIsVisible;
+
+	if (params.sectorSubdivisions == 0)
+	{
+		double maxRadius = 0;
+		//points lying on the viewpoint (they can't be flipped)
+		std::vector<unsigned> viewpointIndexes;
+
+		//convert point cloud to an array of double triplets (for qHull)
+		coordT* pt_array = new coordT[(nbPoints + 1) * 3];
+		{
+			coordT* _pt_array = pt_array;
+
+			for (unsigned i = 0; i < nbPoints; ++i)
+			{
+				CCVector3d P = theCloud->getPoint(i)->toDouble() - viewPoint;
+				*_pt_array++ = static_cast<coordT>(P.x);
+				*_pt_array++ = static_cast<coordT>(P.y);
+				*_pt_array++ = static_cast<coordT>(P.z);
+
+				//we keep track of the highest 'radius'
+				double r2 = P.norm2();
+				if (maxRadius < r2)
+					maxRadius = r2;
+			}
+
+			//we add the view point (Cf. HPR)
+			*_pt_array++ = 0;
+			*_pt_array++ = 0;
+			*_pt_array++ = 0;
+
+			maxRadius = sqrt(maxRadius);
+		}
+
+		//apply spherical flipping
+		{
+			maxRadius *= pow(10.0, params.fParam) * 2;
+
+			coordT* _pt_array = pt_array;
+			for (unsigned i = 0; i < nbPoints; ++i)
+			{
+				CCVector3d P = theCloud->getPoint(i)->toDouble() - viewPoint;
+
+				double norm = P.norm();
+				if (norm == 0)
+				{
+					//the point lies on the viewpoint: it is left there (and flagged as visible below)
+					viewpointIndexes.push_back(i);
+					_pt_array += 3;
+					continue;
+				}
+
+				double r = (maxRadius / norm) - 1.0;
+				*_pt_array++ *= r;
+				*_pt_array++ *= r;
+				*_pt_array++ *= r;
+			}
+		}
+
+		std::vector<bool> pointBelongsToCvxHull;
+		if (FlagConvexHullVertices(pt_array, nbPoints + 1, pointBelongsToCvxHull))
+		{
+			try
+			{
+				pointIsVisible.assign(pointBelongsToCvxHull.begin(), pointBelongsToCvxHull.begin() + nbPoints);
+
+				//the points lying on the viewpoint are always visible
+				for (unsigned index : viewpointIndexes)
+				{
+					pointIsVisible[index] = 1;
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				//not enough memory!
+			}
+		}
+
+		delete[] pt_array;
+		pt_array = nullptr;
+	}
+	else
+	{
+		//sectors mode
+		SectorGrid grid(params.sectorSubdivisions, params.sectorOverlap_deg);
+		unsigned sectorCount = grid.count();
+
+		std::vector<CCVector3d> relativePos;
+		std::vector<unsigned> pointOwner;
+		std::vector< std::vector<unsigned> > sectorPoints;
+		try
+		{
+			relativePos.resize(nbPoints);
+			pointOwner.resize(nbPoints);
+			sectorPoints.resize(sectorCount);
+			pointIsVisible.resize(nbPoints, 0);
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory!
+			return nullptr;
+		}
+
+		//dispatch the points in the (enlarged) sectors
+		double maxRadius = 0;
+		try
+		{
+			for (unsigned i = 0; i < nbPoints; ++i)
+			{
+				CCVector3d P = theCloud->getPoint(i)->toDouble() - viewPoint;
+				relativePos[i] = P;
+
+				//we keep track of the highest 'radius'
+				double r2 = P.norm2();
+				if (maxRadius < r2)
+					maxRadius = r2;
+
+				if (r2 == 0)
+				{
+					//the point lies on the viewpoint: it doesn't belong to any sector and is always visible
+					pointOwner[i] = sectorCount;
+					pointIsVisible[i] = 1;
+					continue;
+				}
+
+				pointOwner[i] = grid.owner(P);
+				grid.forEachSector(P, [&](unsigned sectorIndex) { sectorPoints[sectorIndex].push_back(i); });
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory!
+			return nullptr;
+		}
+
+		//same flipping radius for all sectors
+		maxRadius = sqrt(maxRadius) * pow(10.0, params.fParam) * 2;
+
+		//non empty sectors
+		std::vector<unsigned> sectorIndexes;
+		for (unsigned s = 0; s < sectorCount; ++s)
+		{
+			if (!sectorPoints[s].empty())
+			{
+				sectorIndexes.push_back(s);
+			}
+		}
+
+		CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(sectorIndexes.size()));
+		if (progressCb)
+		{
+			if (progressCb->textCanBeEdited())
+			{
+				progressCb->setMethodTitle("Hidden Point Removal");
+				progressCb->setInfo(qPrintable(QString("Points: %1\nSectors: %2").arg(nbPoints).arg(sectorIndexes.size())));
+			}
+			progressCb->update(0);
+			progressCb->start();
+		}
+
+		std::atomic<bool> processFailed(false);
+		std::atomic<bool> processCanceled(false);
+
+		auto processSector = [&](unsigned s)
+		{
+			if (processFailed || processCanceled)
+			{
+				return;
+			}
+
+			const std::vector<unsigned>& indexes = sectorPoints[s];
+			unsigned count = static_cast<unsigned>(indexes.size());
+
+			bool success = false;
+			std::vector<bool> pointBelongsToCvxHull;
+			if (count >= 4)
+			{
+				coordT* pt_array = new (std::nothrow) coordT[(count + 1) * 3];
+				if (!pt_array)
+				{
+					processFailed = true;
+					return;
+				}
+
+				//apply spherical flipping
+				coordT* _pt_array = pt_array;
+				for (unsigned index : indexes)
+				{
+					const CCVector3d& P = relativePos[index];
+					double r = (maxRadius / P.norm()) - 1.0;
+					*_pt_array++ = static_cast<coordT>(P.x * r);
+					*_pt_array++ = static_cast<coordT>(P.y * r);
+					*_pt_array++ = static_cast<coordT>(P.z * r);
+				}
+
+				//we add the view point (Cf. HPR)
+				*_pt_array++ = 0;
+				*_pt_array++ = 0;
+				*_pt_array++ = 0;
+
+				success = FlagConvexHullVertices(pt_array, count + 1, pointBelongsToCvxHull);
+
+				delete[] pt_array;
+				pt_array = nullptr;
+			}
+
+			//we only keep the visibility of the points of this sector (each point has a single owner)
+			for (unsigned j = 0; j < count; ++j)
+			{
+				unsigned index = indexes[j];
+				if (pointOwner[index] == s)
+				{
+					//to be conservative, the points of a degenerate sector are considered as visible
+					pointIsVisible[index] = (success && !pointBelongsToCvxHull[j] ? 0 : 1);
+				}
+			}
+
+			if (progressCb && !nProgress.oneStep())
+			{
+				processCanceled = true;
+			}
+		};
+
+		int maxThreadCount = params.maxThreadCount;
+		if (maxThreadCount == 0)
+		{
+			maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+		}
+
+#ifndef _DEBUG
+		if (maxThreadCount > 1 && sectorIndexes.size() > 1)
+		{
+			QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+			QtConcurrent::blockingMap(sectorIndexes, processSector);
+		}
+		else
+#endif
+		{
+			for (unsigned s : sectorIndexes)
+			{
+				processSector(s);
+			}
+		}
+
+		if (progressCb)
+		{
+			progressCb->stop();
+		}
+
+		if (processFailed || processCanceled)
+		{
+			return nullptr;
+		}
+	}
+
+	if (!pointIsVisible.empty())
+	{
+		//compute the number of visible points
+		unsigned cvxHullSize = 0;
+		{
+			for (unsigned i = 0; i < nbPoints; ++i)
+				if (pointIsVisible[i])
+					++cvxHullSize;
+		}
+
+		CCCoreLib::ReferenceCloud* visiblePoints = new CCCoreLib::ReferenceCloud(theCloud);
+		if (cvxHullSize != 0 && visiblePoints->reserve(cvxHullSize))
+		{
+			for (unsigned i = 0; i < nbPoints; ++i)
+				if (pointIsVisible[i])
+					visiblePoints->addPointIndex(i); //can't fail, see above
+
+			return visiblePoints;
+
+		}
+		else //not enough memory
+		{
+			delete visiblePoints;
+			visiblePoints = nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+bool HPR::ComputeVisiblePoints(	ccPointCloud* cloud,
+								unsigned char octreeLevel,
+								const CCVector3d& viewPoint,
+								const Parameters& params,
+								CCCoreLib::ReferenceCloud& visiblePoints,
+								CCCoreLib::GenericProgressCallback* progressCb,
+								QString& errorMessage)
+{
+	assert(cloud && octreeLevel <= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
+
+	//compute octree if cloud hasn't any
+	ccOctree::Shared theOctree = cloud->getOctree();
+	if (!theOctree)
+	{
+		theOctree = cloud->computeOctree(progressCb);
+	}
+
+	if (!theOctree)
+	{
+		errorMessage = "Couldn't compute octree!";
+		return false;
+	}
+
+	//HPR
+	QScopedPointer<CCCoreLib::ReferenceCloud> visibleCells;
+	{
+		QElapsedTimer eTimer;
+		eTimer.start();
+
+		QScopedPointer<CCCoreLib::ReferenceCloud> theCellCenters( CCCoreLib::CloudSamplingTools::subsampleCloudWithOctreeAtLevel(	cloud,
+																											octreeLevel,
+																											CCCoreLib::CloudSamplingTools::NEAREST_POINT_TO_CELL_CENTER,
+																											progressCb,
+																											theOctree.data()) );
+		if (!theCellCenters)
+		{
+			errorMessage = "Error while simplifying point cloud with octree!";
+			return false;
+		}
+
+		visibleCells.reset(RemoveHiddenPoints(theCellCenters.data(), viewPoint, params, progressCb));
+		if (!visibleCells)
+		{
+			errorMessage = "Failed to compute the points visibility (not enough memory?)";
+			return false;
+		}
+
+		if (params.sectorSubdivisions != 0)
+		{
+			ccLog::Print(QString("[HPR] Cells: %1 - Sectors: %2 - Time: %3 s").arg(theCellCenters->size()).arg(SectorGrid(params.sectorSubdivisions, params.sectorOverlap_deg).count()).arg(eTimer.elapsed() / 1.0e3));
+		}
+		else
+		{
+			ccLog::Print(QString("[HPR] Cells: %1 - Time: %2 s").arg(theCellCenters->size()).arg(eTimer.elapsed() / 1.0e3));
+		}
+
+		//warning: after this point, visibleCells can't be used anymore as a
+		//normal cloud (as it's 'associated cloud' has been deleted).
+		//Only its indexes are valid! (they are corresponding to octree cells)
+	}
+
+	CCCoreLib::DgmOctree::cellIndexesContainer cellIndexes;
+	if (!theOctree->getCellIndexes(octreeLevel, cellIndexes))
+	{
+		errorMessage = "Couldn't fetch the list of octree cell indexes! (Not enough memory?)";
+		return false;
+	}
+
+	unsigned visibleCellsCount = visibleCells->size();
+	for (unsigned i = 0; i < visibleCellsCount; ++i)
+	{
+		//cell index
+		unsigned index = visibleCells->getPointGlobalIndex(i);
+
+		//points in this cell...
+		CCCoreLib::ReferenceCloud Yk(theOctree->associatedCloud());
+		theOctree->getPointsInCellByCellIndex(&Yk, cellIndexes[index], octreeLevel);
+		//...are all visible
+		if (!visiblePoints.add(Yk))
+		{
+			errorMessage = "Not enough memory!";
+			return false;
+		}
+	}
+
+	ccLog::Print(QString("[HPR] Visible points: %1").arg(visiblePoints.size()));
+
+	return true;
+}
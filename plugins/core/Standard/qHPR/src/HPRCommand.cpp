@@ -0,0 +1,203 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qHPR                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#include "HPRCommand.h"
+#include "HPR.h"
+
+//qCC_db
+#include <ccGBLSensor.h>
+#include <ccOctree.h>
+#include <ccPointCloud.h>
+#include <ccProgressDialog.h>
+
+//Qt
+#include <QScopedPointer>
+
+constexpr char COMMAND_HPR[] = "HPR";
+constexpr char COMMAND_HPR_VIEWPOINT[] = "VIEWPOINT";
+constexpr char COMMAND_HPR_OCTREE_LEVEL[] = "OCTREE_LEVEL";
+constexpr char COMMAND_HPR_SECTORS[] = "SECTORS";
+constexpr char COMMAND_HPR_SECTOR_OVERLAP[] = "SECTOR_OVERLAP";
+constexpr char COMMAND_HPR_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
+
+HPRCommand::HPRCommand()
+	: Command("HPR", COMMAND_HPR)
+{
+}
+
+bool HPRCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[HPR]");
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+
+	// Initialize to match the dialog defaults
+	int octreeLevel = 7;
+	bool customViewPoint = false;
+	CCVector3d viewPoint(0, 0, 0);
+	HPR::Parameters params;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_HPR_VIEWPOINT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().size() < 3)
+			{
+				return cmd.error(QObject::tr("Missing parameter(s): 3 coordinates expected after \"-%1\"").arg(COMMAND_HPR_VIEWPOINT));
+			}
+			for (unsigned char d = 0; d < 3; ++d)
+			{
+				bool conversionOk = false;
+				viewPoint.u[d] = cmd.arguments().takeFirst().toDouble(&conversionOk);
+				if (!conversionOk)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: coordinates after \"-%1\"").arg(COMMAND_HPR_VIEWPOINT));
+				}
+			}
+			customViewPoint = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_HPR_OCTREE_LEVEL))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: octree level after \"-%1\"").arg(COMMAND_HPR_OCTREE_LEVEL));
+			}
+			bool conversionOk = false;
+			octreeLevel = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || octreeLevel < 1 || octreeLevel > CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_HPR_OCTREE_LEVEL));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_HPR_SECTORS))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: sector subdivisions after \"-%1\"").arg(COMMAND_HPR_SECTORS));
+			}
+			bool conversionOk = false;
+			params.sectorSubdivisions = cmd.arguments().takeFirst().toUInt(&conversionOk);
+			if (!conversionOk)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_HPR_SECTORS));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_HPR_SECTOR_OVERLAP))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: sector overlap after \"-%1\"").arg(COMMAND_HPR_SECTOR_OVERLAP));
+			}
+			bool conversionOk = false;
+			params.sectorOverlap_deg = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || params.sectorOverlap_deg < 0 || params.sectorOverlap_deg > 44.0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\" (should be between 0 and 44 degrees)").arg(COMMAND_HPR_SECTOR_OVERLAP));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_HPR_MAX_THREAD_COUNT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after \"-%1\"").arg(COMMAND_HPR_MAX_THREAD_COUNT));
+			}
+			bool conversionOk = false;
+			params.maxThreadCount = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || params.maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_HPR_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	QScopedPointer<ccProgressDialog> progressDialog;
+	if (!cmd.silentMode())
+	{
+		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
+		progressDialog->setAutoClose(false);
+	}
+
+	std::vector<CLCloudDesc> newClouds;
+
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		ccPointCloud* cloud = desc.pc;
+		assert(cloud);
+
+		CCVector3d cloudViewPoint = viewPoint;
+		if (!customViewPoint)
+		{
+			//we look for the scanner position
+			ccHObject::Container sensors;
+			cloud->filterChildren(sensors, false, CC_TYPES::GBL_SENSOR, true);
+			CCVector3 sensorCenter;
+			if (sensors.empty() || !static_cast<ccGBLSensor*>(sensors.front())->getActiveAbsoluteCenter(sensorCenter))
+			{
+				return cmd.error(QObject::tr("Cloud '%1' has no sensor: set the viewpoint with \"-%2\"").arg(cloud->getName()).arg(COMMAND_HPR_VIEWPOINT));
+			}
+			cloudViewPoint = sensorCenter.toDouble();
+		}
+
+		cmd.print(QObject::tr("Cloud '%1' - viewpoint: (%2 ; %3 ; %4)").arg(cloud->getName()).arg(cloudViewPoint.x).arg(cloudViewPoint.y).arg(cloudViewPoint.z));
+
+		CCCoreLib::ReferenceCloud visiblePoints(cloud);
+		QString errorMessage;
+		if (!HPR::ComputeVisiblePoints(cloud, static_cast<unsigned char>(octreeLevel), cloudViewPoint, params, visiblePoints, progressDialog.data(), errorMessage))
+		{
+			return cmd.error(errorMessage);
+		}
+
+		ccPointCloud* newCloud = cloud->partialClone(&visiblePoints);
+		if (!newCloud)
+		{
+			return cmd.error(QObject::tr("Not enough memory"));
+		}
+		newCloud->setName(cloud->getName() + QString(".visible_points"));
+
+		CLCloudDesc newDesc(newCloud, desc.basename + QString("_HPR"), desc.path, desc.indexInFile);
+		newClouds.push_back(newDesc);
+
+		//save output
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(newDesc);
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
+		}
+	}
+
+	// replace the original clouds by the new ones
+	cmd.removeClouds();
+	cmd.clouds() = newClouds;
+
+	return true;
+}
@@ -26,4 +26,8 @@ ccHprDlg::ccHprDlg(QWidget* parent)
 	setupUi(this);
 
 	octreeLevelSpinBox->setRange(2, CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
+
+	//the overlap is only used with sectors
+	sectorOverlapDoubleSpinBox->setEnabled(false);
+	connect(sectorsSpinBox, qOverload<int>(&QSpinBox::valueChanged), [this](int value) { sectorOverlapDoubleSpinBox->setEnabled(value != 0); });
 }
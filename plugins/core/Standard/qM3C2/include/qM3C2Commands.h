@@ -25,6 +25,7 @@
 #include "qM3C2Process.h"
 
 static const char COMMAND_M3C2[] = "M3C2";
+static const char COMMAND_M3C2_EPOCHS[] = "M3C2_EPOCHS";
 
 struct CommandM3C2 : public ccCommandLineInterface::Command
 {
@@ -86,4 +87,73 @@ struct CommandM3C2 : public ccCommandLineInterface::Command
 	}
 };
 
+//! Multi-epoch M3C2: the first loaded cloud is the reference, all the other ones are compared to it
+struct CommandM3C2Epochs : public ccCommandLineInterface::Command
+{
+	CommandM3C2Epochs() : ccCommandLineInterface::Command("M3C2 (multi-epoch)", COMMAND_M3C2_EPOCHS) {}
+
+	virtual bool process(ccCommandLineInterface& cmd) override
+	{
+		cmd.print("[M3C2 - MULTI-EPOCH]");
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QString("Missing parameter: parameters filename after \"-%1\"").arg(COMMAND_M3C2_EPOCHS));
+		}
+
+		//open specified file
+		QString paramFilename(cmd.arguments().takeFirst());
+		cmd.print(QString("Parameters file: '%1'").arg(paramFilename));
+
+		if (cmd.clouds().size() < 2)
+		{
+			cmd.error("Not enough clouds loaded (at least 2 are expected: the reference cloud and one or more compared clouds)");
+			return false;
+		}
+
+		ccPointCloud* cloud1 = ccHObjectCaster::ToPointCloud(cmd.clouds()[0].pc);
+		std::vector<ccPointCloud*> epochs;
+		for (size_t i = 1; i < cmd.clouds().size(); ++i)
+		{
+			ccPointCloud* epoch = ccHObjectCaster::ToPointCloud(cmd.clouds()[i].pc);
+			if (!epoch)
+			{
+				return cmd.error(QString("Cloud #%1 is not a valid point cloud").arg(i + 1));
+			}
+			epochs.push_back(epoch);
+		}
+		cmd.print(QString("Compared epochs: %1").arg(epochs.size()));
+
+		//display dialog
+		qM3C2Dialog dlg(cloud1, epochs.front(), nullptr);
+		if (!dlg.loadParamsFromFile(paramFilename))
+		{
+			return false;
+		}
+
+		QString errorMessage;
+		ccPointCloud* outputCloud = nullptr; //only necessary for the command line version in fact
+		if (!qM3C2Process::ComputeMultiEpoch(dlg, epochs, errorMessage, outputCloud, !cmd.silentMode(), cmd.widgetParent()))
+		{
+			return cmd.error(errorMessage);
+		}
+
+		if (outputCloud)
+		{
+			CLCloudDesc cloudDesc(outputCloud, cmd.clouds().front().basename + QObject::tr("_M3C2_EPOCHS"), cmd.clouds().front().path);
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cloudDesc, QString(), 0, ccCommandLineInterface::ExportOption::ForceNoTimestamp);
+				if (!errorStr.isEmpty())
+				{
+					cmd.error(errorStr);
+				}
+			}
+			//add cloud to the current pool
+			cmd.clouds().push_back(cloudDesc);
+		}
+
+		return true;
+	}
+};
+
 #endif //M3C2_PLUGIN_COMMANDS_HEADER
@@ -0,0 +1,195 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qM3C2                       #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#            COPYRIGHT: UNIVERSITE EUROPEENNE DE BRETAGNE                #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_M3C2_ENGINE_HEADER
+#define Q_M3C2_ENGINE_HEADER
+
+//Local
+#include "qM3C2Dialog.h"
+
+//qCC_db
+#include <ccOctree.h>
+
+//CCCoreLib
+#include <GenericProgressCallback.h>
+
+//system
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace CCCoreLib
+{
+	class ScalarField;
+}
+
+class ccPointCloud;
+class ccScalarField;
+
+//! M3C2 distances computation engine
+/** All the parameters and the working state of a job are held by the
+	engine instance, so that several M3C2 jobs can run at the same time.
+
+	Core points are processed by batches of spatially close points: the
+	candidate points of each cloud are extracted once per batch (with a
+	single octree query enclosing all the cylinders of the batch) and then
+	shared by all the core points of this batch.
+**/
+class qM3C2Engine
+{
+public:
+
+	//! Precision maps
+	/** See "3D uncertainty-based topographic change detection with SfM photogrammetry:
+		precision maps for ground control and directly georeferenced surveys" by James et al.
+	**/
+	struct PrecisionMaps
+	{
+		bool valid() const { return (sX != nullptr && sY != nullptr && sZ != nullptr); }
+		CCCoreLib::ScalarField* sX = nullptr;
+		CCCoreLib::ScalarField* sY = nullptr;
+		CCCoreLib::ScalarField* sZ = nullptr;
+		double scale = 1.0;
+	};
+
+	//! Engine parameters
+	struct Params
+	{
+		//input data
+		ccPointCloud* outputCloud = nullptr;
+		ccPointCloud* corePoints = nullptr;
+		NormsIndexesTableType* coreNormals = nullptr;
+
+		//main options
+		PointCoordinateType projectionRadius = 0;
+		PointCoordinateType projectionDepth = 0;
+		bool updateNormal = false;
+		bool exportNormal = false;
+		bool useMedian = false;
+		bool computeConfidence = false;
+		bool progressiveSearch = false;
+		bool onlyPositiveSearch = false;
+		unsigned minPoints4Stats = 3;
+		double registrationRms = 0;
+
+		//export
+		qM3C2Dialog::ExportOptions exportOption = qM3C2Dialog::PROJECT_ON_CORE_POINTS;
+		bool keepOriginalCloud = false;
+
+		//octrees
+		ccOctree::Shared cloud1Octree;
+		unsigned char level1 = 0;
+		ccOctree::Shared cloud2Octree;
+		unsigned char level2 = 0;
+
+		//scalar fields
+		ccScalarField* m3c2DistSF = nullptr;		//M3C2 distance
+		ccScalarField* distUncertaintySF = nullptr;	//distance uncertainty
+		ccScalarField* sigChangeSF = nullptr;		//significant change
+		ccScalarField* stdDevCloud1SF = nullptr;	//standard deviation information for cloud #1
+		ccScalarField* stdDevCloud2SF = nullptr;	//standard deviation information for cloud #2
+		ccScalarField* densityCloud1SF = nullptr;	//export point density at projection scale for cloud #1
+		ccScalarField* densityCloud2SF = nullptr;	//export point density at projection scale for cloud #2
+
+		//precision maps
+		PrecisionMaps cloud1PM, cloud2PM;
+		bool usePrecisionMaps = false;
+	};
+
+	//! Computation result
+	enum Result
+	{
+		SUCCESS,
+		CANCELED_BY_USER,
+		NOT_ENOUGH_MEMORY,
+	};
+
+	//! Default constructor
+	explicit qM3C2Engine(const Params& params);
+
+	//! Returns the engine parameters
+	const Params& params() const { return m_params; }
+	//! Returns the engine parameters
+	/** Typically used to change cloud #2 (octree, level, precision maps)
+		and the output scalar fields between two epochs.
+	**/
+	Params& params() { return m_params; }
+
+	//! Computes and caches the statistics of cloud #1 for all core points
+	/** Once done, the next calls to computeDistances will only process cloud #2.
+		Cloud #1, the core points and their normals must not change afterwards.
+		\param maxThreadCount max number of threads (0 = all)
+		\param progressCb progress callback (optional)
+		\return the computation result
+	**/
+	Result prepareReference(int maxThreadCount = 0, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Returns whether the statistics of cloud #1 have already been cached
+	bool referenceIsReady() const { return !m_referenceStats.empty(); }
+
+	//! Computes the M3C2 distances for all core points
+	/** The output scalar fields (see Params) must have already been allocated
+		(one value per core point) and initialized with their default values.
+		\param maxThreadCount max number of threads (0 = all)
+		\param progressCb progress callback (optional)
+		\return the computation result
+	**/
+	Result computeDistances(int maxThreadCount = 0, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+protected: //methods
+
+	//! Sorts the core points by batch (i.e. by cell of a regular grid)
+	bool buildBatches();
+
+	//! Processes all the batches (in parallel if possible)
+	Result processAllBatches(int maxThreadCount, CCCoreLib::GenericProgressCallback* progressCb, const QString& title);
+
+	//! Processes all the core points of a given batch
+	void processBatch(unsigned batchIndex);
+
+protected: //members
+
+	//! Statistics of cloud #1 around a core point
+	struct ReferenceStats
+	{
+		ScalarType mean = 0;
+		ScalarType stdDev = 0;
+		unsigned count = 0;
+	};
+
+	//! Parameters
+	Params m_params;
+
+	//! Core point indexes (sorted by batch)
+	std::vector<unsigned> m_sortedIndexes;
+	//! Start position of each batch in m_sortedIndexes (plus one last 'end' position)
+	std::vector<size_t> m_batchStarts;
+
+	//! Cached statistics of cloud #1 (one per core point)
+	std::vector<ReferenceStats> m_referenceStats;
+	//! Whether the current pass only computes the statistics of cloud #1
+	bool m_referenceOnly;
+
+	//! Progress notification
+	CCCoreLib::NormalizedProgress* m_nProgress;
+	//! Whether the process has been canceled
+	std::atomic<bool> m_processCanceled;
+	//! Whether the process has failed
+	std::atomic<bool> m_processFailed;
+};
+
+#endif //Q_M3C2_ENGINE_HEADER
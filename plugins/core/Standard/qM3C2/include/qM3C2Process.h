@@ -21,6 +21,9 @@
 //Local
 #include "qM3C2Dialog.h"
 
+//system
+#include <vector>
+
 class ccMainAppInterface;
 
 //! M3C2 process
@@ -39,6 +42,21 @@ public:
 						QWidget* parentWidget = nullptr,
 						ccMainAppInterface* app = nullptr);
 
+	//! Multi-epoch version: compares the dialog's cloud #1 with several clouds
+	/** The core points, their normals and the statistics of cloud #1 are
+		computed only once. One set of scalar fields (distance, uncertainty,
+		etc.) is generated per compared cloud (epoch).
+		\warning If several epochs are compared, the output points can't be
+		projected on cloud #2 (core points are used instead).
+	**/
+	static bool ComputeMultiEpoch(	const qM3C2Dialog& dlg,
+									const std::vector<ccPointCloud*>& epochs,
+									QString& errorMessage,
+									ccPointCloud*& outputCloud,
+									bool allowDialogs,
+									QWidget* parentWidget = nullptr,
+									ccMainAppInterface* app = nullptr);
+
 };
 
 #endif //Q_M3C2_PROCESS_HEADER
@@ -0,0 +1,686 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qM3C2                       #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#            COPYRIGHT: UNIVERSITE EUROPEENNE DE BRETAGNE                #
+//#                                                                        #
+//##########################################################################
+
+#include "qM3C2Engine.h"
+
+//local
+#include "qM3C2Tools.h"
+
+//qCC_plugins
+#include <ccQtHelpers.h>
+
+//qCC_db
+#include <ccCloudBatches.h>
+#include <ccPointCloud.h>
+#include <ccNormalVectors.h>
+#include <ccScalarField.h>
+
+//Qt
+#include <QtCore>
+#include <QtConcurrentMap>
+
+//system
+#include <algorithm>
+#include <cmath>
+
+static ScalarType SCALAR_ONE = 1;
+
+// Computes the uncertainty based on 'precision maps' (as scattered scalar fields)
+static double ComputePMUncertainty(const CCCoreLib::DgmOctree::NeighboursSet& set, const CCVector3& N, const qM3C2Engine::PrecisionMaps& PM)
+{
+	size_t count = set.size();
+	if (count == 0)
+	{
+		assert(false);
+		return 0;
+	}
+
+	int minIndex = -1;
+	if (count == 1)
+	{
+		minIndex = 0;
+	}
+	else
+	{
+		//compute gravity center
+		CCVector3d G(0, 0, 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			G.x += set[i].point->x;
+			G.y += set[i].point->y;
+			G.z += set[i].point->z;
+		}
+
+		G.x /= count;
+		G.y /= count;
+		G.z /= count;
+
+		//now look for the point that is the closest to the gravity center
+		double minSquareDist = -1.0;
+		minIndex = -1;
+		for (size_t i = 0; i < count; ++i)
+		{
+			CCVector3d dG(	G.x - set[i].point->x,
+							G.y - set[i].point->y,
+							G.z - set[i].point->z );
+			double squareDist = dG.norm2();
+			if (minIndex < 0 || squareDist < minSquareDist)
+			{
+				minSquareDist = squareDist;
+				minIndex = static_cast<int>(i);
+			}
+		}
+	}
+
+	assert(minIndex >= 0);
+	unsigned pointIndex = set[minIndex].pointIndex;
+	CCVector3d sigma(	PM.sX->getValue(pointIndex) * PM.scale,
+						PM.sY->getValue(pointIndex) * PM.scale,
+						PM.sZ->getValue(pointIndex) * PM.scale);
+
+	CCVector3d NS(	N.x * sigma.x,
+					N.y * sigma.y,
+					N.z * sigma.z);
+
+	return NS.norm();
+}
+
+//! Geometry of a batch of core points
+struct BatchGeometry
+{
+	//! Center of the batch bounding-box
+	CCVector3 center;
+	//! Radius of the batch bounding-sphere
+	PointCoordinateType radius = 0;
+	//! Mean normal
+	CCVector3 meanNormal;
+	//! Sine of the max angle between the core points normals and the mean normal
+	/** Or a negative value if the normals are too scattered (or invalid).
+	**/
+	PointCoordinateType sinMaxAngle = -1;
+};
+
+//! Extracts the points of an octree that may lie in the cylinders of a whole batch
+/** The returned set is a superset of the union of all the cylinders:
+	- either a wider and longer cylinder around the mean normal (if the normals of the batch are close enough)
+	- or a sphere enclosing all the cylinders (otherwise)
+**/
+static void ExtractBatchCandidates(	const ccOctree& octree,
+									unsigned char level,
+									const BatchGeometry& batch,
+									PointCoordinateType projectionRadius,
+									PointCoordinateType projectionDepth,
+									CCCoreLib::DgmOctree::NeighboursSet& candidates)
+{
+	candidates.clear();
+
+	if (batch.sinMaxAngle >= 0)
+	{
+		//a point Q of the cylinder (P, N) is such that Q = P + t.N + w (with |t| <= depth, |w| <= radius and w.N = 0)
+		//therefore, relatively to the batch center C and the mean normal M:
+		//	- |(Q - C).M| <= |P - C| + depth + radius.sin(angle)
+		//	- dist(Q, axis(C, M)) <= |P - C| + depth.sin(angle) + radius
+		CCCoreLib::DgmOctree::CylindricalNeighbourhood cn;
+		cn.center = batch.center;
+		cn.dir = batch.meanNormal;
+		cn.level = level;
+		cn.radius = projectionRadius + batch.radius + projectionDepth * batch.sinMaxAngle;
+		cn.maxHalfLength = projectionDepth + batch.radius + projectionRadius * batch.sinMaxAngle;
+		cn.onlyPositiveDir = false;
+
+		octree.getPointsInCylindricalNeighbourhood(cn);
+		candidates.swap(cn.neighbours);
+	}
+	else
+	{
+		PointCoordinateType radius = batch.radius + std::sqrt(projectionRadius * projectionRadius + projectionDepth * projectionDepth);
+		octree.getPointsInSphericalNeighbourhood(batch.center, radius, candidates, level);
+	}
+}
+
+//! Extracts the points of a cylinder from a (superset of) candidate points
+/** Same convention as DgmOctree::getPointsInCylindricalNeighbourhood: the
+	'squareDistd' field of each neighbour stores its signed position along the
+	cylinder axis.
+**/
+static void ExtractCylinder(const CCCoreLib::DgmOctree::NeighboursSet& candidates,
+							const CCVector3& P,
+							const CCVector3& N,
+							PointCoordinateType radius,
+							PointCoordinateType maxHalfLength,
+							bool onlyPositiveDir,
+							CCCoreLib::DgmOctree::NeighboursSet& neighbours)
+{
+	neighbours.clear();
+
+	PointCoordinateType squareRadius = radius * radius;
+	PointCoordinateType minHalfLength = (onlyPositiveDir ? 0 : -maxHalfLength);
+	for (const CCCoreLib::DgmOctree::PointDescriptor& candidate : candidates)
+	{
+		CCVector3 PQ = *candidate.point - P;
+		PointCoordinateType t = PQ.dot(N);
+		if (t < minHalfLength || t > maxHalfLength)
+		{
+			continue;
+		}
+		if (PQ.norm2() - t * t <= squareRadius)
+		{
+			neighbours.emplace_back(candidate.point, candidate.pointIndex, static_cast<double>(t));
+		}
+	}
+}
+
+//! Computes the statistics of one side (cloud) for a given core point
+/** Emulates the progressive cylindrical search if necessary (i.e. the
+	cylinder grows by one octree cell at a time until the statistics are
+	sharp enough).
+	\param cylinder the full cylinder points (output: the points actually used)
+	\param[out] mean the mean (or median) position along the cylinder axis
+	\param[out] stdDev the std. dev. (or IQR) of the positions along the cylinder axis
+	\param buffer a temporary buffer
+**/
+static void ComputeSideStatistics(	CCCoreLib::DgmOctree::NeighboursSet& cylinder,
+									const qM3C2Engine::Params& params,
+									PointCoordinateType step,
+									double& mean,
+									double& stdDev,
+									CCCoreLib::DgmOctree::NeighboursSet& buffer)
+{
+	mean = 0;
+	stdDev = 0;
+
+	if (cylinder.empty())
+	{
+		return;
+	}
+
+	if (!params.progressiveSearch || step <= 0)
+	{
+		qM3C2Tools::ComputeStatistics(cylinder, params.useMedian, mean, stdDev);
+		return;
+	}
+
+	//sort the neighbours by (absolute) position along the axis
+	std::sort(cylinder.begin(), cylinder.end(), [](const CCCoreLib::DgmOctree::PointDescriptor& a, const CCCoreLib::DgmOctree::PointDescriptor& b)
+	{
+		return std::abs(a.squareDistd) < std::abs(b.squareDistd);
+	});
+
+	size_t count = cylinder.size();
+	size_t usedCount = count;
+	bool validStats = false;
+	size_t previousNeighbourCount = 0;
+	size_t neighbourCount = 0;
+	PointCoordinateType currentHalfLength = 0;
+	while (currentHalfLength < params.projectionDepth)
+	{
+		currentHalfLength = std::min(currentHalfLength + step, params.projectionDepth);
+		while (neighbourCount < count && std::abs(cylinder[neighbourCount].squareDistd) <= currentHalfLength)
+		{
+			++neighbourCount;
+		}
+
+		if (neighbourCount != previousNeighbourCount)
+		{
+			//do we have enough points for computing stats?
+			if (neighbourCount >= params.minPoints4Stats)
+			{
+				buffer.assign(cylinder.begin(), cylinder.begin() + neighbourCount);
+				qM3C2Tools::ComputeStatistics(buffer, params.useMedian, mean, stdDev);
+				validStats = true;
+				usedCount = neighbourCount;
+				//do we have a sharp enough 'mean' to stop?
+				if (std::abs(mean) + 2 * stdDev < static_cast<double>(currentHalfLength))
+					break;
+			}
+			previousNeighbourCount = neighbourCount;
+		}
+	}
+
+	if (validStats)
+	{
+		cylinder.resize(usedCount);
+	}
+	else
+	{
+		qM3C2Tools::ComputeStatistics(cylinder, params.useMedian, mean, stdDev);
+	}
+}
+
+qM3C2Engine::qM3C2Engine(const Params& params)
+	: m_params(params)
+	, m_referenceOnly(false)
+	, m_nProgress(nullptr)
+	, m_processCanceled(false)
+	, m_processFailed(false)
+{
+}
+
+bool qM3C2Engine::buildBatches()
+{
+	//we group the core points by cells of the size of the cylinders diameter
+	return ccCloudBatches::BuildGridBatches(m_params.corePoints, 2 * m_params.projectionRadius, m_sortedIndexes, m_batchStarts);
+}
+
+void qM3C2Engine::processBatch(unsigned batchIndex)
+{
+	if (m_processCanceled)
+		return;
+
+	const size_t batchStart = m_batchStarts[batchIndex];
+	const size_t batchSize = m_batchStarts[batchIndex + 1] - batchStart;
+	const unsigned* indexes = m_sortedIndexes.data() + batchStart;
+
+	try
+	{
+		//get the core points (and their normals)
+		std::vector<CCVector3> corePoints(batchSize);
+		std::vector<CCVector3> coreNormals(batchSize, CCVector3(0, 0, 1));
+
+		BatchGeometry batch;
+		{
+			CCVector3 bbMin = *m_params.corePoints->getPoint(indexes[0]);
+			CCVector3 bbMax = bbMin;
+			CCVector3 sumN(0, 0, 0);
+			bool validNormals = true;
+			for (size_t i = 0; i < batchSize; ++i)
+			{
+				const CCVector3& P = corePoints[i] = *m_params.corePoints->getPoint(indexes[i]);
+				bbMin.x = std::min(bbMin.x, P.x);
+				bbMin.y = std::min(bbMin.y, P.y);
+				bbMin.z = std::min(bbMin.z, P.z);
+				bbMax.x = std::max(bbMax.x, P.x);
+				bbMax.y = std::max(bbMax.y, P.y);
+				bbMax.z = std::max(bbMax.z, P.z);
+
+				if (m_params.updateNormal) //i.e. all cases but the VERTICAL mode
+				{
+					coreNormals[i] = ccNormalVectors::GetNormal(m_params.coreNormals->getValue(indexes[i]));
+					if (coreNormals[i].norm2() < 0.5)
+					{
+						validNormals = false;
+					}
+				}
+				sumN += coreNormals[i];
+			}
+			batch.center = (bbMin + bbMax) / 2;
+			batch.radius = (bbMax - bbMin).norm() / 2;
+
+			//are the normals close enough to share a common (enlarged) cylinder?
+			PointCoordinateType sumNorm = sumN.norm();
+			if (validNormals && sumNorm > 0)
+			{
+				batch.meanNormal = sumN / sumNorm;
+				PointCoordinateType minDot = 1;
+				for (size_t i = 0; i < batchSize; ++i)
+				{
+					minDot = std::min(minDot, coreNormals[i].dot(batch.meanNormal));
+				}
+				if (minDot >= static_cast<PointCoordinateType>(0.866)) //30 degrees
+				{
+					batch.sinMaxAngle = std::sqrt(std::max(static_cast<PointCoordinateType>(0), 1 - minDot * minDot));
+				}
+			}
+		}
+
+		const PointCoordinateType step1 = m_params.cloud1Octree->getCellSize(m_params.level1);
+		const PointCoordinateType step2 = (m_params.cloud2Octree ? m_params.cloud2Octree->getCellSize(m_params.level2) : 0);
+
+		//candidate points (shared by all the core points of the batch)
+		CCCoreLib::DgmOctree::NeighboursSet candidates1;
+		CCCoreLib::DgmOctree::NeighboursSet candidates2;
+		bool candidates1Extracted = false;
+		bool candidates2Extracted = false;
+		const bool useReferenceStats = (!m_referenceOnly && !m_referenceStats.empty());
+
+		//per core point buffers
+		CCCoreLib::DgmOctree::NeighboursSet cylinder1;
+		CCCoreLib::DgmOctree::NeighboursSet cylinder2;
+		CCCoreLib::DgmOctree::NeighboursSet buffer;
+
+		for (size_t i = 0; i < batchSize; ++i)
+		{
+			if (m_processCanceled)
+				return;
+
+			const unsigned index = indexes[i];
+			const CCVector3& P = corePoints[i];
+			const CCVector3& N = coreNormals[i];
+
+			//output point
+			CCVector3 outputP = P;
+
+			ScalarType dist = CCCoreLib::NAN_VALUE;
+			double mean1 = 0;
+			double stdDev1 = 0;
+			size_t n1 = 0;
+
+			if (useReferenceStats)
+			{
+				//use the cached statistics of cloud #1
+				const ReferenceStats& stats = m_referenceStats[index];
+				mean1 = stats.mean;
+				stdDev1 = stats.stdDev;
+				n1 = stats.count;
+			}
+			else
+			{
+				if (!candidates1Extracted)
+				{
+					ExtractBatchCandidates(*m_params.cloud1Octree, m_params.level1, batch, m_params.projectionRadius, m_params.projectionDepth, candidates1);
+					candidates1Extracted = true;
+				}
+
+				//extract cloud #1's neighbourhood
+				ExtractCylinder(candidates1, P, N, m_params.projectionRadius, m_params.projectionDepth, m_params.onlyPositiveSearch, cylinder1);
+				ComputeSideStatistics(cylinder1, m_params, step1, mean1, stdDev1, buffer);
+
+				n1 = cylinder1.size();
+				if (n1 != 0 && m_params.usePrecisionMaps && (m_referenceOnly || m_params.computeConfidence || m_params.stdDevCloud1SF))
+				{
+					//compute the Precision Maps derived sigma
+					stdDev1 = ComputePMUncertainty(cylinder1, N, m_params.cloud1PM);
+				}
+
+				if (m_referenceOnly)
+				{
+					//we only cache the statistics of cloud #1
+					ReferenceStats& stats = m_referenceStats[index];
+					stats.mean = static_cast<ScalarType>(mean1);
+					stats.stdDev = static_cast<ScalarType>(stdDev1);
+					stats.count = static_cast<unsigned>(n1);
+					continue;
+				}
+			}
+
+			if (n1 != 0)
+			{
+				if (m_params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD1)
+				{
+					//shift output point on the 1st cloud
+					outputP += static_cast<PointCoordinateType>(mean1) * N;
+				}
+
+				//save cloud #1's std. dev.
+				if (m_params.stdDevCloud1SF)
+				{
+					ScalarType val = static_cast<ScalarType>(stdDev1);
+					m_params.stdDevCloud1SF->setValue(index, val);
+				}
+			}
+
+			//save cloud #1's density
+			if (m_params.densityCloud1SF)
+			{
+				ScalarType val = static_cast<ScalarType>(n1);
+				m_params.densityCloud1SF->setValue(index, val);
+			}
+
+			//now we can process cloud #2
+			if (	n1 != 0
+				||	m_params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2
+				||	m_params.stdDevCloud2SF
+				||	m_params.densityCloud2SF
+				)
+			{
+				if (!candidates2Extracted)
+				{
+					ExtractBatchCandidates(*m_params.cloud2Octree, m_params.level2, batch, m_params.projectionRadius, m_params.projectionDepth, candidates2);
+					candidates2Extracted = true;
+				}
+
+				double mean2 = 0;
+				double stdDev2 = 0;
+
+				//extract cloud #2's neighbourhood
+				ExtractCylinder(candidates2, P, N, m_params.projectionRadius, m_params.projectionDepth, m_params.onlyPositiveSearch, cylinder2);
+				ComputeSideStatistics(cylinder2, m_params, step2, mean2, stdDev2, buffer);
+
+				size_t n2 = cylinder2.size();
+				if (n2 != 0)
+				{
+					assert(stdDev2 != stdDev2 || stdDev2 >= 0); //first inequality fails if stdDev2 is NaN ;)
+
+					if (m_params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2)
+					{
+						//shift output point on the 2nd cloud
+						outputP += static_cast<PointCoordinateType>(mean2) * N;
+					}
+
+					if (m_params.usePrecisionMaps && (m_params.computeConfidence || m_params.stdDevCloud2SF))
+					{
+						//compute the Precision Maps derived sigma
+						stdDev2 = ComputePMUncertainty(cylinder2, N, m_params.cloud2PM);
+					}
+
+					if (n1 != 0)
+					{
+						//m3c2 dist = distance between i1 and i2 (i.e. either the mean or the median of both neighborhoods)
+						dist = static_cast<ScalarType>(mean2 - mean1);
+						m_params.m3c2DistSF->setValue(index, dist);
+
+						//confidence interval
+						if (m_params.computeConfidence)
+						{
+							ScalarType LODStdDev = CCCoreLib::NAN_VALUE;
+							if (m_params.usePrecisionMaps)
+							{
+								LODStdDev = stdDev1*stdDev1 + stdDev2*stdDev2; //equation (2) in M3C2-PM article
+							}
+							//standard M3C2 algortihm: have we enough points for computing the confidence interval?
+							else if (n1 >= m_params.minPoints4Stats && n2 >= m_params.minPoints4Stats)
+							{
+								LODStdDev = (stdDev1*stdDev1) / n1 + (stdDev2*stdDev2) / n2;
+							}
+
+							if (!std::isnan(LODStdDev))
+							{
+								//distance uncertainty (see eq. (1) in M3C2 article)
+								ScalarType LOD = static_cast<ScalarType>(1.96 * (sqrt(LODStdDev) + m_params.registrationRms));
+
+								if (m_params.distUncertaintySF)
+								{
+									m_params.distUncertaintySF->setValue(index, LOD);
+								}
+
+								if (m_params.sigChangeSF)
+								{
+									bool significant = (dist < -LOD || dist > LOD);
+									if (significant)
+									{
+										m_params.sigChangeSF->setValue(index, SCALAR_ONE); //already equal to SCALAR_ZERO otherwise
+									}
+								}
+							}
+							//else //DGM: scalar fields have already been initialized with the right 'default' values
+						}
+					}
+
+					//save cloud #2's std. dev.
+					if (m_params.stdDevCloud2SF)
+					{
+						ScalarType val = static_cast<ScalarType>(stdDev2);
+						m_params.stdDevCloud2SF->setValue(index, val);
+					}
+				}
+
+				//save cloud #2's density
+				if (m_params.densityCloud2SF)
+				{
+					ScalarType val = static_cast<ScalarType>(n2);
+					m_params.densityCloud2SF->setValue(index, val);
+				}
+			}
+
+			//output point
+			if (m_params.outputCloud != m_params.corePoints)
+			{
+				*const_cast<CCVector3*>(m_params.outputCloud->getPoint(index)) = outputP;
+			}
+			if (m_params.exportNormal)
+			{
+				m_params.outputCloud->setPointNormal(index, N);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//Not enough memory
+		m_processFailed = true;
+		return;
+	}
+
+	//progress notification
+	if (m_nProgress && !m_nProgress->steps(static_cast<unsigned>(batchSize)))
+	{
+		m_processCanceled = true;
+	}
+}
+
+qM3C2Engine::Result qM3C2Engine::processAllBatches(int maxThreadCount, CCCoreLib::GenericProgressCallback* progressCb, const QString& title)
+{
+	m_processCanceled = false;
+	m_processFailed = false;
+
+	if (m_batchStarts.empty() && !buildBatches())
+	{
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	unsigned corePointCount = m_params.corePoints->size();
+	unsigned batchCount = static_cast<unsigned>(m_batchStarts.empty() ? 0 : m_batchStarts.size() - 1);
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, corePointCount);
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle(qPrintable(title));
+			progressCb->setInfo(qPrintable(QString("Core points: %1").arg(corePointCount)));
+		}
+		progressCb->start();
+	}
+	m_nProgress = (progressCb ? &nProgress : nullptr);
+
+	std::vector<unsigned> batchIndexes;
+	bool useParallelStrategy = true;
+#ifdef _DEBUG
+	useParallelStrategy = false;
+#endif
+	if (useParallelStrategy)
+	{
+		try
+		{
+			batchIndexes.resize(batchCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			useParallelStrategy = false;
+		}
+	}
+
+	if (useParallelStrategy)
+	{
+		for (unsigned i = 0; i < batchCount; ++i)
+		{
+			batchIndexes[i] = i;
+		}
+
+		if (maxThreadCount == 0)
+		{
+			maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+		}
+		assert(maxThreadCount > 0 && maxThreadCount <= QThread::idealThreadCount());
+		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+		QtConcurrent::blockingMap(batchIndexes, [this](unsigned batchIndex) { processBatch(batchIndex); });
+	}
+	else
+	{
+		//manually call the per-batch method!
+		for (unsigned i = 0; i < batchCount; ++i)
+		{
+			processBatch(i);
+		}
+	}
+
+	m_nProgress = nullptr;
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (m_processCanceled)
+	{
+		return CANCELED_BY_USER;
+	}
+	else if (m_processFailed)
+	{
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	return SUCCESS;
+}
+
+qM3C2Engine::Result qM3C2Engine::prepareReference(int maxThreadCount/*=0*/, CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (	!m_params.corePoints
+		||	!m_params.cloud1Octree
+		||	(m_params.updateNormal && !m_params.coreNormals))
+	{
+		assert(false);
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	try
+	{
+		m_referenceStats.resize(m_params.corePoints->size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	m_referenceOnly = true;
+	Result result = processAllBatches(maxThreadCount, progressCb, "M3C2 Reference Statistics");
+	m_referenceOnly = false;
+
+	if (result != SUCCESS)
+	{
+		m_referenceStats.clear();
+		m_referenceStats.shrink_to_fit();
+	}
+
+	return result;
+}
+
+qM3C2Engine::Result qM3C2Engine::computeDistances(int maxThreadCount/*=0*/, CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (	!m_params.corePoints
+		||	!m_params.outputCloud
+		||	!m_params.cloud1Octree
+		||	!m_params.cloud2Octree
+		||	!m_params.m3c2DistSF
+		||	(m_params.updateNormal && !m_params.coreNormals))
+	{
+		assert(false);
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	return processAllBatches(maxThreadCount, progressCb, "M3C2 Distances Computation");
+}
@@ -20,13 +20,13 @@
 //local
 #include "qM3C2Tools.h"
 #include "qM3C2Dialog.h"
+#include "qM3C2Engine.h"
 
 //CCCoreLib
 #include <CloudSamplingTools.h>
 
 //qCC_plugins
 #include <ccMainAppInterface.h>
-#include <ccQtHelpers.h>
 
 //qCC_db
 #include <ccGenericPointCloud.h>
@@ -43,9 +43,11 @@
 #include <QtCore>
 #include <QApplication>
 #include <QElapsedTimer>
-#include <QtConcurrentMap>
 #include <QMessageBox>
 
+//system
+#include <algorithm>
+
 //! Default name for M3C2 scalar fields
 static const char M3C2_DIST_SF_NAME[]			= "M3C2 distance";
 static const char DIST_UNCERTAINTY_SF_NAME[]	= "distance uncertainty";
@@ -68,398 +70,88 @@ static void RemoveScalarField(ccPointCloud* cloud, const std::string& sfName)
 static ScalarType SCALAR_ZERO = 0;
 static ScalarType SCALAR_ONE = 1;
 
-// Precision maps (See "3D uncertainty-based topographic change detection with SfM photogrammetry: precision maps for ground control and directly georeferenced surveys" by James et al.)
-struct PrecisionMaps
-{
-	PrecisionMaps() : sX(nullptr), sY(nullptr), sZ(nullptr), scale(1.0) {}
-	bool valid() const { return (sX != nullptr && sY != nullptr && sZ != nullptr); }
-	CCCoreLib::ScalarField *sX, *sY, *sZ;
-	double scale;
-};
-
-// Computes the uncertainty based on 'precision maps' (as scattered scalar fields)
-static double ComputePMUncertainty(CCCoreLib::DgmOctree::NeighboursSet& set, const CCVector3& N, const PrecisionMaps& PM)
+//! Creates a scalar field with one value per core point (or returns nullptr if not enough memory)
+static ccScalarField* CreateOutputSF(const QString& name, unsigned count, ScalarType defaultValue)
 {
-	size_t count = set.size();
-	if (count == 0)
-	{
-		assert(false);
-		return 0;
-	}
-	
-	int minIndex = -1;
-	if (count == 1)
-	{
-		minIndex = 0;
-	}
-	else
+	ccScalarField* sf = new ccScalarField(name.toStdString());
+	sf->link();
+	if (!sf->resizeSafe(count, true, defaultValue))
 	{
-		//compute gravity center
-		CCVector3d G(0, 0, 0);
-		for (size_t i = 0; i < count; ++i)
-		{
-			G.x += set[i].point->x;
-			G.y += set[i].point->y;
-			G.z += set[i].point->z;
-		}
-
-		G.x /= count;
-		G.y /= count;
-		G.z /= count;
-
-		//now look for the point that is the closest to the gravity center
-		double minSquareDist = -1.0;
-		minIndex = -1;
-		for (size_t i = 0; i < count; ++i)
-		{
-			CCVector3d dG(	G.x - set[i].point->x,
-							G.y - set[i].point->y,
-							G.z - set[i].point->z );
-			double squareDist = dG.norm2();
-			if (minIndex < 0 || squareDist < minSquareDist)
-			{
-				minSquareDist = squareDist;
-				minIndex = static_cast<int>(i);
-			}
-		}
+		sf->release();
+		return nullptr;
 	}
-	
-	assert(minIndex >= 0);
-	unsigned pointIndex = set[minIndex].pointIndex;
-	CCVector3d sigma(	PM.sX->getValue(pointIndex) * PM.scale,
-						PM.sY->getValue(pointIndex) * PM.scale,
-						PM.sZ->getValue(pointIndex) * PM.scale);
-
-	CCVector3d NS(	N.x * sigma.x,
-					N.y * sigma.y,
-					N.z * sigma.z);
-	
-	return NS.norm();
+	return sf;
 }
 
-// Structure for parallel call to ComputeM3C2DistForPoint
-struct M3C2Params
+//! Retrieves the precision maps of a compared cloud (i.e. cloud #2 or any other epoch)
+/** For clouds other than the dialog's cloud #2, the scalar fields are looked for by name.
+**/
+static bool GetComparedCloudPrecisionMaps(const qM3C2Dialog& dlg, ccPointCloud* cloud, qM3C2Engine::PrecisionMaps& PM)
 {
-	//input data
-	ccPointCloud* outputCloud = nullptr;
-	ccPointCloud* corePoints = nullptr;
-	NormsIndexesTableType* coreNormals = nullptr;
-
-	//main options
-	PointCoordinateType projectionRadius = 0;
-	PointCoordinateType projectionDepth = 0;
-	bool updateNormal = false;
-	bool exportNormal = false;
-	bool useMedian = false;
-	bool computeConfidence = false;
-	bool progressiveSearch = false;
-	bool onlyPositiveSearch = false;
-	unsigned minPoints4Stats = 3;
-	double registrationRms = 0;
-
-	//export
-	qM3C2Dialog::ExportOptions exportOption;
-	bool keepOriginalCloud = false;
-
-	//octrees
-	ccOctree::Shared cloud1Octree;
-	unsigned char level1 = 0;
-	ccOctree::Shared cloud2Octree;
-	unsigned char level2 = 0;
-
-	//scalar fields
-	ccScalarField* m3c2DistSF = nullptr;		//M3C2 distance
-	ccScalarField* distUncertaintySF = nullptr;	//distance uncertainty
-	ccScalarField* sigChangeSF = nullptr;		//significant change
-	ccScalarField* stdDevCloud1SF = nullptr;	//standard deviation information for cloud #1
-	ccScalarField* stdDevCloud2SF = nullptr;	//standard deviation information for cloud #2
-	ccScalarField* densityCloud1SF = nullptr;	//export point density at projection scale for cloud #1
-	ccScalarField* densityCloud2SF = nullptr;	//export point density at projection scale for cloud #2
-
-	//precision maps
-	PrecisionMaps cloud1PM, cloud2PM;
-	bool usePrecisionMaps = false;
-
-	//progress notification
-	CCCoreLib::NormalizedProgress* nProgress = nullptr;
-	bool processCanceled = false;
-	bool processFailed = false;
-};
-static M3C2Params s_M3C2Params;
-
-void ComputeM3C2DistForPoint(unsigned index)
-{
-	if (s_M3C2Params.processCanceled)
-		return;
-
-	ScalarType dist = CCCoreLib::NAN_VALUE;
-
-	//get core point #i
-	CCVector3 P;
-	s_M3C2Params.corePoints->getPoint(index, P);
-
-	//get core point's normal #i
-	CCVector3 N(0, 0, 1);
-	if (s_M3C2Params.updateNormal) //i.e. all cases but the VERTICAL mode
+	if (cloud == dlg.getCloud2())
 	{
-		N = ccNormalVectors::GetNormal(s_M3C2Params.coreNormals->getValue(index));
+		PM.sX = cloud->getScalarField(dlg.c2SxComboBox->currentIndex());
+		PM.sY = cloud->getScalarField(dlg.c2SyComboBox->currentIndex());
+		PM.sZ = cloud->getScalarField(dlg.c2SzComboBox->currentIndex());
 	}
-
-	//output point
-	CCVector3 outputP = P;
-
-	//compute M3C2 distance
-	try
-	{
-		double mean1 = 0;
-		double stdDev1 = 0;
-		bool validStats1 = false;
-
-		//extract cloud #1's neighbourhood
-		CCCoreLib::DgmOctree::ProgressiveCylindricalNeighbourhood cn1;
-		cn1.center = P;
-		cn1.dir = N;
-		cn1.level = s_M3C2Params.level1;
-		cn1.maxHalfLength = s_M3C2Params.projectionDepth;
-		cn1.radius = s_M3C2Params.projectionRadius;
-		cn1.onlyPositiveDir = s_M3C2Params.onlyPositiveSearch;
-
-		if (s_M3C2Params.progressiveSearch)
-		{
-			//progressive search
-			size_t previousNeighbourCount = 0;
-			while (cn1.currentHalfLength < cn1.maxHalfLength)
-			{
-				size_t neighbourCount = s_M3C2Params.cloud1Octree->getPointsInCylindricalNeighbourhoodProgressive(cn1);
-				if (neighbourCount != previousNeighbourCount)
-				{
-					//do we have enough points for computing stats?
-					if (neighbourCount >= s_M3C2Params.minPoints4Stats)
-					{
-						qM3C2Tools::ComputeStatistics(cn1.neighbours, s_M3C2Params.useMedian, mean1, stdDev1);
-						validStats1 = true;
-						//do we have a sharp enough 'mean' to stop?
-						if (std::abs(mean1) + 2 * stdDev1 < static_cast<double>(cn1.currentHalfLength))
-							break;
-					}
-					previousNeighbourCount = neighbourCount;
-				}
-			}
-		}
-		else
-		{
-			s_M3C2Params.cloud1Octree->getPointsInCylindricalNeighbourhood(cn1);
-		}
-		
-		size_t n1 = cn1.neighbours.size();
-		if (n1 != 0)
-		{
-			//compute stat. dispersion on cloud #1 neighbours (if necessary)
-			if (!validStats1)
-			{
-				qM3C2Tools::ComputeStatistics(cn1.neighbours, s_M3C2Params.useMedian, mean1, stdDev1);
-			}
-
-			if (s_M3C2Params.usePrecisionMaps && (s_M3C2Params.computeConfidence || s_M3C2Params.stdDevCloud1SF))
-			{
-				//compute the Precision Maps derived sigma
-				stdDev1 = ComputePMUncertainty(cn1.neighbours, N, s_M3C2Params.cloud1PM);
-			}
-
-			if (s_M3C2Params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD1)
-			{
-				//shift output point on the 1st cloud
-				outputP += static_cast<PointCoordinateType>(mean1) * N;
-			}
-
-			//save cloud #1's std. dev.
-			if (s_M3C2Params.stdDevCloud1SF)
-			{
-				ScalarType val = static_cast<ScalarType>(stdDev1);
-				s_M3C2Params.stdDevCloud1SF->setValue(index, val);
-			}
-		}
-
-		//save cloud #1's density
-		if (s_M3C2Params.densityCloud1SF)
-		{
-			ScalarType val = static_cast<ScalarType>(n1);
-			s_M3C2Params.densityCloud1SF->setValue(index, val);
-		}
-
-		//now we can process cloud #2
-		if (	n1 != 0
-			||	s_M3C2Params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2
-			||	s_M3C2Params.stdDevCloud2SF
-			||	s_M3C2Params.densityCloud2SF
-			)
-		{
-			double mean2 = 0;
-			double stdDev2 = 0;
-			bool validStats2 = false;
-			
-			//extract cloud #2's neighbourhood
-			CCCoreLib::DgmOctree::ProgressiveCylindricalNeighbourhood cn2;
-			cn2.center = P;
-			cn2.dir = N;
-			cn2.level = s_M3C2Params.level2;
-			cn2.maxHalfLength = s_M3C2Params.projectionDepth;
-			cn2.radius = s_M3C2Params.projectionRadius;
-			cn2.onlyPositiveDir = s_M3C2Params.onlyPositiveSearch;
-
-			if (s_M3C2Params.progressiveSearch)
-			{
-				//progressive search
-				size_t previousNeighbourCount = 0;
-				while (cn2.currentHalfLength < cn2.maxHalfLength)
-				{
-					size_t neighbourCount = s_M3C2Params.cloud2Octree->getPointsInCylindricalNeighbourhoodProgressive(cn2);
-					if (neighbourCount != previousNeighbourCount)
-					{
-						//do we have enough points for computing stats?
-						if (neighbourCount >= s_M3C2Params.minPoints4Stats)
-						{
-							qM3C2Tools::ComputeStatistics(cn2.neighbours, s_M3C2Params.useMedian, mean2, stdDev2);
-							validStats2 = true;
-							//do we have a sharp enough 'mean' to stop?
-							if (std::abs(mean2) + 2 * stdDev2 < static_cast<double>(cn2.currentHalfLength))
-								break;
-						}
-						previousNeighbourCount = neighbourCount;
-					}
-				}
-			}
-			else
-			{
-				s_M3C2Params.cloud2Octree->getPointsInCylindricalNeighbourhood(cn2);
-			}
-
-			size_t n2 = cn2.neighbours.size();
-			if (n2 != 0)
-			{
-				//compute stat. dispersion on cloud #2 neighbours (if necessary)
-				if (!validStats2)
-				{
-					qM3C2Tools::ComputeStatistics(cn2.neighbours, s_M3C2Params.useMedian, mean2, stdDev2);
-				}
-				assert(stdDev2 != stdDev2 || stdDev2 >= 0); //first inequality fails if stdDev2 is NaN ;)
-
-				if (s_M3C2Params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2)
-				{
-					//shift output point on the 2nd cloud
-					outputP += static_cast<PointCoordinateType>(mean2) * N;
-				}
-
-				if (s_M3C2Params.usePrecisionMaps && (s_M3C2Params.computeConfidence || s_M3C2Params.stdDevCloud2SF))
-				{
-					//compute the Precision Maps derived sigma
-					stdDev2 = ComputePMUncertainty(cn2.neighbours, N, s_M3C2Params.cloud2PM);
-				}
-
-				if (n1 != 0)
-				{
-					//m3c2 dist = distance between i1 and i2 (i.e. either the mean or the median of both neighborhoods)
-					dist = static_cast<ScalarType>(mean2 - mean1);
-					s_M3C2Params.m3c2DistSF->setValue(index, dist);
-
-					//confidence interval
-					if (s_M3C2Params.computeConfidence)
-					{
-						ScalarType LODStdDev = CCCoreLib::NAN_VALUE;
-						if (s_M3C2Params.usePrecisionMaps)
-						{
-							LODStdDev = stdDev1*stdDev1 + stdDev2*stdDev2; //equation (2) in M3C2-PM article
-						}
-						//standard M3C2 algortihm: have we enough points for computing the confidence interval?
-						else if (n1 >= s_M3C2Params.minPoints4Stats && n2 >= s_M3C2Params.minPoints4Stats)
-						{
-							LODStdDev = (stdDev1*stdDev1) / n1 + (stdDev2*stdDev2) / n2;
-						}
-
-						if (!std::isnan(LODStdDev))
-						{
-							//distance uncertainty (see eq. (1) in M3C2 article)
-							ScalarType LOD = static_cast<ScalarType>(1.96 * (sqrt(LODStdDev) + s_M3C2Params.registrationRms));
-
-							if (s_M3C2Params.distUncertaintySF)
-							{
-								s_M3C2Params.distUncertaintySF->setValue(index, LOD);
-							}
-
-							if (s_M3C2Params.sigChangeSF)
-							{
-								bool significant = (dist < -LOD || dist > LOD);
-								if (significant)
-								{
-									s_M3C2Params.sigChangeSF->setValue(index, SCALAR_ONE); //already equal to SCALAR_ZERO otherwise
-								}
-							}
-						}
-						//else //DGM: scalar fields have already been initialized with the right 'default' values
-						//{
-						//	if (distUncertaintySF)
-						//		distUncertaintySF->setValue(index, CCCoreLib::NAN_VALUE);
-						//	if (sigChangeSF)
-						//		sigChangeSF->setValue(index, SCALAR_ZERO);
-						//}
-					}
-				}
-
-				//save cloud #2's std. dev.
-				if (s_M3C2Params.stdDevCloud2SF)
-				{
-					ScalarType val = static_cast<ScalarType>(stdDev2);
-					s_M3C2Params.stdDevCloud2SF->setValue(index, val);
-				}
-			}
-
-			//save cloud #2's density
-			if (s_M3C2Params.densityCloud2SF)
-			{
-				ScalarType val = static_cast<ScalarType>(n2);
-				s_M3C2Params.densityCloud2SF->setValue(index, val);
-			}
-		}
-	}
-	catch (std::bad_alloc&)
+	else
 	{
-		//Not enough memory
-		s_M3C2Params.processFailed = true;
-		return;
+		int sxIndex = cloud->getScalarFieldIndexByName(dlg.c2SxComboBox->currentText().toStdString());
+		int syIndex = cloud->getScalarFieldIndexByName(dlg.c2SyComboBox->currentText().toStdString());
+		int szIndex = cloud->getScalarFieldIndexByName(dlg.c2SzComboBox->currentText().toStdString());
+		PM.sX = (sxIndex >= 0 ? cloud->getScalarField(sxIndex) : nullptr);
+		PM.sY = (syIndex >= 0 ? cloud->getScalarField(syIndex) : nullptr);
+		PM.sZ = (szIndex >= 0 ? cloud->getScalarField(szIndex) : nullptr);
 	}
+	PM.scale = dlg.pm2ScaleDoubleSpinBox->value();
 
-	//output point
-	if (s_M3C2Params.outputCloud != s_M3C2Params.corePoints)
-	{
-		*const_cast<CCVector3*>(s_M3C2Params.outputCloud->getPoint(index)) = outputP;
-	}
-	if (s_M3C2Params.exportNormal)
-	{
-		s_M3C2Params.outputCloud->setPointNormal(index, N);
-	}
+	return PM.valid();
+}
 
-	//progress notification
-	if (s_M3C2Params.nProgress && !s_M3C2Params.nProgress->oneStep())
+//! Converts an engine result to an error message
+static QString GetEngineErrorMessage(qM3C2Engine::Result result)
+{
+	switch (result)
 	{
-		s_M3C2Params.processCanceled = true;
+	case qM3C2Engine::SUCCESS:
+		break;
+	case qM3C2Engine::CANCELED_BY_USER:
+		return "Process canceled by user!";
+	case qM3C2Engine::NOT_ENOUGH_MEMORY:
+		return "Process failed (not enough memory?)";
 	}
+
+	return QString();
 }
 
 bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPointCloud*& outputCloud, bool allowDialogs, QWidget* parentWidget/*=nullptr*/, ccMainAppInterface* app/*=nullptr*/)
+{
+	return ComputeMultiEpoch(dlg, { dlg.getCloud2() }, errorMessage, outputCloud, allowDialogs, parentWidget, app);
+}
+
+bool qM3C2Process::ComputeMultiEpoch(	const qM3C2Dialog& dlg,
+										const std::vector<ccPointCloud*>& epochs,
+										QString& errorMessage,
+										ccPointCloud*& outputCloud,
+										bool allowDialogs,
+										QWidget* parentWidget/*=nullptr*/,
+										ccMainAppInterface* app/*=nullptr*/)
 {
 	errorMessage.clear();
 	outputCloud = nullptr;
 
-	//get the clouds in the right order
+	//get the reference cloud
 	ccPointCloud* cloud1 = dlg.getCloud1();
-	ccPointCloud* cloud2 = dlg.getCloud2();
 
-	if (!cloud1 || !cloud2)
+	if (!cloud1 || epochs.empty() || std::find(epochs.begin(), epochs.end(), nullptr) != epochs.end())
 	{
 		assert(false);
 		return false;
 	}
 
+	//several compared clouds?
+	bool multiEpoch = (epochs.size() > 1);
+
 	//normals computation parameters
 	double normalScale = dlg.normalScaleDoubleSpinBox->value();
 	double projectionScale = dlg.cylDiameterDoubleSpinBox->value();
@@ -467,43 +159,53 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	double samplingDist = dlg.cpSubsamplingDoubleSpinBox->value();
 	ccScalarField* normalScaleSF = nullptr; //normal scale (multi-scale mode only)
 
-	//other parameters are stored in 's_M3C2Params' for parallel call
-	s_M3C2Params = M3C2Params();
-	s_M3C2Params.projectionRadius = static_cast<PointCoordinateType>(projectionScale / 2); //we want the radius in fact ;)
-	s_M3C2Params.projectionDepth = static_cast<PointCoordinateType>(dlg.cylHalfHeightDoubleSpinBox->value());
-	s_M3C2Params.corePoints = dlg.getCorePointsCloud();
-	s_M3C2Params.registrationRms = dlg.rmsCheckBox->isChecked() ? dlg.rmsDoubleSpinBox->value() : 0.0;
-	s_M3C2Params.exportOption = dlg.getExportOption();
-	s_M3C2Params.keepOriginalCloud = dlg.keepOriginalCloud();
-	s_M3C2Params.useMedian = dlg.useMedianCheckBox->isChecked();
-	s_M3C2Params.minPoints4Stats = dlg.getMinPointsForStats();
-	s_M3C2Params.progressiveSearch = !dlg.useSinglePass4DepthCheckBox->isChecked();
-	s_M3C2Params.onlyPositiveSearch = dlg.positiveSearchOnlyCheckBox->isChecked();
+	//other parameters are stored in the engine parameters
+	qM3C2Engine::Params params;
+	params.projectionRadius = static_cast<PointCoordinateType>(projectionScale / 2); //we want the radius in fact ;)
+	params.projectionDepth = static_cast<PointCoordinateType>(dlg.cylHalfHeightDoubleSpinBox->value());
+	params.corePoints = dlg.getCorePointsCloud();
+	params.registrationRms = dlg.rmsCheckBox->isChecked() ? dlg.rmsDoubleSpinBox->value() : 0.0;
+	params.exportOption = dlg.getExportOption();
+	params.keepOriginalCloud = dlg.keepOriginalCloud();
+	params.useMedian = dlg.useMedianCheckBox->isChecked();
+	params.minPoints4Stats = dlg.getMinPointsForStats();
+	params.progressiveSearch = !dlg.useSinglePass4DepthCheckBox->isChecked();
+	params.onlyPositiveSearch = dlg.positiveSearchOnlyCheckBox->isChecked();
+
+	if (multiEpoch && params.exportOption == qM3C2Dialog::PROJECT_ON_CLOUD2)
+	{
+		//the output points can't be projected on several clouds at once
+		if (app)
+			app->dispToConsole("[M3C2] Multi-epoch mode: output points can't be projected on the compared clouds (core points will be used instead)", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+		params.exportOption = qM3C2Dialog::PROJECT_ON_CORE_POINTS;
+	}
 
 	//precision maps
 	{
-		s_M3C2Params.usePrecisionMaps = dlg.precisionMapsGroupBox->isEnabled() && dlg.precisionMapsGroupBox->isChecked();
-		if (s_M3C2Params.usePrecisionMaps)
+		params.usePrecisionMaps = dlg.precisionMapsGroupBox->isEnabled() && dlg.precisionMapsGroupBox->isChecked();
+		if (params.usePrecisionMaps)
 		{
 			if (allowDialogs && QMessageBox::question(parentWidget, "Precision Maps", "Are you sure you want to compute the M3C2 distances with precision maps?", QMessageBox::Yes, QMessageBox::No) == QMessageBox::No)
 			{
-				s_M3C2Params.usePrecisionMaps = false;
+				params.usePrecisionMaps = false;
 				dlg.precisionMapsGroupBox->setChecked(false);
 			}
 		}
-		if (s_M3C2Params.usePrecisionMaps)
+		if (params.usePrecisionMaps)
 		{
-			s_M3C2Params.cloud1PM.sX = cloud1->getScalarField(dlg.c1SxComboBox->currentIndex());
-			s_M3C2Params.cloud1PM.sY = cloud1->getScalarField(dlg.c1SyComboBox->currentIndex());
-			s_M3C2Params.cloud1PM.sZ = cloud1->getScalarField(dlg.c1SzComboBox->currentIndex());
-			s_M3C2Params.cloud1PM.scale = dlg.pm1ScaleDoubleSpinBox->value();
+			params.cloud1PM.sX = cloud1->getScalarField(dlg.c1SxComboBox->currentIndex());
+			params.cloud1PM.sY = cloud1->getScalarField(dlg.c1SyComboBox->currentIndex());
+			params.cloud1PM.sZ = cloud1->getScalarField(dlg.c1SzComboBox->currentIndex());
+			params.cloud1PM.scale = dlg.pm1ScaleDoubleSpinBox->value();
 
-			s_M3C2Params.cloud2PM.sX = cloud2->getScalarField(dlg.c2SxComboBox->currentIndex());
-			s_M3C2Params.cloud2PM.sY = cloud2->getScalarField(dlg.c2SyComboBox->currentIndex());
-			s_M3C2Params.cloud2PM.sZ = cloud2->getScalarField(dlg.c2SzComboBox->currentIndex());
-			s_M3C2Params.cloud2PM.scale = dlg.pm2ScaleDoubleSpinBox->value();
+			bool validPMs = params.cloud1PM.valid();
+			for (size_t i = 0; validPMs && i < epochs.size(); ++i)
+			{
+				qM3C2Engine::PrecisionMaps cloud2PM;
+				validPMs = GetComparedCloudPrecisionMaps(dlg, epochs[i], cloud2PM);
+			}
 
-			if (!s_M3C2Params.cloud1PM.valid() || !s_M3C2Params.cloud2PM.valid())
+			if (!validPMs)
 			{
 				errorMessage = "Invalid 'Precision maps' settings!";
 				return false;
@@ -526,68 +228,53 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	initTimer.start();
 
 	//compute octree(s) if necessary
-	s_M3C2Params.cloud1Octree = cloud1->getOctree();
-	if (!s_M3C2Params.cloud1Octree)
+	params.cloud1Octree = cloud1->getOctree();
+	if (!params.cloud1Octree)
 	{
-		s_M3C2Params.cloud1Octree = cloud1->computeOctree(&pDlg);
-		if (s_M3C2Params.cloud1Octree && cloud1->getParent() && app)
+		params.cloud1Octree = cloud1->computeOctree(&pDlg);
+		if (params.cloud1Octree && cloud1->getParent() && app)
 		{
 			app->addToDB(cloud1->getOctreeProxy());
 		}
 	}
-	if (!s_M3C2Params.cloud1Octree)
+	if (!params.cloud1Octree)
 	{
 		errorMessage = "Failed to compute cloud #1's octree!";
 		return false;
 	}
 
-	s_M3C2Params.cloud2Octree = cloud2->getOctree();
-	if (!s_M3C2Params.cloud2Octree)
-	{
-		s_M3C2Params.cloud2Octree = cloud2->computeOctree(&pDlg);
-		if (s_M3C2Params.cloud2Octree && cloud2->getParent() && app)
-		{
-			app->addToDB(cloud2->getOctreeProxy());
-		}
-	}
-	if (!s_M3C2Params.cloud2Octree)
-	{
-		errorMessage = "Failed to compute cloud #2's octree!";
-		return false;
-	}
-
 	//start the job
 	bool error = false;
 
 	//should we generate the core points?
 	bool corePointsHaveBeenSubsampled = false;
-	if (!s_M3C2Params.corePoints && samplingDist > 0)
+	if (!params.corePoints && samplingDist > 0)
 	{
 		CCCoreLib::CloudSamplingTools::SFModulationParams modParams(false);
 		CCCoreLib::ReferenceCloud* subsampled = CCCoreLib::CloudSamplingTools::resampleCloudSpatially(cloud1,
 			static_cast<PointCoordinateType>(samplingDist),
 			modParams,
-			s_M3C2Params.cloud1Octree.data(),
+			params.cloud1Octree.data(),
 			&pDlg);
 
 		if (subsampled)
 		{
-			s_M3C2Params.corePoints = static_cast<ccPointCloud*>(cloud1)->partialClone(subsampled);
+			params.corePoints = static_cast<ccPointCloud*>(cloud1)->partialClone(subsampled);
 
 			//don't need those references anymore
 			delete subsampled;
 			subsampled = nullptr;
 		}
 
-		if (s_M3C2Params.corePoints)
+		if (params.corePoints)
 		{
-			s_M3C2Params.corePoints->setName(QString("%1.subsampled [min dist. = %2]").arg(cloud1->getName()).arg(samplingDist));
-			s_M3C2Params.corePoints->setVisible(true);
-			s_M3C2Params.corePoints->setDisplay(cloud1->getDisplay());
+			params.corePoints->setName(QString("%1.subsampled [min dist. = %2]").arg(cloud1->getName()).arg(samplingDist));
+			params.corePoints->setVisible(true);
+			params.corePoints->setDisplay(cloud1->getDisplay());
 			if (app)
 			{
-				app->dispToConsole(QString("[M3C2] Sub-sampled cloud has been saved ('%1')").arg(s_M3C2Params.corePoints->getName()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
-				app->addToDB(s_M3C2Params.corePoints);
+				app->dispToConsole(QString("[M3C2] Sub-sampled cloud has been saved ('%1')").arg(params.corePoints->getName()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+				app->addToDB(params.corePoints);
 			}
 			corePointsHaveBeenSubsampled = true;
 		}
@@ -599,28 +286,28 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	}
 
 	//output
-	QString outputName(s_M3C2Params.usePrecisionMaps ? "M3C2-PM output" : "M3C2 output");
+	QString outputName(params.usePrecisionMaps ? "M3C2-PM output" : "M3C2 output");
 
 	if (!error)
 	{
 		//whatever the case, at this point we should have core points
-		assert(s_M3C2Params.corePoints);
+		assert(params.corePoints);
 		if (app)
-			app->dispToConsole(QString("[M3C2] Core points: %1").arg(s_M3C2Params.corePoints->size()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+			app->dispToConsole(QString("[M3C2] Core points: %1").arg(params.corePoints->size()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-		if (s_M3C2Params.keepOriginalCloud)
+		if (params.keepOriginalCloud)
 		{
-			s_M3C2Params.outputCloud = s_M3C2Params.corePoints;
+			params.outputCloud = params.corePoints;
 		}
 		else
 		{
-			s_M3C2Params.outputCloud = new ccPointCloud(/*outputName*/); //setName will be called at the end
-			if (!s_M3C2Params.outputCloud->resize(s_M3C2Params.corePoints->size())) //resize as we will 'set' the new points positions in 'ComputeM3C2DistForPoint'
+			params.outputCloud = new ccPointCloud(/*outputName*/); //setName will be called at the end
+			if (!params.outputCloud->resize(params.corePoints->size())) //resize as we will 'set' the new points positions in 'qM3C2Engine'
 			{
 				errorMessage = "Not enough memory!";
 				error = true;
 			}
-			s_M3C2Params.corePoints->setEnabled(false); //we can hide the core points
+			params.corePoints->setEnabled(false); //we can hide the core points
 		}
 	}
 
@@ -637,8 +324,8 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 		case qM3C2Normals::DEFAULT_MODE:
 		case qM3C2Normals::MULTI_SCALE_MODE:
 		{
-			s_M3C2Params.coreNormals = new NormsIndexesTableType();
-			s_M3C2Params.coreNormals->link(); //will be released anyway at the end of the process
+			params.coreNormals = new NormsIndexesTableType();
+			params.coreNormals->link(); //will be released anyway at the end of the process
 
 			std::vector<PointCoordinateType> radii;
 			if (normMode == qM3C2Normals::MULTI_SCALE_MODE)
@@ -668,12 +355,12 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 			}
 
 			bool invalidNormals = false;
-			ccPointCloud* baseCloud = (useCorePointsOnly ? s_M3C2Params.corePoints : cloud1);
-			ccOctree* baseOctree = (baseCloud == cloud1 ? s_M3C2Params.cloud1Octree.data() : nullptr);
+			ccPointCloud* baseCloud = (useCorePointsOnly ? params.corePoints : cloud1);
+			ccOctree* baseOctree = (baseCloud == cloud1 ? params.cloud1Octree.data() : nullptr);
 
 			//dedicated core points method
-			normalsAreOk = qM3C2Normals::ComputeCorePointsNormals(s_M3C2Params.corePoints,
-				s_M3C2Params.coreNormals,
+			normalsAreOk = qM3C2Normals::ComputeCorePointsNormals(params.corePoints,
+				params.coreNormals,
 				baseCloud,
 				radii,
 				invalidNormals,
@@ -694,7 +381,7 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 				//make normals horizontal if necessary
 				if (normMode == qM3C2Normals::HORIZ_MODE)
 				{
-					qM3C2Normals::MakeNormalsHorizontal(*s_M3C2Params.coreNormals);
+					qM3C2Normals::MakeNormalsHorizontal(*params.coreNormals);
 				}
 
 				//then either use a simple heuristic
@@ -703,8 +390,8 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 				{
 					int preferredOrientation = dlg.normOriPreferredComboBox->currentIndex();
 					assert(preferredOrientation >= ccNormalVectors::PLUS_X && preferredOrientation <= ccNormalVectors::MINUS_SENSOR_ORIGIN);
-					if (!ccNormalVectors::UpdateNormalOrientations(	s_M3C2Params.corePoints,
-																	*s_M3C2Params.coreNormals,
+					if (!ccNormalVectors::UpdateNormalOrientations(	params.corePoints,
+																	*params.coreNormals,
 																	static_cast<ccNormalVectors::Orientation>(preferredOrientation))
 						)
 					{
@@ -717,8 +404,8 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 					ccPointCloud* orientationCloud = dlg.getNormalsOrientationCloud();
 					assert(orientationCloud);
 
-					if (!qM3C2Normals::UpdateNormalOrientationsWithCloud(	s_M3C2Params.corePoints,
-																			*s_M3C2Params.coreNormals,
+					if (!qM3C2Normals::UpdateNormalOrientationsWithCloud(	params.corePoints,
+																			*params.coreNormals,
 																			orientationCloud,
 																			maxThreadCount,
 																			&pDlg)
@@ -729,10 +416,10 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 					}
 				}
 
-				if (!error && s_M3C2Params.coreNormals)
+				if (!error && params.coreNormals)
 				{
-					s_M3C2Params.outputCloud->setNormsTable(s_M3C2Params.coreNormals);
-					s_M3C2Params.outputCloud->showNormals(true);
+					params.outputCloud->setNormsTable(params.coreNormals);
+					params.outputCloud->showNormals(true);
 				}
 			}
 		}
@@ -740,12 +427,12 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 
 		case qM3C2Normals::USE_CLOUD1_NORMALS:
 		{
-			ccPointCloud* sourceCloud = (corePointsHaveBeenSubsampled ? s_M3C2Params.corePoints : cloud1);
-			s_M3C2Params.coreNormals = sourceCloud->normals();
-			if (s_M3C2Params.coreNormals)
+			ccPointCloud* sourceCloud = (corePointsHaveBeenSubsampled ? params.corePoints : cloud1);
+			params.coreNormals = sourceCloud->normals();
+			if (params.coreNormals)
 			{
-				normalsAreOk = (s_M3C2Params.coreNormals->currentSize() == sourceCloud->size());
-				s_M3C2Params.coreNormals->link(); //will be released anyway at the end of the process
+				normalsAreOk = (params.coreNormals->currentSize() == sourceCloud->size());
+				params.coreNormals->link(); //will be released anyway at the end of the process
 			}
 			else
 			{
@@ -757,11 +444,11 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 
 		case qM3C2Normals::USE_CORE_POINTS_NORMALS:
 		{
-			normalsAreOk = s_M3C2Params.corePoints && s_M3C2Params.corePoints->hasNormals();
+			normalsAreOk = params.corePoints && params.corePoints->hasNormals();
 			if (normalsAreOk)
 			{
-				s_M3C2Params.coreNormals = s_M3C2Params.corePoints->normals();
-				s_M3C2Params.coreNormals->link(); //will be released anyway at the end of the process
+				params.coreNormals = params.corePoints->normals();
+				params.coreNormals->link(); //will be released anyway at the end of the process
 			}
 		}
 		break;
@@ -784,14 +471,18 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	}
 
 	outputName += QString(" Proj. scale=%1").arg(projectionScale);
+	if (multiEpoch)
+	{
+		outputName += QString(" [%1 epochs]").arg(epochs.size());
+	}
 
-	if (!error && s_M3C2Params.coreNormals && corePointsHaveBeenSubsampled)
+	if (!error && params.coreNormals && corePointsHaveBeenSubsampled)
 	{
-		if (s_M3C2Params.corePoints->hasNormals() || s_M3C2Params.corePoints->resizeTheNormsTable())
+		if (params.corePoints->hasNormals() || params.corePoints->resizeTheNormsTable())
 		{
-			for (unsigned i = 0; i < s_M3C2Params.coreNormals->currentSize(); ++i)
-				s_M3C2Params.corePoints->setPointNormalIndex(i, s_M3C2Params.coreNormals->getValue(i));
-			s_M3C2Params.corePoints->showNormals(true);
+			for (unsigned i = 0; i < params.coreNormals->currentSize(); ++i)
+				params.corePoints->setPointNormalIndex(i, params.coreNormals->getValue(i));
+			params.corePoints->showNormals(true);
 		}
 		else if (app)
 		{
@@ -801,203 +492,228 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 
 	qint64 initTime_ms = initTimer.elapsed();
 
+	//output scalar fields (in the order they will be added to the output cloud)
+	std::vector<ccScalarField*> outputSFs;
+
 	while (!error) //fake loop for easy break
 	{
 		//we display init. timing only if no error occurred!
 		if (app)
 			app->dispToConsole(QString("[M3C2] Initialization & normal computation: %1 s.").arg(initTime_ms / 1000.0, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-		QElapsedTimer distCompTimer;
-		distCompTimer.start();
-
 		//we are either in vertical mode or we have as many normals as core points
-		unsigned corePointCount = s_M3C2Params.corePoints->size();
-		assert(normMode == qM3C2Normals::VERT_MODE || (s_M3C2Params.coreNormals && corePointCount == s_M3C2Params.coreNormals->currentSize()));
-
-		pDlg.reset();
-		CCCoreLib::NormalizedProgress nProgress(&pDlg, corePointCount);
-		pDlg.setMethodTitle(QObject::tr("M3C2 Distances Computation"));
-		pDlg.setInfo(QObject::tr("Core points: %1").arg(corePointCount));
-		pDlg.start();
-		s_M3C2Params.nProgress = &nProgress;
-
-		//allocate distances SF
-		s_M3C2Params.m3c2DistSF = new ccScalarField(M3C2_DIST_SF_NAME);
-		s_M3C2Params.m3c2DistSF->link();
-		if (!s_M3C2Params.m3c2DistSF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
-		{
-			errorMessage = "Failed to allocate memory for distance values!";
-			error = true;
-			break;
-		}
-		//allocate dist. uncertainty SF
-		s_M3C2Params.distUncertaintySF = new ccScalarField(DIST_UNCERTAINTY_SF_NAME);
-		s_M3C2Params.distUncertaintySF->link();
-		if (!s_M3C2Params.distUncertaintySF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
+		unsigned corePointCount = params.corePoints->size();
+		assert(normMode == qM3C2Normals::VERT_MODE || (params.coreNormals && corePointCount == params.coreNormals->currentSize()));
+
+		bool exportStdDev = dlg.exportStdDevInfoCheckBox->isChecked();
+		bool exportDensity = dlg.exportDensityAtProjScaleCheckBox->isChecked();
+		QString stdDevPrefix("STD");
+		if (params.usePrecisionMaps)
 		{
-			errorMessage = "Failed to allocate memory for dist. uncertainty values!";
-			error = true;
-			break;
+			stdDevPrefix = "SigmaN";
 		}
-		//allocate change significance SF
-		s_M3C2Params.sigChangeSF = new ccScalarField(SIG_CHANGE_SF_NAME);
-		s_M3C2Params.sigChangeSF->link();
-		if (!s_M3C2Params.sigChangeSF->resizeSafe(corePointCount, true, SCALAR_ZERO))
+		else if (params.useMedian)
 		{
-			if (app)
-				app->dispToConsole("Failed to allocate memory for change significance values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-			s_M3C2Params.sigChangeSF->release();
-			s_M3C2Params.sigChangeSF = nullptr;
-			//no need to stop just for this SF!
-			//error = true;
-			//break;
+			stdDevPrefix = "IQR";
 		}
 
-		if (dlg.exportStdDevInfoCheckBox->isChecked())
+		//cloud #1 related scalar fields (shared by all the epochs)
+		if (exportDensity)
 		{
-			QString prefix("STD");
-			if (s_M3C2Params.usePrecisionMaps)
-			{
-				prefix = "SigmaN";
-			}
-			else if (s_M3C2Params.useMedian)
-			{
-				prefix = "IQR";
-			}
-			//allocate cloud #1 std. dev. SF
-			QString stdDevSFName1 = QString(STD_DEV_CLOUD1_SF_NAME).arg(prefix);
-			s_M3C2Params.stdDevCloud1SF = new ccScalarField(stdDevSFName1.toStdString());
-			s_M3C2Params.stdDevCloud1SF->link();
-			if (!s_M3C2Params.stdDevCloud1SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
-			{
-				if (app)
-					app->dispToConsole("Failed to allocate memory for cloud #1 std. dev. values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.stdDevCloud1SF->release();
-				s_M3C2Params.stdDevCloud1SF = nullptr;
-			}
-			//allocate cloud #2 std. dev. SF
-			QString stdDevSFName2 = QString(STD_DEV_CLOUD2_SF_NAME).arg(prefix);
-			s_M3C2Params.stdDevCloud2SF = new ccScalarField(stdDevSFName2.toStdString());
-			s_M3C2Params.stdDevCloud2SF->link();
-			if (!s_M3C2Params.stdDevCloud2SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
-			{
-				if (app)
-					app->dispToConsole("Failed to allocate memory for cloud #2 std. dev. values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.stdDevCloud2SF->release();
-				s_M3C2Params.stdDevCloud2SF = nullptr;
-			}
+			//allocate cloud #1 density SF
+			params.densityCloud1SF = CreateOutputSF(DENSITY_CLOUD1_SF_NAME, corePointCount, CCCoreLib::NAN_VALUE);
+			if (params.densityCloud1SF)
+				outputSFs.push_back(params.densityCloud1SF);
+			else if (app)
+				app->dispToConsole("Failed to allocate memory for cloud #1 density values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
 		}
-		if (dlg.exportDensityAtProjScaleCheckBox->isChecked())
+		if (exportStdDev)
 		{
-			//allocate cloud #1 density SF
-			s_M3C2Params.densityCloud1SF = new ccScalarField(DENSITY_CLOUD1_SF_NAME);
-			s_M3C2Params.densityCloud1SF->link();
-			if (!s_M3C2Params.densityCloud1SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
-			{
-				if (app)
-					app->dispToConsole("Failed to allocate memory for cloud #1 density values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.densityCloud1SF->release();
-				s_M3C2Params.densityCloud1SF = nullptr;
-			}
-			//allocate cloud #2 density SF
-			s_M3C2Params.densityCloud2SF = new ccScalarField(DENSITY_CLOUD2_SF_NAME);
-			s_M3C2Params.densityCloud2SF->link();
-			if (!s_M3C2Params.densityCloud2SF->resizeSafe(corePointCount, true, CCCoreLib::NAN_VALUE))
-			{
-				if (app)
-					app->dispToConsole("Failed to allocate memory for cloud #2 density values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-				s_M3C2Params.densityCloud2SF->release();
-				s_M3C2Params.densityCloud2SF = nullptr;
-			}
+			//allocate cloud #1 std. dev. SF
+			params.stdDevCloud1SF = CreateOutputSF(QString(STD_DEV_CLOUD1_SF_NAME).arg(stdDevPrefix), corePointCount, CCCoreLib::NAN_VALUE);
+			if (params.stdDevCloud1SF)
+				outputSFs.push_back(params.stdDevCloud1SF);
+			else if (app)
+				app->dispToConsole("Failed to allocate memory for cloud #1 std. dev. values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
 		}
 
 		//get best levels for neighbourhood extraction on both octrees
-		assert(s_M3C2Params.cloud1Octree && s_M3C2Params.cloud2Octree);
-		PointCoordinateType equivalentRadius = static_cast<PointCoordinateType>(pow((static_cast<double>(s_M3C2Params.projectionDepth) * s_M3C2Params.projectionDepth) * s_M3C2Params.projectionRadius, 1.0 / 3.0));
-		s_M3C2Params.level1 = s_M3C2Params.cloud1Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
+		assert(params.cloud1Octree);
+		PointCoordinateType equivalentRadius = static_cast<PointCoordinateType>(pow((static_cast<double>(params.projectionDepth) * params.projectionDepth) * params.projectionRadius, 1.0 / 3.0));
+		params.level1 = params.cloud1Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
 		if (app)
-			app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #1): %1").arg(s_M3C2Params.level1), ccMainAppInterface::STD_CONSOLE_MESSAGE);
-
-		s_M3C2Params.level2 = s_M3C2Params.cloud2Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
-		if (app)
-			app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #2): %1").arg(s_M3C2Params.level2), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+			app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #1): %1").arg(params.level1), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
 		//other options
-		s_M3C2Params.updateNormal = (normMode != qM3C2Normals::VERT_MODE);
-		s_M3C2Params.exportNormal = s_M3C2Params.updateNormal && !s_M3C2Params.outputCloud->hasNormals();
-		if (s_M3C2Params.exportNormal && !s_M3C2Params.outputCloud->resizeTheNormsTable()) //resize because we will 'set' the normal in ComputeM3C2DistForPoint
+		params.updateNormal = (normMode != qM3C2Normals::VERT_MODE);
+		params.exportNormal = params.updateNormal && !params.outputCloud->hasNormals();
+		if (params.exportNormal && !params.outputCloud->resizeTheNormsTable()) //resize because we will 'set' the normal in qM3C2Engine
 		{
 			if (app)
 				app->dispToConsole("Failed to allocate memory for exporting normals!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-			s_M3C2Params.exportNormal = false;
+			params.exportNormal = false;
 		}
-		s_M3C2Params.computeConfidence = (s_M3C2Params.distUncertaintySF || s_M3C2Params.sigChangeSF);
 
-		//compute distances
+		qM3C2Engine engine(params);
+
+		if (multiEpoch)
 		{
-			std::vector<unsigned> pointIndexes;
-			bool useParallelStrategy = true;
-#ifdef _DEBUG
-			useParallelStrategy = false;
-#endif
-			if (useParallelStrategy)
+			//the statistics of cloud #1 are computed once and for all
+			QElapsedTimer refTimer;
+			refTimer.start();
+
+			pDlg.reset();
+			qM3C2Engine::Result result = engine.prepareReference(maxThreadCount, &pDlg);
+			if (result != qM3C2Engine::SUCCESS)
 			{
-				try
-				{
-					pointIndexes.resize(corePointCount);
-				}
-				catch (const std::bad_alloc&)
-				{
-					//not enough memory
-					useParallelStrategy = false;
-				}
+				errorMessage = GetEngineErrorMessage(result);
+				error = true;
+				break;
 			}
 
-			if (useParallelStrategy)
+			if (app)
+				app->dispToConsole(QString("[M3C2] Reference statistics computation: %1 s.").arg(static_cast<double>(refTimer.elapsed()) / 1000.0, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+		}
+
+		for (size_t epochIndex = 0; epochIndex < epochs.size(); ++epochIndex)
+		{
+			ccPointCloud* cloud2 = epochs[epochIndex];
+			QString epochSuffix;
+			if (multiEpoch)
 			{
-				for (unsigned i = 0; i < corePointCount; ++i)
-				{
-					pointIndexes[i] = i;
-				}
+				epochSuffix = QString(" [#%1 %2]").arg(epochIndex + 1).arg(cloud2->getName());
+				if (app)
+					app->dispToConsole(QString("[M3C2] Epoch #%1/%2: '%3'").arg(epochIndex + 1).arg(epochs.size()).arg(cloud2->getName()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+			}
+
+			QElapsedTimer distCompTimer;
+			distCompTimer.start();
 
-				if (maxThreadCount == 0)
+			qM3C2Engine::Params& epochParams = engine.params();
+
+			//compute cloud #2's octree if necessary
+			epochParams.cloud2Octree = cloud2->getOctree();
+			if (!epochParams.cloud2Octree)
+			{
+				epochParams.cloud2Octree = cloud2->computeOctree(&pDlg);
+				if (epochParams.cloud2Octree && cloud2->getParent() && app)
 				{
-					maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+					app->addToDB(cloud2->getOctreeProxy());
 				}
-				assert(maxThreadCount > 0 && maxThreadCount <= QThread::idealThreadCount());
-				QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-				QtConcurrent::blockingMap(pointIndexes, ComputeM3C2DistForPoint);
 			}
-			else
+			if (!epochParams.cloud2Octree)
 			{
-				//manually call the static per-point method!
-				for (unsigned i = 0; i < corePointCount; ++i)
-				{
-					ComputeM3C2DistForPoint(i);
-				}
+				errorMessage = QString("Failed to compute cloud #2's octree!%1").arg(epochSuffix);
+				error = true;
+				break;
 			}
-		}
 
-		if (s_M3C2Params.processCanceled)
-		{
-			errorMessage = "Process canceled by user!";
-			error = true;
-		}
-		else if (s_M3C2Params.processFailed)
-		{
-			errorMessage = "Process failed (not enough memory?)";
-			error = true;
-		}
-		else
-		{
+			epochParams.level2 = epochParams.cloud2Octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(equivalentRadius);
+			if (app)
+				app->dispToConsole(QString("[M3C2] Working subdivision level (cloud #2): %1").arg(epochParams.level2), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+
+			if (epochParams.usePrecisionMaps && !GetComparedCloudPrecisionMaps(dlg, cloud2, epochParams.cloud2PM))
+			{
+				//should have been checked before!
+				assert(false);
+				errorMessage = "Invalid 'Precision maps' settings!";
+				error = true;
+				break;
+			}
+
+			//cloud #1 related scalar fields only have to be filled once
+			if (epochIndex != 0)
+			{
+				epochParams.densityCloud1SF = nullptr;
+				epochParams.stdDevCloud1SF = nullptr;
+			}
+
+			//allocate cloud #2 density SF
+			epochParams.densityCloud2SF = nullptr;
+			if (exportDensity)
+			{
+				epochParams.densityCloud2SF = CreateOutputSF(DENSITY_CLOUD2_SF_NAME + epochSuffix, corePointCount, CCCoreLib::NAN_VALUE);
+				if (epochParams.densityCloud2SF)
+					outputSFs.push_back(epochParams.densityCloud2SF);
+				else if (app)
+					app->dispToConsole("Failed to allocate memory for cloud #2 density values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			}
+			//allocate cloud #2 std. dev. SF
+			epochParams.stdDevCloud2SF = nullptr;
+			if (exportStdDev)
+			{
+				epochParams.stdDevCloud2SF = CreateOutputSF(QString(STD_DEV_CLOUD2_SF_NAME).arg(stdDevPrefix) + epochSuffix, corePointCount, CCCoreLib::NAN_VALUE);
+				if (epochParams.stdDevCloud2SF)
+					outputSFs.push_back(epochParams.stdDevCloud2SF);
+				else if (app)
+					app->dispToConsole("Failed to allocate memory for cloud #2 std. dev. values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			}
+			//allocate change significance SF
+			epochParams.sigChangeSF = CreateOutputSF(SIG_CHANGE_SF_NAME + epochSuffix, corePointCount, SCALAR_ZERO);
+			if (epochParams.sigChangeSF)
+			{
+				outputSFs.push_back(epochParams.sigChangeSF);
+			}
+			else if (app)
+			{
+				//no need to stop just for this SF!
+				app->dispToConsole("Failed to allocate memory for change significance values!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+			}
+			//allocate dist. uncertainty SF
+			epochParams.distUncertaintySF = CreateOutputSF(DIST_UNCERTAINTY_SF_NAME + epochSuffix, corePointCount, CCCoreLib::NAN_VALUE);
+			if (!epochParams.distUncertaintySF)
+			{
+				errorMessage = "Failed to allocate memory for dist. uncertainty values!";
+				error = true;
+				break;
+			}
+			outputSFs.push_back(epochParams.distUncertaintySF);
+			//allocate distances SF
+			epochParams.m3c2DistSF = CreateOutputSF(M3C2_DIST_SF_NAME + epochSuffix, corePointCount, CCCoreLib::NAN_VALUE);
+			if (!epochParams.m3c2DistSF)
+			{
+				errorMessage = "Failed to allocate memory for distance values!";
+				error = true;
+				break;
+			}
+			outputSFs.push_back(epochParams.m3c2DistSF);
+
+			epochParams.computeConfidence = (epochParams.distUncertaintySF || epochParams.sigChangeSF);
+
+			//compute distances
+			pDlg.reset();
+			qM3C2Engine::Result result = engine.computeDistances(maxThreadCount, &pDlg);
+			if (result != qM3C2Engine::SUCCESS)
+			{
+				errorMessage = GetEngineErrorMessage(result);
+				error = true;
+				break;
+			}
+
+			//update the scalar fields boundaries
+			if (epochParams.densityCloud1SF)
+				epochParams.densityCloud1SF->computeMinAndMax();
+			if (epochParams.stdDevCloud1SF)
+				epochParams.stdDevCloud1SF->computeMinAndMax();
+			if (epochParams.densityCloud2SF)
+				epochParams.densityCloud2SF->computeMinAndMax();
+			if (epochParams.stdDevCloud2SF)
+				epochParams.stdDevCloud2SF->computeMinAndMax();
+			if (epochParams.sigChangeSF)
+			{
+				epochParams.sigChangeSF->computeMinAndMax();
+				epochParams.sigChangeSF->setMinDisplayed(SCALAR_ONE);
+			}
+			epochParams.distUncertaintySF->computeMinAndMax();
+			epochParams.m3c2DistSF->computeMinAndMax();
+			epochParams.m3c2DistSF->setSymmetricalScale(true);
+
 			qint64 distTime_ms = distCompTimer.elapsed();
 			//we display init. timing only if no error occurred!
 			if (app)
 				app->dispToConsole(QString("[M3C2] Distances computation: %1 s.").arg(static_cast<double>(distTime_ms) / 1000.0, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 		}
 
-		s_M3C2Params.nProgress = nullptr;
-
 		break; //to break from fake loop
 	}
 
@@ -1006,7 +722,7 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	//the most important one at the end)
 	if (!error)
 	{
-		assert(s_M3C2Params.outputCloud && s_M3C2Params.corePoints);
+		assert(params.outputCloud && params.corePoints);
 		int sfIdx = -1;
 
 		//normal scales
@@ -1014,102 +730,48 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 		{
 			normalScaleSF->computeMinAndMax();
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, normalScaleSF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(normalScaleSF);
-		}
-
-		//add clouds' density SFs to output cloud
-		if (s_M3C2Params.densityCloud1SF)
-		{
-			s_M3C2Params.densityCloud1SF->computeMinAndMax();
-			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.densityCloud1SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.densityCloud1SF);
-		}
-		if (s_M3C2Params.densityCloud2SF)
-		{
-			s_M3C2Params.densityCloud2SF->computeMinAndMax();
-			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.densityCloud2SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.densityCloud2SF);
-		}
-
-		//add clouds' std. dev. SFs to output cloud
-		if (s_M3C2Params.stdDevCloud1SF)
-		{
-			s_M3C2Params.stdDevCloud1SF->computeMinAndMax();
-			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.stdDevCloud1SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.stdDevCloud1SF);
-		}
-		if (s_M3C2Params.stdDevCloud2SF)
-		{
-			//add cloud #2 std. dev. SF to output cloud
-			s_M3C2Params.stdDevCloud2SF->computeMinAndMax();
-			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.stdDevCloud2SF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.stdDevCloud2SF);
-		}
-
-		if (s_M3C2Params.sigChangeSF)
-		{
-			//add significance SF to output cloud
-			s_M3C2Params.sigChangeSF->computeMinAndMax();
-			s_M3C2Params.sigChangeSF->setMinDisplayed(SCALAR_ONE);
-			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.sigChangeSF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.sigChangeSF);
-		}
-
-		if (s_M3C2Params.distUncertaintySF)
-		{
-			//add dist. uncertainty SF to output cloud
-			s_M3C2Params.distUncertaintySF->computeMinAndMax();
-			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.distUncertaintySF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.distUncertaintySF);
+			RemoveScalarField(params.outputCloud, normalScaleSF->getName());
+			sfIdx = params.outputCloud->addScalarField(normalScaleSF);
 		}
 
-		if (s_M3C2Params.m3c2DistSF)
+		//add the other SFs (density, std. dev., significance, uncertainty and distances) to output cloud
+		for (ccScalarField* sf : outputSFs)
 		{
-			//add M3C2 distances SF to output cloud
-			s_M3C2Params.m3c2DistSF->computeMinAndMax();
-			s_M3C2Params.m3c2DistSF->setSymmetricalScale(true);
 			//in case the output cloud is the original cloud, we must remove the former SF
-			RemoveScalarField(s_M3C2Params.outputCloud, s_M3C2Params.m3c2DistSF->getName());
-			sfIdx = s_M3C2Params.outputCloud->addScalarField(s_M3C2Params.m3c2DistSF);
+			RemoveScalarField(params.outputCloud, sf->getName());
+			sfIdx = params.outputCloud->addScalarField(sf);
 		}
 
-		s_M3C2Params.outputCloud->invalidateBoundingBox(); //see 'const_cast<...>' in ComputeM3C2DistForPoint ;)
-		s_M3C2Params.outputCloud->setCurrentDisplayedScalarField(sfIdx);
-		s_M3C2Params.outputCloud->showSF(true);
-		s_M3C2Params.outputCloud->showNormals(true);
-		s_M3C2Params.outputCloud->setVisible(true);
-		s_M3C2Params.outputCloud->prepareDisplayForRefresh();
+		params.outputCloud->invalidateBoundingBox(); //see 'const_cast<...>' in qM3C2Engine ;)
+		params.outputCloud->setCurrentDisplayedScalarField(sfIdx);
+		params.outputCloud->showSF(true);
+		params.outputCloud->showNormals(true);
+		params.outputCloud->setVisible(true);
+		params.outputCloud->prepareDisplayForRefresh();
 
-		if (s_M3C2Params.outputCloud != cloud1 && s_M3C2Params.outputCloud != cloud2)
+		if (params.outputCloud != cloud1 && std::find(epochs.begin(), epochs.end(), params.outputCloud) == epochs.end())
 		{
-			s_M3C2Params.outputCloud->setName(outputName);
-			s_M3C2Params.outputCloud->setDisplay(s_M3C2Params.corePoints->getDisplay());
-			s_M3C2Params.outputCloud->importParametersFrom(s_M3C2Params.corePoints);
+			params.outputCloud->setName(outputName);
+			params.outputCloud->setDisplay(params.corePoints->getDisplay());
+			params.outputCloud->importParametersFrom(params.corePoints);
 			if (app)
 			{
-				app->addToDB(s_M3C2Params.outputCloud);
+				app->addToDB(params.outputCloud);
 			}
 			else
 			{
 				//command line mode
-				outputCloud = s_M3C2Params.outputCloud;
+				outputCloud = params.outputCloud;
 			}
 		}
 	}
-	else if (s_M3C2Params.outputCloud)
+	else if (params.outputCloud)
 	{
-		if (s_M3C2Params.outputCloud != s_M3C2Params.corePoints)
+		if (params.outputCloud != params.corePoints)
 		{
-			delete s_M3C2Params.outputCloud;
+			delete params.outputCloud;
 		}
-		s_M3C2Params.outputCloud = nullptr;
+		params.outputCloud = nullptr;
 	}
 
 	if (app)
@@ -1118,22 +780,11 @@ bool qM3C2Process::Compute(const qM3C2Dialog& dlg, QString& errorMessage, ccPoin
 	//release structures
 	if (normalScaleSF)
 		normalScaleSF->release();
-	if (s_M3C2Params.coreNormals)
-		s_M3C2Params.coreNormals->release();
-	if (s_M3C2Params.m3c2DistSF)
-		s_M3C2Params.m3c2DistSF->release();
-	if (s_M3C2Params.sigChangeSF)
-		s_M3C2Params.sigChangeSF->release();
-	if (s_M3C2Params.distUncertaintySF)
-		s_M3C2Params.distUncertaintySF->release();
-	if (s_M3C2Params.stdDevCloud1SF)
-		s_M3C2Params.stdDevCloud1SF->release();
-	if (s_M3C2Params.stdDevCloud2SF)
-		s_M3C2Params.stdDevCloud2SF->release();
-	if (s_M3C2Params.densityCloud1SF)
-		s_M3C2Params.densityCloud1SF->release();
-	if (s_M3C2Params.densityCloud2SF)
-		s_M3C2Params.densityCloud2SF->release();
+	if (params.coreNormals)
+		params.coreNormals->release();
+	for (ccScalarField* sf : outputSFs)
+		sf->release();
+	outputSFs.clear();
 
 	return !error;
 }
@@ -80,6 +80,40 @@ void BaseFilter::updateSelectedEntities(const ccHObject::Container& selectedEnti
 	}
 }
 
+int BaseFilter::applyTo(ccPointCloud* cloud, ccHObject** output/*=nullptr*/)
+{
+	if (output)
+	{
+		*output = nullptr;
+	}
+
+	if (!cloud)
+	{
+		assert(false);
+		return InvalidInput;
+	}
+
+	//temporarily replace the selection by the input cloud
+	ccHObject::Container previousSelection = m_selectedEntities;
+	m_selectedEntities.clear();
+	m_selectedEntities.push_back(cloud);
+
+	ccHObject* createdEntity = nullptr;
+	QMetaObject::Connection connection = connect(this, &BaseFilter::newEntity, [&createdEntity](ccHObject* entity) { createdEntity = entity; });
+
+	int result = compute();
+
+	disconnect(connection);
+	m_selectedEntities = previousSelection;
+
+	if (output)
+	{
+		*output = createdEntity;
+	}
+
+	return result;
+}
+
 void BaseFilter::performAction()
 {
 	//check if selected entities are good
@@ -116,6 +116,15 @@ public:
 	**/
 	virtual int compute() = 0;
 
+	//! Applies the filter to a given cloud, without any dialog (e.g. from the command line)
+	/** The parameters must have been set beforehand. The selection is temporarily
+		replaced by the input cloud, and compute() is called in the current thread.
+		\param cloud input cloud
+		\param output new entity created by the filter (if any)
+		eturn 1 if successful (error code otherwise)
+	**/
+	int applyTo(ccPointCloud* cloud, ccHObject** output = nullptr);
+
 	//! Sets associated CC application interface (to access DB)
 	inline void setMainAppInterface(ccMainAppInterface* app) { m_app = app; }
 
@@ -20,8 +20,7 @@
 #include "FastGlobalRegistrationDlg.h"
 
 //Local
-#include "../utils/cc2sm.h"
-#include "../utils/sm2cc.h"
+#include "../utils/PCLCloudCache.h"
 
 //PCL
 #include <pcl/features/fpfh_omp.h>
@@ -102,7 +101,8 @@ static bool ComputeFeatures(ccPointCloud* cloud, fgr::Features& features, double
 		return false;
 	}
 	
-	pcl::PointCloud<pcl::PointNormal>::Ptr tmp_cloud = cc2smReader(cloud).getAsPointNormal();
+	//the converted cloud is shared with the other filters (e.g. if the normals have just been computed)
+	pcl::PointCloud<pcl::PointNormal>::Ptr tmp_cloud = PCLCloudCache::GetUniqueInstance().getPointNormal(cloud);
 	if (!tmp_cloud)
 	{
 		ccLog::Warning("Failed to convert CC cloud to PCL cloud");
@@ -20,7 +20,7 @@
 //Local
 #include "dialogs/MLSDialog.h"
 #include "../utils/PCLConv.h"
-#include "../utils/cc2sm.h"
+#include "../utils/PCLCloudCache.h"
 #include "../utils/sm2cc.h"
 
 //PCL
@@ -135,8 +135,9 @@ int MLSSmoothingUpsampling::compute()
 
 	ccScalarField* sf = cloud->getCurrentDisplayedScalarField();
 
-	//get xyz in PCL format
-	pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud = cc2smReader(cloud).getRawXYZ();
+	//get xyz in PCL format (shared with the other filters)
+	PCLCloudCache& cache = PCLCloudCache::GetUniqueInstance();
+	pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud = cache.getXYZ(cloud);
 	if (!xyzCloud)
 	{
 		return NotEnoughMemory;
@@ -151,16 +152,20 @@ int MLSSmoothingUpsampling::compute()
 	SmoothMLS<pcl::PointXYZ, pcl::PointNormal> (xyzCloud, m_parameters, rawCloudWithNormals);
 #endif
 
-	PCLCloud cloudWithNormals;
-	TO_PCL_CLOUD(*rawCloudWithNormals, cloudWithNormals);
-
-	ccPointCloud* outputCCCloud = pcl2cc::Convert(cloudWithNormals);
+	//direct conversion (no intermediate PCLCloud)
+	ccPointCloud* outputCCCloud = pcl2cc::Convert(*rawCloudWithNormals, m_parameters.compute_normals_);
 	if (!outputCCCloud)
 	{
 		//conversion failed (not enough memory?)
 		return NotEnoughMemory;
 	}
 
+	//the next filter of a chain won't have to convert the output cloud again
+	if (outputCCCloud->hasNormals())
+	{
+		cache.setPointNormal(outputCCCloud, rawCloudWithNormals);
+	}
+
 	outputCCCloud->setName(cloud->getName() + QString("_smoothed")); //original name + suffix
 	outputCCCloud->setDisplay(cloud->getDisplay());
 
@@ -58,6 +58,9 @@ public:
 	MLSSmoothingUpsampling();
 	~MLSSmoothingUpsampling() override;
 
+	//! Sets the parameters (without any dialog)
+	void setParameters(const MLSParameters& parameters) { m_parameters = parameters; }
+
 protected:
 	//inherited from BaseFilter
 	int compute() override;
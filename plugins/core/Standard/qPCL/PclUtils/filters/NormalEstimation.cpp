@@ -19,9 +19,7 @@
 
 //Local
 #include "dialogs/NormalEstimationDlg.h"
-#include "../utils/PCLConv.h"
-#include "../utils/cc2sm.h"
-#include "../utils/sm2cc.h"
+#include "../utils/PCLCloudCache.h"
 
 //PCL
 #include <pcl/features/impl/normal_3d_omp.hpp>
@@ -31,10 +29,14 @@
 
 //qCC_db
 #include <ccPointCloud.h>
+#include <ccScalarField.h>
 
 //Qt
 #include <QMainWindow>
 
+//! Name of the curvature scalar field
+static const char CURVATURE_SF_NAME[] = "curvature";
+
 template <typename PointInT, typename PointOutT>
 int ComputeNormals(	const typename pcl::PointCloud<PointInT>::Ptr incloud,
 					float radius,
@@ -113,21 +115,28 @@ int NormalEstimation::compute()
 	if (!cloud)
 		return InvalidInput;
 
-	//get xyz as a PCL cloud
-	pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud = cc2smReader(cloud).getRawXYZ();
+	//get xyz as a PCL cloud (shared with the other filters)
+	PCLCloudCache& cache = PCLCloudCache::GetUniqueInstance();
+	pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud = cache.getXYZ(cloud);
 	if (!xyzCloud)
 	{
 		return ComputationError;
 	}
 
 	//now compute the normals
-	pcl::PointCloud<pcl::PointNormal> rawCloudWithNormals;
-	int result = ComputeNormals<pcl::PointXYZ, pcl::PointNormal>(xyzCloud, m_useKnn ? m_knn_radius: m_radius, m_useKnn, rawCloudWithNormals);
+	pcl::PointCloud<pcl::PointNormal>::Ptr rawCloudWithNormals(new pcl::PointCloud<pcl::PointNormal>);
+	int result = ComputeNormals<pcl::PointXYZ, pcl::PointNormal>(xyzCloud, m_useKnn ? m_knn_radius: m_radius, m_useKnn, *rawCloudWithNormals);
 	if (result < 0)
 	{
 		return ComputationError;
 	}
 
+	unsigned pointCount = cloud->size();
+	if (rawCloudWithNormals->size() != pointCount)
+	{
+		return ComputationError;
+	}
+
 	//if we have normals delete them!
 	if (!cloud->hasNormals())
 	{
@@ -137,26 +146,59 @@ int NormalEstimation::compute()
 		}
 	}
 
-	//copy the notmals
-	unsigned pointCount = cloud->size();
+	//the curvature scalar field
+	ccScalarField* curvatureSF = nullptr;
+	{
+		int sfIdx = cloud->getScalarFieldIndexByName(CURVATURE_SF_NAME);
+		if (sfIdx >= 0 && m_overwrite_curvature)
+		{
+			cloud->deleteScalarField(sfIdx);
+			sfIdx = -1;
+		}
+		if (sfIdx < 0)
+		{
+			curvatureSF = new ccScalarField(CURVATURE_SF_NAME);
+			if (!curvatureSF->resizeSafe(pointCount))
+			{
+				curvatureSF->release();
+				curvatureSF = nullptr;
+			}
+		}
+	}
+
+	//copy the normals (and the curvature)
 	for (unsigned i = 0; i < pointCount; ++i)
 	{
-		const pcl::PointNormal& point = rawCloudWithNormals[i];
+		pcl::PointNormal& point = (*rawCloudWithNormals)[i];
 		CCVector3 N(static_cast<PointCoordinateType>(point.normal_x),
 					static_cast<PointCoordinateType>(point.normal_y),
 					static_cast<PointCoordinateType>(point.normal_z));
 
 		cloud->setPointNormal(i, N);
+
+		if (curvatureSF)
+		{
+			curvatureSF->setValue(i, static_cast<ScalarType>(point.curvature));
+		}
+
+		//the coordinates are not filled by the normal estimator
+		const pcl::PointXYZ& P = (*xyzCloud)[i];
+		point.x = P.x;
+		point.y = P.y;
+		point.z = P.z;
 	}
 	cloud->showNormals(true);
 
-	// FIXME: find a way to avoid converting to a PCLPointCloud2 just to get the curvature values!
-	PCLCloud::Ptr cloudWithNormals(new PCLCloud);
-	TO_PCL_CLOUD(rawCloudWithNormals, *cloudWithNormals);
-	pcl2cc::CopyScalarField(*cloudWithNormals, "curvature", *cloud, m_overwrite_curvature);
+	if (curvatureSF)
+	{
+		curvatureSF->computeMinAndMax();
+		cloud->addScalarField(curvatureSF);
+	}
+
+	//the next filters won't have to convert the cloud (with its new normals) again
+	cache.setPointNormal(cloud, rawCloudWithNormals);
 
 	Q_EMIT entityHasChanged(cloud);
 
 	return Success;
 }
-
@@ -25,6 +25,20 @@ public:
 	NormalEstimation();
 	~NormalEstimation() override;
 
+	//! Sets the parameters (without any dialog)
+	/** \param useKnn whether to use the k nearest neighbors (or a radius)
+		\param knn number of neighbors
+		\param radius search radius
+		\param overwriteCurvature whether to overwrite the existing curvature scalar field (if any)
+	**/
+	void setParameters(bool useKnn, int knn, float radius, bool overwriteCurvature)
+	{
+		m_useKnn = useKnn;
+		m_knn_radius = knn;
+		m_radius = radius;
+		m_overwrite_curvature = overwriteCurvature;
+	}
+
 protected:
 	//inherited from BaseFilter
 	int compute() override;
@@ -19,11 +19,11 @@
 
 //Local
 #include "dialogs/StatisticalOutliersRemoverDlg.h"
-#include "../utils/cc2sm.h"
-#include "../utils/sm2cc.h"
+#include "../utils/PCLCloudCache.h"
 
 //PCL
 #include <pcl/filters/statistical_outlier_removal.h>
+#include <pcl/common/io.h>
 
 //qCC_plugins
 #include <ccMainAppInterface.h>
@@ -31,6 +31,9 @@
 //qCC_db
 #include <ccPointCloud.h>
 
+//CCCoreLib
+#include <ReferenceCloud.h>
+
 //Qt
 #include <QMainWindow>
 
@@ -60,26 +63,50 @@ int StatisticalOutliersRemover::compute()
 		return InvalidInput;
 	}
 
-	//now as sensor message
-	PCLCloud::Ptr tmp_cloud = cc2smReader(cloud).getAsSM();
-	if (!tmp_cloud)
+	//get xyz in PCL format (shared with the other filters)
+	PCLCloudCache& cache = PCLCloudCache::GetUniqueInstance();
+	pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud = cache.getXYZ(cloud);
+	if (!xyzCloud)
 	{
-		return ComputationError;
+		return NotEnoughMemory;
 	}
 
-	PCLCloud outcloud;
+	//we only need the indexes of the inliers (the other features are copied from the original cloud)
+	std::vector<int> inlierIndexes;
+	{
+		pcl::StatisticalOutlierRemoval<pcl::PointXYZ> remover;
+		remover.setInputCloud(xyzCloud);
+		remover.setMeanK(m_kNN);
+		remover.setStddevMulThresh(m_std);
+		remover.filter(inlierIndexes);
+	}
 
-	pcl::StatisticalOutlierRemoval<PCLCloud> remover;
-	remover.setInputCloud(tmp_cloud);
-	remover.setMeanK(m_kNN);
-	remover.setStddevMulThresh(m_std);
-	remover.filter(outcloud);
+	CCCoreLib::ReferenceCloud inliers(cloud);
+	if (!inliers.reserve(static_cast<unsigned>(inlierIndexes.size())))
+	{
+		return NotEnoughMemory;
+	}
+	for (int index : inlierIndexes)
+	{
+		inliers.addPointIndex(static_cast<unsigned>(index));
+	}
 
-	//get back outcloud as a ccPointCloud
-	ccPointCloud* final_cloud = pcl2cc::Convert(outcloud);
+	ccPointCloud* final_cloud = cloud->partialClone(&inliers);
 	if (!final_cloud)
 	{
-		return ComputationError;
+		return NotEnoughMemory;
+	}
+
+	//the next filter of a chain won't have to convert the output cloud again
+	try
+	{
+		pcl::PointCloud<pcl::PointXYZ>::Ptr filteredXYZCloud(new pcl::PointCloud<pcl::PointXYZ>);
+		pcl::copyPointCloud(*xyzCloud, inlierIndexes, *filteredXYZCloud);
+		cache.setXYZ(final_cloud, filteredXYZCloud);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not a problem, the cloud will simply be converted again if necessary
 	}
 
 	//create a suitable name for the entity
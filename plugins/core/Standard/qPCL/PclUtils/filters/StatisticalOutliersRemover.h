@@ -25,6 +25,12 @@ public:
 	StatisticalOutliersRemover();
 	~StatisticalOutliersRemover() override;
 
+	//! Sets the parameters (without any dialog)
+	/** \param kNN number of neighbors
+		\param std standard deviation multiplier
+	**/
+	void setParameters(int kNN, float std) { m_kNN = kNN; m_std = std; }
+
 protected:
 	//inherited from BaseFilter
 	int compute() override;
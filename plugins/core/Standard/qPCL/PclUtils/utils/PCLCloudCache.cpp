@@ -0,0 +1,207 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qPCL                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                         COPYRIGHT: Luca Penasa                         #
+//#                                                                        #
+//##########################################################################
+//
+#include "PCLCloudCache.h"
+
+//Local
+#include "cc2sm.h"
+
+//PCL
+#include <pcl/common/io.h>
+
+//qCC_db
+#include <ccPointCloud.h>
+
+//system
+#include <algorithm>
+#include <cassert>
+
+PCLCloudCache& PCLCloudCache::GetUniqueInstance()
+{
+	static PCLCloudCache s_cache;
+	return s_cache;
+}
+
+PCLCloudCache::Signature PCLCloudCache::PointsSignature(const ccPointCloud& cloud)
+{
+	Signature signature;
+	signature.count = cloud.size();
+	signature.version = cloud.getFeatureVersions().points;
+	return signature;
+}
+
+PCLCloudCache::Signature PCLCloudCache::NormalsSignature(const ccPointCloud& cloud)
+{
+	Signature signature;
+	if (cloud.hasNormals())
+	{
+		signature.count = cloud.size();
+		signature.version = cloud.getFeatureVersions().normals;
+	}
+	return signature;
+}
+
+PCLCloudCache::Entry& PCLCloudCache::getEntry(const ccPointCloud& cloud)
+{
+	Signature points = PointsSignature(cloud);
+	Signature normals = NormalsSignature(cloud);
+
+	for (Entry& entry : m_entries)
+	{
+		if (entry.uniqueID == cloud.getUniqueID())
+		{
+			if (entry.points != points)
+			{
+				//the points have changed
+				entry.xyz.reset();
+				entry.pointNormal.reset();
+				entry.points = points;
+			}
+			if (entry.normals != normals)
+			{
+				//the normals have changed
+				entry.pointNormal.reset();
+				entry.normals = normals;
+			}
+			return entry;
+		}
+	}
+
+	Entry entry;
+	entry.uniqueID = cloud.getUniqueID();
+	entry.points = points;
+	entry.normals = normals;
+	m_entries.push_back(entry);
+
+	return m_entries.back();
+}
+
+pcl::PointCloud<pcl::PointXYZ>::Ptr PCLCloudCache::getXYZ(ccPointCloud* cloud)
+{
+	if (!cloud)
+	{
+		assert(false);
+		return {};
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	Entry& entry = getEntry(*cloud);
+	if (!entry.xyz)
+	{
+		if (entry.pointNormal)
+		{
+			//no need to go back to the CC cloud
+			try
+			{
+				pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud(new pcl::PointCloud<pcl::PointXYZ>);
+				pcl::copyPointCloud(*entry.pointNormal, *xyzCloud);
+				entry.xyz = xyzCloud;
+			}
+			catch (...)
+			{
+				//any error (memory, etc.)
+				return {};
+			}
+		}
+		else
+		{
+			entry.xyz = cc2smReader(cloud).getRawXYZ();
+		}
+	}
+
+	return entry.xyz;
+}
+
+pcl::PointCloud<pcl::PointNormal>::Ptr PCLCloudCache::getPointNormal(ccPointCloud* cloud)
+{
+	if (!cloud)
+	{
+		assert(false);
+		return {};
+	}
+	if (!cloud->hasNormals())
+	{
+		return {};
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	Entry& entry = getEntry(*cloud);
+	if (!entry.pointNormal)
+	{
+		entry.pointNormal = cc2smReader(cloud).getAsPointNormal();
+	}
+
+	return entry.pointNormal;
+}
+
+void PCLCloudCache::setXYZ(ccPointCloud* cloud, pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud)
+{
+	if (!cloud || !xyzCloud || xyzCloud->size() != cloud->size())
+	{
+		assert(false);
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	getEntry(*cloud).xyz = xyzCloud;
+}
+
+void PCLCloudCache::setPointNormal(ccPointCloud* cloud, pcl::PointCloud<pcl::PointNormal>::Ptr pointNormalCloud)
+{
+	if (!cloud || !cloud->hasNormals() || !pointNormalCloud || pointNormalCloud->size() != cloud->size())
+	{
+		assert(false);
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	getEntry(*cloud).pointNormal = pointNormalCloud;
+}
+
+void PCLCloudCache::release(const ccPointCloud* cloud)
+{
+	if (!cloud)
+	{
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	unsigned uniqueID = cloud->getUniqueID();
+	m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [uniqueID](const Entry& entry) { return entry.uniqueID == uniqueID; }), m_entries.end());
+}
+
+void PCLCloudCache::releaseAll()
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_entries.clear();
+}
+
+void PCLCloudCache::keepOnly(const ccHObject::Container& entities)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&entities](const Entry& entry)
+		{
+			return std::none_of(entities.begin(), entities.end(), [&entry](const ccHObject* entity) { return entity && entity->getUniqueID() == entry.uniqueID; });
+		}), m_entries.end());
+}
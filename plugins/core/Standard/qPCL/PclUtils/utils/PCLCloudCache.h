@@ -0,0 +1,126 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qPCL                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                         COPYRIGHT: Luca Penasa                         #
+//#                                                                        #
+//##########################################################################
+//
+#ifndef Q_PCL_PLUGIN_CLOUD_CACHE_H
+#define Q_PCL_PLUGIN_CLOUD_CACHE_H
+
+//PCL
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+//qCC_db
+#include <ccHObject.h>
+
+//Qt
+#include <QMutex>
+
+//system
+#include <vector>
+
+class ccPointCloud;
+
+//! Cache of the PCL versions of CC clouds
+/** The PCL point types can't share the CC memory layout (they are padded), so each
+	cloud is still converted, but only once: the converted clouds are shared (smart
+	pointers) by the consecutive filters applied to the same entity. The output of a
+	filter can also be registered, so that the next filter of a chain doesn't have
+	to convert it back.
+
+	The cached clouds are invalidated as soon as the points (or the normals) of the
+	CC cloud are changed. This is detected with the number of points and the feature
+	versions of the cloud (see ccPointCloud::getFeatureVersions), which are incremented
+	by notifyGeometryUpdate, pointsHaveChanged and normalsHaveChanged. Code that edits
+	the points or the normals in place must call one of them (as for the display).
+**/
+class PCLCloudCache
+{
+public:
+
+	//! Returns the unique instance of the cache
+	static PCLCloudCache& GetUniqueInstance();
+
+	//! Returns the cloud as a 'pcl::PointXYZ' cloud (converted only if necessary)
+	/** \return nullptr if the conversion failed (not enough memory)
+	**/
+	pcl::PointCloud<pcl::PointXYZ>::Ptr getXYZ(ccPointCloud* cloud);
+
+	//! Returns the cloud as a 'pcl::PointNormal' cloud (converted only if necessary)
+	/** \return nullptr if the cloud has no normals or if the conversion failed (not enough memory)
+	**/
+	pcl::PointCloud<pcl::PointNormal>::Ptr getPointNormal(ccPointCloud* cloud);
+
+	//! Registers the 'pcl::PointXYZ' version of a cloud (e.g. the output of a filter)
+	void setXYZ(ccPointCloud* cloud, pcl::PointCloud<pcl::PointXYZ>::Ptr xyzCloud);
+
+	//! Registers the 'pcl::PointNormal' version of a cloud (e.g. the output of a filter)
+	/** \warning the CC cloud should have the same normals
+	**/
+	void setPointNormal(ccPointCloud* cloud, pcl::PointCloud<pcl::PointNormal>::Ptr pointNormalCloud);
+
+	//! Releases the cached versions of a cloud
+	void release(const ccPointCloud* cloud);
+
+	//! Releases all the cached clouds
+	void releaseAll();
+
+	//! Only keeps the cached versions of a set of entities
+	void keepOnly(const ccHObject::Container& entities);
+
+protected: //methods
+
+	//! Default constructor
+	PCLCloudCache() = default;
+
+	//! Signature of a CC cloud feature (points or normals)
+	struct Signature
+	{
+		unsigned count = 0;
+		unsigned version = 0;
+
+		bool operator == (const Signature& s) const { return count == s.count && version == s.version; }
+		bool operator != (const Signature& s) const { return !(*this == s); }
+	};
+
+	//! Returns the signature of the points of a cloud
+	static Signature PointsSignature(const ccPointCloud& cloud);
+
+	//! Returns the signature of the normals of a cloud
+	static Signature NormalsSignature(const ccPointCloud& cloud);
+
+	//! Cache entry
+	struct Entry
+	{
+		unsigned uniqueID = 0;
+		Signature points;
+		Signature normals;
+		pcl::PointCloud<pcl::PointXYZ>::Ptr xyz;
+		pcl::PointCloud<pcl::PointNormal>::Ptr pointNormal;
+	};
+
+	//! Returns the (up to date) entry of a cloud (created if necessary)
+	Entry& getEntry(const ccPointCloud& cloud);
+
+protected: //members
+
+	//! Cached clouds
+	std::vector<Entry> m_entries;
+
+	//! Mutex
+	QMutex m_mutex;
+};
+
+#endif // Q_PCL_PLUGIN_CLOUD_CACHE_H
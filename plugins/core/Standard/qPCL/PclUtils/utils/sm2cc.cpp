@@ -484,3 +484,77 @@ ccPointCloud* pcl2cc::Convert(	const PCLCloud& pclCloud,
 
 	return ccCloud;
 }
+
+//! Creates a ccPointCloud with the points of a PCL cloud
+template <class PointT> static ccPointCloud* ConvertPoints(const pcl::PointCloud<PointT>& pclCloud)
+{
+	ccPointCloud* ccCloud = new ccPointCloud();
+
+	unsigned pointCount = static_cast<unsigned>(pclCloud.size());
+	if (!ccCloud->reserve(pointCount))
+	{
+		//not enough memory
+		delete ccCloud;
+		return nullptr;
+	}
+
+	for (const PointT& P : pclCloud.points)
+	{
+		ccCloud->addPoint(CCVector3(static_cast<PointCoordinateType>(P.x),
+									static_cast<PointCoordinateType>(P.y),
+									static_cast<PointCoordinateType>(P.z)));
+	}
+
+	return ccCloud;
+}
+
+ccPointCloud* pcl2cc::Convert(const pcl::PointCloud<pcl::PointXYZ>& pclCloud)
+{
+	return ConvertPoints(pclCloud);
+}
+
+ccPointCloud* pcl2cc::Convert(const pcl::PointCloud<pcl::PointNormal>& pclCloud, bool withNormals)
+{
+	ccPointCloud* ccCloud = ConvertPoints(pclCloud);
+	if (!ccCloud || !withNormals || pclCloud.empty())
+	{
+		return ccCloud;
+	}
+
+	if (!ccCloud->reserveTheNormsTable())
+	{
+		//not enough memory
+		delete ccCloud;
+		return nullptr;
+	}
+
+	//the curvature is stored as a scalar field
+	ccScalarField* curvatureSF = new ccScalarField("curvature");
+	if (!curvatureSF->reserveSafe(static_cast<unsigned>(pclCloud.size())))
+	{
+		//not enough memory
+		curvatureSF->release();
+		curvatureSF = nullptr;
+	}
+
+	for (const pcl::PointNormal& P : pclCloud.points)
+	{
+		ccCloud->addNorm(CCVector3(	static_cast<PointCoordinateType>(P.normal_x),
+									static_cast<PointCoordinateType>(P.normal_y),
+									static_cast<PointCoordinateType>(P.normal_z)));
+		if (curvatureSF)
+		{
+			curvatureSF->addElement(static_cast<ScalarType>(P.curvature));
+		}
+	}
+
+	ccCloud->showNormals(true);
+
+	if (curvatureSF)
+	{
+		curvatureSF->computeMinAndMax();
+		ccCloud->addScalarField(curvatureSF);
+	}
+
+	return ccCloud;
+}
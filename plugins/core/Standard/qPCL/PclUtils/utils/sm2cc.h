@@ -20,6 +20,10 @@
 //Local
 #include "PCLCloud.h"
 
+//PCL
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
 //qCC_db
 #include <ccPointCloud.h>
 
@@ -38,6 +42,15 @@ public:
 									ccGLMatrixd* _transform = nullptr,
 									FileIOFilter::LoadParameters* _loadParameters = nullptr );
 
+	//! Converts a 'pcl::PointXYZ' cloud to a ccPointCloud (directly, i.e. without going through a PCLCloud)
+	static ccPointCloud* Convert(const pcl::PointCloud<pcl::PointXYZ>& pclCloud);
+
+	//! Converts a 'pcl::PointNormal' cloud to a ccPointCloud (directly, i.e. without going through a PCLCloud)
+	/** \param pclCloud input cloud
+		\param withNormals whether to import the normals (and the curvature, as a scalar field) or only the points
+	**/
+	static ccPointCloud* Convert(const pcl::PointCloud<pcl::PointNormal>& pclCloud, bool withNormals);
+
 public: // other related utility functions
 
 	static bool CopyXYZ(const PCLCloud& pclCloud,
@@ -0,0 +1,62 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qPCL                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                        COPYRIGHT: Luca Penasa                          #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_PCL_PLUGIN_COMMANDS_HEADER
+#define Q_PCL_PLUGIN_COMMANDS_HEADER
+
+#include "ccCommandLineInterface.h"
+
+//! PCL normal estimation command (-PCL_NORMALS)
+/** The normals (and the curvature) are computed for each loaded cloud.
+**/
+class PCLNormalsCommand : public ccCommandLineInterface::Command
+{
+public:
+	PCLNormalsCommand();
+
+	~PCLNormalsCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+//! PCL MLS smoothing command (-PCL_MLS)
+/** Each loaded cloud is replaced by its smoothed version.
+**/
+class PCLMLSCommand : public ccCommandLineInterface::Command
+{
+public:
+	PCLMLSCommand();
+
+	~PCLMLSCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+//! PCL Statistical Outlier Removal command (-PCL_SOR)
+/** Each loaded cloud is replaced by its filtered version.
+**/
+class PCLSORCommand : public ccCommandLineInterface::Command
+{
+public:
+	PCLSORCommand();
+
+	~PCLSORCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+#endif //Q_PCL_PLUGIN_COMMANDS_HEADER
@@ -16,12 +16,14 @@
 //##########################################################################
 //
 #include "qPCL.h"
+#include "qPCLCommands.h"
 
 //qCC_db
 #include <ccPointCloud.h>
 
 //PclUtils
 #include <BaseFilter.h>
+#include <PCLCloudCache.h>
 
 //FILTERS
 #include <ExtractSIFT.h>
@@ -42,6 +44,8 @@ qPCL::~qPCL()
 		delete m_filters.back();
 		m_filters.pop_back();
 	}
+
+	PCLCloudCache::GetUniqueInstance().releaseAll();
 }
 
 void qPCL::handleNewEntity(ccHObject* entity)
@@ -116,4 +120,19 @@ void qPCL::onNewSelection(const ccHObject::Container& selectedEntities)
 	{
 		filter->updateSelectedEntities(selectedEntities);
 	}
+
+	//the PCL versions of the unselected clouds are not needed anymore
+	PCLCloudCache::GetUniqueInstance().keepOnly(selectedEntities);
+}
+
+void qPCL::registerCommands(ccCommandLineInterface* cmd)
+{
+	if (!cmd)
+	{
+		assert(false);
+		return;
+	}
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new PCLNormalsCommand));
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new PCLMLSCommand));
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new PCLSORCommand));
 }
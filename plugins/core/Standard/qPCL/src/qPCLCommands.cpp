@@ -0,0 +1,309 @@
+//##########################################################################
+//#                                                                        #
+//#                       CLOUDCOMPARE PLUGIN: qPCL                        #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                        COPYRIGHT: Luca Penasa                          #
+//#                                                                        #
+//##########################################################################
+
+#include "qPCLCommands.h"
+
+//PclUtils
+#include <MLSSmoothingUpsampling.h>
+#include <NormalEstimation.h>
+#include <PCLCloudCache.h>
+#include <StatisticalOutliersRemover.h>
+
+//qCC_db
+#include <ccHObjectCaster.h>
+#include <ccPointCloud.h>
+
+constexpr char COMMAND_PCL_NORMALS[] = "PCL_NORMALS";
+constexpr char COMMAND_PCL_MLS[] = "PCL_MLS";
+constexpr char COMMAND_PCL_SOR[] = "PCL_SOR";
+constexpr char COMMAND_PCL_KNN[] = "KNN";
+constexpr char COMMAND_PCL_RADIUS[] = "RADIUS";
+constexpr char COMMAND_PCL_STD[] = "STD";
+constexpr char COMMAND_PCL_ORDER[] = "ORDER";
+constexpr char COMMAND_PCL_SQR_GAUSS[] = "SQR_GAUSS";
+constexpr char COMMAND_PCL_COMPUTE_NORMALS[] = "COMPUTE_NORMALS";
+
+//! Reads an integer value after an option
+static bool ReadInt(ccCommandLineInterface& cmd, const char* option, int& value, int minValue)
+{
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: value after \"-%1\"").arg(option));
+	}
+	bool conversionOk = false;
+	value = cmd.arguments().takeFirst().toInt(&conversionOk);
+	if (!conversionOk || value < minValue)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(option));
+	}
+	return true;
+}
+
+//! Reads a (strictly positive) floating point value after an option
+static bool ReadPositiveDouble(ccCommandLineInterface& cmd, const char* option, double& value)
+{
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: value after \"-%1\"").arg(option));
+	}
+	bool conversionOk = false;
+	value = cmd.arguments().takeFirst().toDouble(&conversionOk);
+	if (!conversionOk || value <= 0.0)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(option));
+	}
+	return true;
+}
+
+//! Applies a filter to all the loaded clouds
+/** The PCL versions of the clouds are kept in the shared cache between two
+	consecutive commands, so that a chain of PCL commands only converts each
+	cloud once.
+	\param cmd command line interface
+	\param filter filter (with its parameters already set)
+	\param suffix suffix for the output files
+	\param replaceClouds whether the filter creates a new cloud that should replace the input one
+**/
+static bool ApplyFilter(ccCommandLineInterface& cmd, BaseFilter& filter, const char* suffix, bool replaceClouds)
+{
+	PCLCloudCache& cache = PCLCloudCache::GetUniqueInstance();
+
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		ccPointCloud* cloud = desc.pc;
+		assert(cloud);
+
+		cmd.print(QObject::tr("Cloud '%1' - %2 points").arg(cloud->getName()).arg(cloud->size()));
+
+		ccHObject* output = nullptr;
+		int result = filter.applyTo(cloud, &output);
+		if (result != BaseFilter::Success)
+		{
+			delete output;
+			return cmd.error(QObject::tr("Cloud '%1': %2").arg(cloud->getName()).arg(filter.getErrorMessage(result)));
+		}
+
+		if (replaceClouds)
+		{
+			ccPointCloud* outputCloud = ccHObjectCaster::ToPointCloud(output);
+			if (!outputCloud)
+			{
+				delete output;
+				return cmd.error(QObject::tr("Cloud '%1': no output cloud").arg(cloud->getName()));
+			}
+			cmd.print(QObject::tr("\tResulting cloud: %1 points").arg(outputCloud->size()));
+
+			//replace the current cloud by the new one
+			cache.release(cloud);
+			delete cloud;
+			desc.pc = outputCloud;
+			desc.basename += QString("_%1").arg(suffix);
+		}
+
+		//save output
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(desc, suffix);
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
+		}
+	}
+
+	//only keep the PCL versions of the current clouds
+	ccHObject::Container clouds;
+	for (const CLCloudDesc& desc : cmd.clouds())
+	{
+		clouds.push_back(desc.pc);
+	}
+	cache.keepOnly(clouds);
+
+	return true;
+}
+
+PCLNormalsCommand::PCLNormalsCommand()
+	: Command("PCL normal estimation", COMMAND_PCL_NORMALS)
+{
+}
+
+bool PCLNormalsCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[PCL NORMALS]");
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+
+	bool useKnn = true;
+	int knn = 10;
+	double radius = 0.0;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_KNN))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadInt(cmd, COMMAND_PCL_KNN, knn, 1))
+			{
+				return false;
+			}
+			useKnn = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_RADIUS))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveDouble(cmd, COMMAND_PCL_RADIUS, radius))
+			{
+				return false;
+			}
+			useKnn = false;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	NormalEstimation filter;
+	filter.setParameters(useKnn, knn, static_cast<float>(radius), true);
+
+	return ApplyFilter(cmd, filter, "PCL_NORMALS", false);
+}
+
+PCLMLSCommand::PCLMLSCommand()
+	: Command("PCL MLS smoothing", COMMAND_PCL_MLS)
+{
+}
+
+bool PCLMLSCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[PCL MLS]");
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+
+	MLSParameters params;
+	params.polynomial_fit_ = true;
+	params.order_ = 2;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_RADIUS))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveDouble(cmd, COMMAND_PCL_RADIUS, params.search_radius_))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_ORDER))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadInt(cmd, COMMAND_PCL_ORDER, params.order_, 0))
+			{
+				return false;
+			}
+			params.polynomial_fit_ = (params.order_ > 1);
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_SQR_GAUSS))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveDouble(cmd, COMMAND_PCL_SQR_GAUSS, params.sqr_gauss_param_))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_COMPUTE_NORMALS))
+		{
+			cmd.arguments().pop_front();
+			params.compute_normals_ = true;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (params.search_radius_ <= 0.0)
+	{
+		return cmd.error(QObject::tr("Missing parameter: search radius (-%1)").arg(COMMAND_PCL_RADIUS));
+	}
+	if (params.sqr_gauss_param_ <= 0.0)
+	{
+		//same default value as the dialog
+		params.sqr_gauss_param_ = params.search_radius_ * params.search_radius_;
+	}
+
+	MLSSmoothingUpsampling filter;
+	filter.setParameters(params);
+
+	return ApplyFilter(cmd, filter, "PCL_MLS", true);
+}
+
+PCLSORCommand::PCLSORCommand()
+	: Command("PCL Statistical Outlier Removal", COMMAND_PCL_SOR)
+{
+}
+
+bool PCLSORCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[PCL SOR]");
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+
+	int knn = 6;
+	double nSigma = 1.0;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_KNN))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadInt(cmd, COMMAND_PCL_KNN, knn, 1))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCL_STD))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveDouble(cmd, COMMAND_PCL_STD, nSigma))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	StatisticalOutliersRemover filter;
+	filter.setParameters(knn, static_cast<float>(nSigma));
+
+	return ApplyFilter(cmd, filter, "PCL_SOR", true);
+}
@@ -46,6 +46,8 @@ public:
 		\param height height of the OpenGL context used to simulate illumination
 		\param progressCb optional progress bar (optional)
 		\param entityName entity name (optional)
+		\param softwareRendering whether to use the CPU renderer (PCVSoftwareRenderer) instead of OpenGL
+		\param maxThreadCount max number of threads for the CPU renderer (0 = all)
 		\return number of 'light' directions actually used (or a value <0 if an error occurred)
 	**/
 	static int Launch(	unsigned numberOfRays,
@@ -56,7 +58,9 @@ public:
 						unsigned width = 1024,
 						unsigned height = 1024,
 						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
-						const QString& entityName = QString());
+						const QString& entityName = QString(),
+						bool softwareRendering = false,
+						int maxThreadCount = 0);
 
 	//! Simulates global illumination on a cloud (or a mesh) with OpenGL
 	/** Computes per-vertex illumination intensity as a scalar field.
@@ -68,7 +72,10 @@ public:
 		\param height height of the OpenGL context used to simulate illumination
 		\param progressCb optional progress bar (optional)
 		\param entityName entity name (optional)
+		\param softwareRendering whether to use the CPU renderer (PCVSoftwareRenderer) instead of OpenGL
+		\param maxThreadCount max number of threads for the CPU renderer (0 = all)
 		\return success
+		\warning If no OpenGL context can be created, the CPU renderer is used anyway
 	**/
 	static bool Launch(	const std::vector<CCVector3>& rays,
 						CCCoreLib::GenericCloud* vertices,
@@ -77,7 +84,9 @@ public:
 						unsigned width = 1024,
 						unsigned height = 1024,
 						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
-						const QString& entityName = QString());
+						const QString& entityName = QString(),
+						bool softwareRendering = false,
+						int maxThreadCount = 0);
 
 	//! Generates a given number of rays
 	static bool GenerateRays(	unsigned numberOfRays,
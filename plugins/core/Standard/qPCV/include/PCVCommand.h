@@ -38,7 +38,9 @@ public:
 							bool meshIsClosed,
 							unsigned resolution,
 							ccProgressDialog* progressDlg = nullptr,
-							ccMainAppInterface* app = nullptr);
+							ccMainAppInterface* app = nullptr,
+							bool softwareRendering = false,
+							int maxThreadCount = 0);
 
 	bool process(ccCommandLineInterface& cmd) override;
 };
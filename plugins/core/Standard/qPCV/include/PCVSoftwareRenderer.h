@@ -0,0 +1,111 @@
+//##########################################################################
+//#                                                                        #
+//#                                PCV                                     #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU Library General Public License as       #
+//#  published by the Free Software Foundation; version 2 or later of the License.  #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef PCV_SOFTWARE_RENDERER_HEADER
+#define PCV_SOFTWARE_RENDERER_HEADER
+
+//CCCoreLib
+#include <GenericCloud.h>
+#include <GenericMesh.h>
+#include <GenericProgressCallback.h>
+
+//system
+#include <atomic>
+#include <vector>
+
+//! PCV (Portion de Ciel Visible / Ambiant Illumination) software renderer
+/** CPU counterpart of PCVContext: the entity is rasterized in plain z-buffers
+	(one per thread) instead of an OpenGL pixel buffer, so that no OpenGL context
+	is required (e.g. on headless servers). The same orthographic projection and
+	depth offsets as PCVContext are used, so that both give the same illumination.
+
+	The light directions are processed in parallel. The vertices (and triangles)
+	are copied in contiguous single precision arrays (relatively to the entity
+	center) so that the projection loops can be vectorized by the compiler.
+**/
+class PCVSoftwareRenderer
+{
+public:
+	//! Default constructor
+	PCVSoftwareRenderer();
+
+	//! Initialization
+	/** \param W depth buffer width (pixels)
+		\param H depth buffer height (pixels)
+		\param cloud associated cloud (or mesh vertices)
+		\param mesh associated mesh (if any)
+		\param closedMesh whether mesh is closed (faster) or not
+		\return initialization success
+	**/
+	bool init(	unsigned W,
+				unsigned H,
+				CCCoreLib::GenericCloud* cloud,
+				CCCoreLib::GenericMesh* mesh = nullptr,
+				bool closedMesh = true);
+
+	//! Increments the visibility counter of the vertices viewed from each light direction
+	/** \param rays light directions
+		\param visibilityCount per-vertex visibility count (same size as the number of vertices)
+		\param maxThreadCount max number of threads (0 = all)
+		\param nProgress progress notification (optional - one step per light direction)
+		\return false if the process failed or was canceled
+	**/
+	bool accumulate(const std::vector<CCVector3>& rays,
+					std::vector<int>& visibilityCount,
+					int maxThreadCount = 0,
+					CCCoreLib::NormalizedProgress* nProgress = nullptr) const;
+
+protected: //methods
+
+	//! Orthographic projection for a given light direction
+	struct Projection;
+	//! Per-thread buffers
+	struct Buffers;
+
+	//! Renders the entity and flags the visible vertices for one light direction
+	void processRay(const CCVector3& ray, Buffers& buffers, std::atomic<int>* visibilityCount) const;
+
+	//! Rasterizes the points in the depth buffer
+	void rasterizePoints(const Projection& proj, Buffers& buffers) const;
+
+	//! Rasterizes the triangles in the depth buffer
+	void rasterizeTriangles(const Projection& proj, Buffers& buffers) const;
+
+protected: //members
+
+	//! Vertices coordinates (relatively to m_viewCenter)
+	std::vector<float> m_x, m_y, m_z;
+	//! Triangles vertices coordinates (9 values per triangle, relatively to m_viewCenter)
+	std::vector<float> m_triangles;
+	//! Whether a mesh is associated to the vertices
+	bool m_hasMesh;
+
+	//! Zoom (pixels per unit)
+	double m_zoom;
+	//! Center of the displayed entity
+	CCVector3d m_viewCenter;
+
+	//! Depth buffer width (pixels)
+	unsigned m_width;
+	//! Depth buffer height (pixels)
+	unsigned m_height;
+
+	//! Whether displayed mesh is closed or not
+	bool m_meshIsClosed;
+};
+
+#endif
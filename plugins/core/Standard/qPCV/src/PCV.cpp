@@ -18,6 +18,7 @@
 
 #include "PCV.h"
 #include "PCVContext.h"
+#include "PCVSoftwareRenderer.h"
 
 //Qt
 #include <QString>
@@ -209,7 +210,9 @@ int PCV::Launch(unsigned numberOfRays,
 				unsigned width/*=1024*/,
 				unsigned height/*=1024*/,
 				CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
-				const QString& entityName/*=QString()*/)
+				const QString& entityName/*=QString()*/,
+				bool softwareRendering/*=false*/,
+				int maxThreadCount/*=0*/)
 {
 	//generates light directions
 	std::vector<CCVector3> rays;
@@ -218,7 +221,7 @@ int PCV::Launch(unsigned numberOfRays,
 		return -2;
 	}
 
-	if (!Launch(rays, vertices, mesh, meshIsClosed, width, height, progressCb, entityName))
+	if (!Launch(rays, vertices, mesh, meshIsClosed, width, height, progressCb, entityName, softwareRendering, maxThreadCount))
 	{
 		return -1;
 	}
@@ -233,7 +236,9 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 				 unsigned width/*=1024*/,
 				 unsigned height/*=1024*/,
 				 CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
-				 const QString& entityName/*=QString()*/)
+				 const QString& entityName/*=QString()*/,
+				 bool softwareRendering/*=false*/,
+				 int maxThreadCount/*=0*/)
 {
 	if (rays.empty())
 		return false;
@@ -282,38 +287,49 @@ bool PCV::Launch(const std::vector<CCVector3>& rays,
 
 	bool success = true;
 
-	//must be done after progress dialog display!
-	PCVContext win;
-	if (win.init(width, height, vertices, mesh, meshIsClosed))
+	if (!softwareRendering)
 	{
-		for (unsigned i = 0; i < numberOfRays; ++i)
+		//must be done after progress dialog display!
+		PCVContext win;
+		if (win.init(width, height, vertices, mesh, meshIsClosed))
 		{
-			//set current 'light' direction
-			win.setViewDirection(rays[i]);
+			for (unsigned i = 0; i < numberOfRays; ++i)
+			{
+				//set current 'light' direction
+				win.setViewDirection(rays[i]);
 
-			//flag viewed vertices
-			win.GLAccumPixel(visibilityCount);
+				//flag viewed vertices
+				win.GLAccumPixel(visibilityCount);
 
-			if (progressCb && !nProgress.oneStep())
-			{
-				success = false;
-				break;
+				if (progressCb && !nProgress.oneStep())
+				{
+					success = false;
+					break;
+				}
 			}
 		}
-
-		if (success)
+		else
 		{
-			//we convert per-vertex accumulators to an 'intensity' scalar field
-			for (unsigned j = 0; j < numberOfPoints; ++j)
-			{
-				ScalarType visValue = static_cast<ScalarType>(visibilityCount[j]) / numberOfRays;
-				vertices->setPointScalarValue(j, visValue);
-			}
+			//no OpenGL context available (e.g. headless server)
+			softwareRendering = true;
 		}
 	}
-	else
+
+	if (softwareRendering)
+	{
+		PCVSoftwareRenderer renderer;
+		success = renderer.init(width, height, vertices, mesh, meshIsClosed)
+			&& renderer.accumulate(rays, visibilityCount, maxThreadCount, progressCb ? &nProgress : nullptr);
+	}
+
+	if (success)
 	{
-		success = false;
+		//we convert per-vertex accumulators to an 'intensity' scalar field
+		for (unsigned j = 0; j < numberOfPoints; ++j)
+		{
+			ScalarType visValue = static_cast<ScalarType>(visibilityCount[j]) / numberOfRays;
+			vertices->setPointScalarValue(j, visValue);
+		}
 	}
 
 	return success;
@@ -6,10 +6,14 @@
 #include <ccColorScalesManager.h>
 #include <ccGenericMesh.h>
 #include <ccHObjectCaster.h>
+#include <ccLog.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
 
+//Qt
+#include <QElapsedTimer>
+
 constexpr char CC_PCV_FIELD_LABEL_NAME[] = "Illuminance (PCV)";
 
 constexpr char COMMAND_PCV[] = "PCV";
@@ -17,6 +21,8 @@ constexpr char COMMAND_PCV_N_RAYS[] = "N_RAYS";
 constexpr char COMMAND_PCV_IS_CLOSED[] = "IS_CLOSED";
 constexpr char COMMAND_PCV_180[] = "180";
 constexpr char COMMAND_PCV_RESOLUTION[] = "RESOLUTION";
+constexpr char COMMAND_PCV_CPU[] = "CPU";
+constexpr char COMMAND_PCV_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
 
 PCVCommand::PCVCommand()
 	: Command("PCV", COMMAND_PCV)
@@ -28,7 +34,9 @@ bool PCVCommand::Process(	const ccHObject::Container& candidates,
 							bool meshIsClosed,
 							unsigned resolution,
 							ccProgressDialog* progressDlg/*=nullptr*/,
-							ccMainAppInterface* app/*=nullptr*/)
+							ccMainAppInterface* app/*=nullptr*/,
+							bool softwareRendering/*=false*/,
+							int maxThreadCount/*=0*/)
 {
 	size_t count = 0;
 	size_t errorCount = 0;
@@ -89,7 +97,10 @@ bool PCVCommand::Process(	const ccHObject::Container& candidates,
 		bool wasVisible = obj->isVisible();
 		obj->setEnabled(true);
 		obj->setVisible(true);
-		bool success = PCV::Launch(rays, cloud, mesh, meshIsClosed, resolution, resolution, progressDlg, objNameForPorgressDialog);
+		QElapsedTimer timer;
+		timer.start();
+		bool success = PCV::Launch(rays, cloud, mesh, meshIsClosed, resolution, resolution, progressDlg, objNameForPorgressDialog, softwareRendering, maxThreadCount);
+		double elapsed_s = timer.nsecsElapsed() / 1.0e9;
 		obj->setEnabled(wasEnabled);
 		obj->setVisible(wasVisible);
 
@@ -102,6 +113,14 @@ bool PCVCommand::Process(	const ccHObject::Container& candidates,
 		}
 		else
 		{
+			//throughput
+			ccLog::Print(QObject::tr("[PCV] '%1': %2 rays x %3 points in %4 s (%5 rays/s)")
+							.arg(objName)
+							.arg(rays.size())
+							.arg(cloud->size())
+							.arg(elapsed_s, 0, 'f', 3)
+							.arg(elapsed_s > 0 ? rays.size() / elapsed_s : 0.0, 0, 'f', 1));
+
 			ccScalarField* sf = static_cast<ccScalarField*>(cloud->getScalarField(sfIdx));
 			if (sf)
 			{
@@ -153,6 +172,8 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 	bool meshIsClosed = false;
 	bool mode360 = true;
 	unsigned resolution = 1024;
+	bool softwareRendering = false;
+	int maxThreadCount = 0;
 
 	while (!cmd.arguments().empty())
 	{
@@ -190,6 +211,26 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_PCV_RESOLUTION));
 			}
 		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCV_CPU))
+		{
+			//no OpenGL context required
+			cmd.arguments().pop_front();
+			softwareRendering = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_PCV_MAX_THREAD_COUNT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after \"-%1\"").arg(COMMAND_PCV_MAX_THREAD_COUNT));
+			}
+			bool conversionOk = false;
+			maxThreadCount = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_PCV_MAX_THREAD_COUNT));
+			}
+		}
 		else
 		{
 			break;
@@ -221,7 +262,7 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 	for (CLMeshDesc& desc : cmd.meshes())
 		candidates.push_back(desc.mesh);
 
-	if (!Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, nullptr))
+	if (!Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, nullptr, softwareRendering, maxThreadCount))
 	{
 		return cmd.error(QObject::tr("Process failed"));
 	}
@@ -0,0 +1,485 @@
+//##########################################################################
+//#                                                                        #
+//#                                PCV                                     #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU Library General Public License as       #
+//#  published by the Free Software Foundation; version 2 or later of the License.  #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "PCVSoftwareRenderer.h"
+
+//CCCoreLib
+#include <CCMath.h>
+#include <GenericTriangle.h>
+
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
+//Qt
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//system
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace CCCoreLib;
+
+//same depth offset as PCVContext
+#ifndef ZTWIST
+#define ZTWIST 1e-3f
+#endif
+
+//! Number of points projected at once (see ProjectBlock)
+static const unsigned PROJECTION_BLOCK_SIZE = 256;
+
+struct PCVSoftwareRenderer::Projection
+{
+	//! Window X = a.P + a[3]
+	float a[4];
+	//! Window Y = b.P + b[3]
+	float b[4];
+	//! Depth of a vertex (as compared to the depth buffer) = c.P + c[3]
+	/** The entity is rasterized with an additional offset of 2*ZTWIST
+		(see PCVContext::GLAccumPixel).
+	**/
+	float c[4];
+
+	inline void project(const float* P, float& X, float& Y, float& Z) const
+	{
+		X = a[0] * P[0] + a[1] * P[1] + a[2] * P[2] + a[3];
+		Y = b[0] * P[0] + b[1] * P[1] + b[2] * P[2] + b[3];
+		Z = c[0] * P[0] + c[1] * P[1] + c[2] * P[2] + c[3];
+	}
+};
+
+struct PCVSoftwareRenderer::Buffers
+{
+	//! Depth buffer
+	std::vector<float> depth;
+	//! Coverage buffer (only for non closed meshes)
+	std::vector<unsigned char> coverage;
+
+	//! Projected points (see ProjectBlock)
+	float X[PROJECTION_BLOCK_SIZE];
+	float Y[PROJECTION_BLOCK_SIZE];
+	float Z[PROJECTION_BLOCK_SIZE];
+};
+
+//! Projects a block of points (branchless so as to be vectorized)
+static inline void ProjectBlock(const float* a,
+								const float* b,
+								const float* c,
+								const float* x,
+								const float* y,
+								const float* z,
+								unsigned count,
+								float* X,
+								float* Y,
+								float* Z)
+{
+	for (unsigned k = 0; k < count; ++k)
+	{
+		X[k] = a[0] * x[k] + a[1] * y[k] + a[2] * z[k] + a[3];
+		Y[k] = b[0] * x[k] + b[1] * y[k] + b[2] * z[k] + b[3];
+		Z[k] = c[0] * x[k] + c[1] * y[k] + c[2] * z[k] + c[3];
+	}
+}
+
+PCVSoftwareRenderer::PCVSoftwareRenderer()
+	: m_hasMesh(false)
+	, m_zoom(1.0)
+	, m_viewCenter(0, 0, 0)
+	, m_width(0)
+	, m_height(0)
+	, m_meshIsClosed(false)
+{
+}
+
+bool PCVSoftwareRenderer::init(	unsigned W,
+								unsigned H,
+								CCCoreLib::GenericCloud* cloud,
+								CCCoreLib::GenericMesh* mesh/*=nullptr*/,
+								bool closedMesh/*=true*/)
+{
+	if (!cloud || W == 0 || H == 0)
+	{
+		assert(false);
+		return false;
+	}
+
+	m_width = W;
+	m_height = H;
+	m_hasMesh = (mesh != nullptr);
+	m_meshIsClosed = (closedMesh || !mesh);
+
+	//same zoom and center as PCVContext::associateToEntity
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud->getBoundingBox(bbMin, bbMax);
+	PointCoordinateType maxD = (bbMax - bbMin).norm();
+	m_zoom = (CCCoreLib::GreaterThanEpsilon(maxD) ? static_cast<double>(std::min(m_width, m_height)) / maxD : 1.0);
+	m_viewCenter = CCVector3d::fromArray(((bbMax + bbMin) / 2).u);
+
+	unsigned pointCount = cloud->size();
+	try
+	{
+		m_x.resize(pointCount);
+		m_y.resize(pointCount);
+		m_z.resize(pointCount);
+		if (mesh)
+		{
+			m_triangles.resize(static_cast<size_t>(mesh->size()) * 9);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		m_x.clear();
+		m_y.clear();
+		m_z.clear();
+		m_triangles.clear();
+		return false;
+	}
+
+	cloud->placeIteratorAtBeginning();
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		const CCVector3* P = cloud->getNextPoint();
+		m_x[i] = static_cast<float>(P->x - m_viewCenter.x);
+		m_y[i] = static_cast<float>(P->y - m_viewCenter.y);
+		m_z[i] = static_cast<float>(P->z - m_viewCenter.z);
+	}
+
+	if (mesh)
+	{
+		unsigned triCount = mesh->size();
+		mesh->placeIteratorAtBeginning();
+		float* t = m_triangles.data();
+		for (unsigned i = 0; i < triCount; ++i)
+		{
+			GenericTriangle* tri = mesh->_getNextTriangle();
+			const CCVector3* vertices[3] { tri->_getA(), tri->_getB(), tri->_getC() };
+			for (const CCVector3* P : vertices)
+			{
+				*t++ = static_cast<float>(P->x - m_viewCenter.x);
+				*t++ = static_cast<float>(P->y - m_viewCenter.y);
+				*t++ = static_cast<float>(P->z - m_viewCenter.z);
+			}
+		}
+	}
+
+	return true;
+}
+
+void PCVSoftwareRenderer::rasterizePoints(const Projection& proj, Buffers& buffers) const
+{
+	const int W = static_cast<int>(m_width);
+	const int H = static_cast<int>(m_height);
+	float* depth = buffers.depth.data();
+	unsigned char* coverage = (buffers.coverage.empty() ? nullptr : buffers.coverage.data());
+
+	unsigned pointCount = static_cast<unsigned>(m_x.size());
+	for (unsigned start = 0; start < pointCount; start += PROJECTION_BLOCK_SIZE)
+	{
+		unsigned count = std::min(PROJECTION_BLOCK_SIZE, pointCount - start);
+		ProjectBlock(proj.a, proj.b, proj.c, m_x.data() + start, m_y.data() + start, m_z.data() + start, count, buffers.X, buffers.Y, buffers.Z);
+
+		for (unsigned k = 0; k < count; ++k)
+		{
+			int x = static_cast<int>(std::floor(buffers.X[k]));
+			int y = static_cast<int>(std::floor(buffers.Y[k]));
+			if (x >= 0 && x < W && y >= 0 && y < H)
+			{
+				int dec = x + y * W;
+				float z = buffers.Z[k] + 2.0f * ZTWIST;
+				if (z < depth[dec])
+				{
+					depth[dec] = z;
+				}
+				if (coverage)
+				{
+					coverage[dec] = 1;
+				}
+			}
+		}
+	}
+}
+
+void PCVSoftwareRenderer::rasterizeTriangles(const Projection& proj, Buffers& buffers) const
+{
+	const int W = static_cast<int>(m_width);
+	const int H = static_cast<int>(m_height);
+	float* depth = buffers.depth.data();
+	unsigned char* coverage = (buffers.coverage.empty() ? nullptr : buffers.coverage.data());
+
+	size_t triCount = m_triangles.size() / 9;
+	const float* t = m_triangles.data();
+	for (size_t i = 0; i < triCount; ++i, t += 9)
+	{
+		float X[3];
+		float Y[3];
+		float Z[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			proj.project(t + 3 * k, X[k], Y[k], Z[k]);
+			Z[k] += 2.0f * ZTWIST;
+		}
+
+		//counter-clockwise triangles (in window coordinates) are front-facing
+		float area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+		if (area <= 0)
+		{
+			if (m_meshIsClosed || area == 0)
+			{
+				//back faces are culled if the mesh is closed
+				continue;
+			}
+			std::swap(X[1], X[2]);
+			std::swap(Y[1], Y[2]);
+			std::swap(Z[1], Z[2]);
+			area = -area;
+		}
+
+		//bounding box of the covered pixel centers
+		int xMin = std::max(0, static_cast<int>(std::ceil(std::min({ X[0], X[1], X[2] }) - 0.5f)));
+		int xMax = std::min(W - 1, static_cast<int>(std::floor(std::max({ X[0], X[1], X[2] }) - 0.5f)));
+		int yMin = std::max(0, static_cast<int>(std::ceil(std::min({ Y[0], Y[1], Y[2] }) - 0.5f)));
+		int yMax = std::min(H - 1, static_cast<int>(std::floor(std::max({ Y[0], Y[1], Y[2] }) - 0.5f)));
+		if (xMin > xMax || yMin > yMax)
+		{
+			continue;
+		}
+
+		//edge functions (e0 is the barycentric weight of vertex #0, etc.)
+		float invArea = 1.0f / area;
+		float dx0 = -(Y[2] - Y[1]), dx1 = -(Y[0] - Y[2]), dx2 = -(Y[1] - Y[0]);
+		float cx = xMin + 0.5f;
+		for (int y = yMin; y <= yMax; ++y)
+		{
+			float cy = y + 0.5f;
+			float e0 = (X[2] - X[1]) * (cy - Y[1]) - (Y[2] - Y[1]) * (cx - X[1]);
+			float e1 = (X[0] - X[2]) * (cy - Y[2]) - (Y[0] - Y[2]) * (cx - X[2]);
+			float e2 = (X[1] - X[0]) * (cy - Y[0]) - (Y[1] - Y[0]) * (cx - X[0]);
+
+			float* depthRow = depth + y * W;
+			for (int x = xMin; x <= xMax; ++x, e0 += dx0, e1 += dx1, e2 += dx2)
+			{
+				if (e0 >= 0 && e1 >= 0 && e2 >= 0)
+				{
+					float z = (e0 * Z[0] + e1 * Z[1] + e2 * Z[2]) * invArea;
+					if (z < depthRow[x])
+					{
+						depthRow[x] = z;
+					}
+					if (coverage)
+					{
+						coverage[x + y * W] = 1;
+					}
+				}
+			}
+		}
+	}
+}
+
+void PCVSoftwareRenderer::processRay(const CCVector3& ray, Buffers& buffers, std::atomic<int>* visibilityCount) const
+{
+	//same view as PCVContext::setViewDirection (i.e. gluLookAt from -ray towards the origin)
+	CCVector3d f = CCVector3d::fromArray(ray.u);
+	if (CCCoreLib::LessThanEpsilon(f.norm2()))
+	{
+		return;
+	}
+	CCVector3d up(0, 0, 1);
+	if (1 - std::abs(ray.z) < 1.0e-4)
+	{
+		up = CCVector3d(0, 1, 0);
+	}
+	f.normalize();
+	CCVector3d s = f.cross(up);
+	s.normalize();
+	CCVector3d u = s.cross(f);
+
+	//same orthographic projection as PCVContext::glInit (with a [0, 1 - 2*ZTWIST] depth range)
+	double w2 = 0.5 * m_width;
+	double h2 = 0.5 * m_height;
+	double maxD = static_cast<double>(std::max(m_width, m_height));
+	double depthScale = (1.0 - 2.0 * ZTWIST) * 0.5;
+
+	Projection proj;
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		proj.a[d] = static_cast<float>(m_zoom * s.u[d]);
+		proj.b[d] = static_cast<float>(m_zoom * u.u[d]);
+		proj.c[d] = static_cast<float>(depthScale * m_zoom * f.u[d] / maxD);
+	}
+	proj.a[3] = static_cast<float>(w2);
+	proj.b[3] = static_cast<float>(h2);
+	proj.c[3] = static_cast<float>(depthScale);
+
+	//render the entity
+	std::fill(buffers.depth.begin(), buffers.depth.end(), 1.0f);
+	if (!buffers.coverage.empty())
+	{
+		std::fill(buffers.coverage.begin(), buffers.coverage.end(), static_cast<unsigned char>(0));
+	}
+	if (m_hasMesh)
+	{
+		rasterizeTriangles(proj, buffers);
+	}
+	else
+	{
+		rasterizePoints(proj, buffers);
+	}
+
+	//flag the visible vertices
+	const int W = static_cast<int>(m_width);
+	const int H = static_cast<int>(m_height);
+	const float* depth = buffers.depth.data();
+	const unsigned char* coverage = (buffers.coverage.empty() ? nullptr : buffers.coverage.data());
+
+	unsigned pointCount = static_cast<unsigned>(m_x.size());
+	for (unsigned start = 0; start < pointCount; start += PROJECTION_BLOCK_SIZE)
+	{
+		unsigned count = std::min(PROJECTION_BLOCK_SIZE, pointCount - start);
+		ProjectBlock(proj.a, proj.b, proj.c, m_x.data() + start, m_y.data() + start, m_z.data() + start, count, buffers.X, buffers.Y, buffers.Z);
+
+		for (unsigned k = 0; k < count; ++k)
+		{
+			int x = static_cast<int>(std::floor(buffers.X[k]));
+			int y = static_cast<int>(std::floor(buffers.Y[k]));
+			if (x < 0 || x >= W || y < 0 || y >= H)
+			{
+				continue;
+			}
+
+			int dec = x + y * W;
+			if (coverage)
+			{
+				//the vertex must be close to a rendered pixel (see PCVContext::GLAccumPixel)
+				int x1 = std::min(x + 1, W - 1);
+				int dy = (y + 1 < H ? W : 0);
+				if (!coverage[dec] && !coverage[x1 + y * W] && !coverage[dec + dy] && !coverage[x1 + y * W + dy])
+				{
+					continue;
+				}
+			}
+
+			if (buffers.Z[k] < depth[dec])
+			{
+				visibilityCount[start + k].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+bool PCVSoftwareRenderer::accumulate(	const std::vector<CCVector3>& rays,
+										std::vector<int>& visibilityCount,
+										int maxThreadCount/*=0*/,
+										CCCoreLib::NormalizedProgress* nProgress/*=nullptr*/) const
+{
+	if (visibilityCount.size() != m_x.size())
+	{
+		assert(false);
+		return false;
+	}
+	if (rays.empty())
+	{
+		return true;
+	}
+
+	//the light directions are processed in parallel: the counters are shared
+	std::vector<std::atomic<int>> counters;
+	try
+	{
+		counters = std::vector<std::atomic<int>>(visibilityCount.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	unsigned rayCount = static_cast<unsigned>(rays.size());
+	size_t bufferSize = static_cast<size_t>(m_width) * m_height;
+
+	std::atomic<unsigned> nextRay(0);
+	std::atomic<unsigned> runningWorkers(0);
+	std::atomic<bool> canceled(false);
+
+	//each worker has its own buffers and processes the next available light direction
+	auto worker = [&](int)
+	{
+		Buffers buffers;
+		try
+		{
+			buffers.depth.resize(bufferSize);
+			if (!m_meshIsClosed)
+			{
+				buffers.coverage.resize(bufferSize);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory for this worker (the others will do the job)
+			return;
+		}
+		++runningWorkers;
+
+		for (unsigned r = nextRay++; r < rayCount && !canceled; r = nextRay++)
+		{
+			processRay(rays[r], buffers, counters.data());
+
+			if (nProgress && !nProgress->oneStep())
+			{
+				canceled = true;
+			}
+		}
+	};
+
+	if (maxThreadCount == 0)
+	{
+		maxThreadCount = ccQtHelpers::GetMaxThreadCount();
+	}
+	int workerCount = std::max(1, std::min(maxThreadCount, static_cast<int>(rayCount)));
+#ifdef _DEBUG
+	workerCount = 1;
+#endif
+
+	if (workerCount > 1)
+	{
+		std::vector<int> workerIndexes(workerCount);
+		for (int i = 0; i < workerCount; ++i)
+		{
+			workerIndexes[i] = i;
+		}
+		QThreadPool::globalInstance()->setMaxThreadCount(workerCount);
+		QtConcurrent::blockingMap(workerIndexes, worker);
+	}
+	else
+	{
+		worker(0);
+	}
+
+	if (canceled || runningWorkers == 0)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < visibilityCount.size(); ++i)
+	{
+		visibilityCount[i] += counters[i];
+	}
+
+	return true;
+}
@@ -41,6 +41,7 @@ static int s_raysSpinBoxValue			= 256;
 static int s_resSpinBoxValue			= 1024;
 static bool s_mode180CheckBoxState		= true;
 static bool s_closedMeshCheckBoxState	= false;
+static bool s_softwareRenderingState	= false;
 
 
 qPCV::qPCV(QObject* parent/*=nullptr*/)
@@ -126,6 +127,7 @@ void qPCV::doAction()
 		dlg.mode180CheckBox->setChecked(s_mode180CheckBoxState);
 		dlg.resSpinBox->setValue(s_resSpinBoxValue);
 		dlg.closedMeshCheckBox->setChecked(s_closedMeshCheckBoxState);
+		dlg.softwareRenderingCheckBox->setChecked(s_softwareRenderingState);
 	}
 
 	dlg.closedMeshCheckBox->setEnabled(hasMeshes); //for meshes only
@@ -173,11 +175,13 @@ void qPCV::doAction()
 	s_mode180CheckBoxState		= dlg.mode180CheckBox->isChecked();
 	s_resSpinBoxValue			= dlg.resSpinBox->value();
 	s_closedMeshCheckBoxState	= dlg.closedMeshCheckBox->isChecked();
+	s_softwareRenderingState	= dlg.softwareRenderingCheckBox->isChecked();
 
 	unsigned rayCount = dlg.raysSpinBox->value();
 	unsigned resolution = dlg.resSpinBox->value();
 	bool meshIsClosed = (hasMeshes ? dlg.closedMeshCheckBox->isChecked() : false);
 	bool mode360 = !dlg.mode180CheckBox->isChecked();
+	bool softwareRendering = dlg.softwareRenderingCheckBox->isChecked();
 
 	//PCV type ShadeVis
 	std::vector<CCVector3> rays;
@@ -221,7 +225,7 @@ void qPCV::doAction()
 	ccProgressDialog pcvProgressCb(true, m_app->getMainWindow());
 	pcvProgressCb.setAutoClose(false);
 
-	PCVCommand::Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, m_app);
+	PCVCommand::Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, m_app, softwareRendering);
 
 	pcvProgressCb.close();
 
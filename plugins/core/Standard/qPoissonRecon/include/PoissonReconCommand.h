@@ -0,0 +1,37 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: qPoissonRecon                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_POISSON_RECON_COMMAND_HEADER
+#define Q_POISSON_RECON_COMMAND_HEADER
+
+#include "ccCommandLineInterface.h"
+
+//! Poisson Surface Reconstruction command (-POISSON)
+/** A mesh is reconstructed for each loaded cloud (with normals). The duration
+	of each stage of the reconstruction is reported.
+**/
+class PoissonReconCommand : public ccCommandLineInterface::Command
+{
+public:
+	PoissonReconCommand();
+
+	~PoissonReconCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+#endif //Q_POISSON_RECON_COMMAND_HEADER
@@ -0,0 +1,92 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: qPoissonRecon                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#ifndef Q_POISSON_RECON_PROCESS_HEADER
+#define Q_POISSON_RECON_PROCESS_HEADER
+
+//PoissonRecon
+#include <PoissonReconLib.h>
+
+//Qt
+#include <QString>
+
+class ccMesh;
+class ccPointCloud;
+
+//! Poisson reconstruction process (shared by the GUI and the command line)
+/** The input points, normals and colors are read directly from the cloud, and the
+	output vertices, triangles and density values are streamed into the output mesh
+	(its capacity grows geometrically, and the density SF is only allocated when the
+	library outputs the first density value).
+**/
+class PoissonReconProcess
+{
+public:
+
+	//! Reconstruction report
+	struct Report
+	{
+		//! Octree depth (as estimated, or after reduction to fit the memory budget)
+		int depth = 0;
+		//! Requested octree depth (from the depth or the finest cell width parameters)
+		int requestedDepth = 0;
+		//! Whether the depth has been reduced to fit the memory budget
+		bool depthReduced = false;
+		//! Estimated peak memory (in MB)
+		double estimatedMemory_MB = 0.0;
+
+		//! Preparation duration (memory estimation, etc.) - in seconds
+		double preparation_s = 0.0;
+		//! Reconstruction duration (octree, solver and iso-surface extraction) - in seconds
+		double reconstruction_s = 0.0;
+		//! Output duration (transfer of the mesh elements) - in seconds
+		double output_s = 0.0;
+		//! Finalization duration (normals, scalar field, etc.) - in seconds
+		double finalization_s = 0.0;
+	};
+
+	//! Estimates the peak memory required by a reconstruction
+	/** This is a rough estimate: the number of octree nodes at the finest level
+		is extrapolated from the number of cells occupied by the points at a coarser
+		level (assuming that the points sample a surface).
+		\param cloud input cloud
+		\param params reconstruction parameters
+		\param depth octree depth (or 0 to use the depth corresponding to params.finestCellWidth)
+		\return estimated memory (in MB)
+	**/
+	static double EstimateMemory_MB(ccPointCloud& cloud, const PoissonReconLib::Parameters& params, int depth = 0);
+
+	//! Returns the octree depth corresponding to the parameters (depth or finest cell width)
+	static int GetDepth(ccPointCloud& cloud, const PoissonReconLib::Parameters& params);
+
+	//! Reconstructs a mesh from a cloud with normals
+	/** \param cloud input cloud (with normals)
+		\param params reconstruction parameters
+		\param memoryBudget_MB memory budget (in MB, or 0 for no limit). If set, the octree depth is reduced
+		when the (rough) memory estimation exceeds it. Otherwise the requested depth is always used.
+		\param errorMessage error message (if any)
+		\param report reconstruction report (optional)
+		\return the reconstructed mesh (or nullptr if an error occurred)
+	**/
+	static ccMesh* Reconstruct(	ccPointCloud& cloud,
+								const PoissonReconLib::Parameters& params,
+								unsigned memoryBudget_MB,
+								QString& errorMessage,
+								Report* report = nullptr);
+};
+
+#endif //Q_POISSON_RECON_PROCESS_HEADER
@@ -0,0 +1,245 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: qPoissonRecon                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#include "PoissonReconCommand.h"
+
+//Local
+#include "PoissonReconProcess.h"
+
+//qCC_db
+#include <ccMesh.h>
+#include <ccPointCloud.h>
+
+//system
+#include <algorithm>
+
+constexpr char COMMAND_POISSON[] = "POISSON";
+constexpr char COMMAND_POISSON_DEPTH[] = "DEPTH";
+constexpr char COMMAND_POISSON_RESOLUTION[] = "RESOLUTION";
+constexpr char COMMAND_POISSON_SAMPLES_PER_NODE[] = "SAMPLES_PER_NODE";
+constexpr char COMMAND_POISSON_POINT_WEIGHT[] = "POINT_WEIGHT";
+constexpr char COMMAND_POISSON_BOUNDARY[] = "BOUNDARY";
+constexpr char COMMAND_POISSON_BOUNDARY_FREE[] = "FREE";
+constexpr char COMMAND_POISSON_BOUNDARY_DIRICHLET[] = "DIRICHLET";
+constexpr char COMMAND_POISSON_BOUNDARY_NEUMANN[] = "NEUMANN";
+constexpr char COMMAND_POISSON_LINEAR_FIT[] = "LINEAR_FIT";
+constexpr char COMMAND_POISSON_DENSITY[] = "DENSITY";
+constexpr char COMMAND_POISSON_WITH_COLORS[] = "WITH_COLORS";
+constexpr char COMMAND_POISSON_MAX_MEMORY[] = "MAX_MEMORY";
+constexpr char COMMAND_POISSON_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
+
+PoissonReconCommand::PoissonReconCommand()
+	: Command("Poisson Surface Reconstruction", COMMAND_POISSON)
+{
+}
+
+bool PoissonReconCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[POISSON]");
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+
+	PoissonReconLib::Parameters params;
+	params.withColors = false;
+	params.density = false;
+	params.linearFit = false;
+	unsigned memoryBudget_MB = 0;
+	int maxThreadCount = 0;
+
+	while (!cmd.arguments().empty())
+	{
+		const QString& arg = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_DEPTH))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: octree depth after \"-%1\"").arg(COMMAND_POISSON_DEPTH));
+			}
+			bool conversionOk = false;
+			params.depth = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || params.depth < 1)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_POISSON_DEPTH));
+			}
+			params.finestCellWidth = 0;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_RESOLUTION))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: finest cell width after \"-%1\"").arg(COMMAND_POISSON_RESOLUTION));
+			}
+			bool conversionOk = false;
+			params.finestCellWidth = cmd.arguments().takeFirst().toFloat(&conversionOk);
+			if (!conversionOk || params.finestCellWidth <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_POISSON_RESOLUTION));
+			}
+			params.depth = 0;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_SAMPLES_PER_NODE))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: samples per node after \"-%1\"").arg(COMMAND_POISSON_SAMPLES_PER_NODE));
+			}
+			bool conversionOk = false;
+			params.samplesPerNode = cmd.arguments().takeFirst().toFloat(&conversionOk);
+			if (!conversionOk || params.samplesPerNode < 1.0f)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_POISSON_SAMPLES_PER_NODE));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_POINT_WEIGHT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: point weight after \"-%1\"").arg(COMMAND_POISSON_POINT_WEIGHT));
+			}
+			bool conversionOk = false;
+			params.pointWeight = cmd.arguments().takeFirst().toFloat(&conversionOk);
+			if (!conversionOk || params.pointWeight < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_POISSON_POINT_WEIGHT));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_BOUNDARY))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: boundary type after \"-%1\"").arg(COMMAND_POISSON_BOUNDARY));
+			}
+			QString boundary = cmd.arguments().takeFirst().toUpper();
+			if (boundary == COMMAND_POISSON_BOUNDARY_FREE)
+			{
+				params.boundary = PoissonReconLib::Parameters::FREE;
+			}
+			else if (boundary == COMMAND_POISSON_BOUNDARY_DIRICHLET)
+			{
+				params.boundary = PoissonReconLib::Parameters::DIRICHLET;
+			}
+			else if (boundary == COMMAND_POISSON_BOUNDARY_NEUMANN)
+			{
+				params.boundary = PoissonReconLib::Parameters::NEUMANN;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Invalid boundary type: '%1' (should be %2, %3 or %4)").arg(boundary).arg(COMMAND_POISSON_BOUNDARY_FREE).arg(COMMAND_POISSON_BOUNDARY_DIRICHLET).arg(COMMAND_POISSON_BOUNDARY_NEUMANN));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_LINEAR_FIT))
+		{
+			cmd.arguments().pop_front();
+			params.linearFit = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_DENSITY))
+		{
+			cmd.arguments().pop_front();
+			params.density = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_WITH_COLORS))
+		{
+			cmd.arguments().pop_front();
+			params.withColors = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_MAX_MEMORY))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: memory budget after \"-%1\"").arg(COMMAND_POISSON_MAX_MEMORY));
+			}
+			bool conversionOk = false;
+			memoryBudget_MB = cmd.arguments().takeFirst().toUInt(&conversionOk);
+			if (!conversionOk)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\" (memory budget in MB)").arg(COMMAND_POISSON_MAX_MEMORY));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(arg, COMMAND_POISSON_MAX_THREAD_COUNT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after \"-%1\"").arg(COMMAND_POISSON_MAX_THREAD_COUNT));
+			}
+			bool conversionOk = false;
+			maxThreadCount = cmd.arguments().takeFirst().toInt(&conversionOk);
+			if (!conversionOk || maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_POISSON_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	params.threads = (maxThreadCount == 0 ? PoissonReconLib::Parameters::GetMaxThreadCount() : std::min(maxThreadCount, PoissonReconLib::Parameters::GetMaxThreadCount()));
+
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		ccPointCloud* cloud = desc.pc;
+		assert(cloud);
+
+		cmd.print(QObject::tr("Cloud '%1' - %2 points - %3 thread(s)").arg(cloud->getName()).arg(cloud->size()).arg(params.threads));
+
+		QString errorMessage;
+		PoissonReconProcess::Report report;
+		ccMesh* mesh = PoissonReconProcess::Reconstruct(*cloud, params, memoryBudget_MB, errorMessage, &report);
+		if (!mesh)
+		{
+			return cmd.error(QObject::tr("Cloud '%1': %2").arg(cloud->getName()).arg(errorMessage));
+		}
+
+		//(a reduced depth is already reported by the reconstruction process)
+		cmd.print(QObject::tr("\tOctree depth: %1 (requested: %2) - estimated memory: %3 MB").arg(report.depth).arg(report.requestedDepth).arg(report.estimatedMemory_MB, 0, 'f', 0));
+		cmd.print(QObject::tr("\tTimings: preparation %1 s / reconstruction %2 s / output %3 s / finalization %4 s")
+					.arg(report.preparation_s, 0, 'f', 3)
+					.arg(report.reconstruction_s, 0, 'f', 3)
+					.arg(report.output_s, 0, 'f', 3)
+					.arg(report.finalization_s, 0, 'f', 3));
+		cmd.print(QObject::tr("\tResulting mesh: #%1 faces, %2 vertices").arg(mesh->size()).arg(mesh->getAssociatedCloud()->size()));
+
+		CLMeshDesc meshDesc(mesh, desc.basename, desc.path, desc.indexInFile);
+
+		//save output
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(meshDesc, "POISSON");
+			if (!errorStr.isEmpty())
+			{
+				delete mesh;
+				return cmd.error(errorStr);
+			}
+		}
+
+		//add the resulting mesh to the main set
+		cmd.meshes().push_back(meshDesc);
+	}
+
+	return true;
+}
@@ -0,0 +1,547 @@
+//##########################################################################
+//#                                                                        #
+//#                CLOUDCOMPARE PLUGIN: qPoissonRecon                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#include "PoissonReconProcess.h"
+
+//qCC_db
+#include <ccLog.h>
+#include <ccMesh.h>
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+//Qt
+#include <QElapsedTimer>
+
+//system
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+//! Enlargement of the bounding cube of the points (same as the default 'scale' of the library)
+static const double c_boundingCubeScale = 1.1;
+//! Max octree depth used to count the cells occupied by the points (i.e. a 256 x 256 x 256 grid)
+static const int c_occupancyMaxDepth = 8;
+//! Average memory per octree node (node, FEM coefficients and system matrix row)
+/** Order of magnitude only (not calibrated against a given version of the library): the
+	node itself (~64 bytes), a few double coefficients (constraints, solution, normal field),
+	and a sparse system matrix row (up to 5x5x5 neighbors, with 'double' values and indexes,
+	of which only a fraction is stored at the same time). The estimation is only used to reduce
+	the depth when a memory budget is explicitly set (see Reconstruct).
+**/
+static const double c_bytesPerNode = 512.0;
+//! Average memory per input sample (copied inside the library)
+/** Position, normal and weight (in double) plus the optional color and the sample data
+	stored in the octree. Order of magnitude only (same remark as c_bytesPerNode).
+**/
+static const double c_bytesPerSample = 64.0;
+//! Min octree depth (when the depth is reduced to fit the memory budget)
+static const int c_minDepth = 5;
+//! Min capacity increment of the output containers
+static const unsigned c_minCapacityIncrement = 4096;
+
+//! Returns the next capacity of an output container
+static unsigned NextCapacity(unsigned size)
+{
+	//geometric growth (so as to limit the number of reallocations/copies for large meshes)
+	size_t capacity = static_cast<size_t>(size) + std::max<size_t>(c_minCapacityIncrement, size / 2);
+	return static_cast<unsigned>(std::min<size_t>(capacity, std::numeric_limits<unsigned>::max()));
+}
+
+//! Increases the capacity of an output container
+template <class ReserveFunc> static bool GrowCapacity(unsigned size, ReserveFunc reserve)
+{
+	unsigned capacity = NextCapacity(size);
+	if (capacity == size)
+	{
+		//max capacity reached
+		return false;
+	}
+	if (reserve(capacity))
+	{
+		return true;
+	}
+
+	//not enough memory for the geometric growth, we try a smaller increment
+	capacity = static_cast<unsigned>(std::min<size_t>(static_cast<size_t>(size) + c_minCapacityIncrement, std::numeric_limits<unsigned>::max()));
+	return reserve(capacity);
+}
+
+template <typename Real>
+class PointCloudWrapper : public PoissonReconLib::ICloud<Real>
+{
+public:
+	explicit PointCloudWrapper( const ccPointCloud& cloud ) : m_cloud(cloud) {}
+
+	virtual size_t size() const { return m_cloud.size(); }
+	virtual bool hasNormals() const { return m_cloud.hasNormals(); }
+	virtual bool hasColors() const { return m_cloud.hasColors(); }
+	virtual void getPoint(size_t index, Real* coords) const
+	{
+		if (index >= m_cloud.size())
+		{
+			assert(false);
+			return;
+		}
+		//point
+		const CCVector3* P = m_cloud.getPoint(static_cast<unsigned>(index));
+		coords[0] = static_cast<Real>(P->x);
+		coords[1] = static_cast<Real>(P->y);
+		coords[2] = static_cast<Real>(P->z);
+	}
+
+	virtual void getNormal(size_t index, Real* coords) const
+	{
+		if (index >= m_cloud.size() || !m_cloud.hasNormals())
+		{
+			assert(false);
+			return;
+		}
+
+		const CCVector3& N = m_cloud.getPointNormal(static_cast<unsigned>(index));
+		coords[0] = static_cast<Real>(N.x);
+		coords[1] = static_cast<Real>(N.y);
+		coords[2] = static_cast<Real>(N.z);
+	}
+
+	virtual void getColor(size_t index, Real* rgb) const
+	{
+		if (index >= m_cloud.size() || !m_cloud.hasColors())
+		{
+			assert(false);
+			return;
+		}
+
+		const ccColor::Rgb& color = m_cloud.getPointColor(static_cast<unsigned>(index));
+		rgb[0] = static_cast<Real>(color.r);
+		rgb[1] = static_cast<Real>(color.g);
+		rgb[2] = static_cast<Real>(color.b);
+	}
+
+protected:
+	const ccPointCloud& m_cloud;
+};
+
+template <typename Real>
+class MeshWrapper : public PoissonReconLib::IMesh<Real>
+{
+public:
+	MeshWrapper(ccMesh& mesh, ccPointCloud& vertices, bool withDensity, const QElapsedTimer& timer)
+		: m_mesh(mesh)
+		, m_vertices(vertices)
+		, m_withDensity(withDensity)
+		, m_densitySF(nullptr)
+		, m_timer(timer)
+		, m_firstOutputTime(-1)
+		, m_error(false)
+	{}
+
+	~MeshWrapper()
+	{
+		if (m_densitySF)
+		{
+			m_densitySF->release();
+			m_densitySF = nullptr;
+		}
+	}
+
+	bool checkMeshCapacity()
+	{
+		if (m_error)
+		{
+			//no need to go further
+			return false;
+		}
+		if (m_mesh.size() == m_mesh.capacity() && !GrowCapacity(m_mesh.size(), [&](unsigned n) { return m_mesh.reserve(n); }))
+		{
+			m_error = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool checkVertexCapacity()
+	{
+		if (m_error)
+		{
+			//no need to go further
+			return false;
+		}
+		if (m_vertices.size() == m_vertices.capacity() && !GrowCapacity(m_vertices.size(), [&](unsigned n) { return m_vertices.reserve(n); }))
+		{
+			m_error = true;
+			return false;
+		}
+		return true;
+	}
+
+	virtual void addVertex(const Real* coords) override
+	{
+		if (m_firstOutputTime < 0)
+		{
+			m_firstOutputTime = m_timer.elapsed();
+		}
+		if (!checkVertexCapacity())
+		{
+			return;
+		}
+		CCVector3 P = CCVector3::fromArray(coords);
+		m_vertices.addPoint(P);
+	}
+
+	virtual void addNormal(const Real* coords) override
+	{
+		if (!checkVertexCapacity())
+		{
+			return;
+		}
+		if (!m_vertices.hasNormals() && !m_vertices.reserveTheNormsTable())
+		{
+			m_error = true;
+			return;
+		}
+		CCVector3 N = CCVector3::fromArray(coords);
+		m_vertices.addNorm(N);
+	}
+
+	virtual void addColor(const Real* rgb) override
+	{
+		if (!checkVertexCapacity())
+		{
+			return;
+		}
+		if (!m_vertices.hasColors())
+		{
+			if (!m_vertices.reserveTheRGBTable())
+			{
+				m_error = true;
+				return;
+			}
+		}
+		m_vertices.addColor(	static_cast<ColorCompType>(std::min((Real)255, std::max((Real)0, rgb[0]))),
+								static_cast<ColorCompType>(std::min((Real)255, std::max((Real)0, rgb[1]))),
+								static_cast<ColorCompType>(std::min((Real)255, std::max((Real)0, rgb[2]))) );
+	}
+
+	virtual void addDensity(double d) override
+	{
+		if (!m_withDensity || m_error)
+		{
+			return;
+		}
+		if (!m_densitySF)
+		{
+			//the scalar field is only allocated when the first value is received
+			m_densitySF = new ccScalarField("Density");
+		}
+		if (m_densitySF->size() == m_densitySF->capacity() && !GrowCapacity(static_cast<unsigned>(m_densitySF->size()), [&](unsigned n) { return m_densitySF->reserveSafe(n); }))
+		{
+			m_error = true;
+			return;
+		}
+		m_densitySF->addElement(static_cast<ScalarType>(d));
+	}
+
+	void addTriangle(size_t i1, size_t i2, size_t i3) override
+	{
+		if (!checkMeshCapacity())
+		{
+			return;
+		}
+		m_mesh.addTriangle(static_cast<unsigned>(i1), static_cast<unsigned>(i2), static_cast<unsigned>(i3));
+	}
+
+	bool isInErrorState() const { return m_error; }
+
+	//! Returns the time at which the first vertex has been received (or -1 if none)
+	qint64 firstOutputTime() const { return m_firstOutputTime; }
+
+	//! Returns the density SF (if any) and releases its ownership
+	ccScalarField* takeDensitySF()
+	{
+		ccScalarField* sf = m_densitySF;
+		m_densitySF = nullptr;
+		return sf;
+	}
+
+protected:
+	ccMesh& m_mesh;
+	ccPointCloud& m_vertices;
+	bool m_withDensity;
+	ccScalarField* m_densitySF;
+	const QElapsedTimer& m_timer;
+	qint64 m_firstOutputTime;
+	bool m_error;
+};
+
+//! Points occupancy (see ComputeOccupancy)
+struct Occupancy
+{
+	//! Number of input points
+	unsigned pointCount = 0;
+	//! Octree depth of the occupancy grid
+	int depth = 0;
+	//! Number of occupied cells
+	size_t cellCount = 0;
+};
+
+//! Counts the cells occupied by the points (at a coarse octree depth)
+static Occupancy ComputeOccupancy(ccPointCloud& cloud, int depth)
+{
+	Occupancy occupancy;
+	occupancy.pointCount = cloud.size();
+	occupancy.depth = std::max(0, std::min(depth, c_occupancyMaxDepth));
+	if (occupancy.pointCount == 0)
+	{
+		return occupancy;
+	}
+
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud.getBoundingBox(bbMin, bbMax);
+	CCVector3 diag = bbMax - bbMin;
+	double width = c_boundingCubeScale * std::max(diag.x, std::max(diag.y, diag.z));
+
+	const unsigned gridSize = (1u << occupancy.depth);
+	std::vector<bool> occupied;
+	try
+	{
+		occupied.resize(static_cast<size_t>(gridSize) * gridSize * gridSize, false);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory: we assume that each point is in its own cell
+		occupancy.cellCount = occupancy.pointCount;
+		return occupancy;
+	}
+
+	if (width <= 0)
+	{
+		//all the points are at the same position
+		occupancy.cellCount = 1;
+		return occupancy;
+	}
+
+	CCVector3d origin = ((bbMin + bbMax) / 2).toDouble() - CCVector3d(width, width, width) / 2;
+	double cellSize = width / gridSize;
+
+	for (unsigned i = 0; i < occupancy.pointCount; ++i)
+	{
+		CCVector3d P = cloud.getPoint(i)->toDouble() - origin;
+		size_t cellIndex = 0;
+		for (unsigned char d = 0; d < 3; ++d)
+		{
+			int pos = static_cast<int>(std::floor(P.u[2 - d] / cellSize));
+			pos = std::max(0, std::min(pos, static_cast<int>(gridSize) - 1));
+			cellIndex = cellIndex * gridSize + static_cast<size_t>(pos);
+		}
+		if (!occupied[cellIndex])
+		{
+			occupied[cellIndex] = true;
+			++occupancy.cellCount;
+		}
+	}
+
+	return occupancy;
+}
+
+//! Estimates the peak memory of a reconstruction (in MB) from the points occupancy
+static double EstimateMemoryFromOccupancy_MB(const Occupancy& occupancy, const PoissonReconLib::Parameters& params, int depth)
+{
+	//the points are assumed to sample a surface: each subdivision multiplies the number of nodes by 4
+	double finestNodeCount = static_cast<double>(occupancy.cellCount) * std::pow(4.0, depth - occupancy.depth);
+	//but there's (roughly) no more nodes than samples
+	finestNodeCount = std::min(finestNodeCount, static_cast<double>(std::max<size_t>(occupancy.cellCount, occupancy.pointCount)));
+
+	//the siblings of the occupied nodes are allocated as well (x2), plus the coarser levels (x4/3)
+	double nodeCount = finestNodeCount * 2.0 * 4.0 / 3.0;
+
+	//output mesh: ~1.5 vertex and ~3 triangles per finest node
+	double vertexBytes = sizeof(CCVector3) + sizeof(CompressedNormType);
+	if (params.withColors)
+	{
+		vertexBytes += sizeof(ccColor::Rgb);
+	}
+	if (params.density)
+	{
+		vertexBytes += sizeof(ScalarType);
+	}
+	double triangleBytes = 3 * sizeof(unsigned);
+	double outputBytes = finestNodeCount * (1.5 * vertexBytes + 3.0 * triangleBytes);
+
+	double bytes = occupancy.pointCount * c_bytesPerSample + nodeCount * c_bytesPerNode + outputBytes;
+
+	return bytes / (1024.0 * 1024.0);
+}
+
+int PoissonReconProcess::GetDepth(ccPointCloud& cloud, const PoissonReconLib::Parameters& params)
+{
+	if (params.depth > 0 || params.finestCellWidth <= 0)
+	{
+		return params.depth;
+	}
+
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud.getBoundingBox(bbMin, bbMax);
+	CCVector3 diag = bbMax - bbMin;
+	double width = c_boundingCubeScale * std::max(diag.x, std::max(diag.y, diag.z));
+	if (width <= params.finestCellWidth)
+	{
+		return 1;
+	}
+
+	return static_cast<int>(std::ceil(std::log2(width / params.finestCellWidth)));
+}
+
+double PoissonReconProcess::EstimateMemory_MB(ccPointCloud& cloud, const PoissonReconLib::Parameters& params, int depth/*=0*/)
+{
+	if (depth <= 0)
+	{
+		depth = GetDepth(cloud, params);
+	}
+
+	Occupancy occupancy = ComputeOccupancy(cloud, depth);
+
+	return EstimateMemoryFromOccupancy_MB(occupancy, params, depth);
+}
+
+ccMesh* PoissonReconProcess::Reconstruct(	ccPointCloud& cloud,
+											const PoissonReconLib::Parameters& params,
+											unsigned memoryBudget_MB,
+											QString& errorMessage,
+											Report* report/*=nullptr*/)
+{
+	if (!cloud.hasNormals())
+	{
+		errorMessage = "Cloud must have normals!";
+		return nullptr;
+	}
+	if (cloud.size() == 0)
+	{
+		errorMessage = "Cloud is empty!";
+		return nullptr;
+	}
+
+	Report localReport;
+	Report& rep = (report ? *report : localReport);
+	rep = Report();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	PoissonReconLib::Parameters libParams = params;
+	libParams.withColors = (params.withColors && cloud.hasColors());
+
+	//memory estimation
+	int depth = GetDepth(cloud, libParams);
+	rep.requestedDepth = depth;
+	{
+		Occupancy occupancy = ComputeOccupancy(cloud, depth);
+		rep.estimatedMemory_MB = EstimateMemoryFromOccupancy_MB(occupancy, libParams, depth);
+
+		if (memoryBudget_MB != 0 && rep.estimatedMemory_MB > memoryBudget_MB)
+		{
+			//we reduce the octree depth until the reconstruction fits the budget
+			while (depth > c_minDepth && rep.estimatedMemory_MB > memoryBudget_MB)
+			{
+				--depth;
+				rep.estimatedMemory_MB = EstimateMemoryFromOccupancy_MB(occupancy, libParams, depth);
+			}
+
+			if (rep.estimatedMemory_MB > memoryBudget_MB)
+			{
+				errorMessage = QString("The reconstruction requires at least %1 MB (memory budget: %2 MB)").arg(rep.estimatedMemory_MB, 0, 'f', 0).arg(memoryBudget_MB);
+				return nullptr;
+			}
+
+			if (depth != rep.requestedDepth)
+			{
+				libParams.depth = depth;
+				libParams.finestCellWidth = 0;
+				rep.depthReduced = true;
+				ccLog::Warning(QString("[PoissonRecon] Octree depth reduced from %1 to %2 to fit the memory budget (%3 MB - estimated memory: %4 MB)").arg(rep.requestedDepth).arg(depth).arg(memoryBudget_MB).arg(rep.estimatedMemory_MB, 0, 'f', 0));
+			}
+		}
+	}
+	rep.depth = depth;
+	rep.preparation_s = timer.restart() / 1.0e3;
+
+	ccPointCloud* vertices = new ccPointCloud("vertices");
+	ccMesh* mesh = new ccMesh(vertices);
+	mesh->addChild(vertices);
+
+	ccScalarField* densitySF = nullptr;
+	{
+		MeshWrapper<PointCoordinateType> meshWrapper(*mesh, *vertices, libParams.density, timer);
+		PointCloudWrapper<PointCoordinateType> cloudWrapper(cloud);
+
+		bool success = PoissonReconLib::Reconstruct(libParams, cloudWrapper, meshWrapper);
+
+		qint64 endTime = timer.elapsed();
+		qint64 firstOutputTime = (meshWrapper.firstOutputTime() >= 0 ? meshWrapper.firstOutputTime() : endTime);
+		rep.reconstruction_s = firstOutputTime / 1.0e3;
+		rep.output_s = (endTime - firstOutputTime) / 1.0e3;
+
+		if (!success || meshWrapper.isInErrorState())
+		{
+			errorMessage = (meshWrapper.isInErrorState() ? "Not enough memory to store the output mesh" : "Reconstruction failed!");
+			delete mesh;
+			return nullptr;
+		}
+
+		densitySF = meshWrapper.takeDensitySF();
+	}
+	timer.restart();
+
+	//release the extra capacity of the output containers
+	mesh->shrinkToFit();
+	vertices->shrinkToFit();
+
+	if (!cloud.hasColors())
+	{
+		vertices->unallocateColors();
+	}
+
+	if (densitySF)
+	{
+		if (densitySF->size() == vertices->size())
+		{
+			densitySF->computeMinAndMax();
+			densitySF->showNaNValuesInGrey(false);
+			int sfIdx = vertices->addScalarField(densitySF);
+			vertices->setCurrentDisplayedScalarField(sfIdx);
+		}
+		else
+		{
+			ccLog::Warning("[PoissonRecon] Invalid density values (ignored)");
+			densitySF->release();
+		}
+		densitySF = nullptr;
+	}
+
+	mesh->computeNormals(true);
+	mesh->setName(QString("Mesh[%1] (level %2)").arg(cloud.getName()).arg(depth));
+	vertices->setEnabled(false);
+
+	//copy Global Shift & Scale information
+	vertices->copyGlobalShiftAndScale(cloud);
+
+	rep.finalization_s = timer.elapsed() / 1.0e3;
+
+	return mesh;
+}
@@ -17,6 +17,10 @@
 
 #include "qPoissonRecon.h"
 
+//Local
+#include "PoissonReconCommand.h"
+#include "PoissonReconProcess.h"
+
 //dialog
 #include "ui_poissonReconParamDlg.h"
 
@@ -29,14 +33,9 @@
 #include <QtConcurrentRun>
 #include <QtGui>
 
-//PoissonRecon
-#include <PoissonReconLib.h>
-
 //qCC_db
 #include <ccPointCloud.h>
 #include <ccMesh.h>
-#include <ccProgressDialog.h>
-#include <ccScalarField.h>
 
 //System
 #if defined(CC_WINDOWS)
@@ -46,178 +45,6 @@
 #include <unistd.h>
 #endif
 
-template <typename Real>
-class PointCloudWrapper : public PoissonReconLib::ICloud<Real>
-{
-public:
-	explicit PointCloudWrapper( const ccPointCloud& cloud ) : m_cloud(cloud) {}
-
-	virtual size_t size() const { return m_cloud.size(); }
-	virtual bool hasNormals() const { return m_cloud.hasNormals(); }
-	virtual bool hasColors() const { return m_cloud.hasColors(); }
-	virtual void getPoint(size_t index, Real* coords) const
-	{
-		if (index >= m_cloud.size())
-		{
-			assert(false);
-			return;
-		}
-		//point
-		const CCVector3* P = m_cloud.getPoint(static_cast<unsigned>(index));
-		coords[0] = static_cast<Real>(P->x);
-		coords[1] = static_cast<Real>(P->y);
-		coords[2] = static_cast<Real>(P->z);
-	}
-
-	virtual void getNormal(size_t index, Real* coords) const
-	{
-		if (index >= m_cloud.size() || !m_cloud.hasNormals())
-		{
-			assert(false);
-			return;
-		}
-
-		const CCVector3& N = m_cloud.getPointNormal(static_cast<unsigned>(index));
-		coords[0] = static_cast<Real>(N.x);
-		coords[1] = static_cast<Real>(N.y);
-		coords[2] = static_cast<Real>(N.z);
-	}
-	
-	virtual void getColor(size_t index, Real* rgb) const
-	{
-		if (index >= m_cloud.size() || !m_cloud.hasColors())
-		{
-			assert(false);
-			return;
-		}
-
-		const ccColor::Rgb& color = m_cloud.getPointColor(static_cast<unsigned>(index));
-		rgb[0] = static_cast<Real>(color.r);
-		rgb[1] = static_cast<Real>(color.g);
-		rgb[2] = static_cast<Real>(color.b);
-	}
-
-protected:
-	const ccPointCloud& m_cloud;
-};
-
-template <typename Real>
-class MeshWrapper : public PoissonReconLib::IMesh<Real>
-{
-public:
-	explicit MeshWrapper(ccMesh& mesh, ccPointCloud& vertices, CCCoreLib::ScalarField* densitySF = nullptr)
-		: m_mesh(mesh)
-		, m_vertices(vertices)
-		, m_densitySF(densitySF)
-		, m_error(false)
-	{}
-
-	bool checkMeshCapacity()
-	{
-		if (m_error)
-		{
-			//no need to go further
-			return false;
-		}
-		if (m_mesh.size() == m_mesh.capacity() && !m_mesh.reserve(m_mesh.size() + 1024))
-		{
-			m_error = true;
-			return false;
-		}
-		return true;
-	}
-
-	bool checkVertexCapacity()
-	{
-		if (m_error)
-		{
-			//no need to go further
-			return false;
-		}
-		if (m_vertices.size() == m_vertices.capacity() && !m_vertices.reserve(m_vertices.size() + 4096))
-		{
-			m_error = true;
-			return false;
-		}
-		return true;
-	}
-
-	virtual void addVertex(const Real* coords) override
-	{
-		if (!checkVertexCapacity())
-		{
-			return;
-		}
-		CCVector3 P = CCVector3::fromArray(coords);
-		m_vertices.addPoint(P);
-	}
-
-	virtual void addNormal(const Real* coords) override
-	{
-		if (!checkVertexCapacity())
-		{
-			return;
-		}
-		if (!m_vertices.hasNormals() && !m_vertices.reserveTheNormsTable())
-		{
-			m_error = true;
-			return;
-		}
-		CCVector3 N = CCVector3::fromArray(coords);
-		m_vertices.addNorm(N);
-	}
-
-	virtual void addColor(const Real* rgb) override
-	{
-		if (!checkVertexCapacity())
-		{
-			return;
-		}
-		if (!m_vertices.hasColors())
-		{
-			if (!m_vertices.reserveTheRGBTable())
-			{
-				m_error = true;
-				return;
-			}
-		}
-		m_vertices.addColor(	static_cast<ColorCompType>(std::min((Real)255, std::max((Real)0, rgb[0]))),
-								static_cast<ColorCompType>(std::min((Real)255, std::max((Real)0, rgb[1]))),
-								static_cast<ColorCompType>(std::min((Real)255, std::max((Real)0, rgb[2]))) );
-	}
-
-	virtual void addDensity(double d) override
-	{
-		if (!m_densitySF)
-		{
-			return;
-		}
-		if (m_densitySF->size() == m_densitySF->capacity() && !m_densitySF->reserveSafe(m_densitySF->size() + 4096))
-		{
-			m_error = true;
-			return;
-		}
-		m_densitySF->addElement(static_cast<ScalarType>(d));
-	}
-
-	void addTriangle(size_t i1, size_t i2, size_t i3) override
-	{
-		if (!checkMeshCapacity())
-		{
-			return;
-		}
-		m_mesh.addTriangle(static_cast<unsigned>(i1), static_cast<unsigned>(i2), static_cast<unsigned>(i3));
-	}
-
-	bool isInErrorState() const { return m_error; }
-
-protected:
-	ccMesh& m_mesh;
-	ccPointCloud& m_vertices;
-	bool m_error;
-	CCCoreLib::ScalarField* m_densitySF;
-};
-
 //dialog for qPoissonRecon plugin
 class PoissonReconParamDlg : public QDialog, public Ui::PoissonReconParamDialog
 {
@@ -260,37 +87,19 @@ QList<QAction *> qPoissonRecon::getActions()
 	return QList<QAction *>{ m_action };
 }
 
-static PoissonReconLib::Parameters s_params;
-static ccPointCloud* s_cloud = nullptr;
-static ccMesh* s_mesh = nullptr;
-static ccPointCloud* s_meshVertices = nullptr;
-static CCCoreLib::ScalarField* s_densitySF = nullptr;
-
-bool doReconstruct()
+void qPoissonRecon::registerCommands(ccCommandLineInterface* cmd)
 {
-	//invalid parameters
-	if (!s_cloud || !s_mesh || !s_meshVertices)
+	if (!cmd)
 	{
-		return false;
-	}
-
-	QElapsedTimer timer;
-	timer.start();
-
-	MeshWrapper<PointCoordinateType> meshWrapper(*s_mesh, *s_meshVertices, s_densitySF);
-	PointCloudWrapper<PointCoordinateType> cloudWrapper(*s_cloud);
-	
-	if (!PoissonReconLib::Reconstruct(s_params, cloudWrapper, meshWrapper) || meshWrapper.isInErrorState())
-	{
-		return false;
+		assert(false);
+		return;
 	}
-
-	qint64 elpased_msec = timer.elapsed();
-	ccLog::Print(QString("[PoissonRecon] Duration: %1 s").arg(elpased_msec / 1000.0, 0, 'f', 1));
-
-	return true;
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new PoissonReconCommand));
 }
 
+static PoissonReconLib::Parameters s_params;
+static unsigned s_memoryBudget_MB = 0;
+
 void qPoissonRecon::doAction()
 {
 	assert(m_app);
@@ -349,6 +158,7 @@ void qPoissonRecon::doAction()
 	prpDlg.densityCheckBox->setChecked(s_params.density);
 	prpDlg.weightDoubleSpinBox->setValue(s_params.pointWeight);
 	prpDlg.threadSpinBox->setValue(s_params.threads);
+	prpDlg.memoryBudgetSpinBox->setValue(static_cast<int>(s_memoryBudget_MB));
 	prpDlg.linearFitCheckBox->setChecked(s_params.linearFit);
 	switch (s_params.boundary)
 	{
@@ -380,6 +190,7 @@ void qPoissonRecon::doAction()
 	s_params.density = prpDlg.densityCheckBox->isChecked();
 	s_params.pointWeight = static_cast<float>(prpDlg.weightDoubleSpinBox->value());
 	s_params.threads = prpDlg.threadSpinBox->value();
+	s_memoryBudget_MB = static_cast<unsigned>(prpDlg.memoryBudgetSpinBox->value());
 	s_params.linearFit = prpDlg.linearFitCheckBox->isChecked();
 	switch (prpDlg.boundaryComboBox->currentIndex())
 	{
@@ -399,20 +210,13 @@ void qPoissonRecon::doAction()
 
 	/*** RECONSTRUCTION PROCESS ***/
 
-	assert(s_cloud == nullptr);
-	assert(s_mesh == nullptr);
-	assert(s_meshVertices == nullptr);
-
-	ccScalarField* densitySF = nullptr;
-	ccPointCloud* newPC = new ccPointCloud("vertices");
-	ccMesh* newMesh = new ccMesh(newPC);
-	newMesh->addChild(newPC);
-
 	//run in a separate thread
-	bool result = false;
+	ccMesh* newMesh = nullptr;
+	QString errorMessage;
+	PoissonReconProcess::Report report;
 	{
 		//start message
-		m_app->dispToConsole(QString("[PoissonRecon] Job started (level %1 - %2 threads)").arg(s_params.depth).arg(s_params.threads), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+		m_app->dispToConsole(QString("[PoissonRecon] Job started (level %1 - %2 threads)").arg(PoissonReconProcess::GetDepth(*pc, s_params)).arg(s_params.threads), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
 		//progress dialog (Qtconcurrent::run can't be canceled!)
 		QProgressDialog pDlg(tr("Initialization"), QString(), 0, 0, m_app->getMainWindow());
@@ -432,16 +236,12 @@ void qPoissonRecon::doAction()
 		QApplication::processEvents();
 
 		//run in a separate thread
-		s_cloud = pc;
-		s_mesh = newMesh;
-		s_meshVertices = newPC;
-
-		if (s_params.density)
+		PoissonReconLib::Parameters params = s_params;
+		unsigned memoryBudget_MB = s_memoryBudget_MB;
+		QFuture<ccMesh*> future = QtConcurrent::run([pc, params, memoryBudget_MB, &errorMessage, &report]()
 		{
-			s_densitySF = (densitySF = new ccScalarField("Density"));
-		}
-
-		QFuture<bool> future = QtConcurrent::run(doReconstruct);
+			return PoissonReconProcess::Reconstruct(*pc, params, memoryBudget_MB, errorMessage, &report);
+		});
 
 		//wait until process is finished!
 		while (!future.isFinished())
@@ -456,57 +256,42 @@ void qPoissonRecon::doAction()
 			QApplication::processEvents();
 		}
 
-		result = future.result();
-
-		s_cloud = nullptr;
-		s_mesh = nullptr;
-		s_meshVertices = nullptr;
+		newMesh = future.result();
 
 		pDlg.hide();
 		QApplication::processEvents();
 	}
 
-	if (!result)
+	if (!newMesh)
 	{
-		if (densitySF)
-		{
-			densitySF->release();
-			densitySF = nullptr;
-		}
-		delete newMesh;
-		newMesh = nullptr;
-		m_app->dispToConsole("Reconstruction failed!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		m_app->dispToConsole(QString("Reconstruction failed: %1").arg(errorMessage), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
 		return;
 	}
-	
+
+	ccLog::Print(QString("[PoissonRecon] Estimated memory: %1 MB").arg(report.estimatedMemory_MB, 0, 'f', 0));
+	ccLog::Print(QString("[PoissonRecon] Timings: preparation %1 s / reconstruction %2 s / output %3 s / finalization %4 s")
+					.arg(report.preparation_s, 0, 'f', 1)
+					.arg(report.reconstruction_s, 0, 'f', 1)
+					.arg(report.output_s, 0, 'f', 1)
+					.arg(report.finalization_s, 0, 'f', 1));
+
+	ccPointCloud* newPC = static_cast<ccPointCloud*>(newMesh->getAssociatedCloud());
+
 	//success message
 	m_app->dispToConsole(QString("[PoissonRecon] Job finished (%1 triangles, %2 vertices)").arg(newMesh->size()).arg(newPC->size()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-	newMesh->setName(QString("Mesh[%1] (level %2)").arg(pc->getName()).arg(s_params.depth));
-	newPC->setEnabled(false);
 	newMesh->setVisible(true);
-	newMesh->computeNormals(true);
-	if (!cloudHasColors)
-	{
-		newPC->unallocateColors();
-		newPC->showColors(false);
-	}
+	newPC->showColors(newPC->hasColors());
 	newMesh->showColors(newPC->hasColors());
 
-	if (densitySF)
+	if (newPC->getCurrentDisplayedScalarField())
 	{
-		densitySF->computeMinAndMax();
-		densitySF->showNaNValuesInGrey(false);
-		int sfIdx = newPC->addScalarField(densitySF);
-		newPC->setCurrentDisplayedScalarField(sfIdx);
+		//density SF
 		newPC->showSF(true);
 		newMesh->showColors(newPC->colorsShown());
 		newMesh->showSF(true);
 	}
 
-	//copy Global Shift & Scale information
-	newPC->copyGlobalShiftAndScale(*pc);
-
 	//output mesh
 	m_app->addToDB(newMesh);
 	m_app->setSelectedInDB(ent, false);
@@ -0,0 +1,52 @@
+#ifndef MiscLib__PARALLELFOR_HEADER__
+#define MiscLib__PARALLELFOR_HEADER__
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace MiscLib
+{
+	// Returns the number of threads to use for 'tasks' tasks
+	// (maxThreadCount = 0 means all the available cores)
+	inline unsigned int WorkerCount(unsigned int maxThreadCount, size_t tasks)
+	{
+		unsigned int count = maxThreadCount;
+		if(!count)
+			count = std::max(std::thread::hardware_concurrency(), 1u);
+		if(tasks < count)
+			count = static_cast<unsigned int>(std::max(tasks, (size_t)1));
+		return count;
+	}
+
+	// Calls func(i) for every i in [0, count) on a pool of worker threads
+	// (the calling thread being one of them). Tasks are handed out one at
+	// a time, so their execution order is undefined: func(i) must only
+	// write to data owned by task i.
+	template< class FuncT >
+	void ParallelFor(size_t count, unsigned int maxThreadCount, const FuncT &func)
+	{
+		unsigned int threadCount = WorkerCount(maxThreadCount, count);
+		if(threadCount < 2)
+		{
+			for(size_t i = 0; i < count; ++i)
+				func(i);
+			return;
+		}
+		std::atomic< size_t > next(0);
+		auto worker = [&]()
+		{
+			for(size_t i = next++; i < count; i = next++)
+				func(i);
+		};
+		std::vector< std::thread > threads;
+		threads.reserve(threadCount - 1);
+		for(unsigned int t = 1; t < threadCount; ++t)
+			threads.emplace_back(worker);
+		worker();
+		for(size_t t = 0; t < threads.size(); ++t)
+			threads[t].join();
+	}
+};
+
+#endif
@@ -19,8 +19,8 @@ using namespace MiscLib;
 #define is_odd(x)     ( (x) & 1 )
 #define evenize(x)    ( (x) & (MM-2) )
 
-size_t MiscLib::rn_buf[MiscLib_RN_BUFSIZE];
-size_t MiscLib::rn_point = MiscLib_RN_BUFSIZE;
+thread_local size_t MiscLib::rn_buf[MiscLib_RN_BUFSIZE];
+thread_local size_t MiscLib::rn_point = MiscLib_RN_BUFSIZE;
 
 void MiscLib::rn_setseed(size_t seed)
 {
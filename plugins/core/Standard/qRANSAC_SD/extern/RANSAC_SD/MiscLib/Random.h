@@ -13,8 +13,9 @@
 
 namespace MiscLib
 {
-	extern size_t rn_buf[];
-	extern size_t rn_point;
+	// one generator state per thread (see also RandomStream below)
+	extern thread_local size_t rn_buf[];
+	extern thread_local size_t rn_point;
 	void rn_setseed(size_t);
 	size_t rn_refresh(void);
 	inline size_t rn_rand()
@@ -31,6 +32,44 @@ namespace MiscLib
 	{
 		return (float)rn_rand() / MiscLib_RN_RAND_MOD;
 	}
+
+	/*
+	 * Reentrant random stream (SplitMix64)
+	 *
+	 * rn_rand works on a global buffer and must only be used by one thread.
+	 * A RandomStream holds its whole state, so that every task of a parallel
+	 * loop can draw its own reproducible sequence from (seed, stream).
+	 */
+	class RandomStream
+	{
+	public:
+		RandomStream(unsigned long long seed, unsigned long long stream)
+		: m_state(Mix(seed) ^ Mix(stream + 0x632BE59BD9B4E019ULL))
+		{}
+		unsigned long long Rand()
+		{
+			m_state += 0x9E3779B97F4A7C15ULL;
+			return Mix(m_state);
+		}
+		size_t URand(size_t m)
+		{
+			return static_cast<size_t>(Rand() % m);
+		}
+		// uniform in [0, 1)
+		double DRand()
+		{
+			return (Rand() >> 11) * (1.0 / 9007199254740992.0);
+		}
+		static unsigned long long Mix(unsigned long long z)
+		{
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+
+	private:
+		unsigned long long m_state;
+	};
 };
 
 #endif
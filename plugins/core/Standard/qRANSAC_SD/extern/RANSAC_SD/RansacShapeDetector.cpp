@@ -8,6 +8,7 @@
 #include <deque>
 #include <iostream>
 #include <MiscLib/Random.h>
+#include <MiscLib/ParallelFor.h>
 #include "Candidate.h"
 #include <MiscLib/Performance.h>
 #include "Octree.h"
@@ -86,6 +87,17 @@ void RansacShapeDetector::UpdateLevelWeights(float factor,
 	}
 }
 
+// Output of one candidate generation task
+struct GenerationTaskResult
+{
+	GenerationTaskResult() : drawn(false) {}
+	bool drawn;
+	// (sample level, expected value) of every scored candidate
+	MiscLib::Vector< std::pair< size_t, float > > levelScores;
+	// candidates with a large enough upper bound
+	MiscLib::Vector< Candidate > candidates;
+};
+
 template< class ScoreVisitorT >
 void RansacShapeDetector::GenerateCandidates(
 	const IndexedOctreeType &globalOctree,
@@ -93,25 +105,26 @@ void RansacShapeDetector::GenerateCandidates(
 	const PointCloud &pc, ScoreVisitorT &scoreVisitor,
 	size_t currentSize, size_t numInvalid,
 	const MiscLib::Vector< double > &sampleLevelProbSum,
+	unsigned long long roundSeed,
 	size_t *drawnCandidates,
 	MiscLib::Vector< std::pair< float, size_t > > *sampleLevelScores,
 	float *bestExpectedValue,
 	CandidatesType *candidates) const
 {
-	size_t genCands = 0;
+	// Each task draws its samples from its own random stream and only
+	// writes to its own result: the tasks can run on any thread, in any
+	// order, and the merge below is always done in the same order.
+	const size_t taskCount = 200;
+	MiscLib::Vector< GenerationTaskResult > results(taskCount);
 
-#ifdef DOPARALLEL
-	#pragma omp parallel
-#endif
-	{
-	ScoreVisitorT scoreVisitorCopy(scoreVisitor);
-#ifdef DOPARALLEL
-	#pragma omp for schedule(dynamic, 10) reduction(+:genCands)
-#endif
-	for(int candIter = 0; candIter < 200; ++candIter)
+	ParallelFor(taskCount, m_options.m_maxThreadCount, [&](size_t candIter)
 	{
+		GenerationTaskResult &result = results[candIter];
+		RandomStream rng(roundSeed, candIter);
+		ScoreVisitorT scoreVisitorCopy(scoreVisitor);
+
 		// pick a sample level
-		double s = ((double)rand()) / (double)RAND_MAX;
+		double s = rng.DRand();
 		size_t sampleLevel = 0;
 		for(; sampleLevel < sampleLevelProbSum.size() - 1; ++sampleLevel)
 			if(sampleLevelProbSum[sampleLevel] >= s)
@@ -120,9 +133,9 @@ void RansacShapeDetector::GenerateCandidates(
 		MiscLib::Vector< size_t > samples;
 		const IndexedOctreeType::CellType *node;
 		if(!DrawSamplesStratified(globalOctree, m_reqSamples, sampleLevel,
-			scoreVisitorCopy.GetShapeIndex(), &samples, &node))
-			continue;
-		++genCands;
+			scoreVisitorCopy.GetShapeIndex(), rng, &samples, &node))
+			return;
+		result.drawn = true;
 		// construct the candidates
 		size_t c = samples.size();
 		MiscLib::Vector< Vec3f > samplePoints(samples.size() << 1);
@@ -159,32 +172,35 @@ void RansacShapeDetector::GenerateCandidates(
 			cand.Indices(new MiscLib::RefCounted< MiscLib::Vector< size_t > >);
 			cand.Indices()->Release();
 			shape->Release();
+			// scoring (and bitmap connected component refinement)
 			cand.ImproveBounds(octrees, pc, scoreVisitorCopy,
 				currentSize, m_options.m_bitmapEpsilon, 1);
+			result.levelScores.push_back(std::make_pair(node->Level(), cand.ExpectedValue()));
 			if(cand.UpperBound() < m_options.m_minSupport)
-			{
-#ifdef DOPARALLEL
-				#pragma omp critical
-#endif
-				{
-				(*sampleLevelScores)[node->Level()].first += cand.ExpectedValue();
-				++(*sampleLevelScores)[node->Level()].second;
-				}
 				continue;
-			}
+			result.candidates.push_back(cand);
+		}
+	});
 
-#ifdef DOPARALLEL
-			#pragma omp critical
-#endif
-			{
-				(*sampleLevelScores)[node->Level()].first += cand.ExpectedValue();
-				++(*sampleLevelScores)[node->Level()].second;
-				candidates->push_back(cand);
-				if(cand.ExpectedValue() > *bestExpectedValue)
-					*bestExpectedValue = cand.ExpectedValue();
-			}
+	// merge the results (in the serial order)
+	size_t genCands = 0;
+	for(size_t t = 0; t < taskCount; ++t)
+	{
+		GenerationTaskResult &result = results[t];
+		if(!result.drawn)
+			continue;
+		++genCands;
+		for(size_t i = 0; i < result.levelScores.size(); ++i)
+		{
+			(*sampleLevelScores)[result.levelScores[i].first].first += result.levelScores[i].second;
+			++(*sampleLevelScores)[result.levelScores[i].first].second;
+		}
+		for(size_t i = 0; i < result.candidates.size(); ++i)
+		{
+			candidates->push_back(result.candidates[i]);
+			if(result.candidates[i].ExpectedValue() > *bestExpectedValue)
+				*bestExpectedValue = result.candidates[i].ExpectedValue();
 		}
-	}
 	}
 	*drawnCandidates += genCands;
 }
@@ -459,8 +475,10 @@ RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
 	/*
 	 * Initialization part
 	 */
-	srand((unsigned int)time(NULL));
-	rn_setseed((size_t)time(NULL));
+	size_t seed = m_options.m_randomSeed ? m_options.m_randomSeed : (size_t)time(NULL);
+	srand((unsigned int)seed);
+	rn_setseed(seed);
+	size_t generationRound = 0;
 
 	CandidatesType candidates;
 
@@ -567,6 +585,7 @@ RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
 				octrees, pc, subsetScoreVisitor,
 				currentSize, numInvalid,
 				sampleLevelProbSum,
+				RandomStream::Mix(seed + generationRound++),
 				&drawnCandidates,
 				&sampleLevelScores,
 				&bestExpectedValue,
@@ -819,14 +838,16 @@ RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
 			else
 			{
 				// the bounds of the candidates have become invalid and have to be
-				// recomputed
-#ifdef DOPARALLEL
-				#pragma omp parallel for schedule(static, 100)
-#endif
-				for(int i = 0; i < static_cast<int>(candidates.size()); ++i)
-					candidates[i].RecomputeBounds(octrees, pc, subsetScoreVisitor,
+				// recomputed (the score visitor is modified by each candidate,
+				// hence the copies)
+				ParallelFor(candidates.size(), m_options.m_maxThreadCount, [&](size_t i)
+				{
+					ScorePrimitiveShapeVisitor< FlatNormalThreshPointCompatibilityFunc,
+						ImmediateOctreeType > scoreVisitorCopy(subsetScoreVisitor);
+					candidates[i].RecomputeBounds(octrees, pc, scoreVisitorCopy,
 						currentSize - numInvalid, m_options.m_epsilon,
 						m_options.m_normalThresh, m_options.m_bitmapEpsilon);
+				});
 			}
 			// remove all candidates that have become obsolete
 			std::sort(candidates.begin(), candidates.end(), std::greater< Candidate >());
@@ -915,6 +936,7 @@ RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
 bool RansacShapeDetector::DrawSamplesStratified(const IndexedOctreeType &oct,
 	size_t numSamples, size_t depth,
 	const MiscLib::Vector< int > &shapeIndex,
+	RandomStream &rng,
 	MiscLib::Vector< size_t > *samples,
 	const IndexedOctreeType::CellType **node) const
 {
@@ -925,7 +947,7 @@ bool RansacShapeDetector::DrawSamplesStratified(const IndexedOctreeType &oct,
 		size_t first = 0;
 		do
 		{
-			first = oct.Dereference(rn_rand() % oct.size());
+			first = oct.Dereference(rng.URand(oct.size()));
 		}
 		while(shapeIndex[first] != -1);
 		samples->push_back(first);
@@ -942,7 +964,7 @@ bool RansacShapeDetector::DrawSamplesStratified(const IndexedOctreeType &oct,
 			size_t i = 0, iter = 0;
 			do
 			{
-				i = oct.Dereference(rn_rand() % (*node)->Size()
+				i = oct.Dereference(rng.URand((*node)->Size())
 					+ nodeRange.first);
 			}
 			while( ( shapeIndex[i] != -1
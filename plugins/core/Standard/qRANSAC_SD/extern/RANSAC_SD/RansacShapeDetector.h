@@ -7,6 +7,7 @@
 #include <utility>
 #include "Candidate.h"
 #include <MiscLib/RefCountPtr.h>
+#include <MiscLib/Random.h>
 #include "Octree.h"
 #include <GfxTL/NullClass.h>
 #include <GfxTL/ImmediateTreeDataKernels.h>
@@ -28,6 +29,8 @@ class DLL_LINKAGE RansacShapeDetector
 			, m_fitting(LS_FITTING)
 			, m_probability(0.001f)
 			, m_allowSimplification(true)
+			, m_randomSeed(0)
+			, m_maxThreadCount(0)
 			{}
 			float m_epsilon;
 			float m_normalThresh;
@@ -36,6 +39,8 @@ class DLL_LINKAGE RansacShapeDetector
 			enum { NO_FITTING, LS_FITTING } m_fitting;
 			float m_probability;
 			bool m_allowSimplification;
+			size_t m_randomSeed; // 0 = time-based seed (otherwise the results are reproducible, whatever the number of threads)
+			unsigned int m_maxThreadCount; // candidates generation and scoring threads (0 = all cores)
 		};
 		RansacShapeDetector();
 		RansacShapeDetector(const Options &options);
@@ -53,6 +58,7 @@ class DLL_LINKAGE RansacShapeDetector
 		bool DrawSamplesStratified(const IndexedOctreeType &oct,
 			size_t numSamples, size_t depth,
 			const MiscLib::Vector< int > &shapeIndex,
+			MiscLib::RandomStream &rng,
 			MiscLib::Vector< size_t > *samples,
 			const IndexedOctreeType::CellType **node) const;
 		PrimitiveShape *Fit(bool allowDifferentShapes,
@@ -82,6 +88,7 @@ class DLL_LINKAGE RansacShapeDetector
 			const PointCloud &pc, ScoreVisitorT &scoreVisitor,
 			size_t currentSize, size_t numInvalid,
 			const MiscLib::Vector< double > &sampleLevelProbSum,
+			unsigned long long roundSeed,
 			size_t *drawnCandidates,
 			MiscLib::Vector< std::pair< float, size_t > > *sampleLevelScores,
 			float *bestExpectedValue,
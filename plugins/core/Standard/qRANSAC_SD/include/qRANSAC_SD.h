@@ -67,6 +67,8 @@ public:
 		float minTorusMajorRadius;
 		float maxTorusMinorRadius;
 		float maxTorusMajorRadius;
+		unsigned randomSeed; // random seed (0 = time-based)
+		int maxThreadCount; // max number of threads for candidates generation and scoring (0 = all)
 
 		RansacParams() : epsilon(0.005f)
 			, bitmapEpsilon(0.001f)
@@ -89,6 +91,8 @@ public:
 			, minTorusMajorRadius(0)
 			, maxTorusMinorRadius(std::numeric_limits<float>::max())
 			, maxTorusMajorRadius(std::numeric_limits<float>::max())
+			, randomSeed(0)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
@@ -118,6 +122,8 @@ public:
 			, minTorusMajorRadius(0)
 			, maxTorusMinorRadius(std::numeric_limits<float>::max())
 			, maxTorusMajorRadius(std::numeric_limits<float>::max())
+			, randomSeed(0)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
@@ -135,7 +141,15 @@ public:
 	virtual QList<QAction *> getActions() override;
 	virtual void registerCommands(ccCommandLineInterface* cmd) override;
 
-	static ccHObject* executeRANSAC(ccPointCloud* ccPC, const RansacParams& params, bool silent = false);
+	//! Detection statistics
+	struct RansacStats
+	{
+		size_t shapeCount = 0;		// number of detected shapes
+		size_t remainingPoints = 0;	// number of points not assigned to any shape
+		double detectionTime_s = 0.0;	// duration of the detection itself (normals computation excluded)
+	};
+
+	static ccHObject* executeRANSAC(ccPointCloud* ccPC, const RansacParams& params, bool silent = false, RansacStats* stats = nullptr);
 protected:
 
 	//! Slot called when associated ation is triggered
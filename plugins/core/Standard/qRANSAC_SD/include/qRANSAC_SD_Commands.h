@@ -46,6 +46,9 @@ constexpr char OUTPUT_INDIVIDUAL_PRIMITIVES[] = "OUTPUT_INDIVIDUAL_PRIMITIVES";
 constexpr char OUTPUT_INDIVIDUAL_SUBCLOUDS[] = "OUTPUT_INDIVIDUAL_SUBCLOUDS";
 constexpr char OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE[] = "OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE";
 constexpr char OUTPUT_GROUPED[] = "OUTPUT_GROUPED";
+constexpr char RANDOM_SEED[] = "RANDOM_SEED";
+constexpr char MAX_THREAD_COUNT[] = "MAX_THREAD_COUNT";
+constexpr char BENCHMARK[] = "BENCHMARK";
 
 constexpr char PRIM_PLANE[] = "PLANE";
 constexpr char PRIM_SPHERE[] = "SPHERE";
@@ -69,7 +72,8 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 			BITMAP_EPSILON_PERCENTAGE_OF_SCALE << BITMAP_EPSILON_ABSOLUTE <<
 			SUPPORT_POINTS << MAX_NORMAL_DEV << PROBABILITY << ENABLE_PRIMITIVE <<
 			OUT_CLOUD_DIR << OUT_MESH_DIR << OUT_GROUP_DIR << OUT_PAIR_DIR << OUT_RANDOM_COLOR << OUTPUT_INDIVIDUAL_PRIMITIVES <<
-			OUTPUT_INDIVIDUAL_SUBCLOUDS << OUTPUT_GROUPED << OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE;
+			OUTPUT_INDIVIDUAL_SUBCLOUDS << OUTPUT_GROUPED << OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE <<
+			RANDOM_SEED << MAX_THREAD_COUNT << BENCHMARK;
 		QStringList primitiveNames = QStringList() << PRIM_PLANE << PRIM_SPHERE << PRIM_CYLINDER << PRIM_CONE << PRIM_TORUS;
 		QString outputCloudsDir;
 		QString outputMeshesDir;
@@ -79,6 +83,8 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 		bool outputIndividualPrimitives = false;
 		bool outputIndividualPairs = false;
 		bool outputGrouped = false;
+		bool benchmark = false;
+		bool randomSeedSet = false;
 
 		float epsilonABS = -1.0f;
 		float epsilonPercentage = -1.0f;
@@ -209,6 +215,41 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 				{
 					params.randomColor = true;
 				}
+				else if (param == RANDOM_SEED)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, RANDOM_SEED));
+					}
+					bool ok;
+					unsigned seed = cmd.arguments().takeFirst().toUInt(&ok);
+					if (!ok || seed == 0)
+					{
+						return cmd.error("Invalid random seed (must be a strictly positive integer)!");
+					}
+					cmd.print(QObject::tr("\tRandom seed : %1").arg(seed));
+					params.randomSeed = seed;
+					randomSeedSet = true;
+				}
+				else if (param == MAX_THREAD_COUNT)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, MAX_THREAD_COUNT));
+					}
+					bool ok;
+					int count = cmd.arguments().takeFirst().toInt(&ok);
+					if (!ok || count < 0)
+					{
+						return cmd.error("Invalid max thread count (0 = all cores)!");
+					}
+					cmd.print(QObject::tr("\tMax thread count : %1").arg(count));
+					params.maxThreadCount = count;
+				}
+				else if (param == BENCHMARK)
+				{
+					benchmark = true;
+				}
 				else if (param == OUT_CLOUD_DIR)
 				{
 					if (!makePathIfPossible(cmd, param, &outputCloudsDir, &outputIndividualClouds))
@@ -327,7 +368,16 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 			cmd.print(QObject::tr("\tDefault Shape Search == %1").arg(PRIM_PLANE));
 			params.primEnabled[qRansacSD::RPT_PLANE] = true;
 		}
-		if (!outputIndividualClouds && !outputIndividualPrimitives && !outputGrouped && !outputIndividualPairs)
+		if (benchmark)
+		{
+			//the same samples must be drawn from one run to the other
+			if (!randomSeedSet)
+			{
+				params.randomSeed = 1;
+			}
+			cmd.print(QObject::tr("\tBenchmark mode (random seed: %1, nothing will be exported)").arg(params.randomSeed));
+		}
+		else if (!outputIndividualClouds && !outputIndividualPrimitives && !outputGrouped && !outputIndividualPairs)
 		{
 			cmd.print(QObject::tr("\tDefault output == %1").arg(OUTPUT_GROUPED));
 			outputGrouped = true;
@@ -365,6 +415,23 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 				params.bitmapEpsilon = (0.01f * scale);
 			}
 
+			if (benchmark)
+			{
+				qRansacSD::RansacStats stats;
+				ccHObject* group = qRansacSD::executeRANSAC(clCloud.pc, params, cmd.silentMode(), &stats);
+				delete group;
+
+				double shapesPerSecond = (stats.detectionTime_s > 0 ? stats.shapeCount / stats.detectionTime_s : 0.0);
+				double pointsPerSecond = (stats.detectionTime_s > 0 ? (clCloud.pc->size() - stats.remainingPoints) / stats.detectionTime_s : 0.0);
+				cmd.print(QObject::tr("[RANSAC] Benchmark '%1': %2 shape(s) detected in %3 s (%4 shapes/s - %5 assigned points/s)")
+							.arg(clCloud.pc->getName())
+							.arg(stats.shapeCount)
+							.arg(stats.detectionTime_s, 0, 'f', 3)
+							.arg(shapesPerSecond, 0, 'f', 2)
+							.arg(pointsPerSecond, 0, 'f', 0));
+				continue;
+			}
+
 			ccHObject* group = qRansacSD::executeRANSAC(clCloud.pc, params, cmd.silentMode());
 			
 			if (group)
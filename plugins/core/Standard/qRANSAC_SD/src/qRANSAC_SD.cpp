@@ -109,12 +109,17 @@ static MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_
 static size_t s_remainingPoints = 0;
 static RansacShapeDetector* s_detector = 0;
 static PointCloud* s_cloud = 0;
+static qint64 s_detectionTime_ms = 0;
 void doDetection()
 {
 	if (!s_detector || !s_cloud || !s_shapes)
 		return;
 
+	//timed here, as the calling thread only polls the detection state every 500 ms
+	QElapsedTimer eTimer;
+	eTimer.start();
 	s_remainingPoints = s_detector->Detect(*s_cloud, 0, s_cloud->size(), s_shapes);
+	s_detectionTime_ms = eTimer.elapsed();
 }
 
 //for parameters persistence
@@ -320,7 +325,7 @@ void qRansacSD::doAction()
 }
 
 
-ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& params, bool silent)
+ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& params, bool silent, RansacStats* stats/*=nullptr*/)
 {
 	//consistency check
 	{
@@ -407,6 +412,8 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		ransacOptions.m_minSupport = params.supportPoints;
 		ransacOptions.m_allowSimplification = params.allowSimplification;
 		ransacOptions.m_fitting = params.allowFitting ? RansacShapeDetector::Options::LS_FITTING : RansacShapeDetector::Options::NO_FITTING;
+		ransacOptions.m_randomSeed = params.randomSeed;
+		ransacOptions.m_maxThreadCount = static_cast<unsigned>(std::max(params.maxThreadCount, 0));
 	}
 	const float scale = cloud.getScale();
 
@@ -500,10 +507,13 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		s_detector = &detector;
 		s_shapes = &shapes;
 		s_cloud = &cloud;
-		QElapsedTimer eTimer;
-		eTimer.start();
 		QFuture<void> future = QtConcurrent::run(doDetection);
 
+		if (silent)
+		{
+			future.waitForFinished();
+		}
+
 		while (!future.isFinished())
 		{
 #if defined(CC_WINDOWS)
@@ -525,9 +535,14 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 			pDlg->hide();
 			delete pDlg;
 		}
-		qint64 elapsedTime_ms = eTimer.elapsed();
+		ccLog::Print("[qRANSAC] Search Timing: %2.3f s", static_cast<double>(s_detectionTime_ms) / 1.0e3);
 
-		ccLog::Print("[qRANSAC] Search Timing: %2.3f s", static_cast<double>(elapsedTime_ms) / 1.0e3);
+		if (stats)
+		{
+			stats->shapeCount = shapes.size();
+			stats->remainingPoints = remaining;
+			stats->detectionTime_s = static_cast<double>(s_detectionTime_ms) / 1.0e3;
+		}
 	}
 
 #if 0 //def _DEBUG
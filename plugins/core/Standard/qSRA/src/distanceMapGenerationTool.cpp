@@ -31,10 +31,19 @@
 //CCCoreLib
 #include <Delaunay2dMesh.h>
 
+//CCPluginAPI
+#include <ccQtHelpers.h>
+
 //Qt
 #include <QFile>
 #include <QTextStream>
 #include <QMainWindow>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//system
+#include <algorithm>
+#include <atomic>
 
 //Meta-data key for profile (polyline) origin
 const char PROFILE_ORIGIN_KEY[] = "ProfileOrigin";
@@ -62,6 +71,101 @@ static inline double ComputeLatitude_rad(	PointCoordinateType x,
 	return atan(z / sqrt(static_cast<double>(r)));
 }
 
+//default number of points (or cells) per chunk for parallel processing
+static const unsigned c_defaultChunkSize = 65536;
+
+//helper: splits the [0 ; count[ range in chunks and processes them in parallel
+/** The function is called with the chunk index and the [start ; stop[ range.
+**/
+template <class Function> static void ForEachChunk(unsigned count, unsigned chunkSize, Function func)
+{
+	assert(chunkSize != 0);
+	unsigned chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	std::vector<unsigned> chunkIndexes;
+	try
+	{
+		chunkIndexes.resize(chunkCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory: we process everything at once
+		func(0, 0, count);
+		return;
+	}
+	for (unsigned c = 0; c < chunkCount; ++c)
+	{
+		chunkIndexes[c] = c;
+	}
+
+	auto processChunk = [&](unsigned c)
+	{
+		unsigned start = c * chunkSize;
+		unsigned stop = std::min(start + chunkSize, count);
+		func(c, start, stop);
+	};
+
+#ifndef _DEBUG
+	if (chunkCount > 1)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(ccQtHelpers::GetMaxThreadCount());
+		QtConcurrent::blockingMap(chunkIndexes, processChunk);
+	}
+	else
+#endif
+	{
+		for (unsigned c : chunkIndexes)
+		{
+			processChunk(c);
+		}
+	}
+}
+
+//helper: adds a value (or an aggregated set of values) to a map cell
+/** With the 'average' strategy, the cell value is the sum of the values
+	(it has to be divided by the number of values afterwards).
+**/
+static inline void AddToCell(	DistanceMapGenerationTool::MapCell& cell,
+								double value,
+								unsigned count,
+								DistanceMapGenerationTool::FillStrategyType fillStrategy)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (cell.count) //if there's already values projected in this cell
+	{
+		switch (fillStrategy)
+		{
+		case DistanceMapGenerationTool::FILL_STRAT_MIN_DIST:
+			// Set the minimum SF value
+			if (value < cell.value)
+				cell.value = value;
+			break;
+		case DistanceMapGenerationTool::FILL_STRAT_AVG_DIST:
+			// Sum the values
+			cell.value += value;
+			break;
+		case DistanceMapGenerationTool::FILL_STRAT_MAX_DIST:
+			// Set the maximum SF value
+			if (value > cell.value)
+				cell.value = value;
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+	else
+	{
+		//for the first value, we simply have to store it (whatever the case)
+		cell.value = value;
+	}
+	cell.count += count;
+}
+
 //helper
 static bool GetPolylineMetaVector(const ccPolyline* polyline, const QString& key, CCVector3& P)
 {
@@ -320,7 +424,7 @@ bool DistanceMapGenerationTool::ComputeRadialDist(	ccPointCloud* cloud,
 		dlg.start();
 		CCCoreLib::NormalizedProgress nProgress(static_cast<CCCoreLib::GenericProgressCallback*>(&dlg), pointCount);
 
-		for (unsigned i = 0; i < pointCount; ++i)
+		auto processPoint = [&](unsigned i)
 		{
 			const CCVector3* P = cloud->getPoint(i);
 
@@ -362,19 +466,43 @@ bool DistanceMapGenerationTool::ComputeRadialDist(	ccPointCloud* cloud,
 			}
 
 			sf->setValue(i, minDist);
+		};
+
+		std::atomic<bool> processCanceled(false);
+		if (pointCount != 0)
+		{
+			//the first value is set beforehand, as it may initialize the scalar fields offset
+			processPoint(0);
 
-			if (!nProgress.oneStep())
+			//the other points are processed in parallel
+			ForEachChunk(pointCount - 1, c_defaultChunkSize, [&](unsigned, unsigned start, unsigned stop)
 			{
-				//cancelled by user
-				for (unsigned j = i; j < pointCount; ++j)
-					sf->setValue(j, CCCoreLib::NAN_VALUE);
+				if (!processCanceled)
+				{
+					for (unsigned i = start; i < stop; ++i)
+					{
+						processPoint(i + 1);
+					}
 
-				success = false;
-				break;
-			}
+					if (!nProgress.steps(stop - start))
+					{
+						processCanceled = true;
+					}
+				}
+				else
+				{
+					//cancelled by user
+					for (unsigned i = start; i < stop; ++i)
+					{
+						sf->setValue(i + 1, CCCoreLib::NAN_VALUE);
+					}
+				}
+			});
+		}
 
-			//TEST
-			//*const_cast<CCVector3*>(P) = Prel;
+		if (processCanceled)
+		{
+			success = false;
 		}
 
 		//TEST
@@ -411,26 +539,51 @@ bool DistanceMapGenerationTool::ComputeMinAndMaxLatitude_rad(	ccPointCloud* clou
 	const unsigned char X = (Z < 2 ? Z + 1 : 0);
 	const unsigned char Y = (X < 2 ? X + 1 : 0);
 
-	for (unsigned n = 0; n < count; ++n)
+	//min and max latitudes of each chunk
+	unsigned chunkCount = (count + c_defaultChunkSize - 1) / c_defaultChunkSize;
+	std::vector<double> chunkMinLat_rad;
+	std::vector<double> chunkMaxLat_rad;
+	try
 	{
-		const CCVector3* P = cloud->getPoint(n);
-		CCVector3 relativePos = cloudToSurfaceOrigin * (*P);
-
-		//latitude between 0 and pi/2
-		double lat_rad = ComputeLatitude_rad(relativePos.u[X], relativePos.u[Y], relativePos.u[Z]);
+		chunkMinLat_rad.resize(chunkCount);
+		chunkMaxLat_rad.resize(chunkCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
 
-		if (n)
-		{
-			if (lat_rad < minLat_rad)
-				minLat_rad = lat_rad;
-			else if (lat_rad > maxLat_rad)
-				maxLat_rad = lat_rad;
-		}
-		else
+	ForEachChunk(count, c_defaultChunkSize, [&](unsigned c, unsigned start, unsigned stop)
+	{
+		double minLat = 0.0;
+		double maxLat = 0.0;
+		for (unsigned n = start; n < stop; ++n)
 		{
-			minLat_rad = maxLat_rad = lat_rad;
+			const CCVector3* P = cloud->getPoint(n);
+			CCVector3 relativePos = cloudToSurfaceOrigin * (*P);
+
+			//latitude between 0 and pi/2
+			double lat_rad = ComputeLatitude_rad(relativePos.u[X], relativePos.u[Y], relativePos.u[Z]);
+
+			if (n != start)
+			{
+				if (lat_rad < minLat)
+					minLat = lat_rad;
+				else if (lat_rad > maxLat)
+					maxLat = lat_rad;
+			}
+			else
+			{
+				minLat = maxLat = lat_rad;
+			}
 		}
-	}
+		chunkMinLat_rad[c] = minLat;
+		chunkMaxLat_rad[c] = maxLat;
+	});
+
+	minLat_rad = *std::min_element(chunkMinLat_rad.begin(), chunkMinLat_rad.end());
+	maxLat_rad = *std::max_element(chunkMaxLat_rad.begin(), chunkMaxLat_rad.end());
 
 	return true;
 }
@@ -560,83 +713,99 @@ QSharedPointer<DistanceMapGenerationTool::Map> DistanceMapGenerationTool::Create
 	grid->counterclockwise = counterclockwise;
 	double ccw = (counterclockwise ? -1.0 : 1.0);
 
-	for (unsigned n = 0; n < count; ++n)
+	//project a range of points in a given map
+	auto projectPoints = [&](std::vector<MapCell>& cells, unsigned start, unsigned stop)
 	{
-		//we skip invalid values
-		const ScalarType& val = sf->getValue(n);
-		if (!CCCoreLib::ScalarField::ValidValue(val))
-			continue;
+		for (unsigned n = start; n < stop; ++n)
+		{
+			//we skip invalid values
+			const ScalarType& val = sf->getValue(n);
+			if (!CCCoreLib::ScalarField::ValidValue(val))
+				continue;
 
-		const CCVector3* P = cloud->getPoint(n);
-		CCVector3 relativePos = cloudToSurface * (*P);
+			const CCVector3* P = cloud->getPoint(n);
+			CCVector3 relativePos = cloudToSurface * (*P);
 
-		//convert to cylindrical or conical (spherical) coordinates
-		double x = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
-		if (x < 0.0)
-		{
-			x += 2 * M_PI;
-		}
+			//convert to cylindrical or conical (spherical) coordinates
+			double x = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
+			if (x < 0.0)
+			{
+				x += 2 * M_PI;
+			}
 
-		double y = 0.0;
-		if (conical)
-		{
-			y = ComputeLatitude_rad(relativePos.u[X], relativePos.u[Y], relativePos.u[Z]); //latitude between 0 and pi/2
-		}
-		else
-		{
-			y = relativePos.u[Z]; //height
-		}
+			double y = 0.0;
+			if (conical)
+			{
+				y = ComputeLatitude_rad(relativePos.u[X], relativePos.u[Y], relativePos.u[Z]); //latitude between 0 and pi/2
+			}
+			else
+			{
+				y = relativePos.u[Z]; //height
+			}
 
-		int i = static_cast<int>((x - grid->xMin) / grid->xStep);
-		int j = static_cast<int>((y - grid->yMin) / grid->yStep);
+			int i = static_cast<int>((x - grid->xMin) / grid->xStep);
+			int j = static_cast<int>((y - grid->yMin) / grid->yStep);
 
-		//if we fall exactly on the max corner of the grid box
-		if (i == static_cast<int>(grid->xSteps))
-			--i;
-		if (j == static_cast<int>(grid->ySteps))
-			--j;
+			//if we fall exactly on the max corner of the grid box
+			if (i == static_cast<int>(grid->xSteps))
+				--i;
+			if (j == static_cast<int>(grid->ySteps))
+				--j;
 
-		//we skip points outside the box!
-		if (	i < 0 || i >= static_cast<int>(grid->xSteps)
-			||	j < 0 || j >= static_cast<int>(grid->ySteps) )
-		{
-			continue;
+			//we skip points outside the box!
+			if (	i < 0 || i >= static_cast<int>(grid->xSteps)
+				||	j < 0 || j >= static_cast<int>(grid->ySteps) )
+			{
+				continue;
+			}
+			assert(i >= 0 && j >= 0);
+
+			AddToCell(cells[j*static_cast<int>(grid->xSteps) + i], val, 1, fillStrategy);
 		}
-		assert(i >= 0 && j >= 0);
+	};
 
-		MapCell& cell = (*grid)[j*static_cast<int>(grid->xSteps) + i];
-		if (cell.count) //if there's already values projected in this cell
+	//the cloud is split in (at most) one chunk per thread, each chunk being projected
+	//in its own partial map (the first chunk is directly projected in the output map)
+	unsigned chunkCount = std::min(static_cast<unsigned>(std::max(1, ccQtHelpers::GetMaxThreadCount())), (count + c_defaultChunkSize - 1) / c_defaultChunkSize);
+	std::vector< std::vector<MapCell> > partialMaps;
+	if (chunkCount > 1)
+	{
+		try
 		{
-			switch (fillStrategy)
+			partialMaps.resize(chunkCount - 1);
+			for (std::vector<MapCell>& partialMap : partialMaps)
 			{
-			case FILL_STRAT_MIN_DIST:
-				// Set the minimum SF value
-				if (val < cell.value)
-					cell.value = val;
-				break;
-			case FILL_STRAT_AVG_DIST:
-				// Sum the values
-				cell.value += static_cast<double>(val);
-				break;
-			case FILL_STRAT_MAX_DIST:
-				// Set the maximum SF value
-				if (val > cell.value)
-					cell.value = val;
-				break;
-			default:
-				assert(false);
-				break;
+				partialMap.resize(cellCount);
 			}
 		}
-		else
+		catch (const std::bad_alloc&)
 		{
-			//for the first point, we simply have to store its associated value (whatever the case)
-			cell.value = val;
+			//not enough memory: we'll process all the points in the output map
+			partialMaps.clear();
+			partialMaps.shrink_to_fit();
+			chunkCount = 1;
 		}
-		++cell.count;
+	}
+
+	unsigned chunkSize = (count + chunkCount - 1) / chunkCount;
+	ForEachChunk(count, chunkSize, [&](unsigned c, unsigned start, unsigned stop)
+	{
+		projectPoints(c == 0 ? *grid : partialMaps[c - 1], start, stop);
+	});
 
-		//if (progressCb)
-		//	progressCb->update(30.0 * (float)n / (float)cloud->size());
+	//merge the partial maps in the output map
+	if (!partialMaps.empty())
+	{
+		ForEachChunk(cellCount, c_defaultChunkSize, [&](unsigned, unsigned start, unsigned stop)
+		{
+			for (const std::vector<MapCell>& partialMap : partialMaps)
+			{
+				for (unsigned k = start; k < stop; ++k)
+				{
+					AddToCell((*grid)[k], partialMap[k].value, partialMap[k].count, fillStrategy);
+				}
+			}
+		});
 	}
 
 	//we need to finish the average values computation
@@ -1165,24 +1334,27 @@ bool DistanceMapGenerationTool::ConvertCloudToCylindrical(	ccPointCloud* cloud,
 	PointCoordinateType ccw = (counterclockwise ? -CCCoreLib::PC_ONE : CCCoreLib::PC_ONE);
 
 	//get projection height
-	for (unsigned n = 0; n < cloud->size(); ++n)
+	ForEachChunk(cloud->size(), c_defaultChunkSize, [&](unsigned, unsigned start, unsigned stop)
 	{
-		CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
-		CCVector3 relativePos = cloudToSurface * (*P);
-
-		//convert to cylindrical coordinates
-		double lon_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
-		if (lon_rad < 0.0)
+		for (unsigned n = start; n < stop; ++n)
 		{
-			lon_rad += 2 * M_PI;
-		}
-		
-		PointCoordinateType height = relativePos.u[Z];
+			CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
+			CCVector3 relativePos = cloudToSurface * (*P);
 
-		P->x = static_cast<PointCoordinateType>(lon_rad);
-		P->y = height;
-		P->z = 0;
-	}
+			//convert to cylindrical coordinates
+			double lon_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
+			if (lon_rad < 0.0)
+			{
+				lon_rad += 2 * M_PI;
+			}
+
+			PointCoordinateType height = relativePos.u[Z];
+
+			P->x = static_cast<PointCoordinateType>(lon_rad);
+			P->y = height;
+			P->z = 0;
+		}
+	});
 
 	cloud->refreshBB();
 	if (cloud->getOctree())
@@ -1218,22 +1390,25 @@ bool DistanceMapGenerationTool::ConvertCloudToConical(	ccPointCloud* cloud,
 	double nProj = ConicalProjectN(latMin_rad, latMax_rad) * conicalSpanRatio;
 
 	//get projection height
-	for (unsigned n = 0; n < cloud->size(); ++n)
+	ForEachChunk(cloud->size(), c_defaultChunkSize, [&](unsigned, unsigned start, unsigned stop)
 	{
-		CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
-		CCVector3 relativePos = cloudToSurface * (*P);
+		for (unsigned n = start; n < stop; ++n)
+		{
+			CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
+			CCVector3 relativePos = cloudToSurface * (*P);
 
-		//convert to cylindrical coordinates
-		PointCoordinateType ang_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]);
-		if (ang_rad < 0.0)
-			ang_rad += static_cast<PointCoordinateType>(2 * M_PI);
+			//convert to cylindrical coordinates
+			PointCoordinateType ang_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]);
+			if (ang_rad < 0.0)
+				ang_rad += static_cast<PointCoordinateType>(2 * M_PI);
 
-		double lat_rad = ComputeLatitude_rad(	relativePos.u[X],
-												relativePos.u[Y],
-												relativePos.u[Z] ); //between 0 and pi/2
+			double lat_rad = ComputeLatitude_rad(	relativePos.u[X],
+													relativePos.u[Y],
+													relativePos.u[Z] ); //between 0 and pi/2
 
-		*P = ProjectPointOnCone(ang_rad, lat_rad, latMin_rad, nProj, counterclockwise);
-	}
+			*P = ProjectPointOnCone(ang_rad, lat_rad, latMin_rad, nProj, counterclockwise);
+		}
+	});
 
 	cloud->refreshBB();
 	if (cloud->getOctree())
@@ -1621,30 +1796,38 @@ QImage DistanceMapGenerationTool::ConvertMapToImage(const QSharedPointer<Map>& m
 	{
 		bool csIsRelative = colorScale->isRelative();
 
-		const MapCell* cell = &map->at(0);
-		for (unsigned j = 0; j < map->ySteps; ++j)
+		//we write the pixels directly in the image buffer (QImage::setPixel is quite slow)
+		uchar* bits = image.bits();
+		int bytesPerLine = image.bytesPerLine();
+
+		//rows are processed in parallel (by chunks of roughly the same number of cells)
+		unsigned rowsPerChunk = std::max(1u, c_defaultChunkSize / std::max(1u, map->xSteps));
+		ForEachChunk(map->ySteps, rowsPerChunk, [&](unsigned, unsigned start, unsigned stop)
 		{
-			//for each column
-			for (unsigned i = 0; i < map->xSteps; ++i, ++cell)
+			for (unsigned j = start; j < stop; ++j)
 			{
-				const ccColor::Rgb* rgb = &ccColor::lightGreyRGB;
+				const MapCell* cell = &map->at(j * map->xSteps);
+				QRgb* pixel = reinterpret_cast<QRgb*>(bits + static_cast<size_t>(j) * bytesPerLine);
 
-				if (cell->count != 0)
+				//for each column
+				for (unsigned i = 0; i < map->xSteps; ++i, ++cell, ++pixel)
 				{
-					double relativePos = csIsRelative ? (cell->value - map->minVal) / (map->maxVal - map->minVal) : colorScale->getRelativePosition(cell->value);
-					if (relativePos < 0.0)
-						relativePos = 0.0;
-					else if (relativePos > 1.0)
-						relativePos = 1.0;
-					rgb = colorScale->getColorByRelativePos(relativePos, colorScaleSteps, &ccColor::lightGreyRGB);
-				}
+					const ccColor::Rgb* rgb = &ccColor::lightGreyRGB;
 
-				//DGM FIXME: QImage::sePixel is quite slow!
-				image.setPixel(	static_cast<int>(i),
-								static_cast<int>(j),
-								qRgb(rgb->r, rgb->g, rgb->b));
+					if (cell->count != 0)
+					{
+						double relativePos = csIsRelative ? (cell->value - map->minVal) / (map->maxVal - map->minVal) : colorScale->getRelativePosition(cell->value);
+						if (relativePos < 0.0)
+							relativePos = 0.0;
+						else if (relativePos > 1.0)
+							relativePos = 1.0;
+						rgb = colorScale->getColorByRelativePos(relativePos, colorScaleSteps, &ccColor::lightGreyRGB);
+					}
+
+					*pixel = qRgb(rgb->r, rgb->g, rgb->b);
+				}
 			}
-		}
+		});
 	}
 
 	return image;
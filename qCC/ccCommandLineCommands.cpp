@@ -18,11 +18,22 @@
 #include <ccVolumeCalcTool.h>
 #include <ccSubMesh.h>
 #include <ccPointCloudInterpolator.h>
+#include <ccImage.h>
+#include <ccCameraSensor.h>
+#include <ccMultiCameraColorizer.h>
+#include <cc2DViewportObject.h>
 
 //qCC_io
 #include <AsciiFilter.h>
 #include <PlyFilter.h>
 
+//qCC_gl
+#include <ccGLOffscreenWindow.h>
+
+//plugins
+#include <ccGLPluginInterface.h>
+#include <ccPluginManager.h>
+
 //qCC
 #include "ccCommon.h"
 #include "ccComparisonDlg.h"
@@ -40,6 +51,8 @@
 #include "ccEntityAction.h"
 
 #include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
 
 //commands
@@ -178,6 +191,20 @@ constexpr char COMMAND_FLIP_TRIANGLES[]					= "FLIP_TRI";
 constexpr char COMMAND_DEBUG[]							= "DEBUG";
 constexpr char COMMAND_VERBOSITY[]						= "VERBOSITY";
 constexpr char COMMAND_FILTER[]							= "FILTER";
+constexpr char COMMAND_COLORIZE_FROM_CAMERAS[]			= "COLORIZE_FROM_CAMERAS";	//+ cameras file name
+constexpr char COMMAND_COLORIZE_BLEND[]					= "BLEND";
+constexpr char COMMAND_COLORIZE_NO_OCCLUSION[]			= "NO_OCCLUSION";
+constexpr char COMMAND_COLORIZE_DEPTH_TOLERANCE[]		= "DEPTH_TOLERANCE";
+constexpr char COMMAND_COLORIZE_MAX_IMAGES[]			= "MAX_IMAGES";
+constexpr char COMMAND_COLORIZE_IMAGE_LIST[]			= "IMAGE_LIST";
+constexpr char COMMAND_RENDER[]							= "RENDER";
+constexpr char COMMAND_RENDER_VIEWPORTS[]				= "VIEWPORTS";	//+ viewports file name
+constexpr char COMMAND_RENDER_SIZE[]					= "SIZE";		//+ width and height
+constexpr char COMMAND_RENDER_ZOOM[]					= "ZOOM";
+constexpr char COMMAND_RENDER_GL_FILTER[]				= "GL_FILTER";	//+ GL filter (plugin) name
+constexpr char COMMAND_RENDER_OVERLAY[]					= "OVERLAY";
+constexpr char COMMAND_RENDER_OUTPUT_DIR[]				= "OUTPUT_DIR";
+constexpr char COMMAND_RENDER_TIMINGS[]					= "TIMINGS";
 
 //options / modifiers
 constexpr char COMMAND_MAX_THREAD_COUNT[]				= "MAX_TCOUNT";
@@ -7968,3 +7995,492 @@ bool CommandSetVerbosity::process(ccCommandLineInterface& cmd)
 
 	return true;
 }
+
+CommandColorizeFromCameras::CommandColorizeFromCameras()
+	: ccCommandLineInterface::Command(QObject::tr("Colorize from cameras"), COMMAND_COLORIZE_FROM_CAMERAS)
+{}
+
+bool CommandColorizeFromCameras::process(ccCommandLineInterface& cmd)
+{
+	cmd.print(QObject::tr("[COLORIZE FROM CAMERAS]"));
+
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: cameras filename after \"-%1\"").arg(COMMAND_COLORIZE_FROM_CAMERAS));
+	}
+	QString camerasFilename = cmd.arguments().takeFirst();
+
+	ccMultiCameraColorizer::Parameters params;
+	QString imageListFilename;
+
+	//optional parameters
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_COLORIZE_IMAGE_LIST))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: image list filename after '%1'").arg(COMMAND_COLORIZE_IMAGE_LIST));
+			}
+			imageListFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_COLORIZE_BLEND))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			params.mode = ccMultiCameraColorizer::BLEND;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_COLORIZE_NO_OCCLUSION))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			params.testOcclusions = false;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_COLORIZE_DEPTH_TOLERANCE))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: depth tolerance after '%1'").arg(COMMAND_COLORIZE_DEPTH_TOLERANCE));
+			}
+
+			bool ok = false;
+			params.depthTolerance = cmd.arguments().takeFirst().toFloat(&ok);
+			if (!ok || params.depthTolerance < 0)
+			{
+				return cmd.error(QObject::tr("Invalid depth tolerance! (after %1)").arg(COMMAND_COLORIZE_DEPTH_TOLERANCE));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_COLORIZE_MAX_IMAGES))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max number of images after '%1'").arg(COMMAND_COLORIZE_MAX_IMAGES));
+			}
+
+			bool ok = false;
+			params.maxDecodedImages = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok)
+			{
+				return cmd.error(QObject::tr("Invalid max number of images! (after %1)").arg(COMMAND_COLORIZE_MAX_IMAGES));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_MAX_THREAD_COUNT))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after '%1'").arg(COMMAND_MAX_THREAD_COUNT));
+			}
+
+			bool ok = false;
+			params.maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || params.maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid thread count! (after %1)").arg(COMMAND_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
+		}
+	}
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No point cloud to colorize! (be sure to open one with \"-%1 [cloud filename]\" before \"-%2\")").arg(COMMAND_OPEN, COMMAND_COLORIZE_FROM_CAMERAS));
+	}
+
+	//load the cameras (images + camera sensors)
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+	QScopedPointer<ccHObject> camerasDB(FileIOFilter::LoadFromFile(camerasFilename, cmd.fileLoadingParams(), result));
+	if (!camerasDB)
+	{
+		return cmd.error(QObject::tr("Failed to load the cameras file '%1'").arg(camerasFilename));
+	}
+
+	ccMultiCameraColorizer colorizer;
+	if (!imageListFilename.isEmpty())
+	{
+		//the images are only referenced by their filename: they are decoded on demand by the colorizer
+		//(one image filename per line, in the same order as the camera sensors, e.g. Bundler 'list.txt' file)
+		QFile imageListFile(imageListFilename);
+		if (!imageListFile.open(QIODevice::ReadOnly | QIODevice::Text))
+		{
+			return cmd.error(QObject::tr("Failed to open the image list file '%1'").arg(imageListFilename));
+		}
+		QDir imageListDir = QFileInfo(imageListFilename).absoluteDir();
+
+		QStringList imageFilenames;
+		QTextStream in(&imageListFile);
+		while (!in.atEnd())
+		{
+			QString line = in.readLine().trimmed();
+			if (!line.isEmpty())
+			{
+				//only the first token is used (Bundler lists may also contain the focal length)
+				imageFilenames << imageListDir.absoluteFilePath(line.split(' ', QString::SkipEmptyParts).front());
+			}
+		}
+
+		ccHObject::Container sensors;
+		camerasDB->filterChildren(sensors, true, CC_TYPES::CAMERA_SENSOR, true);
+		if (static_cast<size_t>(imageFilenames.size()) != sensors.size())
+		{
+			return cmd.error(QObject::tr("The number of images in the list (%1) doesn't match the number of camera sensors (%2)").arg(imageFilenames.size()).arg(sensors.size()));
+		}
+
+		for (size_t i = 0; i < sensors.size(); ++i)
+		{
+			if (!colorizer.addCamera(static_cast<ccCameraSensor*>(sensors[i]), imageFilenames[static_cast<int>(i)]))
+			{
+				cmd.warning(QObject::tr("Invalid camera sensor '%1' (ignored)").arg(sensors[i]->getName()));
+			}
+		}
+	}
+	else
+	{
+		//the images have already been decoded by the importer: the ones that can be found on disk are
+		//released and decoded again (on demand) by the colorizer. Use -IMAGE_LIST to avoid the initial decoding.
+		//the image names are relative to the cameras file folder (e.g. Bundler 'list.txt' file)
+		QDir camerasDir = QFileInfo(camerasFilename).absoluteDir();
+
+		ccHObject::Container images;
+		camerasDB->filterChildren(images, true, CC_TYPES::IMAGE);
+		for (ccHObject* entity : images)
+		{
+			ccImage* image = static_cast<ccImage*>(entity);
+			ccCameraSensor* sensor = image->getAssociatedSensor();
+			if (!sensor)
+			{
+				cmd.warning(QObject::tr("Image '%1' has no associated camera sensor (ignored)").arg(image->getName()));
+				continue;
+			}
+
+			//if the image file can be found, the camera is registered by filename: the image is then only
+			//decoded when needed by the colorizer, and the version decoded by the importer can be released
+			QString imageFilename = camerasDir.absoluteFilePath(image->getName());
+			if (QFileInfo(imageFilename).isFile())
+			{
+				if (colorizer.addCamera(sensor, imageFilename))
+				{
+					image->setData(QImage());
+				}
+				else
+				{
+					cmd.warning(QObject::tr("Invalid camera sensor for image '%1' (ignored)").arg(image->getName()));
+				}
+			}
+			else if (!colorizer.addCamera(sensor, image))
+			{
+				cmd.warning(QObject::tr("Invalid camera sensor or image '%1' (ignored)").arg(image->getName()));
+			}
+		}
+	}
+	if (colorizer.cameraCount() == 0)
+	{
+		return cmd.error(QObject::tr("No valid camera (image + camera sensor) found in file '%1'").arg(camerasFilename));
+	}
+	cmd.print(QObject::tr("\tCameras: %1").arg(colorizer.cameraCount()));
+
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		QString errorMessage;
+		unsigned colorizedCount = 0;
+		if (!colorizer.colorize(desc.pc, params, errorMessage, &colorizedCount, cmd.progressDialog()))
+		{
+			return cmd.error(QObject::tr("Failed to colorize cloud '%1': %2").arg(desc.pc->getName(), errorMessage));
+		}
+		cmd.print(QObject::tr("\tCloud '%1': %2 / %3 points colorized").arg(desc.pc->getName()).arg(colorizedCount).arg(desc.pc->size()));
+
+		//save output
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(desc, "COLORIZED");
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
+		}
+	}
+
+	return true;
+}
+
+CommandRender::CommandRender()
+	: ccCommandLineInterface::Command(QObject::tr("Render"), COMMAND_RENDER)
+{}
+
+//! Looks for a GL filter plugin (by name) and returns a new instance of its filter
+static ccGlFilter* CreateGLFilter(const QString& name)
+{
+	for (ccPluginInterface* plugin : ccPluginManager::Get().pluginList())
+	{
+		if (plugin && plugin->getType() == CC_GL_FILTER_PLUGIN && plugin->getName().contains(name, Qt::CaseInsensitive))
+		{
+			return static_cast<ccGLPluginInterface*>(plugin)->getFilter();
+		}
+	}
+
+	return nullptr;
+}
+
+bool CommandRender::process(ccCommandLineInterface& cmd)
+{
+	cmd.print(QObject::tr("[RENDER]"));
+
+	QString viewportsFilename;
+	int width = 1920;
+	int height = 1080;
+	float zoom = 1.0f;
+	QString glFilterName;
+	bool renderOverlayItems = false;
+	QString outputDir;
+	bool showTimings = false;
+
+	//optional parameters
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_VIEWPORTS))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: viewports filename after '%1'").arg(COMMAND_RENDER_VIEWPORTS));
+			}
+			viewportsFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_SIZE))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().size() < 2)
+			{
+				return cmd.error(QObject::tr("Missing parameter(s): width and height after '%1'").arg(COMMAND_RENDER_SIZE));
+			}
+
+			bool okW = false;
+			bool okH = false;
+			width = cmd.arguments().takeFirst().toInt(&okW);
+			height = cmd.arguments().takeFirst().toInt(&okH);
+			if (!okW || !okH || width <= 0 || height <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid size! (after %1)").arg(COMMAND_RENDER_SIZE));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_ZOOM))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: zoom factor after '%1'").arg(COMMAND_RENDER_ZOOM));
+			}
+
+			bool ok = false;
+			zoom = cmd.arguments().takeFirst().toFloat(&ok);
+			if (!ok || zoom <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid zoom factor! (after %1)").arg(COMMAND_RENDER_ZOOM));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_GL_FILTER))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: GL filter name after '%1'").arg(COMMAND_RENDER_GL_FILTER));
+			}
+			glFilterName = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_OVERLAY))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			renderOverlayItems = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_OUTPUT_DIR))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: output directory after '%1'").arg(COMMAND_RENDER_OUTPUT_DIR));
+			}
+			outputDir = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RENDER_TIMINGS))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			showTimings = true;
+		}
+		else
+		{
+			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
+		}
+	}
+
+	if (cmd.clouds().empty() && cmd.meshes().empty())
+	{
+		return cmd.error(QObject::tr("No entity loaded (be sure to open at least one file with \"-%1 [filename]\" before \"-%2\")").arg(COMMAND_OPEN, COMMAND_RENDER));
+	}
+
+	//output base name and directory (by default: the ones of the first entity)
+	const CLEntityDesc& firstDesc = (!cmd.clouds().empty() ? static_cast<const CLEntityDesc&>(cmd.clouds().front()) : static_cast<const CLEntityDesc&>(cmd.meshes().front()));
+	QString baseName = firstDesc.basename;
+	if (outputDir.isEmpty())
+	{
+		outputDir = firstDesc.path;
+	}
+
+	//load the viewports (if any)
+	QScopedPointer<ccHObject> viewportsDB;
+	ccHObject::Container viewports;
+	if (!viewportsFilename.isEmpty())
+	{
+		CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+		viewportsDB.reset(FileIOFilter::LoadFromFile(viewportsFilename, cmd.fileLoadingParams(), result));
+		if (!viewportsDB)
+		{
+			return cmd.error(QObject::tr("Failed to load the viewports file '%1'").arg(viewportsFilename));
+		}
+		viewportsDB->filterChildren(viewports, true, CC_TYPES::VIEWPORT_2D_OBJECT, true);
+		if (viewports.empty())
+		{
+			return cmd.error(QObject::tr("No viewport found in file '%1'").arg(viewportsFilename));
+		}
+		baseName = QFileInfo(viewportsFilename).completeBaseName();
+		cmd.print(QObject::tr("\tViewports: %1").arg(viewports.size()));
+	}
+
+	//create the offscreen 3D view
+	QElapsedTimer timer;
+	timer.start();
+	QScopedPointer<ccGLOffscreenWindow> glWindow(ccGLOffscreenWindow::Create(width, height, true));
+	if (!glWindow)
+	{
+		return cmd.error(QObject::tr("Failed to create the offscreen 3D view (no OpenGL context available? Check the Qt platform plugin, e.g. QT_QPA_PLATFORM=offscreen)"));
+	}
+	if (showTimings)
+	{
+		cmd.print(QObject::tr("\tOffscreen view initialized in %1 ms").arg(timer.elapsed()));
+	}
+	glWindow->setRenderTimingsEnabled(showTimings);
+
+	if (!glFilterName.isEmpty())
+	{
+		if (!glWindow->areGLFiltersEnabled())
+		{
+			return cmd.error(QObject::tr("GL filters are not supported by the OpenGL context"));
+		}
+		//the filter is only owned by the window once it has been successfully initialized
+		QScopedPointer<ccGlFilter> glFilter(CreateGLFilter(glFilterName));
+		if (!glFilter)
+		{
+			return cmd.error(QObject::tr("GL filter '%1' not found (is the corresponding plugin loaded?)").arg(glFilterName));
+		}
+		glWindow->setGlFilter(glFilter.data());
+		if (glWindow->getGlFilter() != glFilter.data())
+		{
+			return cmd.error(QObject::tr("Failed to initialize GL filter '%1'").arg(glFilterName));
+		}
+		glFilter.take();
+	}
+
+	//the scene (the entities still belong to the command line)
+	ccHObject scene("Render scene");
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		scene.addChild(desc.pc, ccHObject::DP_NONE);
+	}
+	for (CLMeshDesc& desc : cmd.meshes())
+	{
+		scene.addChild(desc.mesh, ccHObject::DP_NONE);
+	}
+	glWindow->setSceneDB(&scene);
+	//entities are only drawn by (and taken into account in the bounding box of) their associated display
+	scene.setDisplay_recursive(glWindow.data());
+	glWindow->setLODEnabled(false);
+
+	bool success = true;
+	size_t viewCount = std::max<size_t>(viewports.size(), 1);
+	for (size_t i = 0; i < viewCount; ++i)
+	{
+		QString filename;
+		if (viewports.empty())
+		{
+			glWindow->zoomGlobal();
+			filename = QString("%1_RENDER.png").arg(baseName);
+		}
+		else
+		{
+			const cc2DViewportObject* viewport = static_cast<const cc2DViewportObject*>(viewports[i]);
+			glWindow->setViewportParameters(viewport->getParameters());
+			filename = QString("%1_%2.png").arg(baseName).arg(i + 1, 3, 10, QChar('0'));
+		}
+
+		QImage image = glWindow->renderToImage(zoom, false, renderOverlayItems, true);
+		if (image.isNull())
+		{
+			cmd.warning(QObject::tr("Failed to render view #%1").arg(i + 1));
+			success = false;
+			break;
+		}
+
+		timer.restart();
+		QString fullPath = QDir(outputDir).absoluteFilePath(filename);
+		if (!image.save(fullPath))
+		{
+			cmd.warning(QObject::tr("Failed to save image '%1'").arg(fullPath));
+			success = false;
+			break;
+		}
+		qint64 save_ms = timer.elapsed();
+
+		cmd.print(QObject::tr("\tView #%1 rendered to '%2' (%3 x %4)").arg(i + 1).arg(fullPath).arg(image.width()).arg(image.height()));
+		if (showTimings)
+		{
+			const ccGLWindowInterface::RenderTimings& timings = glWindow->getLastRenderTimings();
+			cmd.print(QObject::tr("\t\tTimings (ms): setup %1 / 3D %2 / GL filter %3 / overlay %4 / read back %5 / total %6 / save %7")
+						.arg(timings.setup_ms, 0, 'f', 1)
+						.arg(timings.render3D_ms, 0, 'f', 1)
+						.arg(timings.glFilter_ms, 0, 'f', 1)
+						.arg(timings.overlay_ms, 0, 'f', 1)
+						.arg(timings.readBack_ms, 0, 'f', 1)
+						.arg(timings.total_ms, 0, 'f', 1)
+						.arg(save_ms));
+		}
+	}
+
+	//release the scene (the window won't unlink the entities once its DB root is null)
+	scene.setDisplay_recursive(nullptr);
+	glWindow->setSceneDB(nullptr);
+	scene.detachAllChildren();
+
+	if (!success)
+	{
+		return cmd.error(QObject::tr("Rendering failed"));
+	}
+
+	return true;
+}
@@ -617,4 +617,18 @@ struct CommandSetVerbosity : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandColorizeFromCameras : public ccCommandLineInterface::Command
+{
+	CommandColorizeFromCameras();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+struct CommandRender : public ccCommandLineInterface::Command
+{
+	CommandRender();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 #endif //COMMAND_LINE_COMMANDS_HEADER
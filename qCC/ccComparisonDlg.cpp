@@ -790,6 +790,7 @@ bool ccComparisonDlg::computeDistances()
 			{
 				size_t validDB = 0;
 				//we also make sure that the sensors have valid depth buffer!
+				std::vector<ccGBLSensor*> sensorsWithoutDB;
 				for (unsigned i = 0; i < pc->getChildrenNumber(); ++i)
 				{
 					ccHObject* child = pc->getChild(i);
@@ -798,20 +799,45 @@ bool ccComparisonDlg::computeDistances()
 						ccGBLSensor* sensor = static_cast<ccGBLSensor*>(child);
 						if (sensor->getDepthBuffer().zBuff.empty())
 						{
-							int errorCode;
+							sensorsWithoutDB.push_back(sensor);
+						}
+						else
+						{
+							++validDB;
+						}
+					}
+				}
+				if (!sensorsWithoutDB.empty())
+				{
+					//all the missing depth buffers are computed at once (the cloud is read only once)
+					int errorCode;
+					if (ccGBLSensor::ComputeDepthBuffers(pc, sensorsWithoutDB, errorCode))
+					{
+						validDB += sensorsWithoutDB.size();
+					}
+					else if (sensorsWithoutDB.size() > 1 && errorCode != ccGBLSensor::ERROR_PROC_CANCELLED)
+					{
+						//the batch mode needs all the depth buffers at once: we try again sensor by sensor
+						ccLog::Warning(QString("[ComputeDistances] ") + ccGBLSensor::GetErrorString(errorCode) + " (the depth buffers will be computed one at a time)");
+						for (ccGBLSensor* sensor : sensorsWithoutDB)
+						{
 							if (!sensor->computeDepthBuffer(pc, errorCode))
 							{
 								ccLog::Warning(QString("[ComputeDistances] ") + ccGBLSensor::GetErrorString(errorCode));
+								if (errorCode == ccGBLSensor::ERROR_PROC_CANCELLED)
+								{
+									break;
+								}
 							}
 							else
 							{
 								++validDB;
 							}
 						}
-						else
-						{
-							++validDB;
-						}
+					}
+					else
+					{
+						ccLog::Warning(QString("[ComputeDistances] ") + ccGBLSensor::GetErrorString(errorCode));
 					}
 				}
 
@@ -24,7 +24,6 @@
 
 //CCCoreLib
 #include <NormalDistribution.h>
-#include <ScalarFieldTools.h>
 #include <StatisticalTestingTools.h>
 #include <WeibullDistribution.h>
 #include <ReferenceCloud.h>
@@ -1075,11 +1074,14 @@ namespace ccEntityAction
 				QElapsedTimer eTimer;
 				eTimer.start();
 				
-				if (!CCCoreLib::ScalarFieldTools::applyScalarFieldGaussianFilter(	static_cast<PointCoordinateType>(spatialSigma),
-																					pc,
-																					static_cast<PointCoordinateType>(scalarFieldSigma),
-																					parent ? pDlg.data() : nullptr,
-																					octree.data()))
+				ccPointCloud::SpatialFilterParameters sfFilterParams;
+				sfFilterParams.sigma = static_cast<PointCoordinateType>(spatialSigma);
+				sfFilterParams.sigmaSF = static_cast<PointCoordinateType>(scalarFieldSigma);
+				sfFilterParams.guideSF = outSF;
+				sfFilterParams.options = filterParams;
+				sfFilterParams.scalarFields.emplace_back(outSF, pc->getScalarField(sfIdx));
+
+				if (!pc->applySpatialFilter(sfFilterParams, parent ? pDlg.data() : nullptr))
 				{
 					ccConsole::Warning(QObject::tr("[Bilateral/Gaussian/Mean/Median filter]  Failed to apply filter"));
 					return false;
@@ -34,6 +34,7 @@
 #include <ccPointCloud.h>
 #include <ccMesh.h>
 #include <ccHObjectCaster.h>
+#include <ccRegionSelector.h>
 #include <cc2DViewportObject.h>
 
 //for the helper (apply)
@@ -53,13 +54,9 @@
 #include <QSettings>
 
 //System
+#include <algorithm>
 #include <assert.h>
 
-#if defined(_OPENMP)
-//OpenMP
-#include <omp.h>
-#endif
-
 ccGraphicalSegmentationTool::ccGraphicalSegmentationTool(QWidget* parent)
 	: ccOverlayDialog(parent)
 	, Ui::GraphicalSegmentationDlg()
@@ -911,6 +908,9 @@ void ccGraphicalSegmentationTool::segment(bool keepPointsInside, ScalarType clas
 
 	bool classificationMode = CCCoreLib::ScalarField::ValidValue(classificationValue);
 
+	// segmentation region (the prism defined by the polyline and the camera viewing rays)
+	ccRegionSelector::ScreenPolygonRegion polyRegion(camera, m_segmentationPoly, polyInsideViewport);
+
 	// for each selected entity
 	int errorCount = 0;
 	for (QSet<ccHObject *>::const_iterator p = m_toSegment.constBegin(); p != m_toSegment.constEnd(); ++p)
@@ -934,8 +934,6 @@ void ccGraphicalSegmentationTool::segment(bool keepPointsInside, ScalarType clas
 
 		assert(!visibilityArray.empty());
 
-		int cloudSize = static_cast<int>(cloud->size());
-
 		// if a classification value is set as input, this means that we want to label the
 		// set of points, and we don't want to segment it
 		CCCoreLib::ScalarField* classifSF = nullptr;
@@ -965,55 +963,57 @@ void ccGraphicalSegmentationTool::segment(bool keepPointsInside, ScalarType clas
 			pc->setCurrentDisplayedScalarField(sfIdx);
 		}
 
-		// we project each point and we check if it falls inside the segmentation polyline
-#if defined(_OPENMP)
-#pragma omp parallel for num_threads(omp_get_max_threads())
-#endif
-		for (int i = 0; i < cloudSize; ++i)
+		// we look for the points falling inside the segmentation polyline
+		// (if the cloud has an octree, only the points of the cells straddling the polyline are projected)
+		std::vector<unsigned> insideIndexes;
+		if (!ccRegionSelector::Select(cloud, polyRegion, insideIndexes, true))
 		{
-			if (visibilityArray[i] == CCCoreLib::POINT_VISIBLE)
-			{
-				const CCVector3* P3D = cloud->getPoint(i);
-
-				CCVector3d Q2D;
-				bool pointInFrustum = false;
-				camera.project(*P3D, Q2D, &pointInFrustum);
+			++errorCount;
+			continue;
+		}
 
-				bool pointInside = false;
-				if (pointInFrustum || !polyInsideViewport) //we can only skip the test if the point is outside the viewport/frustum AND the polyline is fully inside the viewport
+		if (classifSF) // classification mode
+		{
+			for (unsigned i : insideIndexes)
+			{
+				if (visibilityArray[i] == CCCoreLib::POINT_VISIBLE)
 				{
-					CCVector2 P2D(	static_cast<PointCoordinateType>(Q2D.x - half_w),
-									static_cast<PointCoordinateType>(Q2D.y - half_h));
-
-					pointInside = CCCoreLib::ManualSegmentationTools::isPointInsidePoly(P2D, m_segmentationPoly);
+					classifSF->setValue(i, classificationValue);
 				}
-
-				if (classifSF) // classification mode
+			}
+		}
+		else if (keepPointsInside) // 'segment in' or 'export inside selection' modes
+		{
+			// only the visible points inside the polyline remain visible
+			size_t visibleInsideCount = 0;
+			for (unsigned i : insideIndexes)
+			{
+				if (visibilityArray[i] == CCCoreLib::POINT_VISIBLE)
 				{
-					if (pointInside)
-					{
-						classifSF->setValue(i, classificationValue);
-					}
+					insideIndexes[visibleInsideCount++] = i;
 				}
-				else if (exportSelection)
-				{
-					// 'export inside selection' mode
-					assert(keepPointsInside == true);
-					visibilityArray[i] = (pointInside ? CCCoreLib::POINT_VISIBLE : CCCoreLib::POINT_HIDDEN);
+			}
+			insideIndexes.resize(visibleInsideCount);
 
-					if (pointInside)
-					{
-						// (exported points or triangles will be hidden until the Segment tool is closed)
-						outVisibilityArray[i] = CCCoreLib::POINT_HIDDEN;
-					}
-				}
-				else
+			std::fill(visibilityArray.begin(), visibilityArray.end(), CCCoreLib::POINT_HIDDEN);
+			for (unsigned i : insideIndexes)
+			{
+				visibilityArray[i] = CCCoreLib::POINT_VISIBLE;
+
+				if (exportSelection)
 				{
-					// standard segmentation mode
-					visibilityArray[i] = (keepPointsInside != pointInside ? CCCoreLib::POINT_HIDDEN : CCCoreLib::POINT_VISIBLE);
+					// (exported points or triangles will be hidden until the Segment tool is closed)
+					outVisibilityArray[i] = CCCoreLib::POINT_HIDDEN;
 				}
 			}
 		}
+		else // 'segment out' mode
+		{
+			for (unsigned i : insideIndexes)
+			{
+				visibilityArray[i] = CCCoreLib::POINT_HIDDEN;
+			}
+		}
 
 		if (classifSF)
 		{
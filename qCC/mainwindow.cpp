@@ -2681,31 +2681,26 @@ void MainWindow::doActionComputePointsVisibility()
 	assert(sf);
 	if (sf)
 	{
-		sf->fill(0);
-
 		//progress bar
-		ccProgressDialog pdlg(true);
-		CCCoreLib::NormalizedProgress nprogress(&pdlg,pointCloud->size());
-		pdlg.setMethodTitle(tr("Compute visibility"));
-		pdlg.setInfo(tr("Points: %L1").arg( pointCloud->size() ));
-		pdlg.start();
-		QApplication::processEvents();
+		ccProgressDialog pdlg(true, this);
 
-		for (unsigned i = 0; i < pointCloud->size(); i++)
+		//the points are projected in parallel
+		std::vector<unsigned char> visibility;
+		if (ccGBLSensor::ComputeVisibility(pointCloud, { sensor }, visibility, &pdlg))
 		{
-			const CCVector3* P = pointCloud->getPoint(i);
-			unsigned char visibility = sensor->checkVisibility(*P);
-			ScalarType visValue = static_cast<ScalarType>(visibility);
-
-			sf->setValue(i, visValue);
-
-			if (!nprogress.oneStep())
+			for (unsigned i = 0; i < pointCloud->size(); i++)
 			{
-				//cancelled by user
-				pointCloud->deleteScalarField(sfIdx);
-				sf = nullptr;
-				break;
+				sf->setValue(i, static_cast<ScalarType>(visibility[i]));
+			}
+		}
+		else
+		{
+			if (!pdlg.isCancelRequested())
+			{
+				ccLog::Error(tr("Not enough memory!"));
 			}
+			pointCloud->deleteScalarField(sfIdx);
+			sf = nullptr;
 		}
 
 		if (sf)